@@ -0,0 +1,123 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_assign.h"
+
+/*
+ * Hungarian algorithm with potentials. Minimizes the cost, which is
+ * the negated score scaled by (n + 1) with a bonus of 1 for keeping
+ * the element in place. The total bonus is less than (n + 1), so it
+ * only breaks ties between equally scored assignments.
+ *
+ * Arrays are indexed from 1, row/column 0 is the fake starting point.
+ */
+int
+binder_assign_best(
+    const int* score,
+    guint n,
+    guint* order)
+{
+    const gint64 scale = n + 1;
+    gint64* u;
+    gint64* v;
+    gint64* minv;
+    guint* p;
+    guint* way;
+    gboolean* used;
+    int total = 0;
+    guint i, j;
+
+    if (!n) {
+        return 0;
+    }
+
+    u = g_new0(gint64, 3 * (n + 1));
+    v = u + (n + 1);
+    minv = v + (n + 1);
+    p = g_new0(guint, 2 * (n + 1));
+    way = p + (n + 1);
+    used = g_new(gboolean, n + 1);
+
+    for (i = 1; i <= n; i++) {
+        guint j0 = 0;
+
+        p[0] = i;
+        for (j = 0; j <= n; j++) {
+            minv[j] = G_MAXINT64;
+            used[j] = FALSE;
+        }
+
+        do {
+            const guint i0 = p[j0];
+            gint64 delta = G_MAXINT64;
+            guint j1 = 0;
+
+            used[j0] = TRUE;
+            for (j = 1; j <= n; j++) {
+                if (!used[j]) {
+                    const gint64 cost = -score[(i0 - 1) * n + (j - 1)] *
+                        scale - ((i0 == j) ? 1 : 0);
+                    const gint64 cur = cost - u[i0] - v[j];
+
+                    if (cur < minv[j]) {
+                        minv[j] = cur;
+                        way[j] = j0;
+                    }
+                    if (minv[j] < delta) {
+                        delta = minv[j];
+                        j1 = j;
+                    }
+                }
+            }
+            for (j = 0; j <= n; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0]);
+
+        /* Augment along the path */
+        do {
+            const guint j1 = way[j0];
+
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    for (j = 1; j <= n; j++) {
+        const guint row = p[j] - 1;
+
+        order[row] = j - 1;
+        total += score[row * n + (j - 1)];
+    }
+
+    g_free(u);
+    g_free(p);
+    g_free(used);
+    return total;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
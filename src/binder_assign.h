@@ -0,0 +1,43 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_ASSIGN_H
+#define BINDER_ASSIGN_H
+
+#include "binder_types.h"
+
+/*
+ * Solves the assignment problem for the n x n score matrix (row-major,
+ * score[i * n + j] is the score of assigning j to i) in O(n^3) time.
+ * Fills order with the assignment maximizing the total score, which
+ * is returned. Among equally good assignments, the one leaving more
+ * elements in place (order[i] == i) wins.
+ */
+int
+binder_assign_best(
+    const int* score,
+    guint n,
+    guint* order)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_ASSIGN_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
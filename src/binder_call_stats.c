@@ -0,0 +1,134 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_call_stats.h"
+#include "binder_histogram.h"
+#include "binder_log.h"
+
+#include <string.h>
+
+struct binder_call_stats {
+    BinderCallStageStats stage[BINDER_CALL_STAGE_COUNT];
+};
+
+static
+void
+binder_call_stats_stage_add(
+    BinderCallStats* stats,
+    BINDER_CALL_STAGE stage,
+    gint64 from,
+    gint64 to)
+{
+    BinderCallStageStats* s = stats->stage + stage;
+
+    if (from && to >= from) {
+        const guint ms = (guint)((to - from) / 1000);
+
+        s->count++;
+        s->total_ms += ms;
+        s->max_ms = MAX(s->max_ms, ms);
+        s->last_ms = ms;
+        binder_histogram_add(s->buckets, BINDER_CALL_STATS_BUCKETS, ms);
+        GDEBUG("%s %u ms", binder_call_stage_name(stage), ms);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderCallStats*
+binder_call_stats_new(
+    void)
+{
+    return g_new0(BinderCallStats, 1);
+}
+
+void
+binder_call_stats_free(
+    BinderCallStats* stats)
+{
+    g_free(stats);
+}
+
+void
+binder_call_stats_reset(
+    BinderCallStats* stats)
+{
+    if (stats) {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
+
+void
+binder_call_stats_add(
+    BinderCallStats* stats,
+    const BinderCallTimeline* t)
+{
+    if (stats && t) {
+        binder_call_stats_stage_add(stats, BINDER_CALL_STAGE_DIAL,
+            t->dial, t->dial_resp);
+        binder_call_stats_stage_add(stats, BINDER_CALL_STAGE_PRESENT,
+            t->dial, t->present);
+        binder_call_stats_stage_add(stats, BINDER_CALL_STAGE_ALERTING,
+            t->dial, t->alerting);
+        binder_call_stats_stage_add(stats, BINDER_CALL_STAGE_ACTIVE,
+            t->dial, t->active);
+        binder_call_stats_stage_add(stats, BINDER_CALL_STAGE_HANGUP,
+            t->hangup, t->disconnect);
+        binder_call_stats_stage_add(stats, BINDER_CALL_STAGE_FAIL_CAUSE,
+            t->disconnect, t->fail_cause);
+    }
+}
+
+const BinderCallStageStats*
+binder_call_stats_get(
+    BinderCallStats* stats,
+    BINDER_CALL_STAGE stage)
+{
+    return (stats && stage >= 0 && stage < BINDER_CALL_STAGE_COUNT) ?
+        (stats->stage + stage) : NULL;
+}
+
+const char*
+binder_call_stage_name(
+    BINDER_CALL_STAGE stage)
+{
+    switch (stage) {
+    case BINDER_CALL_STAGE_DIAL:
+        return "dial";
+    case BINDER_CALL_STAGE_PRESENT:
+        return "present";
+    case BINDER_CALL_STAGE_ALERTING:
+        return "alerting";
+    case BINDER_CALL_STAGE_ACTIVE:
+        return "active";
+    case BINDER_CALL_STAGE_HANGUP:
+        return "hangup";
+    case BINDER_CALL_STAGE_FAIL_CAUSE:
+        return "failcause";
+    case BINDER_CALL_STAGE_COUNT:
+        break;
+    }
+    return NULL;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,98 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_CALL_STATS_H
+#define BINDER_CALL_STATS_H
+
+#include "binder_types.h"
+
+/*
+ * Call setup and teardown timing. Each call collects a timeline
+ * (monotonic timestamps in microseconds, zero if the event didn't
+ * happen), which gets folded into per-stage histograms (in ms, see
+ * binder_histogram.h) when the call is gone.
+ */
+#define BINDER_CALL_STATS_BUCKETS (18)
+
+typedef enum binder_call_stage {
+    BINDER_CALL_STAGE_DIAL,         /* Dial request => dial response */
+    BINDER_CALL_STAGE_PRESENT,      /* Dial request => call in the list */
+    BINDER_CALL_STAGE_ALERTING,     /* Dial request => alerting */
+    BINDER_CALL_STAGE_ACTIVE,       /* Dial request => active */
+    BINDER_CALL_STAGE_HANGUP,       /* Hangup request => call is gone */
+    BINDER_CALL_STAGE_FAIL_CAUSE,   /* Call is gone => fail cause known */
+    BINDER_CALL_STAGE_COUNT
+} BINDER_CALL_STAGE;
+
+typedef struct binder_call_timeline {
+    gint64 dial;
+    gint64 dial_resp;
+    gint64 present;
+    gint64 alerting;
+    gint64 active;
+    gint64 hangup;
+    gint64 disconnect;
+    gint64 fail_cause;
+} BinderCallTimeline;
+
+typedef struct binder_call_stage_stats {
+    guint count;
+    guint max_ms;
+    guint last_ms; /* The last call which got this far */
+    guint64 total_ms;
+    guint buckets[BINDER_CALL_STATS_BUCKETS];
+} BinderCallStageStats;
+
+BinderCallStats*
+binder_call_stats_new(
+    void)
+    BINDER_INTERNAL;
+
+void
+binder_call_stats_free(
+    BinderCallStats* stats)
+    BINDER_INTERNAL;
+
+void
+binder_call_stats_reset(
+    BinderCallStats* stats)
+    BINDER_INTERNAL;
+
+void
+binder_call_stats_add(
+    BinderCallStats* stats,
+    const BinderCallTimeline* timeline)
+    BINDER_INTERNAL;
+
+const BinderCallStageStats*
+binder_call_stats_get(
+    BinderCallStats* stats,
+    BINDER_CALL_STAGE stage)
+    BINDER_INTERNAL;
+
+const char*
+binder_call_stage_name(
+    BINDER_CALL_STAGE stage)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_CALL_STATS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
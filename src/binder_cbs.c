@@ -16,6 +16,7 @@
 #include "binder_cbs.h"
 #include "binder_log.h"
 #include "binder_modem.h"
+#include "binder_radio.h"
 #include "binder_util.h"
 
 #include <ofono/cbs.h>
@@ -25,30 +26,54 @@
 #include <radio_request.h>
 #include <radio_request_group.h>
 #include <radio_messaging_types.h>
+#include <radio_modem_types.h>
 
 #include <gbinder_reader.h>
 #include <gbinder_writer.h>
 
 #include <gutil_macros.h>
+#include <gutil_misc.h>
 #include <gutil_strv.h>
 
+#include <string.h>
+
+typedef enum binder_cbs_activation {
+    CBS_ACTIVATION_UNKNOWN,
+    CBS_ACTIVATION_ON,
+    CBS_ACTIVATION_OFF
+} BINDER_CBS_ACTIVATION;
+
+typedef struct binder_cbs_range {
+    guint from;
+    guint to;
+} BinderCbsRange;
+
 typedef struct binder_cbs {
     struct ofono_cbs* cbs;
     RadioRequestGroup* g;
+    RadioClient* modem_client;
+    BinderRadio* radio;
     RADIO_AIDL_INTERFACE interface_aidl;
     char* log_prefix;
     guint register_id;
     gulong event_id;
+    gulong reset_id;
+    gulong radio_state_id;
+    GArray* config; /* BinderCbsRange, last one accepted by the modem */
+    BINDER_CBS_ACTIVATION activation;
 } BinderCbs;
 
 typedef struct binder_cbs_cbd {
     BinderCbs* self;
     ofono_cbs_set_cb_t cb;
     gpointer data;
+    GArray* config; /* Being sent to the modem */
+    gboolean activate;
 } BinderCbsCbData;
 
 #define CBS_CHECK_RETRY_MS    1000
 #define CBS_CHECK_RETRY_COUNT 30
+#define CBS_MAX_SERVICE_ID    0xffff
 
 #define DBG_(cd,fmt,args...) DBG("%s" fmt, (cd)->log_prefix, ##args)
 
@@ -73,11 +98,119 @@ binder_cbs_callback_data_new(
 static
 void
 binder_cbs_callback_data_free(
-    gpointer cbd)
+    gpointer user_data)
 {
+    BinderCbsCbData* cbd = user_data;
+
+    if (cbd->config) {
+        g_array_unref(cbd->config);
+    }
     g_slice_free(BinderCbsCbData, cbd);
 }
 
+static
+void
+binder_cbs_forget_config(
+    BinderCbs* self)
+{
+    /* Next time everything will be sent to the modem */
+    if (self->config) {
+        g_array_unref(self->config);
+        self->config = NULL;
+    }
+    self->activation = CBS_ACTIVATION_UNKNOWN;
+}
+
+static
+gint
+binder_cbs_range_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderCbsRange* r1 = a;
+    const BinderCbsRange* r2 = b;
+
+    return (r1->from < r2->from) ? -1 : (r1->from > r2->from) ? 1 :
+        (r1->to < r2->to) ? -1 : (r1->to > r2->to);
+}
+
+static
+gboolean
+binder_cbs_parse_id(
+    const char* str,
+    guint* id)
+{
+    int value;
+
+    if (gutil_parse_int(str, 10, &value) && value >= 0 &&
+        value <= CBS_MAX_SERVICE_ID) {
+        *id = value;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+GArray*
+binder_cbs_parse_topics(
+    const char* topics)
+{
+    GArray* ranges = g_array_new(FALSE, FALSE, sizeof(BinderCbsRange));
+    char** list = topics ? g_strsplit(topics, ",", 0) : NULL;
+    char** ptr;
+
+    /* "1,2,10-20" => sorted list of non-overlapping ranges */
+    for (ptr = list; ptr && *ptr; ptr++) {
+        char** range = g_strsplit(*ptr, "-", 0);
+        const guint n = gutil_strv_length(range);
+        BinderCbsRange r;
+
+        if ((n == 1 && binder_cbs_parse_id(range[0], &r.from) &&
+            binder_cbs_parse_id(range[0], &r.to)) ||
+            (n == 2 && binder_cbs_parse_id(range[0], &r.from) &&
+            binder_cbs_parse_id(range[1], &r.to))) {
+            if (r.from > r.to) {
+                const guint tmp = r.from;
+
+                r.from = r.to;
+                r.to = tmp;
+            }
+            g_array_append_val(ranges, r);
+        } else {
+            ofono_warn("Ignoring CB topic '%s'", *ptr);
+        }
+        g_strfreev(range);
+    }
+    g_strfreev(list);
+
+    if (ranges->len > 1) {
+        BinderCbsRange* r = (BinderCbsRange*)ranges->data;
+        guint i, n = 0;
+
+        /* Merge overlapping and adjacent ranges */
+        g_array_sort(ranges, binder_cbs_range_compare);
+        for (i = 1; i < ranges->len; i++) {
+            if (r[i].from <= r[n].to + 1) {
+                r[n].to = MAX(r[n].to, r[i].to);
+            } else {
+                r[++n] = r[i];
+            }
+        }
+        g_array_set_size(ranges, n + 1);
+    }
+    return ranges;
+}
+
+static
+gboolean
+binder_cbs_config_equal(
+    const GArray* a,
+    const GArray* b)
+{
+    return a && b && a->len == b->len &&
+        !memcmp(a->data, b->data, sizeof(BinderCbsRange) * a->len);
+}
+
 static
 gboolean
 binder_cbs_retry(
@@ -110,6 +243,8 @@ binder_cbs_activate_cb(
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == code) {
             if (error == RADIO_ERROR_NONE) {
+                cbd->self->activation = cbd->activate ?
+                    CBS_ACTIVATION_ON : CBS_ACTIVATION_OFF;
                 cbd->cb(binder_error_ok(&err), cbd->data);
                 return;
             } else {
@@ -121,6 +256,7 @@ binder_cbs_activate_cb(
                 resp);
         }
     }
+    cbd->self->activation = CBS_ACTIVATION_UNKNOWN;
     cbd->cb(binder_error_failure(&err), cbd->data);
 }
 
@@ -137,12 +273,13 @@ binder_cbs_activate(
     guint32 code = self->interface_aidl == RADIO_MESSAGING_INTERFACE ?
         RADIO_MESSAGING_REQ_SET_GSM_BROADCAST_ACTIVATION :
         RADIO_REQ_SET_GSM_BROADCAST_ACTIVATION;
+    BinderCbsCbData* cbd = binder_cbs_callback_data_new(self, cb, data);
     RadioRequest* req = radio_request_new2(self->g,
         code, &writer,
         binder_cbs_activate_cb,
-        binder_cbs_callback_data_free,
-        binder_cbs_callback_data_new(self, cb, data));
+        binder_cbs_callback_data_free, cbd);
 
+    cbd->activate = activate;
     gbinder_writer_append_bool(&writer, activate);  /* activate */
     DBG_(self, "%sactivating CB", activate ? "" : "de");
     radio_request_set_retry_func(req, binder_cbs_retry);
@@ -170,7 +307,15 @@ binder_cbs_set_config_cb(
             RADIO_RESP_SET_GSM_BROADCAST_CONFIG;
         if (resp == code) {
             if (error == RADIO_ERROR_NONE) {
-                binder_cbs_activate(cbd->self, TRUE, cbd->cb, cbd->data);
+                BinderCbs* self = cbd->self;
+
+                /* The modem has accepted this config */
+                if (self->config) {
+                    g_array_unref(self->config);
+                }
+                self->config = cbd->config;
+                cbd->config = NULL;
+                binder_cbs_activate(self, TRUE, cbd->cb, cbd->data);
                 return;
             } else {
                 ofono_warn("Failed to set broadcast config, error %d", error);
@@ -180,6 +325,7 @@ binder_cbs_set_config_cb(
                 resp);
         }
     }
+    binder_cbs_forget_config(cbd->self);
     cbd->cb(binder_error_failure(&err), cbd->data);
 }
 
@@ -187,7 +333,7 @@ static
 void
 binder_cbs_set_config(
     BinderCbs* self,
-    const char* topics,
+    GArray* ranges, /* Takes ownership */
     ofono_cbs_set_cb_t cb,
     void* data)
 {
@@ -195,15 +341,15 @@ binder_cbs_set_config(
     guint32 code = self->interface_aidl == RADIO_MESSAGING_INTERFACE ?
         RADIO_MESSAGING_REQ_SET_GSM_BROADCAST_CONFIG :
         RADIO_REQ_SET_GSM_BROADCAST_CONFIG;
+    BinderCbsCbData* cbd = binder_cbs_callback_data_new(self, cb, data);
     RadioRequest* req = radio_request_new2(self->g,
         code, &writer,
         binder_cbs_set_config_cb,
-        binder_cbs_callback_data_free,
-        binder_cbs_callback_data_new(self, cb, data));
-
-    char** list = topics ? g_strsplit(topics, ",", 0) : NULL;
-    const guint count = gutil_strv_length(list);
+        binder_cbs_callback_data_free, cbd);
+    const BinderCbsRange* r = (BinderCbsRange*)ranges->data;
+    const guint count = ranges->len;
 
+    cbd->config = ranges;
     if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) {
         /* setGsmBroadcastConfig(int32_t serial, vec<GsmBroadcastSmsConfigInfo>); */
         GBinderParent parent;
@@ -218,20 +364,11 @@ binder_cbs_set_config(
 
         for (i = 0; i < count; i++) {
             RadioGsmBroadcastSmsConfig* config = configs + i;
-            const char* entry = list[i];
-            const char* delim = strchr(entry, '-');
 
             config->selected = TRUE;
             config->toCodeScheme = 0xff;
-            if (delim) {
-                char** range = g_strsplit(entry, "-", 0);
-
-                config->fromServiceId = atoi(range[0]);
-                config->toServiceId = atoi(range[1]);
-                g_strfreev(range);
-            } else {
-                config->fromServiceId = config->toServiceId = atoi(entry);
-            }
+            config->fromServiceId = r[i].from;
+            config->toServiceId = r[i].to;
         }
 
         /* Every vector, even the one without data, requires two buffer objects */
@@ -247,36 +384,24 @@ binder_cbs_set_config(
         gbinder_writer_append_int32(&writer, count);
 
         for (i = 0; i < count; i++) {
-            const char* entry = list[i];
-            const char* delim = strchr(entry, '-');
-
             /* Non-null parcelable */
             gbinder_writer_append_int32(&writer, 1);
             /* Parcelable size */
             gbinder_writer_append_int32(&writer, 6 * sizeof(gint32));
 
-            if (delim) {
-                char** range = g_strsplit(entry, "-", 0);
-
-                gbinder_writer_append_int32(&writer, atoi(range[0]));
-                gbinder_writer_append_int32(&writer, atoi(range[1]));
-                g_strfreev(range);
-            } else {
-                gbinder_writer_append_int32(&writer, atoi(entry));
-                gbinder_writer_append_int32(&writer, atoi(entry));
-            }
+            gbinder_writer_append_int32(&writer, r[i].from);
+            gbinder_writer_append_int32(&writer, r[i].to);
             gbinder_writer_append_int32(&writer, 0);
             gbinder_writer_append_int32(&writer, 0xff);
             gbinder_writer_append_bool(&writer, TRUE);
         }
     }
 
-    DBG_(self, "configuring CB");
+    DBG_(self, "configuring CB (%u range(s))", count);
     radio_request_set_retry_func(req, binder_cbs_retry);
     radio_request_set_retry(req, CBS_CHECK_RETRY_MS, CBS_CHECK_RETRY_COUNT);
     radio_request_submit(req);
     radio_request_unref(req);
-    g_strfreev(list);
 }
 
 static
@@ -288,9 +413,23 @@ binder_cbs_set_topics(
     void* data)
 {
     BinderCbs* self = binder_cbs_get_data(cbs);
+    GArray* config = binder_cbs_parse_topics(topics);
 
     DBG_(self, "%s", topics);
-    binder_cbs_set_config(self, topics, cb, data);
+    if (binder_cbs_config_equal(config, self->config)) {
+        g_array_unref(config);
+        if (self->activation == CBS_ACTIVATION_ON) {
+            struct ofono_error err;
+
+            /* Nothing to do */
+            DBG_(self, "CB config unchanged");
+            cb(binder_error_ok(&err), data);
+        } else {
+            binder_cbs_activate(self, TRUE, cb, data);
+        }
+    } else {
+        binder_cbs_set_config(self, config, cb, data);
+    }
 }
 
 static
@@ -303,7 +442,14 @@ binder_cbs_clear_topics(
     BinderCbs* self = binder_cbs_get_data(cbs);
 
     DBG_(self, "");
-    binder_cbs_activate(self, FALSE, cb, data);
+    if (self->activation == CBS_ACTIVATION_OFF) {
+        struct ofono_error err;
+
+        DBG_(self, "CB already deactivated");
+        cb(binder_error_ok(&err), data);
+    } else {
+        binder_cbs_activate(self, FALSE, cb, data);
+    }
 }
 
 static
@@ -351,6 +497,37 @@ binder_cbs_notify(
     }
 }
 
+static
+void
+binder_cbs_modem_reset_notify(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderCbs* self = user_data;
+
+    /* Whatever the modem had is gone */
+    DBG_(self, "modem reset");
+    binder_cbs_forget_config(self);
+}
+
+static
+void
+binder_cbs_radio_state_cb(
+    BinderRadio* radio,
+    BINDER_RADIO_PROPERTY property,
+    void* user_data)
+{
+    BinderCbs* self = user_data;
+
+    /* The modem doesn't have to keep the configuration across power off */
+    if (radio->state != RADIO_STATE_ON) {
+        DBG_(self, "%s", binder_radio_state_string(radio->state));
+        binder_cbs_forget_config(self);
+    }
+}
+
 static
 gboolean
 binder_cbs_register(
@@ -367,6 +544,14 @@ binder_cbs_register(
     DBG_(self, "registering for CB");
     self->event_id = radio_client_add_indication_handler(client,
         code, binder_cbs_notify, self);
+    if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) {
+        self->reset_id = radio_client_add_indication_handler(client,
+            RADIO_IND_MODEM_RESET, binder_cbs_modem_reset_notify, self);
+    } else {
+        self->reset_id = radio_client_add_indication_handler(
+            self->modem_client, RADIO_MODEM_IND_MODEM_RESET,
+            binder_cbs_modem_reset_notify, self);
+    }
     ofono_cbs_register(self->cbs);
     return G_SOURCE_REMOVE;
 }
@@ -383,6 +568,10 @@ binder_cbs_probe(
 
     self->cbs = cbs;
     self->g = radio_request_group_new(modem->messaging_client); /* Keeps ref to client */
+    self->modem_client = radio_client_ref(modem->client);
+    self->radio = binder_radio_ref(modem->radio);
+    self->radio_state_id = binder_radio_add_property_handler(self->radio,
+        BINDER_RADIO_PROPERTY_STATE, binder_cbs_radio_state_cb, self);
     self->interface_aidl = radio_client_aidl_interface(modem->messaging_client);
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
     self->register_id = g_idle_add(binder_cbs_register, self);
@@ -404,8 +593,15 @@ binder_cbs_remove(
         g_source_remove(self->register_id);
     }
     radio_client_remove_handler(self->g->client, self->event_id);
+    radio_client_remove_handler(self->interface_aidl ==
+        RADIO_AIDL_INTERFACE_NONE ? self->g->client : self->modem_client,
+        self->reset_id);
+    radio_client_unref(self->modem_client);
+    binder_radio_remove_handler(self->radio, self->radio_state_id);
+    binder_radio_unref(self->radio);
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
+    binder_cbs_forget_config(self);
     g_free(self->log_prefix);
     g_free(self);
 
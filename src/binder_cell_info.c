@@ -14,6 +14,7 @@
  */
 
 #include "binder_cell_info.h"
+#include "binder_network.h"
 #include "binder_sim_card.h"
 #include "binder_radio.h"
 #include "binder_util.h"
@@ -35,6 +36,13 @@
 
 #define DEFAULT_UPDATE_RATE_MS  (10000) /* 10 sec */
 #define MAX_RETRIES             (5)
+#define STABLE_SNAPSHOTS        (3)  /* Before the interval gets widened */
+
+enum binder_cell_info_network_event {
+    NETWORK_EVENT_VOICE_STATE,
+    NETWORK_EVENT_DATA_STATE,
+    NETWORK_EVENT_COUNT
+};
 
 enum binder_cell_info_event {
     CELL_INFO_EVENT_1_0,
@@ -48,15 +56,28 @@ typedef GObjectClass BinderCellInfoClass;
 typedef struct binder_cell_info {
     GObject object;
     struct ofono_cell_info info;
-    struct ofono_cell **cells;
+    GPtrArray* cells;
+    GPtrArray* next;
+    GPtrArray* update;
+    GPtrArray* added;
+    GPtrArray* removed;
+    GPtrArray* changed;
+    GPtrArray* spare;
+    BinderCellInfoStats stats;
     RadioInstance* instance;
     RadioClient* client;
     BinderRadio* radio;
+    BinderNetwork* network;
     BinderSimCard* sim_card;
     gulong radio_state_event_id;
     gulong sim_status_event_id;
+    gulong network_event_id[NETWORK_EVENT_COUNT];
     gboolean sim_card_ready;
     int update_rate_ms;
+    int adaptive_min_ms;
+    int adaptive_max_ms;
+    int adaptive_rate_ms;
+    guint stable_count;
     char* log_prefix;
     gulong event_id[CELL_INFO_EVENT_COUNT];
     RadioRequest* query_req;
@@ -66,10 +87,12 @@ typedef struct binder_cell_info {
 
 enum binder_cell_info_signal {
     SIGNAL_CELLS_CHANGED,
+    SIGNAL_CELLS_DIFF,
     SIGNAL_COUNT
 };
 
 #define SIGNAL_CELLS_CHANGED_NAME   "binder-cell-info-cells-changed"
+#define SIGNAL_CELLS_DIFF_NAME      "binder-cell-info-cells-diff"
 
 static GUtilIdlePool* binder_cell_info_pool = NULL;
 static guint binder_cell_info_signals[SIGNAL_COUNT] = { 0 };
@@ -81,13 +104,80 @@ G_DEFINE_TYPE(BinderCellInfo, binder_cell_info, G_TYPE_OBJECT)
 
 #define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
 
+static
+void
+binder_cell_info_adapt_rate(
+    BinderCellInfo* self,
+    gboolean serving_changed,
+    gboolean neighbours_changed);
+
 /*
- * binder_cell_info_list_equal() assumes that zero-initialized
+ * binder_cell_info_update_cells() assumes that zero-initialized
  * struct ofono_cell gets allocated regardless of the cell type,
- * even if a part of the structure remains unused.
+ * even if a part of the structure remains unused. That includes
+ * the cells recycled by binder_cell_info_new_cell().
  */
 
-#define binder_cell_new() g_new0(struct ofono_cell, 1)
+static
+struct ofono_cell*
+binder_cell_info_new_cell(
+    BinderCellInfo* self)
+{
+    GPtrArray* spare = self->spare;
+
+    if (spare->len) {
+        struct ofono_cell* cell = spare->pdata[spare->len - 1];
+
+        g_ptr_array_set_size(spare, spare->len - 1);
+        memset(cell, 0, sizeof(*cell));
+        self->stats.cells_reused++;
+        return cell;
+    } else {
+        self->stats.cells_allocated++;
+        return g_new0(struct ofono_cell, 1);
+    }
+}
+
+static
+void
+binder_cell_info_recycle_cells(
+    BinderCellInfo* self,
+    GPtrArray* cells)
+{
+    guint i;
+
+    for (i = 0; i < cells->len; i++) {
+        struct ofono_cell* cell = cells->pdata[i];
+
+        if (cell) {
+            g_ptr_array_add(self->spare, cell);
+        }
+    }
+    g_ptr_array_set_size(cells, 0);
+}
+
+static
+void
+binder_cell_info_set_cells(
+    BinderCellInfo* self,
+    GPtrArray* cells)
+{
+    /* Swap the arrays, both are reused */
+    self->next = self->cells;
+    self->cells = cells;
+    g_ptr_array_add(cells, NULL);
+    self->info.cells = (const ofono_cell_ptr*)cells->pdata;
+    g_ptr_array_set_size(self->next, 0);
+}
+
+static
+GPtrArray*
+binder_cell_info_update_list(
+    BinderCellInfo* self)
+{
+    g_ptr_array_set_size(self->update, 0);
+    return self->update;
+}
 
 static
 const char*
@@ -134,23 +224,33 @@ binder_cell_info_list_compare(
 }
 
 static
-gboolean
-binder_cell_info_list_equal(
-    const ofono_cell_ptr* l1,
-    const ofono_cell_ptr* l2)
+void
+binder_cell_info_emit_diff(
+    BinderCellInfo* self)
 {
-    if (l1 && l2) {
-        while (*l1 && *l2) {
-            if (memcmp(*l1, *l2, sizeof(struct ofono_cell))) {
-                return FALSE;
-            }
-            l1++;
-            l2++;
-        }
-        return !*l1 && !*l2;
-    } else {
-        return (!l1 || !*l1) && (!l2 || !*l2);
-    }
+    BinderCellInfoDiff diff;
+
+    DBG_(self, "+%u -%u ~%u (%u allocated, %u reused)", self->added->len,
+        self->removed->len, self->changed->len, self->stats.cells_allocated,
+        self->stats.cells_reused);
+    g_ptr_array_add(self->added, NULL);
+    g_ptr_array_add(self->removed, NULL);
+    g_ptr_array_add(self->changed, NULL);
+    diff.added = (const ofono_cell_ptr*)self->added->pdata;
+    diff.removed = (const ofono_cell_ptr*)self->removed->pdata;
+    diff.changed = (const ofono_cell_ptr*)self->changed->pdata;
+    g_signal_emit(self, binder_cell_info_signals[SIGNAL_CELLS_DIFF], 0, &diff);
+    g_signal_emit(self, binder_cell_info_signals[SIGNAL_CELLS_CHANGED], 0);
+}
+
+static
+void
+binder_cell_info_diff_reset(
+    BinderCellInfo* self)
+{
+    g_ptr_array_set_size(self->added, 0);
+    g_ptr_array_set_size(self->changed, 0);
+    binder_cell_info_recycle_cells(self, self->removed);
 }
 
 static
@@ -158,14 +258,26 @@ void
 binder_cell_info_clear(
     BinderCellInfo* self)
 {
-    if (self->cells && self->cells[0]) {
-        gutil_ptrv_free((void**)self->cells);
-        self->info.cells = self->cells = g_new0(struct ofono_cell*, 1);
-        g_signal_emit(self, binder_cell_info_signals[SIGNAL_CELLS_CHANGED], 0);
+    /* The array is NULL-terminated */
+    if (self->cells->len > 1) {
+        GPtrArray* removed = self->removed;
+        guint i;
+
+        for (i = 0; i + 1 < self->cells->len; i++) {
+            g_ptr_array_add(removed, self->cells->pdata[i]);
+        }
+        binder_cell_info_set_cells(self, self->next);
+        binder_cell_info_emit_diff(self);
+        binder_cell_info_diff_reset(self);
     }
 }
 
-/* NULL-terminates and takes ownership of GPtrArray */
+/*
+ * Merges the new (unsorted) list into the current one. Cells are
+ * matched by location, the ones which are still there are updated
+ * in place and keep their addresses. Cells from the list are either
+ * stolen or recycled, the list is left empty.
+ */
 static
 void
 binder_cell_info_update_cells(
@@ -173,21 +285,60 @@ binder_cell_info_update_cells(
     GPtrArray* l)
 {
     if (l) {
+        struct ofono_cell** old = (struct ofono_cell**)self->cells->pdata;
+        GPtrArray* cells = self->next;
+        gboolean serving_changed = FALSE;
+        guint i = 0;
+
         g_ptr_array_sort(l, binder_cell_info_list_compare);
-        g_ptr_array_add(l, NULL);
-
-        DBG_(self, "%d cell(s)", (int)(l->len - 1));
-        if (!binder_cell_info_list_equal(self->cells,
-           (struct ofono_cell**)l->pdata)) {
-            gutil_ptrv_free((void**)self->cells);
-            self->info.cells = self->cells = (struct ofono_cell **)
-                g_ptr_array_free(l, FALSE);
-            g_signal_emit(self, binder_cell_info_signals
-                [SIGNAL_CELLS_CHANGED], 0);
+        DBG_(self, "%u cell(s)", l->len);
+
+        while (*old || i < l->len) {
+            struct ofono_cell* cell = *old;
+            struct ofono_cell* update = (i < l->len) ? l->pdata[i] : NULL;
+            const int diff = !cell ? 1 : !update ? -1 :
+                ofono_cell_compare_location(cell, update);
+
+            if (diff < 0) {
+                /* This cell is gone */
+                serving_changed |= cell->registered;
+                g_ptr_array_add(self->removed, cell);
+                old++;
+            } else if (diff > 0) {
+                /* A new one, steal it from the update */
+                serving_changed |= update->registered;
+                g_ptr_array_add(cells, update);
+                g_ptr_array_add(self->added, update);
+                l->pdata[i++] = NULL;
+            } else {
+                /* Same location, signal and whatnot may have changed */
+                if (memcmp(cell, update, sizeof(*cell))) {
+                    serving_changed |= (!cell->registered !=
+                        !update->registered);
+                    *cell = *update;
+                    g_ptr_array_add(self->changed, cell);
+                }
+                g_ptr_array_add(cells, cell);
+                old++;
+                i++;
+            }
+        }
+
+        if (self->added->len || self->removed->len) {
+            binder_cell_info_set_cells(self, cells);
         } else {
-            g_ptr_array_set_free_func(l, g_free);
-            g_ptr_array_free(l, TRUE);
+            /* The set of cells is the same, keep the current array */
+            g_ptr_array_set_size(cells, 0);
+        }
+
+        if (self->added->len || self->removed->len || self->changed->len) {
+            binder_cell_info_emit_diff(self);
         }
+
+        binder_cell_info_adapt_rate(self, serving_changed,
+            self->added->len || self->removed->len);
+        binder_cell_info_diff_reset(self);
+        binder_cell_info_recycle_cells(self, l);
     }
 }
 
@@ -227,781 +378,763 @@ binder_cell_info_invalidate_nr(
 
 static
 struct ofono_cell*
-binder_cell_info_new_cell_gsm(
-    gboolean registered,
-    const RadioCellIdentityGsm* id,
-    const RadioSignalStrengthGsm* ss)
+binder_cell_info_new_cell_type(
+    BinderCellInfo* self,
+    enum ofono_cell_type type,
+    gboolean registered)
 {
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_gsm* gsm = &cell->info.gsm;
+    struct ofono_cell* cell = binder_cell_info_new_cell(self);
 
-    cell->type = OFONO_CELL_TYPE_GSM;
+    cell->type = type;
     cell->registered = registered;
-
-    binder_cell_info_invalidate(gsm, sizeof(*gsm));
-    gutil_parse_int(id->mcc.data.str, 10, &gsm->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &gsm->mnc);
-    gsm->lac = id->lac;
-    gsm->cid = id->cid;
-    gsm->arfcn = id->arfcn;
-    gsm->bsic = id->bsic;
-    gsm->signalStrength = ss->signalStrength;
-    gsm->bitErrorRate = ss->bitErrorRate;
-    gsm->timingAdvance = ss->timingAdvance;
-    DBG("[gsm] reg=%d%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(gsm->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(gsm->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(gsm->lac, ",lac=%d"),
-        binder_cell_info_int_format(gsm->cid, ",cid=%d"),
-        binder_cell_info_int_format(gsm->arfcn, ",arfcn=%d"),
-        binder_cell_info_int_format(gsm->bsic, ",bsic=%d"),
-        binder_cell_info_int_format(gsm->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(gsm->bitErrorRate, ",err=%d"),
-        binder_cell_info_int_format(gsm->timingAdvance, ",t=%d"));
+    switch (type) {
+    case OFONO_CELL_TYPE_GSM:
+        binder_cell_info_invalidate(&cell->info.gsm, sizeof(cell->info.gsm));
+        break;
+    case OFONO_CELL_TYPE_WCDMA:
+        binder_cell_info_invalidate(&cell->info.wcdma,
+            sizeof(cell->info.wcdma));
+        break;
+    case OFONO_CELL_TYPE_LTE:
+        binder_cell_info_invalidate(&cell->info.lte, sizeof(cell->info.lte));
+        break;
+    case OFONO_CELL_TYPE_NR:
+        binder_cell_info_invalidate_nr(&cell->info.nr);
+        break;
+    }
     return cell;
 }
 
 static
-struct
-ofono_cell*
-binder_cell_info_new_cell_wcdma(
-    gboolean registered,
-    const RadioCellIdentityWcdma* id,
-    const RadioSignalStrengthWcdma* ss)
+void
+binder_cell_info_log_cell(
+    const struct ofono_cell* cell)
 {
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_wcdma* wcdma = &cell->info.wcdma;
+    const gboolean registered = cell->registered;
+    const struct ofono_cell_info_gsm* gsm;
+    const struct ofono_cell_info_wcdma* wcdma;
+    const struct ofono_cell_info_lte* lte;
+    const struct ofono_cell_info_nr* nr;
+
+    switch (cell->type) {
+    case OFONO_CELL_TYPE_GSM:
+        gsm = &cell->info.gsm;
+        DBG("[gsm] reg=%d%s%s%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(gsm->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(gsm->mnc, ",mnc=%d"),
+            binder_cell_info_int_format(gsm->lac, ",lac=%d"),
+            binder_cell_info_int_format(gsm->cid, ",cid=%d"),
+            binder_cell_info_int_format(gsm->arfcn, ",arfcn=%d"),
+            binder_cell_info_int_format(gsm->bsic, ",bsic=%d"),
+            binder_cell_info_int_format(gsm->signalStrength, ",strength=%d"),
+            binder_cell_info_int_format(gsm->bitErrorRate, ",err=%d"),
+            binder_cell_info_int_format(gsm->timingAdvance, ",t=%d"));
+        break;
+    case OFONO_CELL_TYPE_WCDMA:
+        wcdma = &cell->info.wcdma;
+        DBG("[wcdma] reg=%d%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(wcdma->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(wcdma->mnc, ",mnc=%d"),
+            binder_cell_info_int_format(wcdma->lac, ",lac=%d"),
+            binder_cell_info_int_format(wcdma->cid, ",cid=%d"),
+            binder_cell_info_int_format(wcdma->psc, ",psc=%d"),
+            binder_cell_info_int_format(wcdma->signalStrength,
+                ",strength=%d"),
+            binder_cell_info_int_format(wcdma->bitErrorRate, ",err=%d"));
+        break;
+    case OFONO_CELL_TYPE_LTE:
+        lte = &cell->info.lte;
+        DBG("[lte] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(lte->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(lte->mnc, ",mnc=%d"),
+            binder_cell_info_int_format(lte->ci, ",ci=%d"),
+            binder_cell_info_int_format(lte->pci, ",pci=%d"),
+            binder_cell_info_int_format(lte->tac, ",tac=%d"),
+            binder_cell_info_int_format(lte->signalStrength, ",strength=%d"),
+            binder_cell_info_int_format(lte->rsrp, ",rsrp=%d"),
+            binder_cell_info_int_format(lte->rsrq, ",rsrq=%d"),
+            binder_cell_info_int_format(lte->rssnr, ",rssnr=%d"),
+            binder_cell_info_int_format(lte->cqi, ",cqi=%d"),
+            binder_cell_info_int_format(lte->timingAdvance, ",t=%d"));
+        break;
+    case OFONO_CELL_TYPE_NR:
+        nr = &cell->info.nr;
+        DBG("[nr] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(nr->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(nr->mnc, ",mnc=%d"),
+            binder_cell_info_int64_format(nr->nci, ",nci=%" G_GINT64_FORMAT),
+            binder_cell_info_int_format(nr->pci, ",pci=%d"),
+            binder_cell_info_int_format(nr->tac, ",tac=%d"),
+            binder_cell_info_int_format(nr->ssRsrp, ",ssRsrp=%d"),
+            binder_cell_info_int_format(nr->ssRsrq, ",ssRsrq=%d"),
+            binder_cell_info_int_format(nr->ssSinr, ",ssSinr=%d"),
+            binder_cell_info_int_format(nr->csiRsrp, ",csiRsrp=%d"),
+            binder_cell_info_int_format(nr->csiRsrq, ",csiRsrq=%d"),
+            binder_cell_info_int_format(nr->csiSinr, ",csiSinr=%d"));
+        break;
+    }
+}
 
-    cell->type = OFONO_CELL_TYPE_WCDMA;
-    cell->registered = registered;
+/*==========================================================================*
+ * HIDL layouts
+ *
+ * HIDL structures are mapped directly into memory, each IRadio version
+ * is described by a table of field offsets and sizes. Every field has
+ * an "invalid" sentinel which gets mapped to OFONO_CELL_INVALID_VALUE
+ * (or OFONO_CELL_INVALID_VALUE_INT64 for 64-bit fields).
+ *==========================================================================*/
 
-    binder_cell_info_invalidate(wcdma, sizeof(*wcdma));
-    gutil_parse_int(id->mcc.data.str, 10, &wcdma->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &wcdma->mnc);
-    wcdma->lac = id->lac;
-    wcdma->cid = id->cid;
-    wcdma->psc = id->psc;
-    wcdma->uarfcn = id->uarfcn;
-    wcdma->signalStrength = ss->signalStrength;
-    wcdma->bitErrorRate = ss->bitErrorRate;
-    DBG("[wcdma] reg=%d%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(wcdma->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(wcdma->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(wcdma->lac, ",lac=%d"),
-        binder_cell_info_int_format(wcdma->cid, ",cid=%d"),
-        binder_cell_info_int_format(wcdma->psc, ",psc=%d"),
-        binder_cell_info_int_format(wcdma->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(wcdma->bitErrorRate, ",err=%d"));
-    return cell;
-}
+typedef enum binder_cell_info_field_kind {
+    FIELD_INT,          /* Integer, 1 to 8 bytes */
+    FIELD_STRING        /* GBinderHidlString containing an integer */
+} BINDER_CELL_INFO_FIELD_KIND;
+
+typedef struct binder_cell_info_field {
+    guint16 src;        /* Offset of the field in the HIDL structure */
+    guint8 size;        /* Size of the HIDL field */
+    guint8 kind;        /* BINDER_CELL_INFO_FIELD_KIND */
+    guint16 dst;        /* Offset of the field in struct ofono_cell */
+    guint8 dst_size;    /* Size of the ofono_cell field (4 or 8) */
+    gint64 invalid;     /* Invalid value of the HIDL field */
+} BinderCellInfoField;
+
+typedef struct binder_cell_info_hidl_type {
+    gint32 hal_type;
+    enum ofono_cell_type type;
+    gssize vec;         /* Offset of the hidl_vec, negative if inline */
+    guint elem_size;    /* Size of the vector element */
+    const BinderCellInfoField* fields;
+    guint nfields;
+} BinderCellInfoHidlType;
+
+typedef struct binder_cell_info_hidl_layout {
+    const char* name;
+    RADIO_RESP resp;
+    RADIO_IND ind;
+    guint cell_size;
+    guint16 type_offset;
+    guint8 type_size;
+    guint16 reg_offset;
+    guint8 reg_size;
+    const BinderCellInfoHidlType* types;
+    guint ntypes;
+} BinderCellInfoHidlLayout;
+
+#define MEMBER_SIZE(type,member) sizeof(((type*)0)->member)
+#define CELL_OFFSET(member) G_STRUCT_OFFSET(struct ofono_cell, info.member)
+#define CELL_SIZE(member) MEMBER_SIZE(struct ofono_cell, info.member)
+
+#define FIELD_(elem,src,dst,kind,invalid) { G_STRUCT_OFFSET(elem,src), \
+    MEMBER_SIZE(elem,src), kind, CELL_OFFSET(dst), CELL_SIZE(dst), invalid }
+#define INT_FIELD(elem,src,dst) \
+    FIELD_(elem,src,dst,FIELD_INT,OFONO_CELL_INVALID_VALUE)
+#define INT_FIELD2(elem,src,dst,invalid) \
+    FIELD_(elem,src,dst,FIELD_INT,invalid)
+#define INT64_FIELD(elem,src,dst) \
+    FIELD_(elem,src,dst,FIELD_INT,OFONO_CELL_INVALID_VALUE_INT64)
+#define STR_FIELD(elem,src,dst) \
+    FIELD_(elem,src,dst,FIELD_STRING,0)
+
+#define GSM_FIELDS(elem,id,ss) \
+    STR_FIELD(elem, id.mcc, gsm.mcc), \
+    STR_FIELD(elem, id.mnc, gsm.mnc), \
+    INT_FIELD(elem, id.lac, gsm.lac), \
+    INT_FIELD(elem, id.cid, gsm.cid), \
+    INT_FIELD(elem, id.arfcn, gsm.arfcn), \
+    INT_FIELD2(elem, id.bsic, gsm.bsic, 0xff), \
+    INT_FIELD(elem, ss.signalStrength, gsm.signalStrength), \
+    INT_FIELD(elem, ss.bitErrorRate, gsm.bitErrorRate), \
+    INT_FIELD(elem, ss.timingAdvance, gsm.timingAdvance)
+
+#define WCDMA_FIELDS(elem,id,ss) \
+    STR_FIELD(elem, id.mcc, wcdma.mcc), \
+    STR_FIELD(elem, id.mnc, wcdma.mnc), \
+    INT_FIELD(elem, id.lac, wcdma.lac), \
+    INT_FIELD(elem, id.cid, wcdma.cid), \
+    INT_FIELD(elem, id.psc, wcdma.psc), \
+    INT_FIELD(elem, id.uarfcn, wcdma.uarfcn), \
+    INT_FIELD(elem, ss.signalStrength, wcdma.signalStrength), \
+    INT_FIELD(elem, ss.bitErrorRate, wcdma.bitErrorRate)
+
+#define LTE_FIELDS(elem,id,ss) \
+    STR_FIELD(elem, id.mcc, lte.mcc), \
+    STR_FIELD(elem, id.mnc, lte.mnc), \
+    INT_FIELD(elem, id.ci, lte.ci), \
+    INT_FIELD(elem, id.pci, lte.pci), \
+    INT_FIELD(elem, id.tac, lte.tac), \
+    INT_FIELD(elem, id.earfcn, lte.earfcn), \
+    INT_FIELD(elem, ss.signalStrength, lte.signalStrength), \
+    INT_FIELD(elem, ss.rsrp, lte.rsrp), \
+    INT_FIELD(elem, ss.rsrq, lte.rsrq), \
+    INT_FIELD(elem, ss.rssnr, lte.rssnr), \
+    INT_FIELD(elem, ss.cqi, lte.cqi), \
+    INT_FIELD(elem, ss.timingAdvance, lte.timingAdvance)
+
+#define NR_FIELDS(elem,id,ss) \
+    STR_FIELD(elem, id.mcc, nr.mcc), \
+    STR_FIELD(elem, id.mnc, nr.mnc), \
+    INT64_FIELD(elem, id.nci, nr.nci), \
+    INT_FIELD(elem, id.pci, nr.pci), \
+    INT_FIELD(elem, id.tac, nr.tac), \
+    INT_FIELD(elem, id.nrarfcn, nr.nrarfcn), \
+    INT_FIELD(elem, ss.ssRsrp, nr.ssRsrp), \
+    INT_FIELD(elem, ss.ssRsrq, nr.ssRsrq), \
+    INT_FIELD(elem, ss.ssSinr, nr.ssSinr), \
+    INT_FIELD(elem, ss.csiRsrp, nr.csiRsrp), \
+    INT_FIELD(elem, ss.csiRsrq, nr.csiRsrq), \
+    INT_FIELD(elem, ss.csiSinr, nr.csiSinr)
+
+#define HIDL_VEC_TYPE(hal,type,cell,vec,elem,fields) { hal, type, \
+    G_STRUCT_OFFSET(cell,vec), sizeof(elem), fields, G_N_ELEMENTS(fields) }
+#define HIDL_INLINE_TYPE(hal,type,fields) { hal, type, -1, 0, \
+    fields, G_N_ELEMENTS(fields) }
+#define HIDL_LAYOUT(name,resp,ind,cell,types) { name, resp, ind, \
+    sizeof(cell), G_STRUCT_OFFSET(cell,cellInfoType), \
+    MEMBER_SIZE(cell,cellInfoType), G_STRUCT_OFFSET(cell,registered), \
+    MEMBER_SIZE(cell,registered), types, G_N_ELEMENTS(types) }
+
+/* IRadio 1.0 */
+
+static const BinderCellInfoField binder_cell_info_gsm_1_0[] = {
+    GSM_FIELDS(RadioCellInfoGsm, cellIdentityGsm, signalStrengthGsm)
+};
 
-static
-struct ofono_cell*
-binder_cell_info_new_cell_lte(
-    gboolean registered,
-    const RadioCellIdentityLte* id,
-    const RadioSignalStrengthLte* ss)
-{
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_lte* lte = &cell->info.lte;
+static const BinderCellInfoField binder_cell_info_wcdma_1_0[] = {
+    WCDMA_FIELDS(RadioCellInfoWcdma, cellIdentityWcdma, signalStrengthWcdma)
+};
 
-    cell->type = OFONO_CELL_TYPE_LTE;
-    cell->registered = registered;
+static const BinderCellInfoField binder_cell_info_lte_1_0[] = {
+    LTE_FIELDS(RadioCellInfoLte, cellIdentityLte, signalStrengthLte)
+};
 
-    binder_cell_info_invalidate(lte, sizeof(*lte));
-    gutil_parse_int(id->mcc.data.str, 10, &lte->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &lte->mnc);
-    lte->ci = id->ci;
-    lte->pci = id->pci;
-    lte->tac = id->tac;
-    lte->earfcn = id->earfcn;
-    lte->signalStrength = ss->signalStrength;
-    lte->rsrp = ss->rsrp;
-    lte->rsrq = ss->rsrq;
-    lte->rssnr = ss->rssnr;
-    lte->cqi = ss->cqi;
-    lte->timingAdvance = ss->timingAdvance;
-    DBG("[lte] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(lte->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(lte->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(lte->ci, ",ci=%d"),
-        binder_cell_info_int_format(lte->pci, ",pci=%d"),
-        binder_cell_info_int_format(lte->tac, ",tac=%d"),
-        binder_cell_info_int_format(lte->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(lte->rsrp, ",rsrp=%d"),
-        binder_cell_info_int_format(lte->rsrq, ",rsrq=%d"),
-        binder_cell_info_int_format(lte->rssnr, ",rssnr=%d"),
-        binder_cell_info_int_format(lte->cqi, ",cqi=%d"),
-        binder_cell_info_int_format(lte->timingAdvance, ",t=%d"));
-    return cell;
-}
-static
-struct ofono_cell*
-binder_cell_info_new_cell_nr(
-    gboolean registered,
-    const RadioCellIdentityNr* id,
-    const RadioSignalStrengthNr* ss)
-{
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_nr* nr = &cell->info.nr;
+static const BinderCellInfoHidlType binder_cell_info_types_1_0[] = {
+    HIDL_VEC_TYPE(RADIO_CELL_INFO_GSM, OFONO_CELL_TYPE_GSM,
+        RadioCellInfo, gsm, RadioCellInfoGsm,
+        binder_cell_info_gsm_1_0),
+    HIDL_VEC_TYPE(RADIO_CELL_INFO_WCDMA, OFONO_CELL_TYPE_WCDMA,
+        RadioCellInfo, wcdma, RadioCellInfoWcdma,
+        binder_cell_info_wcdma_1_0),
+    HIDL_VEC_TYPE(RADIO_CELL_INFO_LTE, OFONO_CELL_TYPE_LTE,
+        RadioCellInfo, lte, RadioCellInfoLte,
+        binder_cell_info_lte_1_0)
+};
 
-    cell->type = OFONO_CELL_TYPE_NR;
-    cell->registered = registered;
+/* IRadio 1.2 */
 
-    binder_cell_info_invalidate_nr(nr);
-    gutil_parse_int(id->mcc.data.str, 10, &nr->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &nr->mnc);
-    nr->nci = id->nci;
-    nr->pci = id->pci;
-    nr->tac = id->tac;
-    nr->nrarfcn = id->nrarfcn;
-    nr->ssRsrp = ss->ssRsrp;
-    nr->ssRsrq = ss->ssRsrq;
-    nr->ssSinr = ss->ssSinr;
-    nr->csiRsrp = ss->csiRsrp;
-    nr->csiRsrq = ss->csiRsrq;
-    nr->csiSinr = ss->csiSinr;
-    DBG("[nr] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(nr->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(nr->mnc, ",mnc=%d"),
-        binder_cell_info_int64_format(nr->nci, ",nci=%" G_GINT64_FORMAT),
-        binder_cell_info_int_format(nr->pci, ",pci=%d"),
-        binder_cell_info_int_format(nr->tac, ",tac=%d"),
-        binder_cell_info_int_format(nr->ssRsrp, ",ssRsrp=%d"),
-        binder_cell_info_int_format(nr->ssRsrq, ",ssRsrq=%d"),
-        binder_cell_info_int_format(nr->ssSinr, ",ssSinr=%d"),
-        binder_cell_info_int_format(nr->csiRsrp, ",csiRsrp=%d"),
-        binder_cell_info_int_format(nr->csiRsrq, ",csiRsrq=%d"),
-        binder_cell_info_int_format(nr->csiSinr, ",csiSinr=%d"));
-    return cell;
-}
+static const BinderCellInfoField binder_cell_info_gsm_1_2[] = {
+    GSM_FIELDS(RadioCellInfoGsm_1_2, cellIdentityGsm.base,
+        signalStrengthGsm)
+};
 
-static
-struct ofono_cell*
-binder_cell_info_new_cell_gsm_aidl(
-    gboolean registered,
-    GBinderReader* reader)
-{
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_gsm* gsm = &cell->info.gsm;
-    gsize data_read;
-    gsize initial_size;
-    gsize parcel_size;
+static const BinderCellInfoField binder_cell_info_wcdma_1_2[] = {
+    WCDMA_FIELDS(RadioCellInfoWcdma_1_2, cellIdentityWcdma.base,
+        signalStrengthWcdma.base)
+};
 
-    cell->type = OFONO_CELL_TYPE_GSM;
-    cell->registered = registered;
+static const BinderCellInfoField binder_cell_info_lte_1_2[] = {
+    LTE_FIELDS(RadioCellInfoLte_1_2, cellIdentityLte.base,
+        signalStrengthLte)
+};
 
-    binder_cell_info_invalidate(gsm, sizeof(*gsm));
-    /* CellInfoGsm */
-    if (binder_read_parcelable_size(reader)) {
-        /* CellIdentityGsm */
-        parcel_size = binder_read_parcelable_size(reader);
-        initial_size = gbinder_reader_bytes_read(reader);
-        binder_read_string16_parse_int(reader, &gsm->mcc);
-        binder_read_string16_parse_int(reader, &gsm->mnc);
-        gbinder_reader_read_int32(reader, &gsm->lac);
-        gbinder_reader_read_int32(reader, &gsm->cid);
-        gbinder_reader_read_int32(reader, &gsm->arfcn);
-        gbinder_reader_read_int32(reader, &gsm->bsic);
-        data_read = gbinder_reader_bytes_read(reader) - initial_size;
-        while (data_read < parcel_size) {
-            gbinder_reader_read_uint32(reader, NULL);
-            data_read += sizeof(guint32);
-        }
+static const BinderCellInfoHidlType binder_cell_info_types_1_2[] = {
+    HIDL_VEC_TYPE(RADIO_CELL_INFO_GSM, OFONO_CELL_TYPE_GSM,
+        RadioCellInfo_1_2, gsm, RadioCellInfoGsm_1_2,
+        binder_cell_info_gsm_1_2),
+    HIDL_VEC_TYPE(RADIO_CELL_INFO_WCDMA, OFONO_CELL_TYPE_WCDMA,
+        RadioCellInfo_1_2, wcdma, RadioCellInfoWcdma_1_2,
+        binder_cell_info_wcdma_1_2),
+    HIDL_VEC_TYPE(RADIO_CELL_INFO_LTE, OFONO_CELL_TYPE_LTE,
+        RadioCellInfo_1_2, lte, RadioCellInfoLte_1_2,
+        binder_cell_info_lte_1_2)
+};
 
-        /* SignalStrengthGsm */
-        binder_read_parcelable_size(reader);
-        gbinder_reader_read_int32(reader, &gsm->signalStrength);
-        gbinder_reader_read_int32(reader, &gsm->bitErrorRate);
-        gbinder_reader_read_int32(reader, &gsm->timingAdvance);
-    }
+/* IRadio 1.4 */
 
-    DBG("[gsm] reg=%d%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(gsm->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(gsm->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(gsm->lac, ",lac=%d"),
-        binder_cell_info_int_format(gsm->cid, ",cid=%d"),
-        binder_cell_info_int_format(gsm->arfcn, ",arfcn=%d"),
-        binder_cell_info_int_format(gsm->bsic, ",bsic=%d"),
-        binder_cell_info_int_format(gsm->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(gsm->bitErrorRate, ",err=%d"),
-        binder_cell_info_int_format(gsm->timingAdvance, ",t=%d"));
-    return cell;
-}
+static const BinderCellInfoField binder_cell_info_gsm_1_4[] = {
+    GSM_FIELDS(RadioCellInfo_1_4, info.gsm.cellIdentityGsm.base,
+        info.gsm.signalStrengthGsm)
+};
 
-static
-struct
-ofono_cell*
-binder_cell_info_new_cell_wcdma_aidl(
-    gboolean registered,
-    GBinderReader* reader)
-{
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_wcdma* wcdma = &cell->info.wcdma;
-    gsize data_read;
-    gsize initial_size;
-    gsize parcel_size;
+static const BinderCellInfoField binder_cell_info_wcdma_1_4[] = {
+    WCDMA_FIELDS(RadioCellInfo_1_4, info.wcdma.cellIdentityWcdma.base,
+        info.wcdma.signalStrengthWcdma.base)
+};
 
-    cell->type = OFONO_CELL_TYPE_WCDMA;
-    cell->registered = registered;
+static const BinderCellInfoField binder_cell_info_lte_1_4[] = {
+    LTE_FIELDS(RadioCellInfo_1_4, info.lte.base.cellIdentityLte.base,
+        info.lte.base.signalStrengthLte)
+};
 
-    binder_cell_info_invalidate(wcdma, sizeof(*wcdma));
-
-    /* CellInfoWcdma */
-    if (binder_read_parcelable_size(reader)) {
-        /* CellIdentityWcdma */
-        parcel_size = binder_read_parcelable_size(reader);
-        initial_size = gbinder_reader_bytes_read(reader);
-        binder_read_string16_parse_int(reader, &wcdma->mcc);
-        binder_read_string16_parse_int(reader, &wcdma->mnc);
-        gbinder_reader_read_int32(reader, &wcdma->lac);
-        gbinder_reader_read_int32(reader, &wcdma->cid);
-        gbinder_reader_read_int32(reader, &wcdma->psc);
-        gbinder_reader_read_int32(reader, &wcdma->uarfcn);
-        data_read = gbinder_reader_bytes_read(reader) - initial_size;
-        while (data_read < parcel_size) {
-            gbinder_reader_read_uint32(reader, NULL);
-            data_read += sizeof(guint32);
-        }
+static const BinderCellInfoField binder_cell_info_nr_1_4[] = {
+    NR_FIELDS(RadioCellInfo_1_4, info.nr.cellIdentity,
+        info.nr.signalStrength)
+};
 
-        /* SignalStrengthWcdma */
-        binder_read_parcelable_size(reader);
-        gbinder_reader_read_int32(reader, &wcdma->signalStrength);
-        gbinder_reader_read_int32(reader, &wcdma->bitErrorRate);
-        gbinder_reader_read_int32(reader, NULL); /* rscp */
-        gbinder_reader_read_int32(reader, NULL); /* ecno */
-    }
+static const BinderCellInfoHidlType binder_cell_info_types_1_4[] = {
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_4_GSM, OFONO_CELL_TYPE_GSM,
+        binder_cell_info_gsm_1_4),
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_4_WCDMA, OFONO_CELL_TYPE_WCDMA,
+        binder_cell_info_wcdma_1_4),
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_4_LTE, OFONO_CELL_TYPE_LTE,
+        binder_cell_info_lte_1_4),
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_4_NR, OFONO_CELL_TYPE_NR,
+        binder_cell_info_nr_1_4)
+};
 
-    DBG("[wcdma] reg=%d%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(wcdma->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(wcdma->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(wcdma->lac, ",lac=%d"),
-        binder_cell_info_int_format(wcdma->cid, ",cid=%d"),
-        binder_cell_info_int_format(wcdma->psc, ",psc=%d"),
-        binder_cell_info_int_format(wcdma->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(wcdma->bitErrorRate, ",err=%d"));
-    return cell;
-}
+/* IRadio 1.5 */
 
-static
-struct ofono_cell*
-binder_cell_info_new_cell_lte_aidl(
-    gboolean registered,
-    GBinderReader* reader)
-{
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_lte* lte = &cell->info.lte;
-    gsize data_read;
-    gsize initial_size;
-    gsize parcel_size;
+static const BinderCellInfoField binder_cell_info_gsm_1_5[] = {
+    GSM_FIELDS(RadioCellInfo_1_5, info.gsm.cellIdentityGsm.base.base,
+        info.gsm.signalStrengthGsm)
+};
 
-    cell->type = OFONO_CELL_TYPE_LTE;
-    cell->registered = registered;
+static const BinderCellInfoField binder_cell_info_wcdma_1_5[] = {
+    WCDMA_FIELDS(RadioCellInfo_1_5, info.wcdma.cellIdentityWcdma.base.base,
+        info.wcdma.signalStrengthWcdma.base)
+};
 
-    binder_cell_info_invalidate(lte, sizeof(*lte));
-
-    /* CellInfoLte */
-    if (binder_read_parcelable_size(reader)) {
-        /* CellIdentityLte */
-        parcel_size = binder_read_parcelable_size(reader);
-        initial_size = gbinder_reader_bytes_read(reader);
-        binder_read_string16_parse_int(reader, &lte->mcc);
-        binder_read_string16_parse_int(reader, &lte->mnc);
-        gbinder_reader_read_int32(reader, &lte->ci);
-        gbinder_reader_read_int32(reader, &lte->pci);
-        gbinder_reader_read_int32(reader, &lte->tac);
-        gbinder_reader_read_int32(reader, &lte->earfcn);
-        data_read = gbinder_reader_bytes_read(reader) - initial_size;
-        while (data_read < parcel_size) {
-            gbinder_reader_read_uint32(reader, NULL);
-            data_read += sizeof(guint32);
-        }
+static const BinderCellInfoField binder_cell_info_lte_1_5[] = {
+    LTE_FIELDS(RadioCellInfo_1_5, info.lte.cellIdentityLte.base.base,
+        info.lte.signalStrengthLte)
+};
 
-        /* SignalStrengthLte */
-        binder_read_parcelable_size(reader);
-        gbinder_reader_read_int32(reader, &lte->signalStrength);
-        gbinder_reader_read_int32(reader, &lte->rsrp);
-        gbinder_reader_read_int32(reader, &lte->rsrq);
-        gbinder_reader_read_int32(reader, &lte->rssnr);
-        gbinder_reader_read_int32(reader, &lte->cqi);
-        gbinder_reader_read_int32(reader, &lte->timingAdvance);
-        gbinder_reader_read_int32(reader, NULL);
-    }
+static const BinderCellInfoField binder_cell_info_nr_1_5[] = {
+    NR_FIELDS(RadioCellInfo_1_5, info.nr.cellIdentityNr.base,
+        info.nr.signalStrengthNr)
+};
 
-    DBG("[lte] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(lte->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(lte->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(lte->ci, ",ci=%d"),
-        binder_cell_info_int_format(lte->pci, ",pci=%d"),
-        binder_cell_info_int_format(lte->tac, ",tac=%d"),
-        binder_cell_info_int_format(lte->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(lte->rsrp, ",rsrp=%d"),
-        binder_cell_info_int_format(lte->rsrq, ",rsrq=%d"),
-        binder_cell_info_int_format(lte->rssnr, ",rssnr=%d"),
-        binder_cell_info_int_format(lte->cqi, ",cqi=%d"),
-        binder_cell_info_int_format(lte->timingAdvance, ",t=%d"));
-    return cell;
+static const BinderCellInfoHidlType binder_cell_info_types_1_5[] = {
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_5_GSM, OFONO_CELL_TYPE_GSM,
+        binder_cell_info_gsm_1_5),
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_5_WCDMA, OFONO_CELL_TYPE_WCDMA,
+        binder_cell_info_wcdma_1_5),
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_5_LTE, OFONO_CELL_TYPE_LTE,
+        binder_cell_info_lte_1_5),
+    HIDL_INLINE_TYPE(RADIO_CELL_INFO_1_5_NR, OFONO_CELL_TYPE_NR,
+        binder_cell_info_nr_1_5)
+};
+
+static const BinderCellInfoHidlLayout binder_cell_info_hidl_layouts[] = {
+    HIDL_LAYOUT("cellInfoList", RADIO_RESP_GET_CELL_INFO_LIST,
+        RADIO_IND_CELL_INFO_LIST, RadioCellInfo,
+        binder_cell_info_types_1_0),
+    HIDL_LAYOUT("cellInfoList_1_2", RADIO_RESP_GET_CELL_INFO_LIST_1_2,
+        RADIO_IND_CELL_INFO_LIST_1_2, RadioCellInfo_1_2,
+        binder_cell_info_types_1_2),
+    HIDL_LAYOUT("cellInfoList_1_4", RADIO_RESP_GET_CELL_INFO_LIST_1_4,
+        RADIO_IND_CELL_INFO_LIST_1_4, RadioCellInfo_1_4,
+        binder_cell_info_types_1_4),
+    HIDL_LAYOUT("cellInfoList_1_5", RADIO_RESP_GET_CELL_INFO_LIST_1_5,
+        RADIO_IND_CELL_INFO_LIST_1_5, RadioCellInfo_1_5,
+        binder_cell_info_types_1_5)
+};
+
+static inline
+gint64
+binder_cell_info_hidl_int(
+    const guint8* ptr,
+    guint size)
+{
+    switch (size) {
+    case 1: return *ptr;
+    case 2: return *(const gint16*)ptr;
+    case 8: return *(const gint64*)ptr;
+    default: return *(const gint32*)ptr;
+    }
 }
+
 static
 struct ofono_cell*
-binder_cell_info_new_cell_nr_aidl(
+binder_cell_info_decode_hidl_cell(
+    BinderCellInfo* self,
+    const BinderCellInfoHidlType* t,
     gboolean registered,
-    GBinderReader* reader)
+    const guint8* elem)
 {
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_nr* nr = &cell->info.nr;
-    gsize data_read;
-    gsize initial_size;
-    gsize parcel_size;
-
-    cell->type = OFONO_CELL_TYPE_NR;
-    cell->registered = registered;
-
-    binder_cell_info_invalidate_nr(nr);
-
-    /* CellInfoNr */
-    if (binder_read_parcelable_size(reader)) {
-        /* CellIdentityNr */
-        parcel_size = binder_read_parcelable_size(reader);
-        initial_size = gbinder_reader_bytes_read(reader);
-        binder_read_string16_parse_int(reader, &nr->mcc);
-        binder_read_string16_parse_int(reader, &nr->mnc);
-        gbinder_reader_read_int64(reader, &nr->nci);
-        gbinder_reader_read_int32(reader, &nr->pci);
-        gbinder_reader_read_int32(reader, &nr->tac);
-        gbinder_reader_read_int32(reader, &nr->nrarfcn);
-        data_read = gbinder_reader_bytes_read(reader) - initial_size;
-        while (data_read < parcel_size) {
-            gbinder_reader_read_uint32(reader, NULL);
-            data_read += sizeof(guint32);
-        }
-
-        /* SignalStrengthNr */
-        parcel_size = binder_read_parcelable_size(reader);
-        initial_size = gbinder_reader_bytes_read(reader);
-        gbinder_reader_read_int32(reader, &nr->ssRsrp);
-        gbinder_reader_read_int32(reader, &nr->ssRsrp);
-        gbinder_reader_read_int32(reader, &nr->ssSinr);
-        gbinder_reader_read_int32(reader, &nr->csiRsrp);
-        gbinder_reader_read_int32(reader, &nr->csiRsrq);
-        gbinder_reader_read_int32(reader, &nr->csiSinr);
-        data_read = gbinder_reader_bytes_read(reader) - initial_size;
-        while (data_read < parcel_size) {
-            gbinder_reader_read_uint32(reader, NULL);
-            data_read += sizeof(guint32);
+    struct ofono_cell* cell = binder_cell_info_new_cell_type(self, t->type,
+        registered);
+    guint8* base = (guint8*)cell;
+    const BinderCellInfoField* f = t->fields;
+    const BinderCellInfoField* end = f + t->nfields;
+
+    for (; f < end; f++) {
+        const guint8* src = elem + f->src;
+        guint8* dst = base + f->dst;
+
+        if (f->kind == FIELD_STRING) {
+            gutil_parse_int(((const GBinderHidlString*)src)->data.str, 10,
+                (int*)dst);
+        } else {
+            const gint64 value = binder_cell_info_hidl_int(src, f->size);
+
+            if (f->dst_size == sizeof(gint64)) {
+                *(gint64*)dst = (value == f->invalid) ?
+                    OFONO_CELL_INVALID_VALUE_INT64 : value;
+            } else {
+                *(int*)dst = (value == f->invalid) ?
+                    OFONO_CELL_INVALID_VALUE : (int)value;
+            }
         }
     }
 
-    DBG("[nr] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(nr->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(nr->mnc, ",mnc=%d"),
-        binder_cell_info_int64_format(nr->nci, ",nci=%" G_GINT64_FORMAT),
-        binder_cell_info_int_format(nr->pci, ",pci=%d"),
-        binder_cell_info_int_format(nr->tac, ",tac=%d"),
-        binder_cell_info_int_format(nr->ssRsrp, ",ssRsrp=%d"),
-        binder_cell_info_int_format(nr->ssRsrq, ",ssRsrq=%d"),
-        binder_cell_info_int_format(nr->ssSinr, ",ssSinr=%d"),
-        binder_cell_info_int_format(nr->csiRsrp, ",csiRsrp=%d"),
-        binder_cell_info_int_format(nr->csiRsrq, ",csiRsrq=%d"),
-        binder_cell_info_int_format(nr->csiSinr, ",csiSinr=%d"));
+    binder_cell_info_log_cell(cell);
     return cell;
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_0(
-    const RadioCellInfo* cells,
-    gsize count)
+const BinderCellInfoHidlType*
+binder_cell_info_hidl_type(
+    const BinderCellInfoHidlLayout* layout,
+    gint32 hal_type)
 {
-    gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
+    guint i;
 
-    for (i = 0; i < count; i++) {
-        const RadioCellInfo* cell = cells + i;
-        const gboolean reg = cell->registered;
-        const RadioCellInfoGsm* gsm;
-        const RadioCellInfoLte* lte;
-        const RadioCellInfoWcdma* wcdma;
-        guint j;
-
-        switch (cell->cellInfoType) {
-        case RADIO_CELL_INFO_GSM:
-            gsm = cell->gsm.data.ptr;
-            for (j = 0; j < cell->gsm.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_gsm(reg,
-                    &gsm[j].cellIdentityGsm,
-                    &gsm[j].signalStrengthGsm));
-            }
-            continue;
-        case RADIO_CELL_INFO_LTE:
-            lte = cell->lte.data.ptr;
-            for (j = 0; j < cell->lte.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_lte(reg,
-                    &lte[j].cellIdentityLte,
-                    &lte[j].signalStrengthLte));
-            }
-            continue;
-        case RADIO_CELL_INFO_WCDMA:
-            wcdma = cell->wcdma.data.ptr;
-            for (j = 0; j < cell->wcdma.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(reg,
-                    &wcdma[j].cellIdentityWcdma,
-                    &wcdma[j].signalStrengthWcdma));
-            }
-            continue;
-        case RADIO_CELL_INFO_CDMA:
-        case RADIO_CELL_INFO_TD_SCDMA:
-            break;
+    for (i = 0; i < layout->ntypes; i++) {
+        if (layout->types[i].hal_type == hal_type) {
+            return layout->types + i;
         }
-        DBG("unsupported cell type %d", cell->cellInfoType);
     }
-    return l;
+    return NULL;
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_2(
-    const RadioCellInfo_1_2* cells,
-    gsize count)
+void
+binder_cell_info_decode_hidl(
+    BinderCellInfo* self,
+    const BinderCellInfoHidlLayout* layout,
+    GBinderReader* reader)
 {
-    gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
-
-    for (i = 0; i < count; i++) {
-        const RadioCellInfo_1_2* cell = cells + i;
-        const gboolean registered = cell->registered;
-        const RadioCellInfoGsm_1_2* gsm;
-        const RadioCellInfoLte_1_2* lte;
-        const RadioCellInfoWcdma_1_2* wcdma;
-        guint j;
+    gsize i, count = 0;
+    const guint8* cells = gbinder_reader_read_hidl_vec1(reader, &count,
+        layout->cell_size);
 
-        switch (cell->cellInfoType) {
-        case RADIO_CELL_INFO_GSM:
-            gsm = cell->gsm.data.ptr;
-            for (j = 0; j < cell->gsm.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_gsm(registered,
-                    &gsm[j].cellIdentityGsm.base,
-                    &gsm[j].signalStrengthGsm));
-            }
-            continue;
-        case RADIO_CELL_INFO_LTE:
-            lte = cell->lte.data.ptr;
-            for (j = 0; j < cell->lte.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_lte(registered,
-                    &lte[j].cellIdentityLte.base,
-                    &lte[j].signalStrengthLte));
-            }
-            continue;
-        case RADIO_CELL_INFO_WCDMA:
-            wcdma = cell->wcdma.data.ptr;
-            for (j = 0; j < cell->wcdma.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(registered,
-                    &wcdma[j].cellIdentityWcdma.base,
-                    &wcdma[j].signalStrengthWcdma.base));
+    if (cells) {
+        GPtrArray* l = binder_cell_info_update_list(self);
+
+        for (i = 0; i < count; i++) {
+            const guint8* info = cells + i * layout->cell_size;
+            const gint32 hal_type = (gint32) binder_cell_info_hidl_int
+                (info + layout->type_offset, layout->type_size);
+            const gboolean registered = binder_cell_info_hidl_int
+                (info + layout->reg_offset, layout->reg_size) != 0;
+            const BinderCellInfoHidlType* t =
+                binder_cell_info_hidl_type(layout, hal_type);
+
+            if (!t) {
+                DBG("unsupported cell type %d", hal_type);
+            } else if (t->vec >= 0) {
+                const GBinderHidlVec* vec = (const GBinderHidlVec*)
+                    (info + t->vec);
+                const guint8* elem = vec->data.ptr;
+                guint j;
+
+                for (j = 0; j < vec->count; j++, elem += t->elem_size) {
+                    g_ptr_array_add(l, binder_cell_info_decode_hidl_cell(self,
+                        t, registered, elem));
+                }
+            } else {
+                g_ptr_array_add(l, binder_cell_info_decode_hidl_cell(self,
+                    t, registered, info));
             }
-            continue;
-        case RADIO_CELL_INFO_CDMA:
-        case RADIO_CELL_INFO_TD_SCDMA:
-            break;
         }
-        DBG("unsupported cell type %d", cell->cellInfoType);
+        binder_cell_info_update_cells(self, l);
+    } else {
+        ofono_warn("Failed to parse %s payload", layout->name);
     }
-    return l;
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_4(
-    const RadioCellInfo_1_4* cells,
-    gsize count)
+const BinderCellInfoHidlLayout*
+binder_cell_info_hidl_layout_for_resp(
+    RADIO_RESP resp)
 {
-    gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
+    guint i;
 
-    for (i = 0; i < count; i++) {
-        const RadioCellInfo_1_4* cell = cells + i;
-        const gboolean registered = cell->registered;
-
-        switch ((RADIO_CELL_INFO_TYPE_1_4)cell->cellInfoType) {
-        case RADIO_CELL_INFO_1_4_GSM:
-            g_ptr_array_add(l, binder_cell_info_new_cell_gsm(registered,
-                &cell->info.gsm.cellIdentityGsm.base,
-                &cell->info.gsm.signalStrengthGsm));
-            continue;
-        case RADIO_CELL_INFO_1_4_LTE:
-            g_ptr_array_add(l, binder_cell_info_new_cell_lte(registered,
-                &cell->info.lte.base.cellIdentityLte.base,
-                &cell->info.lte.base.signalStrengthLte));
-            continue;
-        case RADIO_CELL_INFO_1_4_WCDMA:
-            g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(registered,
-                &cell->info.wcdma.cellIdentityWcdma.base,
-                &cell->info.wcdma.signalStrengthWcdma.base));
-            continue;
-        case RADIO_CELL_INFO_1_4_NR:
-            g_ptr_array_add(l, binder_cell_info_new_cell_nr(registered,
-                &cell->info.nr.cellIdentity,
-                &cell->info.nr.signalStrength));
-            continue;
-        case RADIO_CELL_INFO_1_4_TD_SCDMA:
-        case RADIO_CELL_INFO_1_4_CDMA:
-            break;
+    for (i = 0; i < G_N_ELEMENTS(binder_cell_info_hidl_layouts); i++) {
+        if (binder_cell_info_hidl_layouts[i].resp == resp) {
+            return binder_cell_info_hidl_layouts + i;
         }
-        DBG("unsupported cell type %d", cell->cellInfoType);
     }
-    return l;
+    return NULL;
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_5(
-    const RadioCellInfo_1_5* cells,
-    gsize count)
+const BinderCellInfoHidlLayout*
+binder_cell_info_hidl_layout_for_ind(
+    RADIO_IND ind)
 {
-    gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
+    guint i;
 
-    for (i = 0; i < count; i++) {
-        const RadioCellInfo_1_5* cell = cells + i;
-        const gboolean registered = cell->registered;
-
-        switch ((RADIO_CELL_INFO_TYPE_1_5)cell->cellInfoType) {
-        case RADIO_CELL_INFO_1_5_GSM:
-            g_ptr_array_add(l, binder_cell_info_new_cell_gsm(registered,
-                &cell->info.gsm.cellIdentityGsm.base.base,
-                &cell->info.gsm.signalStrengthGsm));
-            continue;
-        case RADIO_CELL_INFO_1_5_LTE:
-            g_ptr_array_add(l, binder_cell_info_new_cell_lte(registered,
-                &cell->info.lte.cellIdentityLte.base.base,
-                &cell->info.lte.signalStrengthLte));
-            continue;
-        case RADIO_CELL_INFO_1_5_WCDMA:
-            g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(registered,
-                &cell->info.wcdma.cellIdentityWcdma.base.base,
-                &cell->info.wcdma.signalStrengthWcdma.base));
-            continue;
-        case RADIO_CELL_INFO_1_5_NR:
-            g_ptr_array_add(l, binder_cell_info_new_cell_nr(registered,
-                &cell->info.nr.cellIdentityNr.base,
-                &cell->info.nr.signalStrengthNr));
-            continue;
-        case RADIO_CELL_INFO_1_5_TD_SCDMA:
-        case RADIO_CELL_INFO_1_5_CDMA:
-            break;
+    for (i = 0; i < G_N_ELEMENTS(binder_cell_info_hidl_layouts); i++) {
+        if (binder_cell_info_hidl_layouts[i].ind == ind) {
+            return binder_cell_info_hidl_layouts + i;
         }
-        DBG("unsupported cell type %d", cell->cellInfoType);
     }
-    return l;
+    return NULL;
 }
 
-static
-GPtrArray*
-binder_cell_info_array_new_aidl(
-    GBinderReader* reader)
-{
-    gsize i;
-    gint32 count = 0;
-    GPtrArray* l;
-    gbinder_reader_read_int32(reader, &count);
-    l = g_ptr_array_sized_new(count + 1);
+/*==========================================================================*
+ * AIDL layouts
+ *
+ * AIDL parcelables have to be read sequentially, each cell type is
+ * described by a sequence of operations. Parcelable sizes are honored,
+ * i.e. the fields added in later versions of the interface get skipped.
+ *==========================================================================*/
 
-    for (i = 0; i < count; i++) {
-        gboolean registered;
-        gint32 type;
-        if (!binder_read_parcelable_size(reader)) {
-            continue;
-        }
+typedef enum binder_cell_info_aidl_op {
+    AIDL_BEGIN,         /* Parcelable header */
+    AIDL_END,           /* Skips the rest of the innermost parcelable */
+    AIDL_STRING,        /* String16 containing an integer */
+    AIDL_INT32,
+    AIDL_INT64,
+    AIDL_SKIP32
+} BINDER_CELL_INFO_AIDL_OP;
+
+#define AIDL_MAX_DEPTH (4)
+
+typedef struct binder_cell_info_aidl_field {
+    guint8 op;          /* BINDER_CELL_INFO_AIDL_OP */
+    guint16 dst;        /* Offset of the field in struct ofono_cell */
+} BinderCellInfoAidlField;
+
+typedef struct binder_cell_info_aidl_type {
+    gint32 hal_type;
+    enum ofono_cell_type type;
+    const BinderCellInfoAidlField* fields;
+    guint nfields;
+} BinderCellInfoAidlType;
+
+#define AIDL_OP(op) { op, 0 }
+#define AIDL_FIELD(op,dst) { op, CELL_OFFSET(dst) }
+#define AIDL_TYPE(hal,type,fields) { hal, type, fields, G_N_ELEMENTS(fields) }
+
+static const BinderCellInfoAidlField binder_cell_info_gsm_aidl[] = {
+    AIDL_OP(AIDL_BEGIN),                        /* CellInfoGsm */
+    AIDL_OP(AIDL_BEGIN),                        /* CellIdentityGsm */
+    AIDL_FIELD(AIDL_STRING, gsm.mcc),
+    AIDL_FIELD(AIDL_STRING, gsm.mnc),
+    AIDL_FIELD(AIDL_INT32, gsm.lac),
+    AIDL_FIELD(AIDL_INT32, gsm.cid),
+    AIDL_FIELD(AIDL_INT32, gsm.arfcn),
+    AIDL_FIELD(AIDL_INT32, gsm.bsic),
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_BEGIN),                        /* SignalStrengthGsm */
+    AIDL_FIELD(AIDL_INT32, gsm.signalStrength),
+    AIDL_FIELD(AIDL_INT32, gsm.bitErrorRate),
+    AIDL_FIELD(AIDL_INT32, gsm.timingAdvance),
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_END)
+};
 
-        gbinder_reader_read_bool(reader, &registered);
-        gbinder_reader_read_int32(reader, NULL); /* connectionStatus */
-        gbinder_reader_read_int32(reader, NULL); /* non-null rat specific info union */
-        gbinder_reader_read_int32(reader, &type);
+static const BinderCellInfoAidlField binder_cell_info_wcdma_aidl[] = {
+    AIDL_OP(AIDL_BEGIN),                        /* CellInfoWcdma */
+    AIDL_OP(AIDL_BEGIN),                        /* CellIdentityWcdma */
+    AIDL_FIELD(AIDL_STRING, wcdma.mcc),
+    AIDL_FIELD(AIDL_STRING, wcdma.mnc),
+    AIDL_FIELD(AIDL_INT32, wcdma.lac),
+    AIDL_FIELD(AIDL_INT32, wcdma.cid),
+    AIDL_FIELD(AIDL_INT32, wcdma.psc),
+    AIDL_FIELD(AIDL_INT32, wcdma.uarfcn),
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_BEGIN),                        /* SignalStrengthWcdma */
+    AIDL_FIELD(AIDL_INT32, wcdma.signalStrength),
+    AIDL_FIELD(AIDL_INT32, wcdma.bitErrorRate),
+    AIDL_OP(AIDL_SKIP32),                       /* rscp */
+    AIDL_OP(AIDL_SKIP32),                       /* ecno */
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_END)
+};
 
-        switch (type) {
-        case RADIO_CELL_INFO_1_5_GSM:
-            g_ptr_array_add(l, binder_cell_info_new_cell_gsm_aidl(registered,
-                reader));
-            continue;
-        case RADIO_CELL_INFO_1_5_LTE:
-            g_ptr_array_add(l, binder_cell_info_new_cell_lte_aidl(registered,
-                reader));
-            continue;
-        case RADIO_CELL_INFO_1_5_WCDMA:
-            g_ptr_array_add(l, binder_cell_info_new_cell_wcdma_aidl(registered,
-                reader));
-            continue;
-        case RADIO_CELL_INFO_1_5_NR:
-            g_ptr_array_add(l, binder_cell_info_new_cell_nr_aidl(registered,
-                reader));
-            continue;
-        case RADIO_CELL_INFO_1_5_TD_SCDMA:
-        case RADIO_CELL_INFO_1_5_CDMA:
-            /* Skip not implemented cell info types */
-            gbinder_reader_read_parcelable(reader, NULL);
-            break;
-        }
-        DBG("unsupported cell type %d", type);
-        gbinder_reader_read_parcelable(reader, NULL);
-    }
-    return l;
-}
+static const BinderCellInfoAidlField binder_cell_info_lte_aidl[] = {
+    AIDL_OP(AIDL_BEGIN),                        /* CellInfoLte */
+    AIDL_OP(AIDL_BEGIN),                        /* CellIdentityLte */
+    AIDL_FIELD(AIDL_STRING, lte.mcc),
+    AIDL_FIELD(AIDL_STRING, lte.mnc),
+    AIDL_FIELD(AIDL_INT32, lte.ci),
+    AIDL_FIELD(AIDL_INT32, lte.pci),
+    AIDL_FIELD(AIDL_INT32, lte.tac),
+    AIDL_FIELD(AIDL_INT32, lte.earfcn),
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_BEGIN),                        /* SignalStrengthLte */
+    AIDL_FIELD(AIDL_INT32, lte.signalStrength),
+    AIDL_FIELD(AIDL_INT32, lte.rsrp),
+    AIDL_FIELD(AIDL_INT32, lte.rsrq),
+    AIDL_FIELD(AIDL_INT32, lte.rssnr),
+    AIDL_FIELD(AIDL_INT32, lte.cqi),
+    AIDL_FIELD(AIDL_INT32, lte.timingAdvance),
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_END)
+};
 
-static
-void
-binder_cell_info_list_1_0(
-    BinderCellInfo* self,
-    GBinderReader* reader)
-{
-    gsize count;
-    const RadioCellInfo* cells = gbinder_reader_read_hidl_type_vec(reader,
-        RadioCellInfo, &count);
+static const BinderCellInfoAidlField binder_cell_info_nr_aidl[] = {
+    AIDL_OP(AIDL_BEGIN),                        /* CellInfoNr */
+    AIDL_OP(AIDL_BEGIN),                        /* CellIdentityNr */
+    AIDL_FIELD(AIDL_STRING, nr.mcc),
+    AIDL_FIELD(AIDL_STRING, nr.mnc),
+    AIDL_FIELD(AIDL_INT64, nr.nci),
+    AIDL_FIELD(AIDL_INT32, nr.pci),
+    AIDL_FIELD(AIDL_INT32, nr.tac),
+    AIDL_FIELD(AIDL_INT32, nr.nrarfcn),
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_BEGIN),                        /* SignalStrengthNr */
+    AIDL_FIELD(AIDL_INT32, nr.ssRsrp),
+    AIDL_FIELD(AIDL_INT32, nr.ssRsrq),
+    AIDL_FIELD(AIDL_INT32, nr.ssSinr),
+    AIDL_FIELD(AIDL_INT32, nr.csiRsrp),
+    AIDL_FIELD(AIDL_INT32, nr.csiRsrq),
+    AIDL_FIELD(AIDL_INT32, nr.csiSinr),
+    AIDL_OP(AIDL_END),
+    AIDL_OP(AIDL_END)
+};
 
-    if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_0(cells, count));
-    } else {
-        ofono_warn("Failed to parse cellInfoList payload");
-    }
-}
+static const BinderCellInfoAidlType binder_cell_info_aidl_types[] = {
+    AIDL_TYPE(RADIO_CELL_INFO_1_5_GSM, OFONO_CELL_TYPE_GSM,
+        binder_cell_info_gsm_aidl),
+    AIDL_TYPE(RADIO_CELL_INFO_1_5_WCDMA, OFONO_CELL_TYPE_WCDMA,
+        binder_cell_info_wcdma_aidl),
+    AIDL_TYPE(RADIO_CELL_INFO_1_5_LTE, OFONO_CELL_TYPE_LTE,
+        binder_cell_info_lte_aidl),
+    AIDL_TYPE(RADIO_CELL_INFO_1_5_NR, OFONO_CELL_TYPE_NR,
+        binder_cell_info_nr_aidl)
+};
 
 static
 void
-binder_cell_info_list_1_2(
-    BinderCellInfo* self,
-    GBinderReader* reader)
+binder_cell_info_aidl_skip(
+    GBinderReader* reader,
+    gsize start,
+    gsize size)
 {
-    gsize count;
-    const RadioCellInfo_1_2* cells = gbinder_reader_read_hidl_type_vec(reader,
-        RadioCellInfo_1_2, &count);
+    gsize data_read = gbinder_reader_bytes_read(reader) - start;
 
-    if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_2(cells, count));
-    } else {
-        ofono_warn("Failed to parse cellInfoList_1_2 payload");
+    while (data_read < size && gbinder_reader_read_uint32(reader, NULL)) {
+        data_read += sizeof(guint32);
     }
 }
 
 static
-void
-binder_cell_info_list_1_4(
+struct ofono_cell*
+binder_cell_info_decode_aidl_cell(
     BinderCellInfo* self,
+    const BinderCellInfoAidlType* t,
+    gboolean registered,
     GBinderReader* reader)
 {
-    gsize count;
-    const RadioCellInfo_1_4* cells = gbinder_reader_read_hidl_type_vec(reader,
-        RadioCellInfo_1_4, &count);
-
-    if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_4(cells, count));
-    } else {
-        ofono_warn("Failed to parse cellInfoList_1_4 payload");
+    struct ofono_cell* cell = binder_cell_info_new_cell_type(self, t->type,
+        registered);
+    guint8* base = (guint8*)cell;
+    gsize start[AIDL_MAX_DEPTH];
+    gsize size[AIDL_MAX_DEPTH];
+    guint i, depth = 0;
+
+    for (i = 0; i < t->nfields; i++) {
+        const BinderCellInfoAidlField* f = t->fields + i;
+
+        switch ((BINDER_CELL_INFO_AIDL_OP)f->op) {
+        case AIDL_BEGIN:
+            GASSERT(depth < AIDL_MAX_DEPTH);
+            size[depth] = binder_read_parcelable_size(reader);
+            if (!size[depth]) {
+                /* The caller will skip the rest of CellInfo */
+                i = t->nfields;
+                continue;
+            }
+            start[depth++] = gbinder_reader_bytes_read(reader);
+            break;
+        case AIDL_END:
+            GASSERT(depth > 0);
+            depth--;
+            binder_cell_info_aidl_skip(reader, start[depth], size[depth]);
+            break;
+        case AIDL_STRING:
+            binder_read_string16_parse_int(reader, (gint32*)(base + f->dst));
+            break;
+        case AIDL_INT32:
+            gbinder_reader_read_int32(reader, (gint32*)(base + f->dst));
+            break;
+        case AIDL_INT64:
+            gbinder_reader_read_int64(reader, (gint64*)(base + f->dst));
+            break;
+        case AIDL_SKIP32:
+            gbinder_reader_read_int32(reader, NULL);
+            break;
+        }
     }
-}
-
-static
-void
-binder_cell_info_list_1_5(
-    BinderCellInfo* self,
-    GBinderReader* reader)
-{
-    gsize count;
-    const RadioCellInfo_1_5* cells = gbinder_reader_read_hidl_type_vec(reader,
-        RadioCellInfo_1_5, &count);
 
-    if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_5(cells, count));
-    } else {
-        ofono_warn("Failed to parse cellInfoList_1_5 payload");
-    }
+    binder_cell_info_log_cell(cell);
+    return cell;
 }
 
 static
 void
-binder_cell_info_list_aidl(
+binder_cell_info_decode_aidl(
     BinderCellInfo* self,
     GBinderReader* reader)
 {
-    binder_cell_info_update_cells(self,
-        binder_cell_info_array_new_aidl(reader));
-}
+    GPtrArray* l = binder_cell_info_update_list(self);
+    gint32 i, count = 0;
 
-static
-void
-binder_cell_info_list_changed_1_0(
-    RadioClient* client,
-    RADIO_IND code,
-    const GBinderReader* args,
-    gpointer user_data)
-{
-    BinderCellInfo* self = THIS(user_data);
+    gbinder_reader_read_int32(reader, &count);
+    for (i = 0; i < count; i++) {
+        const BinderCellInfoAidlType* t = NULL;
+        const gsize size = binder_read_parcelable_size(reader);
+        const gsize start = gbinder_reader_bytes_read(reader);
+        gboolean registered = FALSE;
+        gint32 type = -1;
+        guint j;
 
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST);
-    if (self->enabled) {
-        GBinderReader reader;
+        if (!size) {
+            continue;
+        }
 
-        gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_0(self, &reader);
-    }
-}
+        /* CellInfo */
+        gbinder_reader_read_bool(reader, &registered);
+        gbinder_reader_read_int32(reader, NULL); /* connectionStatus */
+        gbinder_reader_read_int32(reader, NULL); /* ratSpecificInfo */
+        gbinder_reader_read_int32(reader, &type);
 
-static
-void
-binder_cell_info_list_changed_1_2(
-    RadioClient* client,
-    RADIO_IND code,
-    const GBinderReader* args,
-    gpointer user_data)
-{
-    BinderCellInfo* self = THIS(user_data);
+        for (j = 0; j < G_N_ELEMENTS(binder_cell_info_aidl_types); j++) {
+            if (binder_cell_info_aidl_types[j].hal_type == type) {
+                t = binder_cell_info_aidl_types + j;
+                break;
+            }
+        }
 
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST_1_2);
-    if (self->enabled) {
-        GBinderReader reader;
+        if (t) {
+            g_ptr_array_add(l, binder_cell_info_decode_aidl_cell(self, t,
+                registered, reader));
+        } else {
+            DBG("unsupported cell type %d", type);
+        }
 
-        gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_2(self, &reader);
+        /* Skip whatever is left, including not implemented cell types */
+        binder_cell_info_aidl_skip(reader, start, size);
     }
+    binder_cell_info_update_cells(self, l);
 }
 
-static
-void
-binder_cell_info_list_changed_1_4(
-    RadioClient* client,
-    RADIO_IND code,
-    const GBinderReader* args,
-    gpointer user_data)
-{
-    BinderCellInfo* self = THIS(user_data);
-
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST_1_4);
-    if (self->enabled) {
-        GBinderReader reader;
-
-        gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_4(self, &reader);
-    }
-}
+/*==========================================================================*
+ * Radio events
+ *==========================================================================*/
 
 static
 void
-binder_cell_info_list_changed_1_5(
+binder_cell_info_list_changed_hidl(
     RadioClient* client,
     RADIO_IND code,
     const GBinderReader* args,
     gpointer user_data)
 {
     BinderCellInfo* self = THIS(user_data);
+    const BinderCellInfoHidlLayout* layout =
+        binder_cell_info_hidl_layout_for_ind(code);
 
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST_1_5);
-    if (self->enabled) {
+    GASSERT(layout);
+    if (self->enabled && layout) {
         GBinderReader reader;
 
         gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_5(self, &reader);
+        binder_cell_info_decode_hidl(self, layout, &reader);
     }
 }
 
@@ -1020,7 +1153,7 @@ binder_cell_info_list_changed_aidl(
         GBinderReader reader;
 
         gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_aidl(self, &reader);
+        binder_cell_info_decode_aidl(self, &reader);
     }
 }
 
@@ -1046,27 +1179,19 @@ binder_cell_info_list_cb(
                 GBinderReader reader;
 
                 gbinder_reader_copy(&reader, args);
-                const RADIO_AIDL_INTERFACE iface_aidl = radio_client_aidl_interface(self->client);
-                if (iface_aidl == RADIO_AIDL_INTERFACE_NONE) {
-                    switch (resp) {
-                    case RADIO_RESP_GET_CELL_INFO_LIST:
-                        binder_cell_info_list_1_0(self, &reader);
-                        break;
-                    case RADIO_RESP_GET_CELL_INFO_LIST_1_2:
-                        binder_cell_info_list_1_2(self, &reader);
-                        break;
-                    case RADIO_RESP_GET_CELL_INFO_LIST_1_4:
-                        binder_cell_info_list_1_4(self, &reader);
-                        break;
-                    case RADIO_RESP_GET_CELL_INFO_LIST_1_5:
-                        binder_cell_info_list_1_5(self, &reader);
-                        break;
-                    default:
-                        ofono_warn("Unexpected getCellInfoList response %d", resp);
-                        break;
+                if (radio_client_aidl_interface(self->client) ==
+                    RADIO_AIDL_INTERFACE_NONE) {
+                    const BinderCellInfoHidlLayout* layout =
+                        binder_cell_info_hidl_layout_for_resp(resp);
+
+                    if (layout) {
+                        binder_cell_info_decode_hidl(self, layout, &reader);
+                    } else {
+                        ofono_warn("Unexpected getCellInfoList response %d",
+                            resp);
                     }
                 } else {
-                    binder_cell_info_list_aidl(self, &reader);
+                    binder_cell_info_decode_aidl(self, &reader);
                 }
             }
         } else {
@@ -1165,13 +1290,94 @@ binder_cell_info_set_rate(
 
     gbinder_writer_append_int32(&writer,
         (self->update_rate_ms >= 0 && self->enabled) ?
-            self->update_rate_ms : INT_MAX);
+            self->adaptive_rate_ms : INT_MAX);
 
     radio_request_set_retry(self->set_rate_req, BINDER_RETRY_MS, MAX_RETRIES);
     radio_request_set_retry_func(self->set_rate_req, binder_cell_info_retry);
     radio_request_submit(self->set_rate_req);
 }
 
+/*
+ * Adaptive update rate. The interval requested by ofono is the fastest
+ * one, it's widened (up to adaptive_max_ms) while the serving cell and
+ * the set of neighbouring cells remain the same, and gets reset back
+ * when the serving cell or registration state changes. Adaptation is
+ * disabled if adaptive_max_ms is zero.
+ */
+
+static
+int
+binder_cell_info_tight_rate(
+    BinderCellInfo* self)
+{
+    return (self->adaptive_max_ms > 0) ?
+        MAX(self->update_rate_ms, self->adaptive_min_ms) :
+        self->update_rate_ms;
+}
+
+static
+void
+binder_cell_info_update_adaptive_rate(
+    BinderCellInfo* self,
+    int ms)
+{
+    self->stable_count = 0;
+    if (self->adaptive_rate_ms != ms) {
+        DBG_(self, "%d ms", ms);
+        self->adaptive_rate_ms = ms;
+        if (self->enabled && self->sim_card_ready) {
+            binder_cell_info_set_rate(self);
+        }
+    }
+}
+
+static
+void
+binder_cell_info_tighten_rate(
+    BinderCellInfo* self)
+{
+    binder_cell_info_update_adaptive_rate(self,
+        binder_cell_info_tight_rate(self));
+}
+
+static
+void
+binder_cell_info_adapt_rate(
+    BinderCellInfo* self,
+    gboolean serving_changed,
+    gboolean neighbours_changed)
+{
+    if (self->adaptive_max_ms > 0 && self->update_rate_ms >= 0) {
+        if (serving_changed) {
+            binder_cell_info_tighten_rate(self);
+        } else if (neighbours_changed) {
+            self->stable_count = 0;
+        } else if (++self->stable_count >= STABLE_SNAPSHOTS) {
+            const int max = MAX(self->adaptive_max_ms,
+                binder_cell_info_tight_rate(self));
+            const int ms = self->adaptive_rate_ms;
+
+            binder_cell_info_update_adaptive_rate(self,
+                (ms < max / 2) ? (ms * 2) : max);
+        }
+    }
+}
+
+static
+void
+binder_cell_info_network_state_cb(
+    BinderNetwork* network,
+    BINDER_NETWORK_PROPERTY property,
+    void* user_data)
+{
+    BinderCellInfo* self = THIS(user_data);
+
+    if (self->adaptive_max_ms > 0 && self->update_rate_ms >= 0) {
+        DBG_(self, "registration state changed");
+        binder_cell_info_tighten_rate(self);
+    }
+}
+
 static
 void
 binder_cell_info_refresh(
@@ -1226,6 +1432,12 @@ typedef struct binder_cell_info_closure {
     void* user_data;
 } BinderCellInfoClosure;
 
+typedef struct binder_cell_info_diff_closure {
+    GCClosure cclosure;
+    BinderCellInfoDiffFunc cb;
+    void* user_data;
+} BinderCellInfoDiffClosure;
+
 static inline BinderCellInfo* binder_cell_info_cast(struct ofono_cell_info* info)
     { return G_CAST(info, BinderCellInfo, info); }
 
@@ -1254,6 +1466,16 @@ binder_cell_info_cells_changed_cb(
     closure->cb(&self->info, closure->user_data);
 }
 
+static
+void
+binder_cell_info_cells_diff_cb(
+    BinderCellInfo* self,
+    const BinderCellInfoDiff* diff,
+    BinderCellInfoDiffClosure* closure)
+{
+    closure->cb(&self->info, diff, closure->user_data);
+}
+
 static
 gulong
 binder_cell_info_add_cells_changed_handler_proc(
@@ -1299,6 +1521,8 @@ binder_cell_info_set_update_interval_proc(
 
     if (self->update_rate_ms != ms) {
         self->update_rate_ms = ms;
+        self->adaptive_rate_ms = binder_cell_info_tight_rate(self);
+        self->stable_count = 0;
         DBG_(self, "%d ms", ms);
         if (self->enabled && self->sim_card_ready) {
             binder_cell_info_set_rate(self);
@@ -1334,36 +1558,37 @@ binder_cell_info_new(
     RadioClient* client,
     const char* log_prefix,
     BinderRadio* radio,
-    BinderSimCard* sim)
+    BinderNetwork* network,
+    BinderSimCard* sim,
+    const BinderSlotConfig* config)
 {
     BinderCellInfo* self = g_object_new(THIS_TYPE, 0);
 
     self->instance = radio_instance_ref(instance);
     self->client = radio_client_ref(client);
     self->radio = binder_radio_ref(radio);
+    self->network = binder_network_ref(network);
     self->sim_card = binder_sim_card_ref(sim);
     self->log_prefix = binder_dup_prefix(log_prefix);
+    if (config->cell_info_interval_max_ms > 0) {
+        self->adaptive_min_ms = config->cell_info_interval_min_ms;
+        self->adaptive_max_ms = config->cell_info_interval_max_ms;
+        self->adaptive_rate_ms = binder_cell_info_tight_rate(self);
+    }
     const RADIO_AIDL_INTERFACE iface_aidl =
         radio_client_aidl_interface(self->client);
 
     DBG_(self, "");
     if (iface_aidl == RADIO_AIDL_INTERFACE_NONE) {
-        self->event_id[CELL_INFO_EVENT_1_0] =
-            radio_client_add_indication_handler(client,
-                RADIO_IND_CELL_INFO_LIST,
-                binder_cell_info_list_changed_1_0, self);
-        self->event_id[CELL_INFO_EVENT_1_2] =
-            radio_client_add_indication_handler(client,
-                RADIO_IND_CELL_INFO_LIST_1_2,
-                binder_cell_info_list_changed_1_2, self);
-        self->event_id[CELL_INFO_EVENT_1_4] =
-            radio_client_add_indication_handler(client,
-                RADIO_IND_CELL_INFO_LIST_1_4,
-                binder_cell_info_list_changed_1_4, self);
-        self->event_id[CELL_INFO_EVENT_1_5] =
-            radio_client_add_indication_handler(client,
-                RADIO_IND_CELL_INFO_LIST_1_5,
-                binder_cell_info_list_changed_1_5, self);
+        guint i;
+
+        G_STATIC_ASSERT(G_N_ELEMENTS(binder_cell_info_hidl_layouts) ==
+            CELL_INFO_EVENT_COUNT);
+        for (i = 0; i < CELL_INFO_EVENT_COUNT; i++) {
+            self->event_id[i] = radio_client_add_indication_handler(client,
+                binder_cell_info_hidl_layouts[i].ind,
+                binder_cell_info_list_changed_hidl, self);
+        }
     } else {
         self->event_id[CELL_INFO_EVENT_1_0] =
             radio_client_add_indication_handler(client,
@@ -1377,6 +1602,14 @@ binder_cell_info_new(
     self->sim_status_event_id =
         binder_sim_card_add_status_changed_handler(sim,
             binder_cell_info_sim_status_cb, self);
+    self->network_event_id[NETWORK_EVENT_VOICE_STATE] =
+        binder_network_add_property_handler(network,
+            BINDER_NETWORK_PROPERTY_VOICE_STATE,
+            binder_cell_info_network_state_cb, self);
+    self->network_event_id[NETWORK_EVENT_DATA_STATE] =
+        binder_network_add_property_handler(network,
+            BINDER_NETWORK_PROPERTY_DATA_STATE,
+            binder_cell_info_network_state_cb, self);
     self->sim_card_ready = binder_sim_card_ready(sim);
     binder_cell_info_refresh(self);
 
@@ -1388,6 +1621,46 @@ binder_cell_info_new(
     return &self->info;
 }
 
+gulong
+binder_cell_info_add_cells_diff_handler(
+    struct ofono_cell_info* info,
+    BinderCellInfoDiffFunc cb,
+    void* user_data)
+{
+    if (G_LIKELY(info) && G_LIKELY(cb)) {
+        BinderCellInfoDiffClosure* closure = (BinderCellInfoDiffClosure *)
+            g_closure_new_simple(sizeof(BinderCellInfoDiffClosure), NULL);
+        GCClosure* cc = &closure->cclosure;
+
+        cc->closure.data = closure;
+        cc->callback = G_CALLBACK(binder_cell_info_cells_diff_cb);
+        closure->cb = cb;
+        closure->user_data = user_data;
+        return g_signal_connect_closure_by_id(binder_cell_info_cast(info),
+            binder_cell_info_signals[SIGNAL_CELLS_DIFF], 0,
+            &cc->closure, FALSE);
+    } else {
+        return 0;
+    }
+}
+
+void
+binder_cell_info_get_stats(
+    struct ofono_cell_info* info,
+    BinderCellInfoStats* stats)
+{
+    if (G_LIKELY(stats)) {
+        if (G_LIKELY(info)) {
+            BinderCellInfo* self = binder_cell_info_cast(info);
+
+            *stats = self->stats;
+            stats->cells_pooled = self->spare->len;
+        } else {
+            memset(stats, 0, sizeof(*stats));
+        }
+    }
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -1406,8 +1679,16 @@ binder_cell_info_init(
         binder_cell_info_set_enabled_proc
     };
 
-    self->update_rate_ms = DEFAULT_UPDATE_RATE_MS;
-    self->info.cells = self->cells = g_new0(struct ofono_cell*, 1);
+    self->update_rate_ms = self->adaptive_rate_ms = DEFAULT_UPDATE_RATE_MS;
+    self->cells = g_ptr_array_new();
+    self->next = g_ptr_array_new();
+    self->update = g_ptr_array_new();
+    self->added = g_ptr_array_new();
+    self->removed = g_ptr_array_new();
+    self->changed = g_ptr_array_new();
+    self->spare = g_ptr_array_new();
+    g_ptr_array_add(self->cells, NULL);
+    self->info.cells = (const ofono_cell_ptr*)self->cells->pdata;
     self->info.proc = &binder_cell_info_proc;
 }
 
@@ -1426,9 +1707,19 @@ binder_cell_info_finalize(
     radio_instance_unref(self->instance);
     binder_radio_remove_handler(self->radio, self->radio_state_event_id);
     binder_radio_unref(self->radio);
+    binder_network_remove_all_handlers(self->network, self->network_event_id);
+    binder_network_unref(self->network);
     binder_sim_card_remove_handler(self->sim_card, self->sim_status_event_id);
     binder_sim_card_unref(self->sim_card);
-    gutil_ptrv_free((void**)self->cells);
+    g_ptr_array_set_free_func(self->cells, g_free);
+    g_ptr_array_free(self->cells, TRUE);
+    g_ptr_array_free(self->next, TRUE);
+    g_ptr_array_free(self->update, TRUE);
+    g_ptr_array_free(self->added, TRUE);
+    g_ptr_array_free(self->removed, TRUE);
+    g_ptr_array_free(self->changed, TRUE);
+    g_ptr_array_set_free_func(self->spare, g_free);
+    g_ptr_array_free(self->spare, TRUE);
     g_free(self->log_prefix);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
@@ -1442,6 +1733,10 @@ binder_cell_info_class_init(
     binder_cell_info_signals[SIGNAL_CELLS_CHANGED] =
         g_signal_new(SIGNAL_CELLS_CHANGED_NAME, G_OBJECT_CLASS_TYPE(klass),
             G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+    binder_cell_info_signals[SIGNAL_CELLS_DIFF] =
+        g_signal_new(SIGNAL_CELLS_DIFF_NAME, G_OBJECT_CLASS_TYPE(klass),
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE,
+            1, G_TYPE_POINTER);
 }
 
 /*
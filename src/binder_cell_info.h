@@ -20,13 +20,54 @@
 
 #include <ofono/cell-info.h>
 
+/*
+ * Incremental change notification. All lists are NULL-terminated.
+ * Added and changed cells remain owned by ofono_cell_info, removed
+ * ones are only valid for the duration of the callback.
+ */
+typedef struct binder_cell_info_diff {
+    const ofono_cell_ptr* added;
+    const ofono_cell_ptr* removed;
+    const ofono_cell_ptr* changed;
+} BinderCellInfoDiff;
+
+/* Cell allocation counters, for diagnostics */
+typedef struct binder_cell_info_stats {
+    guint cells_allocated;  /* Allocated from the heap */
+    guint cells_reused;     /* Taken from the pool */
+    guint cells_pooled;     /* Currently sitting in the pool */
+} BinderCellInfoStats;
+
+typedef
+void
+(*BinderCellInfoDiffFunc)(
+    struct ofono_cell_info* info,
+    const BinderCellInfoDiff* diff,
+    void* user_data);
+
 struct ofono_cell_info*
 binder_cell_info_new(
     RadioInstance* instance,
     RadioClient* client,
     const char* log_prefix,
     BinderRadio* radio,
-    BinderSimCard* sim)
+    BinderNetwork* network,
+    BinderSimCard* sim,
+    const BinderSlotConfig* config)
+    BINDER_INTERNAL;
+
+/* Removed with ofono_cell_info_remove_handler() */
+gulong
+binder_cell_info_add_cells_diff_handler(
+    struct ofono_cell_info* info,
+    BinderCellInfoDiffFunc cb,
+    void* user_data)
+    BINDER_INTERNAL;
+
+void
+binder_cell_info_get_stats(
+    struct ofono_cell_info* info,
+    BinderCellInfoStats* stats)
     BINDER_INTERNAL;
 
 #endif /* BINDER_CELL_INFO_H */
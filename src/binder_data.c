@@ -15,6 +15,7 @@
 
 #include "binder_base.h"
 #include "binder_data.h"
+#include "binder_data_retry.h"
 #include "binder_radio.h"
 #include "binder_network.h"
 #include "binder_sim_settings.h"
@@ -105,6 +106,28 @@ struct binder_data_manager {
     enum ofono_radio_access_mode non_data_mode;
 };
 
+/* Requests of higher priority (lower value) jump ahead of the others */
+typedef enum binder_data_request_priority {
+    DATA_REQUEST_PRIORITY_TEARDOWN,  /* deactivateDataCall */
+    DATA_REQUEST_PRIORITY_ALLOW,     /* setDataAllowed, setPreferredDataModem */
+    DATA_REQUEST_PRIORITY_SETUP,     /* setupDataCall */
+    DATA_REQUEST_PRIORITY_COUNT
+} BINDER_DATA_REQUEST_PRIORITY;
+
+typedef struct binder_data_request_queue {
+    BinderDataRequest* first;
+    BinderDataRequest* last;
+    guint depth;
+} BinderDataRequestQueue;
+
+typedef struct binder_data_request_stats {
+    guint submitted;
+    guint coalesced;
+    guint max_depth;
+    gint64 total_wait_us;
+    gint64 max_wait_us;
+} BinderDataRequestStats;
+
 typedef struct binder_data_object {
     BinderBase base;
     BinderData pub;
@@ -117,8 +140,12 @@ typedef struct binder_data_object {
     BINDER_DATA_FLAGS flags;
     RADIO_RESTRICTED_STATE restricted_state;
 
-    BinderDataRequest* req_queue;
-    BinderDataRequest* pending_req;
+    BinderDataRequestQueue req_queue[DATA_REQUEST_PRIORITY_COUNT];
+    BinderDataRequest* pending_req; /* Exclusive (teardown/allow) request */
+    BinderDataRequest* pending_setup; /* Concurrent setupDataCall requests */
+    guint pending_setup_count;
+    BinderDataRequest* retry_wait; /* Setups waiting for their retry timer */
+    BinderDataRequestStats req_stats[DATA_REQUEST_PRIORITY_COUNT];
 
     BinderDataOptions options;
     BinderDataProfileConfig profile_config;
@@ -129,6 +156,8 @@ typedef struct binder_data_object {
     gulong io_event_id[IO_EVENT_COUNT];
     gulong settings_event_id[SETTINGS_EVENT_COUNT];
     GHashTable* grab;
+    GHashTable* call_table; /* cid => BinderDataCall owned by pub.calls */
+    BinderDataRetry* retry;
     gboolean downgraded_tech; /* Status 55 workaround */
 } BinderDataObject;
 
@@ -140,6 +169,29 @@ G_DEFINE_TYPE(BinderDataObject, binder_data_object, BINDER_TYPE_BASE)
 #define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, BinderDataObject)
 BINDER_BASE_ASSERT_COUNT(BINDER_DATA_PROPERTY_COUNT);
 
+enum binder_data_signal {
+    SIGNAL_CALL_EVENT,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_CALL_EVENT_NAME "binder-data-call-event"
+#define SIGNAL_CALL_EVENT_DETAIL "%x"
+#define SIGNAL_CALL_EVENT_DETAIL_MAX_LEN (8)
+
+static guint binder_data_signals[SIGNAL_COUNT] = { 0 };
+
+typedef struct binder_data_call_closure {
+    GCClosure cclosure;
+    BinderDataCallEventFunc cb;
+    void* user_data;
+} BinderDataCallClosure;
+
+typedef struct binder_data_call_event_rec {
+    int cid;
+    BINDER_DATA_CALL_EVENT event;
+    const BinderDataCall* call;
+} BinderDataCallEventRec;
+
 typedef enum binder_data_request_flags {
     DATA_REQUEST_NO_FLAGS = 0,
     DATA_REQUEST_FLAG_COMPLETED = 0x1,
@@ -151,6 +203,8 @@ typedef enum binder_data_request_flags {
 struct binder_data_request {
     BinderDataRequest* next;
     BinderDataObject* data;
+    BINDER_DATA_REQUEST_PRIORITY priority;
+    gint64 queued; /* Monotonic time */
     union binder_data_request_cb {
         BinderDataCallSetupFunc setup;
         BinderDataCallDeactivateFunc deact;
@@ -173,7 +227,6 @@ typedef struct binder_data_request_setup {
     char* password;
     enum ofono_gprs_proto proto;
     enum ofono_gprs_auth_method auth_method;
-    guint retry_count;
     guint retry_delay_id;
 } BinderDataRequestSetup;
 
@@ -410,57 +463,60 @@ binder_data_set_data_allowed_request_new(
  *==========================================================================*/
 
 static
-BinderDataCall*
-binder_data_call_new()
+void
+binder_data_call_builder_add_hidl_vec(
+    BinderDataCallBuilder* builder,
+    BINDER_DATA_ADDR_TYPE type,
+    const GBinderHidlVec* vec)
 {
-    return g_new0(struct binder_data_call, 1);
-}
+    const GBinderHidlString* strings = vec->data.ptr;
+    guint i;
 
-/* extern */
-BinderDataCall*
-binder_data_call_dup(
-    const BinderDataCall* call)
-{
-    if (call) {
-        BinderDataCall* dc = binder_data_call_new();
-
-        dc->cid = call->cid;
-        dc->status = call->status;
-        dc->active = call->active;
-        dc->prot = call->prot;
-        dc->retry_time = call->retry_time;
-        dc->mtu = call->mtu;
-        dc->ifname = g_strdup(call->ifname);
-        dc->dnses = g_strdupv(call->dnses);
-        dc->gateways = g_strdupv(call->gateways);
-        dc->addresses = g_strdupv(call->addresses);
-        dc->pcscf = g_strdupv(call->pcscf);
-        return dc;
+    for (i = 0; i < vec->count; i++) {
+        binder_data_call_builder_add(builder, type, strings[i].data.str);
     }
-    return NULL;
 }
 
 static
 void
-binder_data_call_destroy(
-    BinderDataCall* call)
+binder_data_call_builder_add_string16_array(
+    BinderDataCallBuilder* builder,
+    BINDER_DATA_ADDR_TYPE type,
+    GBinderReader* reader)
 {
-    g_free(call->ifname);
-    g_strfreev(call->dnses);
-    g_strfreev(call->gateways);
-    g_strfreev(call->addresses);
-    g_strfreev(call->pcscf);
+    gint32 i, count = 0;
+
+    gbinder_reader_read_int32(reader, &count);
+    for (i = 0; i < count; i++) {
+        char* str = gbinder_reader_read_string16(reader);
+
+        binder_data_call_builder_add(builder, type, str);
+        g_free(str);
+    }
 }
 
-/* extern */
+static
 void
-binder_data_call_free(
-    BinderDataCall* call)
+binder_data_call_dump(
+    const BinderDataCall* call)
 {
-    if (call) {
-        binder_data_call_destroy(call);
-        g_free(call);
-    }
+    char* addresses = binder_data_call_addr_list(call,
+        BINDER_DATA_ADDR_ADDRESS);
+    char* dnses = binder_data_call_addr_list(call, BINDER_DATA_ADDR_DNS);
+    char* gateways = binder_data_call_addr_list(call,
+        BINDER_DATA_ADDR_GATEWAY);
+    char* pcscf = binder_data_call_addr_list(call, BINDER_DATA_ADDR_PCSCF);
+
+    DBG("[status=%d,retry=%d,cid=%d,active=%d,type=%d,ifname=%s,"
+        "mtu=%d,address=%s,dns=%s,gateways=%s,pcscf=%s]",
+        call->status, call->retry_time, call->cid, call->active,
+        call->prot, binder_data_call_ifname(call), call->mtu, addresses,
+        dnses, gateways, pcscf);
+
+    g_free(addresses);
+    g_free(dnses);
+    g_free(gateways);
+    g_free(pcscf);
 }
 
 static
@@ -488,25 +544,28 @@ BinderDataCall*
 binder_data_call_new_1_0(
     const RadioDataCall* dc)
 {
-    BinderDataCall* call = binder_data_call_new();
-
-    call->cid = dc->cid;
-    call->status = dc->status;
-    call->active = dc->active;
-    call->prot = binder_ofono_proto_from_proto_str(dc->type.data.str);
-    call->retry_time = dc->suggestedRetryTime;
-    call->mtu = dc->mtu;
-    call->ifname = g_strdup(dc->ifname.data.str);
-    call->dnses = g_strsplit(dc->dnses.data.str, " ", -1);
-    call->gateways = g_strsplit(dc->gateways.data.str, " ", -1);
-    call->addresses = g_strsplit(dc->addresses.data.str, " ", -1);
-    call->pcscf = g_strsplit(dc->pcscf.data.str, " ", -1);
-
-    DBG("[status=%d,retry=%d,cid=%d,active=%d,type=%s,ifname=%s,"
-        "mtu=%d,address=%s,dns=%s,gateways=%s,pcscf=%s]",
-        call->status, call->retry_time, call->cid, call->active,
-        dc->type.data.str, call->ifname, call->mtu, dc->addresses.data.str,
-        dc->dnses.data.str, dc->gateways.data.str, dc->pcscf.data.str);
+    BinderDataCallBuilder b;
+    BinderDataCall* call;
+
+    binder_data_call_builder_init(&b);
+    b.call.cid = dc->cid;
+    b.call.status = dc->status;
+    b.call.active = dc->active;
+    b.call.prot = binder_ofono_proto_from_proto_str(dc->type.data.str);
+    b.call.retry_time = dc->suggestedRetryTime;
+    b.call.mtu = dc->mtu;
+    binder_data_call_builder_set_ifname(&b, dc->ifname.data.str);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_ADDRESS,
+        dc->addresses.data.str);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_GATEWAY,
+        dc->gateways.data.str);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_DNS,
+        dc->dnses.data.str);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_PCSCF,
+        dc->pcscf.data.str);
+
+    call = binder_data_call_builder_finish(&b);
+    binder_data_call_dump(call);
     return call;
 }
 
@@ -537,28 +596,28 @@ BinderDataCall*
 binder_data_call_new_1_4(
     const RadioDataCall_1_4* dc)
 {
-    BinderDataCall* call = binder_data_call_new();
-
-    call->cid = dc->cid;
-    call->status = dc->cause;
-    call->active = dc->active;
-    call->prot = dc->type;
-    call->retry_time = dc->suggestedRetryTime;
-    call->mtu = dc->mtu;
-    call->ifname = g_strdup(dc->ifname.data.str);
-    call->dnses = binder_strv_from_hidl_string_vec(&dc->dnses);
-    call->gateways = binder_strv_from_hidl_string_vec(&dc->gateways);
-    call->addresses = binder_strv_from_hidl_string_vec(&dc->addresses);
-    call->pcscf = binder_strv_from_hidl_string_vec(&dc->pcscf);
-
-    DBG("[status=%d,retry=%d,cid=%d,active=%d,type=%d,ifname=%s,"
-        "mtu=%d,address=%s,dns=%s,gateways=%s,pcscf=%s]",
-        call->status, call->retry_time, call->cid, call->active,
-        dc->type, call->ifname, call->mtu,
-        binder_print_strv(call->addresses, " "),
-        binder_print_strv(call->dnses, " "),
-        binder_print_strv(call->gateways, " "),
-        binder_print_strv(call->pcscf, " "));
+    BinderDataCallBuilder b;
+    BinderDataCall* call;
+
+    binder_data_call_builder_init(&b);
+    b.call.cid = dc->cid;
+    b.call.status = dc->cause;
+    b.call.active = dc->active;
+    b.call.prot = dc->type;
+    b.call.retry_time = dc->suggestedRetryTime;
+    b.call.mtu = dc->mtu;
+    binder_data_call_builder_set_ifname(&b, dc->ifname.data.str);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_ADDRESS,
+        &dc->addresses);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_GATEWAY,
+        &dc->gateways);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_DNS,
+        &dc->dnses);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_PCSCF,
+        &dc->pcscf);
+
+    call = binder_data_call_builder_finish(&b);
+    binder_data_call_dump(call);
     return call;
 }
 
@@ -567,28 +626,28 @@ BinderDataCall*
 binder_data_call_new_1_5(
     const RadioDataCall_1_5* dc)
 {
-    BinderDataCall* call = binder_data_call_new();
-
-    call->cid = dc->cid;
-    call->status = dc->cause;
-    call->active = dc->active;
-    call->prot = dc->type;
-    call->retry_time = dc->suggestedRetryTime;
-    call->mtu = dc->mtuV4;
-    call->ifname = g_strdup(dc->ifname.data.str);
-    call->dnses = binder_strv_from_hidl_string_vec(&dc->dnses);
-    call->gateways = binder_strv_from_hidl_string_vec(&dc->gateways);
-    call->addresses = binder_strv_from_hidl_string_vec(&dc->addresses);
-    call->pcscf = binder_strv_from_hidl_string_vec(&dc->pcscf);
-
-    DBG("[status=%d,retry=%d,cid=%d,active=%d,type=%d,ifname=%s,"
-        "mtu=%d,address=%s,dns=%s,gateways=%s,pcscf=%s]",
-        call->status, call->retry_time, call->cid, call->active,
-        dc->type, call->ifname, call->mtu,
-        binder_print_strv(call->addresses, " "),
-        binder_print_strv(call->dnses, " "),
-        binder_print_strv(call->gateways, " "),
-        binder_print_strv(call->pcscf, " "));
+    BinderDataCallBuilder b;
+    BinderDataCall* call;
+
+    binder_data_call_builder_init(&b);
+    b.call.cid = dc->cid;
+    b.call.status = dc->cause;
+    b.call.active = dc->active;
+    b.call.prot = dc->type;
+    b.call.retry_time = dc->suggestedRetryTime;
+    b.call.mtu = dc->mtuV4;
+    binder_data_call_builder_set_ifname(&b, dc->ifname.data.str);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_ADDRESS,
+        &dc->addresses);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_GATEWAY,
+        &dc->gateways);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_DNS,
+        &dc->dnses);
+    binder_data_call_builder_add_hidl_vec(&b, BINDER_DATA_ADDR_PCSCF,
+        &dc->pcscf);
+
+    call = binder_data_call_builder_finish(&b);
+    binder_data_call_dump(call);
     return call;
 }
 
@@ -597,13 +656,18 @@ BinderDataCall*
 binder_data_call_new_aidl(
     GBinderReader* reader)
 {
-    BinderDataCall* call = binder_data_call_new();
+    BinderDataCallBuilder b;
+    BinderDataCall* call = &b.call;
+    char* ifname;
 
     gsize data_read;
-    gsize parcel_size = binder_read_parcelable_size(reader);
-    gsize initial_size = gbinder_reader_bytes_read(reader);
+    gsize parcel_size;
+    gsize initial_size;
     gint64 retry_time;
 
+    binder_data_call_builder_init(&b);
+    parcel_size = binder_read_parcelable_size(reader);
+    initial_size = gbinder_reader_bytes_read(reader);
     gbinder_reader_read_int32(reader, &call->status);
     gbinder_reader_read_int64(reader, &retry_time);
     // Is there better way to do this?
@@ -617,24 +681,17 @@ binder_data_call_new_aidl(
     gbinder_reader_read_int32(reader, &call->cid);
     gbinder_reader_read_uint32(reader, &call->active);
     gbinder_reader_read_uint32(reader, &call->prot);
-    call->ifname = gbinder_reader_read_string16(reader);
+    ifname = gbinder_reader_read_string16(reader);
+    binder_data_call_builder_set_ifname(&b, ifname);
+    g_free(ifname);
 
     // addresses
     {
         gint32 addresses_count = 0;
-        guint i;
-        char** out;
-        char** ptr;
-        gbinder_reader_read_int32(reader, &addresses_count);
-
-        if (addresses_count < 0) {
-            addresses_count = 0;
-        }
+        gint32 i;
 
-        out = g_new0(char*, addresses_count + 1);
-        ptr = out;
-
-        for (i = 0; i < addresses_count; i++, ptr++) {
+        gbinder_reader_read_int32(reader, &addresses_count);
+        for (i = 0; i < addresses_count; i++) {
             gsize address_data_read;
             gsize address_parcel_size = binder_read_parcelable_size(reader);
             gsize address_initial_size = gbinder_reader_bytes_read(reader);
@@ -644,7 +701,9 @@ binder_data_call_new_aidl(
             }
 
             char* str = gbinder_reader_read_string16(reader);
-            *ptr = str ? str : g_strdup("");
+
+            binder_data_call_builder_add(&b, BINDER_DATA_ADDR_ADDRESS, str);
+            g_free(str);
 
             // Ignore rest of values for now
             address_data_read = gbinder_reader_bytes_read(reader) - address_initial_size;
@@ -653,11 +712,13 @@ binder_data_call_new_aidl(
                 address_data_read += sizeof(guint32);
             }
         }
-        call->addresses = out;
     }
-    call->dnses = binder_strv_from_string16_array(reader);
-    call->gateways = binder_strv_from_string16_array(reader);
-    call->pcscf = binder_strv_from_string16_array(reader);
+    binder_data_call_builder_add_string16_array(&b, BINDER_DATA_ADDR_DNS,
+        reader);
+    binder_data_call_builder_add_string16_array(&b, BINDER_DATA_ADDR_GATEWAY,
+        reader);
+    binder_data_call_builder_add_string16_array(&b, BINDER_DATA_ADDR_PCSCF,
+        reader);
     // mtuV4
     gbinder_reader_read_int32(reader, &call->mtu);
     // Ignore rest of the values for now
@@ -667,14 +728,8 @@ binder_data_call_new_aidl(
         data_read += sizeof(guint32);
     }
 
-    DBG("[status=%d,retry=%d,cid=%d,active=%d,type=%d,ifname=%s,"
-        "mtu=%d,address=%s,dns=%s,gateways=%s,pcscf=%s]",
-        call->status, call->retry_time, call->cid, call->active,
-        call->prot, call->ifname, call->mtu,
-        binder_print_strv(call->addresses, " "),
-        binder_print_strv(call->dnses, " "),
-        binder_print_strv(call->gateways, " "),
-        binder_print_strv(call->pcscf, " "));
+    call = binder_data_call_builder_finish(&b);
+    binder_data_call_dump(call);
     return call;
 }
 
@@ -746,76 +801,99 @@ binder_data_call_list_aidl(
 }
 
 static
-gboolean
-binder_data_call_equal(
-    const BinderDataCall* c1,
-    const BinderDataCall* c2)
+GQuark
+binder_data_call_quark(
+    int cid)
 {
-    if (c1 == c2) {
-        return TRUE;
-    } else if (c1 && c2) {
-        return c1->cid == c2->cid &&
-            c1->status == c2->status &&
-            c1->active == c2->active &&
-            c1->prot == c2->prot &&
-            c1->retry_time == c2->retry_time &&
-            c1->mtu == c2->mtu &&
-            !g_strcmp0(c1->ifname, c2->ifname) &&
-            gutil_strv_equal(c1->dnses, c2->dnses) &&
-            gutil_strv_equal(c1->gateways, c2->gateways) &&
-            gutil_strv_equal(c1->addresses, c2->addresses) &&
-            gutil_strv_equal(c1->pcscf, c2->pcscf);
-    } else {
-        return FALSE;
-    }
+    char buf[SIGNAL_CALL_EVENT_DETAIL_MAX_LEN + 1];
+
+    snprintf(buf, sizeof(buf), SIGNAL_CALL_EVENT_DETAIL, cid);
+    buf[sizeof(buf) - 1] = 0;
+    return g_quark_from_string(buf);
 }
 
 static
-gboolean
-binder_data_call_list_equal(
-    GSList* l1,
-    GSList* l2)
+void
+binder_data_emit_call_event(
+    BinderDataObject* self,
+    int cid,
+    BINDER_DATA_CALL_EVENT event,
+    const BinderDataCall* call)
 {
-    while (l1 && l2) {
-        if (!binder_data_call_equal(l1->data, l2->data)) {
-            return FALSE;
-        }
-        l1 = l1->next;
-        l2 = l2->next;
-    }
-    return (!l1 && !l2);
+    g_signal_emit(self, binder_data_signals[SIGNAL_CALL_EVENT],
+        binder_data_call_quark(cid), cid, event, call);
 }
 
 static
-gboolean
-binder_data_call_list_contains(
-    GSList* l,
-    const BinderDataCall* call)
+void
+binder_data_call_table_rebuild(
+    BinderDataObject* self)
 {
-    while (l) {
-        if (binder_data_call_equal(l->data, call)) {
-            return TRUE;
+    GSList* l;
+
+    g_hash_table_remove_all(self->call_table);
+    for (l = self->pub.calls; l; l = l->next) {
+        BinderDataCall* call = l->data;
+
+        g_hash_table_insert(self->call_table, GINT_TO_POINTER(call->cid),
+            call);
+    }
+}
+
+/*
+ * Both lists are sorted by cid. Returns the number of events stored
+ * in the array, which must be large enough to hold an event for every
+ * call in both lists.
+ */
+static
+guint
+binder_data_call_list_diff(
+    GSList* l1,
+    GSList* l2,
+    BinderDataCallEventRec* events)
+{
+    BinderDataCallEventRec* ev = events;
+
+    while (l1 || l2) {
+        const BinderDataCall* c1 = l1 ? l1->data : NULL;
+        const BinderDataCall* c2 = l2 ? l2->data : NULL;
+
+        if (c2 && (!c1 || c2->cid < c1->cid)) {
+            ev->cid = c2->cid;
+            ev->event = BINDER_DATA_CALL_ADDED;
+            ev->call = c2;
+            ev++;
+            l2 = l2->next;
+        } else if (c1 && (!c2 || c1->cid < c2->cid)) {
+            ev->cid = c1->cid;
+            ev->event = BINDER_DATA_CALL_REMOVED;
+            ev->call = c1;
+            ev++;
+            l1 = l1->next;
+        } else {
+            if (!binder_data_call_equal(c1, c2)) {
+                ev->cid = c2->cid;
+                ev->event = BINDER_DATA_CALL_CHANGED;
+                ev->call = c2;
+                ev++;
+            }
+            l1 = l1->next;
+            l2 = l2->next;
         }
-        l = l->next;
     }
-    return FALSE;
+    return ev - events;
 }
 
 /* extern */
-BinderDataCall*
-binder_data_call_find(
-    GSList* l,
+const BinderDataCall*
+binder_data_get_call(
+    BinderData* data,
     int cid)
 {
-    while (l) {
-        BinderDataCall* call = l->data;
+    BinderDataObject* self = binder_data_cast(data);
 
-        if (call->cid == cid) {
-            return call;
-        }
-        l = l->next;
-    }
-    return NULL;
+    return G_LIKELY(self) ? g_hash_table_lookup(self->call_table,
+        GINT_TO_POINTER(cid)) : NULL;
 }
 
 static
@@ -828,22 +906,35 @@ binder_data_set_calls(
     BinderData* data = &self->pub;
     GHashTableIter it;
     gpointer key;
+    BinderDataCallEventRec* events = g_new(BinderDataCallEventRec,
+        g_slist_length(data->calls) + g_slist_length(list));
+    const guint n = binder_data_call_list_diff(data->calls, list, events);
 
-    if (binder_data_call_list_equal(data->calls, list)) {
+    if (!n) {
         binder_data_call_list_free(list);
     } else {
+        GSList* old_calls = data->calls;
+        guint i;
+
         DBG("data calls changed");
-        binder_data_call_list_free(data->calls);
         data->calls = list;
+        binder_data_call_table_rebuild(self);
         binder_base_queue_property_change(base, BINDER_DATA_PROPERTY_CALLS);
+
+        /* Removed calls stay alive until all events have been emitted */
+        for (i = 0; i < n; i++) {
+            const BinderDataCallEventRec* ev = events + i;
+
+            binder_data_emit_call_event(self, ev->cid, ev->event, ev->call);
+        }
+        binder_data_call_list_free(old_calls);
     }
+    g_free(events);
 
     /* Clean up the grab table */
     g_hash_table_iter_init(&it, self->grab);
     while (g_hash_table_iter_next(&it, &key, NULL)) {
-        const int cid = GPOINTER_TO_INT(key);
-
-        if (!binder_data_call_find(data->calls, cid)) {
+        if (!g_hash_table_contains(self->call_table, key)) {
             g_hash_table_iter_remove(&it);
         }
     }
@@ -1151,38 +1242,291 @@ binder_data_request_cancel_io(
 }
 
 static
-void
-binder_data_request_submit_next(
+gboolean
+binder_data_request_unlink(
+    BinderDataRequest* dr)
+{
+    BinderDataRequestQueue* q = dr->data->req_queue + dr->priority;
+    BinderDataRequest* prev = NULL;
+    BinderDataRequest* ptr = q->first;
+
+    /* Lanes are short, the walk only happens when a request is canceled */
+    while (ptr && ptr != dr) {
+        prev = ptr;
+        ptr = ptr->next;
+    }
+
+    if (ptr) {
+        if (prev) {
+            prev->next = dr->next;
+        } else {
+            q->first = dr->next;
+        }
+        if (q->last == dr) {
+            q->last = prev;
+        }
+        dr->next = NULL;
+        q->depth--;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_data_request_unlink_retry(
+    BinderDataRequest* dr)
+{
+    BinderDataObject* data = dr->data;
+    BinderDataRequest* prev = NULL;
+    BinderDataRequest* ptr = data->retry_wait;
+
+    while (ptr && ptr != dr) {
+        prev = ptr;
+        ptr = ptr->next;
+    }
+
+    if (ptr) {
+        if (prev) {
+            prev->next = dr->next;
+        } else {
+            data->retry_wait = dr->next;
+        }
+        dr->next = NULL;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+BinderDataRequest*
+binder_data_request_dequeue(
     BinderDataObject* data)
 {
-    if (!data->pending_req) {
-        int submission_failure = 0;
+    int i;
+
+    for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+        BinderDataRequestQueue* q = data->req_queue + i;
+        BinderDataRequest* dr = q->first;
 
-        binder_data_power_update(data);
-        while (data->req_queue) {
-            BinderDataRequest* dr = data->req_queue;
+        if (dr) {
+            BinderDataRequestStats* stats = data->req_stats + i;
+            const gint64 wait = g_get_monotonic_time() - dr->queued;
 
-            GASSERT(dr->data == data);
-            data->req_queue = dr->next;
+            if (!(q->first = dr->next)) {
+                q->last = NULL;
+            }
             dr->next = NULL;
+            q->depth--;
 
-            data->pending_req = dr;
-            if (dr->submit(dr)) {
-                DBG_(data, "submitted %s request %p", dr->name, dr);
-                break;
-            } else {
-                DBG_(data, "%s request %p done (or failed)", dr->name, dr);
-                data->pending_req = NULL;
-                if (dr->flags & DATA_REQUEST_FLAG_SUBMISSION_FAILURE) {
-                    submission_failure++;
+            stats->submitted++;
+            stats->total_wait_us += wait;
+            if (stats->max_wait_us < wait) {
+                stats->max_wait_us = wait;
+            }
+            DBG_(data, "%s request %p waited %d ms", dr->name, dr,
+                (int)(wait / 1000));
+            return dr;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+binder_data_request_stats_dump(
+    BinderDataObject* data)
+{
+    static const char* lane[DATA_REQUEST_PRIORITY_COUNT] = {
+        "teardown", "allow", "setup"
+    };
+    int i;
+
+    for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+        const BinderDataRequestStats* stats = data->req_stats + i;
+
+        if (stats->submitted || stats->coalesced) {
+            DBG_(data, "%s: %u submitted, %u coalesced, max depth %u, "
+                "wait avg %d ms, max %d ms", lane[i], stats->submitted,
+                stats->coalesced, stats->max_depth, stats->submitted ?
+                (int)(stats->total_wait_us / stats->submitted / 1000) : 0,
+                (int)(stats->max_wait_us / 1000));
+        }
+    }
+}
+
+static
+void
+binder_data_retry_stats_dump(
+    const char* apn,
+    const BinderDataRetryStats* stats,
+    void* user_data)
+{
+    BinderDataObject* data = THIS(user_data);
+
+    DBG_(data, "%s: %u attempts (%u retries), %u connected, %u failed, "
+        "connect avg %u ms, max %u ms, max %u attempts", apn,
+        stats->attempts, stats->retries, stats->connected, stats->failed,
+        stats->connected ? (stats->total_connect_ms / stats->connected) : 0,
+        stats->max_connect_ms, stats->max_attempts);
+}
+
+static
+gboolean
+binder_data_requests_pending(
+    BinderDataObject* data)
+{
+    int i;
+
+    if (data->pending_req || data->pending_setup || data->retry_wait) {
+        return TRUE;
+    }
+    for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+        if (data->req_queue[i].first) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*
+ * Two setupDataCall requests for the same APN (or the same explicitly
+ * configured data profile) are never submitted concurrently. Profiles
+ * shared by everything (default and invalid) don't count.
+ */
+static
+gboolean
+binder_data_request_setup_conflict(
+    const BinderDataRequest* dr1,
+    const BinderDataRequest* dr2)
+{
+    const BinderDataRequestSetup* s1 = G_CAST(dr1, BinderDataRequestSetup,
+        req);
+    const BinderDataRequestSetup* s2 = G_CAST(dr2, BinderDataRequestSetup,
+        req);
+
+    return !g_ascii_strcasecmp(s1->apn ? s1->apn : "",
+        s2->apn ? s2->apn : "") || (s1->profile_id == s2->profile_id &&
+        s1->profile_id != RADIO_DATA_PROFILE_DEFAULT &&
+        s1->profile_id != RADIO_DATA_PROFILE_INVALID);
+}
+
+static
+BinderDataRequest*
+binder_data_request_next(
+    BinderDataObject* data)
+{
+    if (data->pending_req) {
+        /* Nothing overlaps with teardown and allow requests */
+        return NULL;
+    } else if (data->req_queue[DATA_REQUEST_PRIORITY_TEARDOWN].first ||
+        data->req_queue[DATA_REQUEST_PRIORITY_ALLOW].first) {
+        /* Those have to wait until all setups are done */
+        return data->pending_setup ? NULL :
+            binder_data_request_dequeue(data);
+    } else {
+        const BinderDataRequest* next =
+            data->req_queue[DATA_REQUEST_PRIORITY_SETUP].first;
+
+        if (next && data->pending_setup_count <
+            data->options.data_call_setup_concurrency) {
+            const BinderDataRequest* dr;
+
+            /* Requests for the same APN are still submitted in order */
+            for (dr = data->pending_setup; dr; dr = dr->next) {
+                if (binder_data_request_setup_conflict(dr, next)) {
+                    return NULL;
+                }
+            }
+            for (dr = data->retry_wait; dr; dr = dr->next) {
+                if (binder_data_request_setup_conflict(dr, next)) {
+                    return NULL;
                 }
-                binder_data_request_free(dr);
             }
+            return binder_data_request_dequeue(data);
         }
+        return NULL;
+    }
+}
+
+static
+void
+binder_data_request_set_pending(
+    BinderDataRequest* dr)
+{
+    BinderDataObject* data = dr->data;
+
+    GASSERT(!dr->next);
+    if (dr->priority == DATA_REQUEST_PRIORITY_SETUP) {
+        dr->next = data->pending_setup;
+        data->pending_setup = dr;
+        data->pending_setup_count++;
+    } else {
+        GASSERT(!data->pending_req);
+        data->pending_req = dr;
+    }
+}
 
-        if (!data->pending_req && !submission_failure) {
-            binder_data_manager_check_data(data->dm);
+static
+gboolean
+binder_data_request_clear_pending(
+    BinderDataRequest* dr)
+{
+    BinderDataObject* data = dr->data;
+
+    if (data->pending_req == dr) {
+        data->pending_req = NULL;
+        return TRUE;
+    } else if (dr->priority == DATA_REQUEST_PRIORITY_SETUP) {
+        BinderDataRequest* prev = NULL;
+        BinderDataRequest* ptr = data->pending_setup;
+
+        while (ptr && ptr != dr) {
+            prev = ptr;
+            ptr = ptr->next;
         }
+
+        if (ptr) {
+            if (prev) {
+                prev->next = dr->next;
+            } else {
+                data->pending_setup = dr->next;
+            }
+            dr->next = NULL;
+            data->pending_setup_count--;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static
+void
+binder_data_request_submit_next(
+    BinderDataObject* data)
+{
+    int submission_failure = 0;
+    BinderDataRequest* dr;
+
+    binder_data_power_update(data);
+    while ((dr = binder_data_request_next(data)) != NULL) {
+        GASSERT(dr->data == data);
+        binder_data_request_set_pending(dr);
+        if (dr->submit(dr)) {
+            DBG_(data, "submitted %s request %p", dr->name, dr);
+        } else {
+            DBG_(data, "%s request %p done (or failed)", dr->name, dr);
+            binder_data_request_clear_pending(dr);
+            if (dr->flags & DATA_REQUEST_FLAG_SUBMISSION_FAILURE) {
+                submission_failure++;
+            }
+            binder_data_request_free(dr);
+        }
+    }
+
+    if (!data->pending_req && !data->pending_setup && !data->retry_wait &&
+        !submission_failure) {
+        binder_data_manager_check_data(data->dm);
     }
     binder_data_power_update(data);
 }
@@ -1199,25 +1543,13 @@ binder_data_request_do_cancel(
         if (dr->cancel) {
             dr->cancel(dr);
         }
-        if (data->pending_req == dr) {
+        if (binder_data_request_clear_pending(dr)) {
             /* Request has been submitted already */
-            data->pending_req = NULL;
-        } else if (data->req_queue == dr) {
-            /* It's the first one in the queue */
-            data->req_queue = dr->next;
-        } else {
-            /* It's somewhere in the queue */
-            BinderDataRequest* prev = data->req_queue;
-
-            while (prev->next && prev->next != dr) {
-                prev = prev->next;
-            }
-
-            /* Assert that it's there */
-            GASSERT(prev);
-            if (prev) {
-                prev->next = dr->next;
-            }
+        } else if (binder_data_request_unlink_retry(dr)) {
+            /* Request was waiting to be retried */
+        } else if (!binder_data_request_unlink(dr)) {
+            /* It must be somewhere in the queue */
+            GASSERT(FALSE);
         }
 
         binder_data_request_free(dr);
@@ -1257,35 +1589,92 @@ binder_data_request_finish(
 {
     BinderDataObject* data = dr->data;
 
-    GASSERT(dr == data->pending_req);
-    GASSERT(!dr->next);
-    data->pending_req = NULL;
+    if (!binder_data_request_clear_pending(dr)) {
+        GASSERT(FALSE);
+    }
 
     binder_data_request_free(dr);
     binder_data_request_submit_next(data);
 }
 
+static
+void
+binder_data_request_coalesce(
+    BinderDataRequest* dr)
+{
+    BinderDataObject* data = dr->data;
+    BinderDataRequestQueue* q = data->req_queue + dr->priority;
+    BinderDataRequest* ptr = q->first;
+
+    /*
+     * Only the final state matters for setDataAllowed and
+     * setPreferredDataModem. The one that's already been submitted
+     * is left alone, but the ones still waiting in the queue get
+     * superseded by the new request.
+     */
+    while (ptr) {
+        BinderDataRequest* next = ptr->next;
+
+        if (ptr->submit == dr->submit) {
+            DBG_(data, "%s request %p supersedes %p", dr->name, dr, ptr);
+            binder_data_request_unlink(ptr);
+            binder_data_request_free(ptr);
+            data->req_stats[dr->priority].coalesced++;
+        }
+        ptr = next;
+    }
+}
+
 static
 void
 binder_data_request_queue(
     BinderDataRequest* dr)
 {
     BinderDataObject* data = dr->data;
+    BinderDataRequestQueue* q = data->req_queue + dr->priority;
+    BinderDataRequestStats* stats = data->req_stats + dr->priority;
 
-    dr->next = NULL;
+    if (dr->priority == DATA_REQUEST_PRIORITY_ALLOW) {
+        binder_data_request_coalesce(dr);
+    }
 
-    if (!data->req_queue) {
-        data->req_queue = dr;
+    /* Append to the tail of its lane */
+    dr->next = NULL;
+    dr->queued = g_get_monotonic_time();
+    if (q->last) {
+        q->last->next = dr;
     } else {
-        BinderDataRequest* last = data->req_queue;
+        q->first = dr;
+    }
+    q->last = dr;
+    if (stats->max_depth < ++q->depth) {
+        stats->max_depth = q->depth;
+    }
 
-        while (last->next) {
-            last = last->next;
-        }
-        last->next = dr;
+    DBG_(data, "queued %s request %p (%u)", dr->name, dr, q->depth);
+    binder_data_request_submit_next(data);
+}
+
+static
+void
+binder_data_request_requeue(
+    BinderDataRequest* dr)
+{
+    BinderDataObject* data = dr->data;
+    BinderDataRequestQueue* q = data->req_queue + dr->priority;
+    BinderDataRequestStats* stats = data->req_stats + dr->priority;
+
+    /* Back to the head of its lane, it's been waiting long enough */
+    dr->queued = g_get_monotonic_time();
+    if (!(dr->next = q->first)) {
+        q->last = dr;
+    }
+    q->first = dr;
+    if (stats->max_depth < ++q->depth) {
+        stats->max_depth = q->depth;
     }
 
-    DBG_(data, "queued %s request %p", dr->name, dr);
+    DBG_(data, "requeued %s request %p (%u)", dr->name, dr, q->depth);
     binder_data_request_submit_next(data);
 }
 
@@ -1301,6 +1690,7 @@ binder_data_call_setup_cancel(
     BinderDataRequestSetup* setup = G_CAST(dr, BinderDataRequestSetup, req);
 
     binder_data_request_cancel_io(dr);
+    binder_data_retry_reset(dr->data->retry, setup->apn);
     if (setup->retry_delay_id) {
         g_source_remove(setup->retry_delay_id);
         setup->retry_delay_id = 0;
@@ -1323,36 +1713,69 @@ binder_data_call_setup_retry(
 
     GASSERT(setup->retry_delay_id);
     setup->retry_delay_id = 0;
-    setup->retry_count++;
-    DBG("silent retry %u out of %u", setup->retry_count,
-        dr->data->options.data_call_retry_limit);
-    dr->submit(dr);
+    DBG_(dr->data, "silent retry for %s", setup->apn);
+    if (binder_data_request_unlink_retry(dr)) {
+        binder_data_request_requeue(dr);
+    } else {
+        GASSERT(FALSE);
+    }
     return G_SOURCE_REMOVE;
 }
 
+static
+gboolean
+binder_data_call_fail_permanent(
+    RADIO_DATA_CALL_FAIL_CAUSE status)
+{
+    switch (status) {
+    case RADIO_DATA_CALL_FAIL_OPERATOR_BARRED:
+    case RADIO_DATA_CALL_FAIL_MISSING_UKNOWN_APN:
+    case RADIO_DATA_CALL_FAIL_UNKNOWN_PDP_ADDRESS_TYPE:
+    case RADIO_DATA_CALL_FAIL_USER_AUTHENTICATION:
+    case RADIO_DATA_CALL_FAIL_ACTIVATION_REJECT_GGSN:
+    case RADIO_DATA_CALL_FAIL_SERVICE_OPTION_NOT_SUPPORTED:
+    case RADIO_DATA_CALL_FAIL_SERVICE_OPTION_NOT_SUBSCRIBED:
+    case RADIO_DATA_CALL_FAIL_NSAPI_IN_USE:
+    case RADIO_DATA_CALL_FAIL_ONLY_IPV4_ALLOWED:
+    case RADIO_DATA_CALL_FAIL_ONLY_IPV6_ALLOWED:
+    case RADIO_DATA_CALL_FAIL_PROTOCOL_ERRORS:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
 static
 gboolean
 binder_data_call_retry(
-    BinderDataRequestSetup* setup)
+    BinderDataRequestSetup* setup,
+    int suggested_ms)
 {
     BinderDataRequest* dr = &setup->req;
-    const BinderDataOptions* options = &dr->data->options;
+    BinderDataObject* self = dr->data;
+    const int ms = binder_data_retry_delay(self->retry, setup->apn,
+        suggested_ms);
 
-    if (setup->retry_count < options->data_call_retry_limit) {
+    if (ms != BINDER_DATA_RETRY_NONE) {
         binder_data_request_cancel_io(dr);
         GASSERT(!setup->retry_delay_id);
-        if (!setup->retry_count) {
-            /* No delay first time */
-            setup->retry_count++;
-            DBG("silent retry %u out of %u", setup->retry_count,
-                options->data_call_retry_limit);
+        if (!ms) {
+            DBG_(self, "silent retry for %s", setup->apn);
             dr->submit(dr);
         } else {
-            const guint ms = options->data_call_retry_delay_ms;
+            DBG_(self, "silent retry for %s scheduled in %d ms",
+                setup->apn, ms);
 
-            DBG("silent retry scheduled in %u ms", ms);
+            /* Don't hold the setup slot while waiting */
+            if (binder_data_request_clear_pending(dr)) {
+                dr->next = self->retry_wait;
+                self->retry_wait = dr;
+            } else {
+                GASSERT(FALSE);
+            }
             setup->retry_delay_id = g_timeout_add(ms,
                 binder_data_call_setup_retry, setup);
+            binder_data_request_submit_next(self);
         }
         return TRUE;
     }
@@ -1440,12 +1863,15 @@ binder_data_call_setup_cb(
         BinderNetwork* network = self->network;
 
         switch (call->status) {
+        case RADIO_DATA_CALL_FAIL_NONE:
+            break;
         case RADIO_DATA_CALL_FAIL_UNSPECIFIED:
             /*
              * First time we retry immediately and if that doesn't work,
-             * then after certain delay.
+             * then after the delay suggested by the modem or with the
+             * exponential backoff.
              */
-            if (binder_data_call_retry(setup)) {
+            if (binder_data_call_retry(setup, call->retry_time)) {
                 binder_data_call_free(call);
                 return;
             }
@@ -1467,26 +1893,61 @@ binder_data_call_setup_cb(
             }
             break;
         default:
+            /*
+             * Other failures are only retried if the modem asks for
+             * it, and never if retrying can't possibly help.
+             */
+            if (call->retry_time >= 0 &&
+                !binder_data_call_fail_permanent(call->status) &&
+                binder_data_call_retry(setup, call->retry_time)) {
+                binder_data_call_free(call);
+                return;
+            }
             break;
         }
     }
 
     binder_data_request_completed(dr);
+    binder_data_retry_done(self->retry, setup->apn, call &&
+        call->status == RADIO_DATA_CALL_FAIL_NONE);
     free_call = call;
 
     if (call && call->status == RADIO_DATA_CALL_FAIL_NONE) {
+        gpointer key = GINT_TO_POINTER(call->cid);
+        BinderDataCall* old = g_hash_table_lookup(self->call_table, key);
+
         if (self->downgraded_tech) {
             DBG("done with status 55 workaround");
             self->downgraded_tech = FALSE;
             binder_data_manager_check_network_mode(self->dm);
         }
 
-        if (!binder_data_call_list_contains(data->calls, call)) {
+        if (!old) {
             data->calls = g_slist_insert_sorted(data->calls, call,
                 binder_data_call_compare);
+            g_hash_table_insert(self->call_table, key, call);
             DBG_(self, "new data call");
             binder_base_queue_property_change(base, BINDER_DATA_PROPERTY_CALLS);
+            binder_data_emit_call_event(self, call->cid,
+                BINDER_DATA_CALL_ADDED, call);
             free_call = NULL;
+        } else if (!binder_data_call_equal(old, call)) {
+            GSList* link = g_slist_find(data->calls, old);
+
+            /* call_table is supposed to mirror the list */
+            GASSERT(link);
+            if (link) {
+                link->data = call;
+            } else {
+                data->calls = g_slist_insert_sorted(data->calls, call,
+                    binder_data_call_compare);
+            }
+            g_hash_table_insert(self->call_table, key, call);
+            DBG_(self, "data call %d updated", call->cid);
+            binder_base_queue_property_change(base, BINDER_DATA_PROPERTY_CALLS);
+            binder_data_emit_call_event(self, call->cid,
+                BINDER_DATA_CALL_CHANGED, call);
+            free_call = old;
         }
     }
 
@@ -1703,7 +2164,11 @@ binder_data_call_setup_submit(
         gbinder_writer_append_bool(&writer, FALSE); /* matchAllRuleAllowed */
     }
 
-    return binder_data_request_call(dr, req);
+    if (binder_data_request_call(dr, req)) {
+        binder_data_retry_attempt(data->retry, setup->apn);
+        return TRUE;
+    }
+    return FALSE;
 }
 
 static
@@ -1758,6 +2223,7 @@ binder_data_call_setup_new(
     setup->auth_method = ctx->auth_method;
 
     dr->name = "CALL_SETUP";
+    dr->priority = DATA_REQUEST_PRIORITY_SETUP;
     dr->cb.setup = cb;
     dr->arg = arg;
     dr->data = data;
@@ -1821,10 +2287,13 @@ binder_data_call_deact_cb(
                  * don't send dataCallListChanged even though the list of calls
                  * has changed. Update the list of calls to account for that.
                  */
-                call = binder_data_call_find(data->calls, deact->cid);
+                gpointer key = GINT_TO_POINTER(deact->cid);
+
+                call = g_hash_table_lookup(self->call_table, key);
                 if (call) {
                     DBG_(self, "removing call %d", deact->cid);
                     data->calls = g_slist_remove(data->calls, call);
+                    g_hash_table_remove(self->call_table, key);
                 }
             } else {
                 ofono_error("Unexpected deactivateDataCall response %d", resp);
@@ -1836,6 +2305,8 @@ binder_data_call_deact_cb(
     }
 
     if (call) {
+        binder_data_emit_call_event(self, call->cid,
+            BINDER_DATA_CALL_REMOVED, call);
         binder_data_call_free(call);
         binder_base_emit_property_change(base, BINDER_DATA_PROPERTY_CALLS);
     } else {
@@ -1881,6 +2352,7 @@ binder_data_call_deact_new(
     dr->submit = binder_data_call_deact_submit;
     dr->cancel = binder_data_call_deact_cancel;
     dr->name = "DEACTIVATE";
+    dr->priority = DATA_REQUEST_PRIORITY_TEARDOWN;
     return dr;
 }
 
@@ -1978,6 +2450,7 @@ binder_data_set_preferred_data_modem_new(
     BinderDataRequest* dr = g_new0(BinderDataRequest, 1);
 
     dr->name = "SET_PREFERRED_DATA_MODEM";
+    dr->priority = DATA_REQUEST_PRIORITY_ALLOW;
     dr->data = data;
     dr->submit = binder_data_set_preferred_data_modem_submit;
     dr->cancel = binder_data_request_cancel_io;
@@ -2063,6 +2536,7 @@ binder_data_allow_new(
     BinderDataRequest* dr = &ad->req;
 
     dr->name = "ALLOW_DATA";
+    dr->priority = DATA_REQUEST_PRIORITY_ALLOW;
     dr->data = data;
     dr->submit = binder_data_allow_submit;
     dr->cancel = binder_data_request_cancel_io;
@@ -2120,6 +2594,18 @@ binder_data_max_allowed_modes(
         OFONO_RADIO_ACCESS_MODE_ALL;
 }
 
+static
+void
+binder_data_call_event_cb(
+    BinderDataObject* self,
+    int cid,
+    guint event,
+    const BinderDataCall* call,
+    BinderDataCallClosure* closure)
+{
+    closure->cb(&self->pub, cid, event, call, closure->user_data);
+}
+
 gulong
 binder_data_add_property_handler(
     BinderData* data,
@@ -2133,6 +2619,32 @@ binder_data_add_property_handler(
         property, G_CALLBACK(callback), user_data) : 0;
 }
 
+gulong
+binder_data_add_call_handler(
+    BinderData* data,
+    int cid,
+    BinderDataCallEventFunc cb,
+    void* user_data)
+{
+    BinderDataObject* self = binder_data_cast(data);
+
+    if (G_LIKELY(self) && G_LIKELY(cb)) {
+        BinderDataCallClosure* closure = (BinderDataCallClosure *)
+            g_closure_new_simple(sizeof(BinderDataCallClosure), NULL);
+        GCClosure* cc = &closure->cclosure;
+
+        cc->closure.data = closure;
+        cc->callback = G_CALLBACK(binder_data_call_event_cb);
+        closure->cb = cb;
+        closure->user_data = user_data;
+        return g_signal_connect_closure_by_id(self,
+            binder_data_signals[SIGNAL_CALL_EVENT],
+            (cid < 0) ? 0 : binder_data_call_quark(cid),
+            &cc->closure, FALSE);
+    }
+    return 0;
+}
+
 void
 binder_data_remove_handler(
     BinderData* data,
@@ -2221,6 +2733,12 @@ binder_data_new(
         BinderSimSettings* settings = network->settings;
 
         self->options = *options;
+        if (!self->options.data_call_setup_concurrency) {
+            self->options.data_call_setup_concurrency = 1;
+        }
+        self->retry = binder_data_retry_new(options->data_call_retry_limit,
+            options->data_call_retry_delay_ms,
+            options->data_call_retry_max_delay_ms);
         self->log_prefix = binder_dup_prefix(name);
         self->profile_config = config->data_profile_config;
         self->slot = config->slot;
@@ -2378,7 +2896,7 @@ void
 binder_data_power_update(
     BinderDataObject* self)
 {
-    if (self->pending_req || self->req_queue) {
+    if (binder_data_requests_pending(self)) {
         binder_radio_power_on(self->radio, self);
     } else {
         binder_radio_power_off(self->radio, self);
@@ -2391,20 +2909,50 @@ binder_data_cancel_requests(
     BinderDataObject* self,
     BINDER_DATA_REQUEST_FLAGS flags)
 {
-    BinderDataRequest* dr = self->req_queue;
+    BinderDataRequest* dr;
+    gboolean canceled = FALSE;
+    int i;
 
-    while (dr) {
-        BinderDataRequest* next = dr->next;
+    for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+        dr = self->req_queue[i].first;
+        while (dr) {
+            BinderDataRequest* next = dr->next;
 
-        GASSERT(dr->data == self);
-        if (dr->flags & flags) {
-            binder_data_request_do_cancel(dr);
+            GASSERT(dr->data == self);
+            if (dr->flags & flags) {
+                binder_data_request_do_cancel(dr);
+            }
+            dr = next;
+        }
+    }
+
+    /* Cancel callbacks may touch the lists, restart after each one */
+    dr = self->retry_wait;
+    while (dr) {
+        if ((dr->flags & flags) && binder_data_request_do_cancel(dr)) {
+            canceled = TRUE;
+            dr = self->retry_wait;
+        } else {
+            dr = dr->next;
         }
-        dr = next;
     }
 
     if (self->pending_req && (self->pending_req->flags & flags)) {
         binder_data_request_cancel(self->pending_req);
+    } else {
+        dr = self->pending_setup;
+        while (dr) {
+            if ((dr->flags & flags) && binder_data_request_do_cancel(dr)) {
+                canceled = TRUE;
+                dr = self->pending_setup;
+            } else {
+                dr = dr->next;
+            }
+        }
+    }
+
+    if (canceled) {
+        binder_data_request_submit_next(self);
     }
 }
 
@@ -2413,14 +2961,24 @@ void
 binder_data_cancel_all_requests(
     BinderDataObject* self)
 {
-    BinderDataRequest* dr = self->req_queue;
+    int i;
 
     binder_data_request_do_cancel(self->pending_req);
-    while (dr) {
-        BinderDataRequest* next = dr->next;
+    while (self->pending_setup) {
+        binder_data_request_do_cancel(self->pending_setup);
+    }
+    while (self->retry_wait) {
+        binder_data_request_do_cancel(self->retry_wait);
+    }
+    for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+        BinderDataRequest* dr = self->req_queue[i].first;
+
+        while (dr) {
+            BinderDataRequest* next = dr->next;
 
-        binder_data_request_do_cancel(dr);
-        dr = next;
+            binder_data_request_do_cancel(dr);
+            dr = next;
+        }
     }
 }
 
@@ -2576,7 +3134,8 @@ binder_data_call_grab(
 {
     BinderDataObject* self = binder_data_cast(data);
 
-    if (self && cookie && binder_data_call_find(data->calls, cid)) {
+    if (self && cookie && g_hash_table_contains(self->call_table,
+        GINT_TO_POINTER(cid))) {
         gpointer key = GINT_TO_POINTER(cid);
         void* prev = g_hash_table_lookup(self->grab, key);
 
@@ -2609,6 +3168,7 @@ binder_data_object_init(
     BinderDataObject* self)
 {
     self->grab = g_hash_table_new(g_direct_hash, g_direct_equal);
+    self->call_table = g_hash_table_new(g_direct_hash, g_direct_equal);
 }
 
 static
@@ -2623,6 +3183,10 @@ binder_data_object_finalize(
     BinderDataManager* dm = self->dm;
 
     binder_data_cancel_all_requests(self);
+    binder_data_request_stats_dump(self);
+    binder_data_retry_foreach_stats(self->retry,
+        binder_data_retry_stats_dump, self);
+    binder_data_retry_free(self->retry);
     dm->data_list = g_slist_remove(dm->data_list, self);
     binder_data_manager_check_data(dm);
 
@@ -2641,6 +3205,7 @@ binder_data_object_finalize(
     binder_data_call_list_free(data->calls);
 
     g_hash_table_destroy(self->grab);
+    g_hash_table_destroy(self->call_table);
     g_free(self->log_prefix);
 
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
@@ -2651,8 +3216,11 @@ void
 binder_data_object_class_init(
     BinderDataObjectClass* klass)
 {
-
     G_OBJECT_CLASS(klass)->finalize = binder_data_object_finalize;
+    binder_data_signals[SIGNAL_CALL_EVENT] =
+        g_signal_new(SIGNAL_CALL_EVENT_NAME, G_OBJECT_CLASS_TYPE(klass),
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_DETAILED, 0, NULL, NULL, NULL,
+            G_TYPE_NONE, 3, G_TYPE_INT, G_TYPE_UINT, G_TYPE_POINTER);
 }
 
 /*==========================================================================*
@@ -2875,7 +3443,7 @@ binder_data_manager_requests_pending(
     for (l = dm->data_list; l; l = l->next) {
         BinderDataObject* data = THIS(l->data);
 
-        if (data->pending_req || data->req_queue) {
+        if (binder_data_requests_pending(data)) {
             return TRUE;
         }
     }
@@ -16,7 +16,7 @@
 #ifndef BINDER_DATA_H
 #define BINDER_DATA_H
 
-#include "binder_types.h"
+#include "binder_data_call.h"
 
 #include <gbinder_writer.h>
 
@@ -32,20 +32,6 @@ typedef enum binder_data_property {
     BINDER_DATA_PROPERTY_COUNT
 } BINDER_DATA_PROPERTY;
 
-typedef struct binder_data_call {
-    int cid;
-    RADIO_DATA_CALL_FAIL_CAUSE status;
-    RADIO_DATA_CALL_ACTIVE_STATUS active;
-    enum ofono_gprs_proto prot;
-    int retry_time;
-    int mtu;
-    char* ifname;
-    char** dnses;
-    char** gateways;
-    char** addresses;
-    char** pcscf;
-} BinderDataCall;
-
 struct binder_data {
     GSList* calls;
 };
@@ -64,10 +50,18 @@ typedef struct binder_data_options {
     BINDER_DATA_ALLOW_DATA allow_data;
     unsigned int data_call_retry_limit;
     unsigned int data_call_retry_delay_ms;
+    unsigned int data_call_retry_max_delay_ms;
+    unsigned int data_call_setup_concurrency;
 } BinderDataOptions;
 
 typedef struct binder_data_request BinderDataRequest;
 
+typedef enum binder_data_call_event {
+    BINDER_DATA_CALL_ADDED,
+    BINDER_DATA_CALL_CHANGED,
+    BINDER_DATA_CALL_REMOVED
+} BINDER_DATA_CALL_EVENT;
+
 typedef
 void
 (*BinderDataPropertyFunc)(
@@ -75,6 +69,16 @@ void
     BINDER_DATA_PROPERTY property,
     void* user_data);
 
+/* Removed call is only valid for the duration of the callback */
+typedef
+void
+(*BinderDataCallEventFunc)(
+    BinderData* data,
+    int cid,
+    BINDER_DATA_CALL_EVENT event,
+    const BinderDataCall* call,
+    void* user_data);
+
 typedef
 void
 (*BinderDataCallSetupFunc)(
@@ -168,6 +172,15 @@ binder_data_add_property_handler(
     void* user_data)
     BINDER_INTERNAL;
 
+/* Negative cid subscribes to the events for all calls */
+gulong
+binder_data_add_call_handler(
+    BinderData* data,
+    int cid,
+    BinderDataCallEventFunc cb,
+    void* user_data)
+    BINDER_INTERNAL;
+
 void
 binder_data_remove_handler(
     BinderData* data,
@@ -221,19 +234,9 @@ binder_data_call_release(
     void* cookie)
     BINDER_INTERNAL;
 
-void
-binder_data_call_free(
-    BinderDataCall* call)
-    BINDER_INTERNAL;
-
-BinderDataCall*
-binder_data_call_dup(
-    const BinderDataCall* call)
-    BINDER_INTERNAL;
-
-BinderDataCall*
-binder_data_call_find(
-    GSList* list,
+const BinderDataCall*
+binder_data_get_call(
+    BinderData* data,
     int cid)
     BINDER_INTERNAL;
 
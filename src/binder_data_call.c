@@ -0,0 +1,287 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_data_call.h"
+#include "binder_log.h"
+
+#include <gutil_misc.h>
+
+#include <arpa/inet.h>
+
+static
+guint
+binder_data_call_addr_offset(
+    const BinderDataCall* call,
+    BINDER_DATA_ADDR_TYPE type)
+{
+    guint i, offset = 0;
+
+    for (i = 0; i < type; i++) {
+        offset += call->count[i];
+    }
+    return offset;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+binder_data_call_builder_init(
+    BinderDataCallBuilder* builder)
+{
+    int i;
+
+    memset(builder, 0, sizeof(*builder));
+    for (i = 0; i < BINDER_DATA_ADDR_TYPE_COUNT; i++) {
+        builder->addr[i] = g_array_new(FALSE, TRUE, sizeof(BinderDataAddr));
+    }
+}
+
+void
+binder_data_call_builder_set_ifname(
+    BinderDataCallBuilder* builder,
+    const char* ifname)
+{
+    g_free(builder->ifname);
+    builder->ifname = g_strdup(ifname);
+}
+
+void
+binder_data_call_builder_add(
+    BinderDataCallBuilder* builder,
+    BINDER_DATA_ADDR_TYPE type,
+    const char* list)
+{
+    if (list) {
+        const char* ptr = list;
+
+        /* The list may contain several space separated addresses */
+        while (*ptr) {
+            const char* end;
+
+            while (g_ascii_isspace(*ptr)) ptr++;
+            end = ptr;
+            while (*end && !g_ascii_isspace(*end)) end++;
+
+            if (end > ptr) {
+                BinderDataAddr addr;
+
+                if (binder_data_addr_parse(ptr, end - ptr, &addr)) {
+                    g_array_append_val(builder->addr[type], addr);
+                } else {
+                    GWARN("Can't parse address %.*s", (int)(end - ptr), ptr);
+                }
+            }
+            ptr = end;
+        }
+    }
+}
+
+BinderDataCall*
+binder_data_call_builder_finish(
+    BinderDataCallBuilder* builder)
+{
+    const char* ifname = builder->ifname ? builder->ifname : "";
+    const gsize ifname_size = strlen(ifname) + 1;
+    guint i, n = 0;
+    BinderDataCall* call;
+    BinderDataAddr* ptr;
+
+    for (i = 0; i < BINDER_DATA_ADDR_TYPE_COUNT; i++) {
+        const guint count = MIN(builder->addr[i]->len, G_MAXUINT8);
+
+        builder->call.count[i] = count;
+        n += count;
+    }
+
+    builder->call.size = sizeof(BinderDataCall) + n * sizeof(BinderDataAddr) +
+        ifname_size;
+    call = g_malloc0(builder->call.size);
+    memcpy(call, &builder->call, sizeof(BinderDataCall));
+    ptr = call->addr;
+    for (i = 0; i < BINDER_DATA_ADDR_TYPE_COUNT; i++) {
+        GArray* addr = builder->addr[i];
+
+        memcpy(ptr, addr->data, call->count[i] * sizeof(BinderDataAddr));
+        ptr += call->count[i];
+        g_array_free(addr, TRUE);
+        builder->addr[i] = NULL;
+    }
+    memcpy(ptr, ifname, ifname_size);
+    g_free(builder->ifname);
+    builder->ifname = NULL;
+    return call;
+}
+
+BinderDataCall*
+binder_data_call_dup(
+    const BinderDataCall* call)
+{
+    return call ? gutil_memdup(call, call->size) : NULL;
+}
+
+void
+binder_data_call_free(
+    BinderDataCall* call)
+{
+    g_free(call);
+}
+
+const char*
+binder_data_call_ifname(
+    const BinderDataCall* call)
+{
+    /* The interface name follows the addresses */
+    return call ? (const char*)(call->addr + binder_data_call_addr_offset(call,
+        BINDER_DATA_ADDR_TYPE_COUNT)) : NULL;
+}
+
+gboolean
+binder_data_call_equal(
+    const BinderDataCall* c1,
+    const BinderDataCall* c2)
+{
+    if (c1 == c2) {
+        return TRUE;
+    } else if (c1 && c2) {
+        return c1->size == c2->size && !memcmp(c1, c2, c1->size);
+    } else {
+        return FALSE;
+    }
+}
+
+const BinderDataAddr*
+binder_data_call_addr(
+    const BinderDataCall* call,
+    BINDER_DATA_ADDR_TYPE type,
+    guint* count)
+{
+    if (call && call->count[type]) {
+        *count = call->count[type];
+        return call->addr + binder_data_call_addr_offset(call, type);
+    }
+    *count = 0;
+    return NULL;
+}
+
+gboolean
+binder_data_call_addr_equal(
+    const BinderDataCall* c1,
+    const BinderDataCall* c2,
+    BINDER_DATA_ADDR_TYPE type)
+{
+    guint n1, n2;
+    const BinderDataAddr* a1 = binder_data_call_addr(c1, type, &n1);
+    const BinderDataAddr* a2 = binder_data_call_addr(c2, type, &n2);
+
+    return n1 == n2 && (!n1 || !memcmp(a1, a2, n1 * sizeof(*a1)));
+}
+
+char*
+binder_data_call_addr_list(
+    const BinderDataCall* call,
+    BINDER_DATA_ADDR_TYPE type)
+{
+    guint i, n;
+    const BinderDataAddr* addr = binder_data_call_addr(call, type, &n);
+    GString* buf = g_string_new(NULL);
+
+    for (i = 0; i < n; i++) {
+        char str[BINDER_DATA_ADDR_STRLEN];
+
+        if (i) {
+            g_string_append_c(buf, ' ');
+        }
+        g_string_append(buf, binder_data_addr_ntop(addr + i, str));
+        if (addr[i].prefix) {
+            g_string_append_printf(buf, "/%u", addr[i].prefix);
+        }
+    }
+    return g_string_free(buf, FALSE);
+}
+
+gboolean
+binder_data_addr_parse(
+    const char* str,
+    gsize len,
+    BinderDataAddr* addr)
+{
+    const char* slash = memchr(str, '/', len);
+    const gsize addr_len = slash ? (gsize)(slash - str) : len;
+    /* IPv6 address may have the scope id (e.g. fe80::1%rmnet0) */
+    const char* scope = memchr(str, '%', addr_len);
+    const gsize ip_len = scope ? (gsize)(scope - str) : addr_len;
+    char buf[BINDER_DATA_ADDR_STRLEN];
+
+    memset(addr, 0, sizeof(*addr));
+    if (ip_len < sizeof(buf)) {
+        memcpy(buf, str, ip_len);
+        buf[ip_len] = 0;
+        if (!scope && inet_pton(AF_INET, buf, &addr->addr.ipv4) > 0) {
+            addr->family = AF_INET;
+        } else if (inet_pton(AF_INET6, buf, &addr->addr.ipv6) > 0) {
+            addr->family = AF_INET6;
+        } else {
+            return FALSE;
+        }
+
+        if (slash) {
+            const guint max = (addr->family == AF_INET) ? 32 : 128;
+            const gsize prefix_len = len - addr_len - 1;
+            char* prefix = g_strndup(slash + 1, prefix_len);
+            guint bits;
+
+            if (gutil_parse_uint(prefix, 10, &bits) && bits <= max) {
+                addr->prefix = bits;
+            }
+            g_free(prefix);
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+const char*
+binder_data_addr_ntop(
+    const BinderDataAddr* addr,
+    char buf[BINDER_DATA_ADDR_STRLEN])
+{
+    return inet_ntop(addr->family, &addr->addr, buf, BINDER_DATA_ADDR_STRLEN);
+}
+
+const char*
+binder_data_addr_netmask(
+    const BinderDataAddr* addr,
+    char buf[BINDER_DATA_ADDR_STRLEN])
+{
+    if (addr->family == AF_INET && addr->prefix) {
+        const guint nbits = addr->prefix;
+        struct in_addr in;
+
+        in.s_addr = htonl((nbits == 32) ? 0xffffffff :
+            ((1u << nbits)-1) << (32-nbits));
+        return inet_ntop(AF_INET, &in, buf, BINDER_DATA_ADDR_STRLEN);
+    }
+    return NULL;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
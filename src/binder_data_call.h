@@ -0,0 +1,162 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_DATA_CALL_H
+#define BINDER_DATA_CALL_H
+
+#include "binder_types.h"
+
+#include <ofono/gprs-context.h>
+
+#include <netinet/in.h>
+
+#define BINDER_DATA_ADDR_STRLEN INET6_ADDRSTRLEN
+
+typedef enum binder_data_addr_type {
+    BINDER_DATA_ADDR_ADDRESS,
+    BINDER_DATA_ADDR_GATEWAY,
+    BINDER_DATA_ADDR_DNS,
+    BINDER_DATA_ADDR_PCSCF,
+    BINDER_DATA_ADDR_TYPE_COUNT
+} BINDER_DATA_ADDR_TYPE;
+
+typedef struct binder_data_addr {
+    guint8 family;  /* AF_INET or AF_INET6 */
+    guint8 prefix;  /* Prefix length, zero if not specified */
+    guint8 reserved[2];
+    union binder_data_addr_bytes {
+        struct in_addr ipv4;
+        struct in6_addr ipv6;
+        guint8 bytes[16];
+    } addr;
+} BinderDataAddr;
+
+/*
+ * The whole thing is a single memory block, addresses are parsed
+ * once when the call is decoded and stored in binary form at the
+ * end of the structure, in the BINDER_DATA_ADDR_TYPE order. They
+ * are followed by the NUL-terminated interface name. Unused bytes
+ * are zeroed, so that two calls can be compared with memcmp.
+ */
+typedef struct binder_data_call {
+    int cid;
+    RADIO_DATA_CALL_FAIL_CAUSE status;
+    RADIO_DATA_CALL_ACTIVE_STATUS active;
+    enum ofono_gprs_proto prot;
+    int retry_time;
+    int mtu;
+    guint8 count[BINDER_DATA_ADDR_TYPE_COUNT];
+    guint size;
+    BinderDataAddr addr[];
+} BinderDataCall;
+
+typedef struct binder_data_call_builder {
+    BinderDataCall call; /* Everything but the addresses */
+    GArray* addr[BINDER_DATA_ADDR_TYPE_COUNT];
+    char* ifname;
+} BinderDataCallBuilder;
+
+void
+binder_data_call_builder_init(
+    BinderDataCallBuilder* builder)
+    BINDER_INTERNAL;
+
+void
+binder_data_call_builder_set_ifname(
+    BinderDataCallBuilder* builder,
+    const char* ifname)
+    BINDER_INTERNAL;
+
+void
+binder_data_call_builder_add(
+    BinderDataCallBuilder* builder,
+    BINDER_DATA_ADDR_TYPE type,
+    const char* list)
+    BINDER_INTERNAL;
+
+BinderDataCall*
+binder_data_call_builder_finish(
+    BinderDataCallBuilder* builder)
+    BINDER_INTERNAL G_GNUC_WARN_UNUSED_RESULT;
+
+BinderDataCall*
+binder_data_call_dup(
+    const BinderDataCall* call)
+    BINDER_INTERNAL;
+
+void
+binder_data_call_free(
+    BinderDataCall* call)
+    BINDER_INTERNAL;
+
+const char*
+binder_data_call_ifname(
+    const BinderDataCall* call)
+    BINDER_INTERNAL;
+
+gboolean
+binder_data_call_equal(
+    const BinderDataCall* c1,
+    const BinderDataCall* c2)
+    BINDER_INTERNAL;
+
+const BinderDataAddr*
+binder_data_call_addr(
+    const BinderDataCall* call,
+    BINDER_DATA_ADDR_TYPE type,
+    guint* count)
+    BINDER_INTERNAL;
+
+gboolean
+binder_data_call_addr_equal(
+    const BinderDataCall* c1,
+    const BinderDataCall* c2,
+    BINDER_DATA_ADDR_TYPE type)
+    BINDER_INTERNAL;
+
+char*
+binder_data_call_addr_list(
+    const BinderDataCall* call,
+    BINDER_DATA_ADDR_TYPE type)
+    BINDER_INTERNAL G_GNUC_WARN_UNUSED_RESULT;
+
+gboolean
+binder_data_addr_parse(
+    const char* str,
+    gsize len,
+    BinderDataAddr* addr)
+    BINDER_INTERNAL;
+
+const char*
+binder_data_addr_ntop(
+    const BinderDataAddr* addr,
+    char buf[BINDER_DATA_ADDR_STRLEN])
+    BINDER_INTERNAL;
+
+const char*
+binder_data_addr_netmask(
+    const BinderDataAddr* addr,
+    char buf[BINDER_DATA_ADDR_STRLEN])
+    BINDER_INTERNAL;
+
+#endif /* BINDER_DATA_CALL_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
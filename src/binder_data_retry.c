@@ -0,0 +1,241 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_data_retry.h"
+#include "binder_log.h"
+
+/* The modem uses INT_MAX to say that the call shouldn't be retried */
+#define RETRY_TIME_NEVER G_MAXINT32
+
+typedef struct binder_data_retry_apn {
+    gboolean active;
+    guint attempt;  /* Number of attempts in the current sequence */
+    gint64 started; /* Monotonic time of the first attempt */
+    BinderDataRetryStats stats;
+} BinderDataRetryApn;
+
+struct binder_data_retry {
+    guint limit;
+    guint delay_ms;
+    guint max_delay_ms;
+    GHashTable* apn;
+};
+
+static
+char*
+binder_data_retry_key(
+    const char* apn)
+{
+    /* APN names are case insensitive */
+    return g_ascii_strdown(apn ? apn : "", -1);
+}
+
+static
+BinderDataRetryApn*
+binder_data_retry_find(
+    BinderDataRetry* retry,
+    const char* apn)
+{
+    char* key = binder_data_retry_key(apn);
+    BinderDataRetryApn* entry = g_hash_table_lookup(retry->apn, key);
+
+    g_free(key);
+    return entry;
+}
+
+static
+BinderDataRetryApn*
+binder_data_retry_get(
+    BinderDataRetry* retry,
+    const char* apn)
+{
+    char* key = binder_data_retry_key(apn);
+    BinderDataRetryApn* entry = g_hash_table_lookup(retry->apn, key);
+
+    if (entry) {
+        g_free(key);
+    } else {
+        entry = g_new0(BinderDataRetryApn, 1);
+        g_hash_table_insert(retry->apn, key, entry);
+    }
+    return entry;
+}
+
+static
+guint
+binder_data_retry_backoff(
+    BinderDataRetry* retry,
+    guint n)
+{
+    /* n is the number of the retry, the first one is not delayed */
+    if (n > 1 && retry->delay_ms) {
+        guint ms = retry->delay_ms;
+
+        while (--n > 1 && ms < retry->max_delay_ms) {
+            ms *= 2;
+        }
+        ms = MIN(ms, retry->max_delay_ms);
+
+        /* Randomize it in [ms/2, ms] range not to retry in lockstep */
+        return g_random_int_range(ms/2, ms + 1);
+    }
+    return 0;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderDataRetry*
+binder_data_retry_new(
+    guint limit,
+    guint delay_ms,
+    guint max_delay_ms)
+{
+    BinderDataRetry* retry = g_new0(BinderDataRetry, 1);
+
+    retry->limit = limit;
+    retry->delay_ms = delay_ms;
+    retry->max_delay_ms = MAX(delay_ms, max_delay_ms);
+    retry->apn = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, g_free);
+    return retry;
+}
+
+void
+binder_data_retry_free(
+    BinderDataRetry* retry)
+{
+    if (retry) {
+        g_hash_table_destroy(retry->apn);
+        g_free(retry);
+    }
+}
+
+void
+binder_data_retry_attempt(
+    BinderDataRetry* retry,
+    const char* apn)
+{
+    if (retry) {
+        BinderDataRetryApn* entry = binder_data_retry_get(retry, apn);
+
+        if (!entry->active) {
+            entry->active = TRUE;
+            entry->attempt = 0;
+            entry->started = g_get_monotonic_time();
+        } else {
+            entry->stats.retries++;
+        }
+        entry->attempt++;
+        entry->stats.attempts++;
+    }
+}
+
+int
+binder_data_retry_delay(
+    BinderDataRetry* retry,
+    const char* apn,
+    int suggested_ms)
+{
+    BinderDataRetryApn* entry = retry ?
+        binder_data_retry_find(retry, apn) : NULL;
+
+    if (!entry || !entry->active) {
+        return BINDER_DATA_RETRY_NONE;
+    } else if (suggested_ms == RETRY_TIME_NEVER) {
+        GDEBUG("Modem says don't retry %s", apn);
+        return BINDER_DATA_RETRY_NONE;
+    } else if (entry->attempt > retry->limit) {
+        GDEBUG("Giving up on %s after %u attempts", apn, entry->attempt);
+        return BINDER_DATA_RETRY_NONE;
+    } else if (suggested_ms >= 0) {
+        /* Honor the modem's suggestion, within reason */
+        return CLAMP((guint)suggested_ms, retry->delay_ms,
+            retry->max_delay_ms);
+    } else {
+        return binder_data_retry_backoff(retry, entry->attempt);
+    }
+}
+
+void
+binder_data_retry_done(
+    BinderDataRetry* retry,
+    const char* apn,
+    gboolean connected)
+{
+    BinderDataRetryApn* entry = retry ?
+        binder_data_retry_find(retry, apn) : NULL;
+
+    if (entry && entry->active) {
+        BinderDataRetryStats* stats = &entry->stats;
+
+        entry->active = FALSE;
+        if (connected) {
+            const guint ms = (guint)((g_get_monotonic_time() -
+                entry->started) / 1000);
+
+            stats->connected++;
+            stats->total_connect_ms += ms;
+            stats->max_connect_ms = MAX(stats->max_connect_ms, ms);
+            stats->max_attempts = MAX(stats->max_attempts, entry->attempt);
+            GDEBUG("%s connected after %u attempt(s) in %u ms", apn,
+                entry->attempt, ms);
+        } else {
+            stats->failed++;
+        }
+    }
+}
+
+void
+binder_data_retry_reset(
+    BinderDataRetry* retry,
+    const char* apn)
+{
+    BinderDataRetryApn* entry = retry ?
+        binder_data_retry_find(retry, apn) : NULL;
+
+    if (entry) {
+        entry->active = FALSE;
+        entry->attempt = 0;
+    }
+}
+
+void
+binder_data_retry_foreach_stats(
+    BinderDataRetry* retry,
+    BinderDataRetryStatsFunc fn,
+    void* user_data)
+{
+    if (retry && fn) {
+        GHashTableIter it;
+        gpointer key, value;
+
+        g_hash_table_iter_init(&it, retry->apn);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            const BinderDataRetryApn* entry = value;
+
+            fn(key, &entry->stats, user_data);
+        }
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
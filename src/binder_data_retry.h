@@ -0,0 +1,101 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_DATA_RETRY_H
+#define BINDER_DATA_RETRY_H
+
+#include "binder_types.h"
+
+/*
+ * Per-APN setupDataCall retry scheduler. The first retry happens
+ * immediately, the following ones are delayed exponentially (with
+ * some jitter) unless the modem suggests its own retry time, which
+ * is then clamped to [delay_ms, max_delay_ms]. The modem may also
+ * tell us not to retry at all.
+ */
+
+#define BINDER_DATA_RETRY_NONE (-1)
+
+typedef struct binder_data_retry_stats {
+    guint attempts;         /* setupDataCall requests submitted */
+    guint retries;          /* ... of which were retries */
+    guint connected;        /* Successful setups */
+    guint failed;           /* Gave up */
+    guint max_attempts;     /* Max attempts before success */
+    guint total_connect_ms; /* Time from the first attempt to success */
+    guint max_connect_ms;
+} BinderDataRetryStats;
+
+typedef
+void
+(*BinderDataRetryStatsFunc)(
+    const char* apn,
+    const BinderDataRetryStats* stats,
+    void* user_data);
+
+BinderDataRetry*
+binder_data_retry_new(
+    guint limit,
+    guint delay_ms,
+    guint max_delay_ms)
+    BINDER_INTERNAL;
+
+void
+binder_data_retry_free(
+    BinderDataRetry* retry)
+    BINDER_INTERNAL;
+
+void
+binder_data_retry_attempt(
+    BinderDataRetry* retry,
+    const char* apn)
+    BINDER_INTERNAL;
+
+int
+binder_data_retry_delay(
+    BinderDataRetry* retry,
+    const char* apn,
+    int suggested_ms)
+    BINDER_INTERNAL;
+
+void
+binder_data_retry_done(
+    BinderDataRetry* retry,
+    const char* apn,
+    gboolean connected)
+    BINDER_INTERNAL;
+
+void
+binder_data_retry_reset(
+    BinderDataRetry* retry,
+    const char* apn)
+    BINDER_INTERNAL;
+
+void
+binder_data_retry_foreach_stats(
+    BinderDataRetry* retry,
+    BinderDataRetryStatsFunc fn,
+    void* user_data)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_DATA_RETRY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -25,9 +25,6 @@
 #include <ofono/mtu-limit.h>
 #include <ofono/watch.h>
 
-#include <gutil_strv.h>
-#include <gutil_misc.h>
-
 #include <arpa/inet.h>
 
 #define CTX_ID_NONE ((unsigned int)(-1))
@@ -49,7 +46,7 @@ typedef struct binder_gprs_context {
     BinderData* data;
     char* log_prefix;
     guint active_ctx_cid;
-    gulong calls_changed_id;
+    gulong call_event_id;
     BinderDataCall* active_call;
     BinderGprsContextCall activate;
     BinderGprsContextCall deactivate;
@@ -61,41 +58,6 @@ static inline BinderGprsContext*
 binder_gprs_context_get_data(struct ofono_gprs_context *gprs)
     {  return ofono_gprs_context_get_data(gprs); }
 
-static
-char*
-binder_gprs_context_netmask(
-    const char* bits)
-{
-    guint nbits;
-
-    if (gutil_parse_uint(bits, 0, &nbits) && nbits < 33) {
-        const char* str;
-        struct in_addr in;
-
-        in.s_addr = htonl((nbits == 32) ? 0xffffffff :
-            ((1u << nbits)-1) << (32-nbits));
-        str = inet_ntoa(in);
-        if (str) {
-            return g_strdup(str);
-        }
-    }
-    return NULL;
-}
-
-static
-int
-binder_gprs_context_address_family(
-    const char* addr)
-{
-    if (strchr(addr, ':')) {
-        return AF_INET6;
-    } else if (strchr(addr, '.')) {
-        return AF_INET;
-    } else {
-        return AF_UNSPEC;
-    }
-}
-
 static
 void
 binder_gprs_context_free_active_call(
@@ -106,9 +68,9 @@ binder_gprs_context_free_active_call(
         binder_data_call_free(self->active_call);
         self->active_call = NULL;
     }
-    if (self->calls_changed_id) {
-        binder_data_remove_handler(self->data, self->calls_changed_id);
-        self->calls_changed_id = 0;
+    if (self->call_event_id) {
+        binder_data_remove_handler(self->data, self->call_event_id);
+        self->call_event_id = 0;
     }
     if (self->mtu_limit) {
         ofono_mtu_limit_free(self->mtu_limit);
@@ -135,7 +97,8 @@ binder_gprs_context_set_active_call(
                 self->mtu_limit = ofono_mtu_limit_new(MAX_MMS_MTU);
             }
         }
-        ofono_mtu_limit_set_ifname(self->mtu_limit, call->ifname);
+        ofono_mtu_limit_set_ifname(self->mtu_limit,
+            binder_data_call_ifname(call));
         binder_data_call_grab(self->data, call->cid, self);
     } else {
         binder_gprs_context_free_active_call(self);
@@ -179,52 +142,33 @@ binder_gprs_context_set_address(
     const BinderDataCall* call)
 {
     const char* ip_addr = NULL;
-    char* ip_mask = NULL;
+    const char* ip_mask = NULL;
     const char* ipv6_addr = NULL;
     unsigned char ipv6_prefix_length = 0;
-    char* tmp_ip_addr = NULL;
-    char* tmp_ipv6_addr = NULL;
-    char* const* list = call->addresses;
-    const int n = gutil_strv_length(list);
-    int i;
+    char ip_buf[BINDER_DATA_ADDR_STRLEN];
+    char mask_buf[BINDER_DATA_ADDR_STRLEN];
+    char ipv6_buf[BINDER_DATA_ADDR_STRLEN];
+    guint i, n;
+    const BinderDataAddr* list = binder_data_call_addr(call,
+        BINDER_DATA_ADDR_ADDRESS, &n);
 
     for (i = 0; i < n && (!ipv6_addr || !ip_addr); i++) {
-        const char* addr = list[i];
+        const BinderDataAddr* addr = list + i;
 
-        switch (binder_gprs_context_address_family(addr)) {
+        switch (addr->family) {
         case AF_INET:
             if (!ip_addr) {
-                const char* s = strchr(addr, '/');
-
-                if (s) {
-                    const gsize len = s - addr;
-                    tmp_ip_addr = g_strndup(addr, len);
-                    ip_addr = tmp_ip_addr;
-                    ip_mask = binder_gprs_context_netmask(s+1);
-                } else {
-                    ip_addr = addr;
-                }
+                ip_addr = binder_data_addr_ntop(addr, ip_buf);
+                ip_mask = binder_data_addr_netmask(addr, mask_buf);
                 if (!ip_mask) {
-                    ip_mask = g_strdup("255.255.255.0");
+                    ip_mask = "255.255.255.0";
                 }
             }
             break;
         case AF_INET6:
             if (!ipv6_addr) {
-                const char* s = strchr(addr, '/');
-
-                if (s) {
-                    const gsize len = s - addr;
-                    const int prefix = atoi(s + 1);
-
-                    tmp_ipv6_addr = g_strndup(addr, len);
-                    ipv6_addr = tmp_ipv6_addr;
-                    if (prefix >= 0 && prefix <= 128) {
-                        ipv6_prefix_length = prefix;
-                    }
-                } else {
-                    ipv6_addr = addr;
-                }
+                ipv6_addr = binder_data_addr_ntop(addr, ipv6_buf);
+                ipv6_prefix_length = addr->prefix;
             }
         }
     }
@@ -237,11 +181,6 @@ binder_gprs_context_set_address(
     if (!ip_addr && !ipv6_addr) {
         ofono_error("GPRS context: No IP address");
     }
-
-    /* Allocate temporary strings */
-    g_free(ip_mask);
-    g_free(tmp_ip_addr);
-    g_free(tmp_ipv6_addr);
 }
 
 static
@@ -252,19 +191,22 @@ binder_gprs_context_set_gateway(
 {
     const char* ip_gw = NULL;
     const char* ipv6_gw = NULL;
-    char* const* list = call->gateways;
-    const int n = gutil_strv_length(list);
-    int i;
+    char ip_buf[BINDER_DATA_ADDR_STRLEN];
+    char ipv6_buf[BINDER_DATA_ADDR_STRLEN];
+    guint i, n;
+    const BinderDataAddr* list = binder_data_call_addr(call,
+        BINDER_DATA_ADDR_GATEWAY, &n);
 
     /* Pick 1 gw for each protocol*/
     for (i = 0; i < n && (!ipv6_gw || !ip_gw); i++) {
-        const char* addr = list[i];
-        switch (binder_gprs_context_address_family(addr)) {
+        const BinderDataAddr* addr = list + i;
+
+        switch (addr->family) {
         case AF_INET:
-            if (!ip_gw) ip_gw = addr;
+            if (!ip_gw) ip_gw = binder_data_addr_ntop(addr, ip_buf);
             break;
         case AF_INET6:
-            if (!ipv6_gw) ipv6_gw = addr;
+            if (!ipv6_gw) ipv6_gw = binder_data_addr_ntop(addr, ipv6_buf);
             break;
         }
     }
@@ -283,32 +225,35 @@ static
 void
 binder_gprs_context_set_servers(
     struct ofono_gprs_context* gc,
-    char* const* list,
+    const BinderDataCall* call,
+    BINDER_DATA_ADDR_TYPE type,
     ofono_gprs_context_list_setter_t set_ipv4,
     ofono_gprs_context_list_setter_t set_ipv6)
 {
-    int i;
+    guint i, n;
+    const BinderDataAddr* list = binder_data_call_addr(call, type, &n);
     const char** ip_list = NULL, ** ip_ptr = NULL;
     const char** ipv6_list = NULL, ** ipv6_ptr = NULL;
-    const int n = gutil_strv_length(list);
+    char (*buf)[BINDER_DATA_ADDR_STRLEN] = n ?
+        g_malloc(n * BINDER_DATA_ADDR_STRLEN) : NULL;
 
     for (i = 0; i < n; i++) {
-        const char *addr = list[i];
+        const BinderDataAddr* addr = list + i;
 
-        switch (binder_gprs_context_address_family(addr)) {
+        switch (addr->family) {
         case AF_INET:
             if (!ip_ptr) {
                 ip_list = g_new0(const char *, n - i + 1);
                 ip_ptr = ip_list;
             }
-            *ip_ptr++ = addr;
+            *ip_ptr++ = binder_data_addr_ntop(addr, buf[i]);
             break;
         case AF_INET6:
             if (!ipv6_ptr) {
                 ipv6_list = g_new0(const char *, n - i + 1);
                 ipv6_ptr = ipv6_list;
             }
-            *ipv6_ptr++ = addr;
+            *ipv6_ptr++ = binder_data_addr_ntop(addr, buf[i]);
             break;
         }
     }
@@ -318,6 +263,7 @@ binder_gprs_context_set_servers(
 
     g_free(ip_list);
     g_free(ipv6_list);
+    g_free(buf);
 }
 
 static
@@ -326,7 +272,7 @@ binder_gprs_context_set_dns_servers(
     struct ofono_gprs_context* gc,
     const BinderDataCall* call)
 {
-    binder_gprs_context_set_servers(gc, call->dnses,
+    binder_gprs_context_set_servers(gc, call, BINDER_DATA_ADDR_DNS,
         ofono_gprs_context_set_ipv4_dns_servers,
         ofono_gprs_context_set_ipv6_dns_servers);
 }
@@ -337,7 +283,7 @@ binder_gprs_context_set_proxy_cscf(
     struct ofono_gprs_context* gc,
     const BinderDataCall* call)
 {
-    binder_gprs_context_set_servers(gc, call->pcscf,
+    binder_gprs_context_set_servers(gc, call, BINDER_DATA_ADDR_PCSCF,
         ofono_gprs_context_set_ipv4_proxy_cscf,
         ofono_gprs_context_set_ipv6_proxy_cscf);
 }
@@ -362,23 +308,28 @@ binder_gprs_context_data_call_change(
     } else if (c1 && c2) {
         int changes = 0;
 
-        if (g_strcmp0(c1->ifname, c2->ifname)) {
+        if (strcmp(binder_data_call_ifname(c1),
+            binder_data_call_ifname(c2))) {
             changes |= DATA_CALL_IFNAME_CHANGED;
         }
 
-        if (!gutil_strv_equal(c1->addresses, c2->addresses)) {
+        if (!binder_data_call_addr_equal(c1, c2,
+            BINDER_DATA_ADDR_ADDRESS)) {
             changes |= DATA_CALL_ADDRESS_CHANGED;
         }
 
-        if (!gutil_strv_equal(c1->gateways, c2->gateways)) {
+        if (!binder_data_call_addr_equal(c1, c2,
+            BINDER_DATA_ADDR_GATEWAY)) {
             changes |= DATA_CALL_GATEWAY_CHANGED;
         }
 
-        if (!gutil_strv_equal(c1->dnses, c2->dnses)) {
+        if (!binder_data_call_addr_equal(c1, c2,
+            BINDER_DATA_ADDR_DNS)) {
             changes |= DATA_CALL_DNS_CHANGED;
         }
 
-        if (!gutil_strv_equal(c1->pcscf, c2->pcscf)) {
+        if (!binder_data_call_addr_equal(c1, c2,
+            BINDER_DATA_ADDR_PCSCF)) {
             changes |= DATA_CALL_PCSCF_CHANGED;
         }
 
@@ -390,9 +341,11 @@ binder_gprs_context_data_call_change(
 
 static
 void
-binder_gprs_context_call_list_changed(
+binder_gprs_context_call_event(
     BinderData* data,
-    BINDER_DATA_PROPERTY property,
+    int cid,
+    BINDER_DATA_CALL_EVENT event,
+    const BinderDataCall* call,
     void* arg)
 {
     BinderGprsContext* self = arg;
@@ -400,15 +353,15 @@ binder_gprs_context_call_list_changed(
 
     /*
      * self->active_call can't be NULL here because this callback
-     * is only registered when we have the active call and released
-     * when active call is dropped.
+     * is only registered (for this particular cid) when we have the
+     * active call and released when active call is dropped.
      */
     BinderDataCall* prev_call = self->active_call;
-    const BinderDataCall* call = binder_data_call_find(data->calls,
-        prev_call->cid);
     int change = 0;
 
-    if (call && call->active != RADIO_DATA_CALL_INACTIVE) {
+    GASSERT(prev_call && prev_call->cid == cid);
+    if (event != BINDER_DATA_CALL_REMOVED &&
+        call->active != RADIO_DATA_CALL_INACTIVE) {
         /* Compare it against the last known state */
         change = binder_gprs_context_data_call_change(call, prev_call);
     } else {
@@ -441,7 +394,7 @@ binder_gprs_context_call_list_changed(
 
     if (change & DATA_CALL_IFNAME_CHANGED) {
         DBG_(self, "interface changed");
-        ofono_gprs_context_set_interface(gc, call->ifname);
+        ofono_gprs_context_set_interface(gc, binder_data_call_ifname(call));
     }
 
     if (change & DATA_CALL_ADDRESS_CHANGED) {
@@ -492,21 +445,20 @@ binder_gprs_context_activate_primary_cb(
         ofono_error("Unexpected data call status %d", call->status);
         error.type = OFONO_ERROR_TYPE_CMS;
         error.error = call->status;
-    } else if (!call->ifname) {
+    } else if (!binder_data_call_ifname(call)[0]) {
         /* Must have interface */
         ofono_error("GPRS context: No interface");
     } else {
         ofono_info("setting up data call");
 
-        GASSERT(!self->calls_changed_id);
-        binder_data_remove_handler(self->data, self->calls_changed_id);
-        self->calls_changed_id = binder_data_add_property_handler(self->data,
-            BINDER_DATA_PROPERTY_CALLS, binder_gprs_context_call_list_changed,
-            self);
+        GASSERT(!self->call_event_id);
+        binder_data_remove_handler(self->data, self->call_event_id);
+        self->call_event_id = binder_data_add_call_handler(self->data,
+            call->cid, binder_gprs_context_call_event, self);
 
         self->active_ctx_cid = self->activate.cid;
         binder_gprs_context_set_active_call(self, call);
-        ofono_gprs_context_set_interface(gc, call->ifname);
+        ofono_gprs_context_set_interface(gc, binder_data_call_ifname(call));
         binder_gprs_context_set_address(gc, call);
         binder_gprs_context_set_gateway(gc, call);
         binder_gprs_context_set_dns_servers(gc, call);
@@ -688,7 +640,7 @@ binder_gprs_context_remove(
             NULL, NULL);
     }
 
-    binder_data_remove_handler(self->data, self->calls_changed_id);
+    binder_data_remove_handler(self->data, self->call_event_id);
     binder_data_unref(self->data);
     binder_network_unref(self->network);
     binder_data_call_free(self->active_call);
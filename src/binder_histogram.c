@@ -0,0 +1,42 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_histogram.h"
+
+#include <ofono/dbus.h>
+
+void
+binder_histogram_dbus_append(
+    DBusMessageIter* it,
+    const guint* buckets,
+    guint count)
+{
+    DBusMessageIter array;
+    const dbus_uint32_t* data = buckets;
+
+    dbus_message_iter_open_container(it, DBUS_TYPE_ARRAY,
+        DBUS_TYPE_UINT32_AS_STRING, &array);
+    dbus_message_iter_append_fixed_array(&array, DBUS_TYPE_UINT32,
+        &data, count);
+    dbus_message_iter_close_container(it, &array);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,51 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_HISTOGRAM_H
+#define BINDER_HISTOGRAM_H
+
+#include "binder_types.h"
+
+/*
+ * Power of two histograms used by the request latency and the call
+ * timing statistics. Bucket 0 counts values less than 1 (ms), bucket N
+ * counts [2^(N-1), 2^N) and the last bucket also counts everything
+ * larger than that. Over D-Bus, a histogram is an array of uint32.
+ */
+
+struct DBusMessageIter;
+
+void
+binder_histogram_dbus_append(
+    struct DBusMessageIter* it,
+    const guint* buckets,
+    guint count)
+    BINDER_INTERNAL;
+
+/* Inline wrappers */
+
+static inline void binder_histogram_add(guint* buckets, guint count,
+    guint value)
+    { buckets[value ? MIN(g_bit_storage(value), count - 1) : 0]++; }
+
+#endif /* BINDER_HISTOGRAM_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,692 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_keepalive.h"
+#include "binder_keepalive_params.h"
+#include "binder_data.h"
+#include "binder_log.h"
+#include "binder_util.h"
+
+#include <ofono/dbus.h>
+#include <ofono/gdbus.h>
+#include <ofono/log.h>
+#include <ofono/modem.h>
+
+#include <radio_client.h>
+#include <radio_request.h>
+#include <radio_request_group.h>
+
+#include <gbinder_reader.h>
+#include <gbinder_writer.h>
+
+#include <arpa/inet.h>
+
+#define BINDER_KEEPALIVE_DBUS_INTERFACE "org.nemomobile.ofono.Keepalive"
+#define BINDER_KEEPALIVE_DBUS_SESSION_SIGNATURE "(uuus)"
+#define BINDER_KEEPALIVE_DBUS_SIGNAL_STATUS_CHANGED "StatusChanged"
+
+/* KeepaliveType */
+typedef enum binder_keepalive_type {
+    BINDER_KEEPALIVE_TYPE_NATT_IPV4 = 0,
+    BINDER_KEEPALIVE_TYPE_NATT_IPV6 = 1
+} BINDER_KEEPALIVE_TYPE;
+
+/* KeepaliveStatusCode */
+typedef enum binder_keepalive_code {
+    BINDER_KEEPALIVE_ACTIVE = 0,
+    BINDER_KEEPALIVE_INACTIVE = 1,
+    BINDER_KEEPALIVE_PENDING = 2
+} BINDER_KEEPALIVE_CODE;
+
+/* android.hardware.radio@1.1::KeepaliveRequest */
+typedef struct binder_keepalive_request {
+    gint32 type;
+    GBinderHidlVec sourceAddress;
+    gint32 sourcePort;
+    GBinderHidlVec destinationAddress;
+    gint32 destinationPort;
+    gint32 maxKeepaliveIntervalMillis;
+    gint32 cid;
+} BinderKeepaliveRequest;
+
+/* android.hardware.radio@1.1::KeepaliveStatus */
+typedef struct binder_keepalive_status {
+    gint32 sessionHandle;
+    gint32 code;
+} BinderKeepaliveStatus;
+
+static const GBinderWriterField binder_keepalive_request_f[] = {
+    GBINDER_WRITER_FIELD_HIDL_VEC_BYTE(BinderKeepaliveRequest,
+        sourceAddress),
+    GBINDER_WRITER_FIELD_HIDL_VEC_BYTE(BinderKeepaliveRequest,
+        destinationAddress),
+    GBINDER_WRITER_FIELD_END()
+};
+static const GBinderWriterType binder_keepalive_request_type = {
+    GBINDER_WRITER_STRUCT_NAME_AND_SIZE(BinderKeepaliveRequest),
+    binder_keepalive_request_f
+};
+
+struct binder_keepalive {
+    char* log_prefix;
+    struct ofono_modem* modem;
+    const char* path;
+    gboolean dbus_registered;
+    DBusConnection* conn;
+    RadioRequestGroup* g;
+    RADIO_AIDL_INTERFACE interface_aidl;
+    BinderData* data;
+    GHashTable* sessions;
+    gulong status_ind_id;
+};
+
+typedef struct binder_keepalive_session {
+    BinderKeepalive* self;
+    guint handle;
+    char* owner;
+    BinderKeepaliveParams params;
+    BINDER_KEEPALIVE_CODE code;
+    gulong call_event_id;
+    guint owner_watch_id;
+} BinderKeepaliveSession;
+
+typedef struct binder_keepalive_start {
+    BinderKeepalive* self;
+    DBusMessage* msg;
+    BinderKeepaliveParams params;
+} BinderKeepaliveStart;
+
+#define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
+
+static
+const char*
+binder_keepalive_code_str(
+    BINDER_KEEPALIVE_CODE code)
+{
+    switch (code) {
+    case BINDER_KEEPALIVE_ACTIVE: return "active";
+    case BINDER_KEEPALIVE_INACTIVE: return "inactive";
+    case BINDER_KEEPALIVE_PENDING: return "pending";
+    }
+    return "unknown";
+}
+
+static
+gboolean
+binder_keepalive_read_status(
+    BinderKeepalive* self,
+    const GBinderReader* args,
+    BinderKeepaliveStatus* status)
+{
+    GBinderReader reader;
+
+    gbinder_reader_copy(&reader, args);
+    if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) {
+        const BinderKeepaliveStatus* st =
+            gbinder_reader_read_hidl_struct(&reader, BinderKeepaliveStatus);
+
+        if (st) {
+            *status = *st;
+            return TRUE;
+        }
+    } else if (binder_read_parcelable_size(&reader) >= 2 * sizeof(gint32)) {
+        return gbinder_reader_read_int32(&reader, &status->sessionHandle) &&
+            gbinder_reader_read_int32(&reader, &status->code);
+    }
+    return FALSE;
+}
+
+static
+void
+binder_keepalive_stop_handle(
+    BinderKeepalive* self,
+    guint handle)
+{
+    /*
+     * Stop requests are not tied to the request group, so that they
+     * don't get cancelled when the whole thing is being destroyed.
+     */
+    GBinderWriter writer;
+    RadioRequest* req = radio_request_new(self->g->client,
+        (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) ?
+        RADIO_REQ_STOP_KEEPALIVE : RADIO_DATA_REQ_STOP_KEEPALIVE, &writer,
+        NULL, NULL, NULL);
+
+    DBG_(self, "stopping keepalive %u", handle);
+
+    /* stopKeepalive(int32 serial, int32 sessionHandle) */
+    gbinder_writer_append_int32(&writer, handle);
+    radio_request_submit(req);
+    radio_request_unref(req);
+}
+
+static
+void
+binder_keepalive_emit_status(
+    BinderKeepalive* self,
+    guint handle,
+    BINDER_KEEPALIVE_CODE code)
+{
+    const dbus_uint32_t id = handle;
+    const char* status = binder_keepalive_code_str(code);
+
+    g_dbus_emit_signal(self->conn, self->path,
+        BINDER_KEEPALIVE_DBUS_INTERFACE,
+        BINDER_KEEPALIVE_DBUS_SIGNAL_STATUS_CHANGED,
+        DBUS_TYPE_UINT32, &id,
+        DBUS_TYPE_STRING, &status,
+        DBUS_TYPE_INVALID);
+}
+
+/*==========================================================================*
+ * Sessions
+ *==========================================================================*/
+
+static
+void
+binder_keepalive_session_free(
+    gpointer data)
+{
+    BinderKeepaliveSession* session = data;
+    BinderKeepalive* self = session->self;
+
+    binder_data_remove_handler(self->data, session->call_event_id);
+    if (session->owner_watch_id) {
+        g_dbus_remove_watch(self->conn, session->owner_watch_id);
+    }
+    g_free(session->owner);
+    g_free(session);
+}
+
+static
+void
+binder_keepalive_session_drop(
+    BinderKeepaliveSession* session,
+    gboolean stop)
+{
+    BinderKeepalive* self = session->self;
+    const guint handle = session->handle;
+
+    if (stop) {
+        binder_keepalive_stop_handle(self, handle);
+    }
+    g_hash_table_remove(self->sessions, GUINT_TO_POINTER(handle));
+    binder_keepalive_emit_status(self, handle, BINDER_KEEPALIVE_INACTIVE);
+}
+
+static
+void
+binder_keepalive_session_call_event(
+    BinderData* data,
+    int cid,
+    BINDER_DATA_CALL_EVENT event,
+    const BinderDataCall* call,
+    void* user_data)
+{
+    BinderKeepaliveSession* session = user_data;
+
+    if (event == BINDER_DATA_CALL_REMOVED ||
+        call->active == RADIO_DATA_CALL_INACTIVE ||
+        !binder_keepalive_params_match_call(&session->params, call)) {
+        DBG_(session->self, "call %d is gone, dropping keepalive %u", cid,
+            session->handle);
+        binder_keepalive_session_drop(session, TRUE);
+    }
+}
+
+static
+void
+binder_keepalive_session_owner_gone(
+    DBusConnection* conn,
+    void* user_data)
+{
+    BinderKeepaliveSession* session = user_data;
+
+    DBG_(session->self, "%s is gone, dropping keepalive %u",
+        session->owner, session->handle);
+
+    /* The watch is being removed by gdbus */
+    session->owner_watch_id = 0;
+    binder_keepalive_session_drop(session, TRUE);
+}
+
+static
+BinderKeepaliveSession*
+binder_keepalive_session_new(
+    BinderKeepalive* self,
+    guint handle,
+    const char* owner,
+    const BinderKeepaliveParams* params,
+    BINDER_KEEPALIVE_CODE code)
+{
+    BinderKeepaliveSession* session = g_new0(BinderKeepaliveSession, 1);
+
+    session->self = self;
+    session->handle = handle;
+    session->owner = g_strdup(owner);
+    session->params = *params;
+    session->code = code;
+    session->call_event_id = binder_data_add_call_handler(self->data,
+        params->cid, binder_keepalive_session_call_event, session);
+    session->owner_watch_id = g_dbus_add_disconnect_watch(self->conn,
+        owner, binder_keepalive_session_owner_gone, session, NULL);
+    g_hash_table_replace(self->sessions, GUINT_TO_POINTER(handle), session);
+    return session;
+}
+
+static
+void
+binder_keepalive_status_ind(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderKeepalive* self = user_data;
+    BinderKeepaliveStatus status;
+
+    /* keepaliveStatus(RadioIndicationType, KeepaliveStatus status) */
+    if (binder_keepalive_read_status(self, args, &status)) {
+        const guint handle = status.sessionHandle;
+        BinderKeepaliveSession* session = g_hash_table_lookup(self->sessions,
+            GUINT_TO_POINTER(handle));
+
+        DBG_(self, "keepalive %u %s", handle,
+            binder_keepalive_code_str(status.code));
+        if (session && session->code != (BINDER_KEEPALIVE_CODE)status.code) {
+            if (status.code == BINDER_KEEPALIVE_INACTIVE) {
+                /* The modem has already stopped it */
+                binder_keepalive_session_drop(session, FALSE);
+            } else {
+                session->code = status.code;
+                binder_keepalive_emit_status(self, handle, status.code);
+            }
+        }
+    }
+}
+
+/*==========================================================================*
+ * startKeepalive
+ *==========================================================================*/
+
+static
+void
+binder_keepalive_start_free(
+    gpointer user_data)
+{
+    BinderKeepaliveStart* start = user_data;
+
+    if (start->msg) {
+        /* Cancelled */
+        g_dbus_send_message(start->self->conn,
+            ofono_dbus_error_canceled(start->msg));
+        dbus_message_unref(start->msg);
+    }
+    g_free(start);
+}
+
+static
+void
+binder_keepalive_start_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderKeepaliveStart* start = user_data;
+    BinderKeepalive* self = start->self;
+    DBusMessage* msg = start->msg;
+    DBusMessage* reply = NULL;
+
+    start->msg = NULL;
+    if (status == RADIO_TX_STATUS_OK) {
+        if (resp == RADIO_RESP_START_KEEPALIVE ||
+            resp == (RADIO_RESP)RADIO_DATA_RESP_START_KEEPALIVE) {
+            BinderKeepaliveStatus ks;
+
+            if (error != RADIO_ERROR_NONE) {
+                DBG_(self, "startKeepalive error %s",
+                    binder_radio_error_string(error));
+                reply = (error == RADIO_ERROR_REQUEST_NOT_SUPPORTED) ?
+                    ofono_dbus_error_not_supported(msg) :
+                    ofono_dbus_error_failed(msg);
+            } else if (binder_keepalive_read_status(self, args, &ks) &&
+                ks.code != BINDER_KEEPALIVE_INACTIVE) {
+                const guint handle = ks.sessionHandle;
+                const dbus_uint32_t id = handle;
+                const BinderDataCall* call = binder_data_get_call(self->data,
+                    start->params.cid);
+
+                DBG_(self, "keepalive %u %s", handle,
+                    binder_keepalive_code_str(ks.code));
+                if (call && call->active != RADIO_DATA_CALL_INACTIVE) {
+                    binder_keepalive_session_new(self, handle,
+                        dbus_message_get_sender(msg), &start->params,
+                        ks.code);
+                    reply = dbus_message_new_method_return(msg);
+                    dbus_message_append_args(reply,
+                        DBUS_TYPE_UINT32, &id,
+                        DBUS_TYPE_INVALID);
+                } else {
+                    /* The call went away while we were waiting */
+                    binder_keepalive_stop_handle(self, handle);
+                    reply = ofono_dbus_error_not_active(msg);
+                }
+            }
+        } else {
+            ofono_error("Unexpected startKeepalive response %d", resp);
+        }
+    }
+
+    g_dbus_send_message(self->conn, reply ? reply :
+        ofono_dbus_error_failed(msg));
+    dbus_message_unref(msg);
+}
+
+static
+RadioRequest*
+binder_keepalive_start_request_new(
+    BinderKeepalive* self,
+    BinderKeepaliveStart* start)
+{
+    const BinderKeepaliveParams* params = &start->params;
+    const guint addr_size = binder_keepalive_params_addr_size(params);
+    const BINDER_KEEPALIVE_TYPE type = (params->src.family == AF_INET6) ?
+        BINDER_KEEPALIVE_TYPE_NATT_IPV6 : BINDER_KEEPALIVE_TYPE_NATT_IPV4;
+    GBinderWriter writer;
+    RadioRequest* req;
+
+    /* startKeepalive(int32 serial, KeepaliveRequest keepalive) */
+    if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) {
+        BinderKeepaliveRequest* kr;
+
+        req = radio_request_new2(self->g, RADIO_REQ_START_KEEPALIVE,
+            &writer, binder_keepalive_start_cb, binder_keepalive_start_free,
+            start);
+        kr = gbinder_writer_new0(&writer, BinderKeepaliveRequest);
+        kr->type = type;
+        kr->sourceAddress.data.ptr = gbinder_writer_memdup(&writer,
+            params->src.addr.bytes, addr_size);
+        kr->sourceAddress.count = addr_size;
+        kr->sourcePort = params->src_port;
+        kr->destinationAddress.data.ptr = gbinder_writer_memdup(&writer,
+            params->dst.addr.bytes, addr_size);
+        kr->destinationAddress.count = addr_size;
+        kr->destinationPort = params->dst_port;
+        kr->maxKeepaliveIntervalMillis = params->interval_ms;
+        kr->cid = params->cid;
+        gbinder_writer_append_struct(&writer, kr,
+            &binder_keepalive_request_type, NULL);
+    } else {
+        gint32 initial_size;
+
+        req = radio_request_new2(self->g, RADIO_DATA_REQ_START_KEEPALIVE,
+            &writer, binder_keepalive_start_cb, binder_keepalive_start_free,
+            start);
+
+        /* Non-null parcelable */
+        gbinder_writer_append_int32(&writer, 1);
+        initial_size = gbinder_writer_bytes_written(&writer);
+        /* Dummy parcelable size, replaced at the end */
+        gbinder_writer_append_int32(&writer, -1);
+
+        gbinder_writer_append_int32(&writer, type);
+        gbinder_writer_append_byte_array(&writer, params->src.addr.bytes,
+            addr_size);                              /* sourceAddress */
+        gbinder_writer_append_int32(&writer, params->src_port);
+        gbinder_writer_append_byte_array(&writer, params->dst.addr.bytes,
+            addr_size);                              /* destinationAddress */
+        gbinder_writer_append_int32(&writer, params->dst_port);
+        gbinder_writer_append_int32(&writer, params->interval_ms);
+        gbinder_writer_append_int32(&writer, params->cid);
+
+        /* Overwrite parcelable size */
+        gbinder_writer_overwrite_int32(&writer, initial_size,
+            gbinder_writer_bytes_written(&writer) - initial_size);
+    }
+    return req;
+}
+
+/*==========================================================================*
+ * D-Bus
+ *==========================================================================*/
+
+static
+DBusMessage*
+binder_keepalive_dbus_start(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderKeepalive* self = user_data;
+    BinderKeepaliveStart* start;
+    BinderKeepaliveParams params;
+    const BinderDataCall* call;
+    const char* src;
+    const char* dst;
+    dbus_uint32_t cid, interval;
+    dbus_uint16_t src_port, dst_port;
+    RadioRequest* req;
+
+    if (!dbus_message_get_args(msg, NULL,
+        DBUS_TYPE_UINT32, &cid,
+        DBUS_TYPE_STRING, &src,
+        DBUS_TYPE_UINT16, &src_port,
+        DBUS_TYPE_STRING, &dst,
+        DBUS_TYPE_UINT16, &dst_port,
+        DBUS_TYPE_UINT32, &interval,
+        DBUS_TYPE_INVALID)) {
+        return ofono_dbus_error_invalid_args(msg);
+    }
+
+    /* Keepalive offload appeared in IRadio 1.1 */
+    if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE &&
+        radio_client_interface(self->g->client) < RADIO_INTERFACE_1_1) {
+        return ofono_dbus_error_not_supported(msg);
+    }
+
+    if (!binder_keepalive_params_init(&params, cid, src, src_port,
+        dst, dst_port, interval)) {
+        return ofono_dbus_error_invalid_args(msg);
+    }
+
+    /* The source address must belong to an active data call */
+    call = binder_data_get_call(self->data, cid);
+    if (!call || call->active == RADIO_DATA_CALL_INACTIVE) {
+        return ofono_dbus_error_not_active(msg);
+    } else if (!binder_keepalive_params_match_call(&params, call)) {
+        return ofono_dbus_error_invalid_args(msg);
+    }
+
+    start = g_new0(BinderKeepaliveStart, 1);
+    start->self = self;
+    start->params = params;
+    req = binder_keepalive_start_request_new(self, start);
+    if (radio_request_submit(req)) {
+        DBG_(self, "starting keepalive %s:%u => %s:%u on call %u every %u ms",
+            src, src_port, dst, dst_port, cid, interval);
+        start->msg = dbus_message_ref(msg);
+        radio_request_unref(req);
+        return NULL;
+    } else {
+        /* This deallocates the start context */
+        radio_request_unref(req);
+        return ofono_dbus_error_failed(msg);
+    }
+}
+
+static
+DBusMessage*
+binder_keepalive_dbus_stop(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderKeepalive* self = user_data;
+    BinderKeepaliveSession* session;
+    dbus_uint32_t handle;
+
+    if (!dbus_message_get_args(msg, NULL,
+        DBUS_TYPE_UINT32, &handle,
+        DBUS_TYPE_INVALID)) {
+        return ofono_dbus_error_invalid_args(msg);
+    }
+
+    session = g_hash_table_lookup(self->sessions, GUINT_TO_POINTER(handle));
+    if (!session) {
+        return ofono_dbus_error_not_found(msg);
+    } else if (g_strcmp0(session->owner, dbus_message_get_sender(msg))) {
+        /* Only the one who started it can stop it */
+        return ofono_dbus_error_access_denied(msg);
+    }
+
+    binder_keepalive_session_drop(session, TRUE);
+    return dbus_message_new_method_return(msg);
+}
+
+static
+DBusMessage*
+binder_keepalive_dbus_get_sessions(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderKeepalive* self = user_data;
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    DBusMessageIter it, array;
+    GHashTableIter hit;
+    gpointer value;
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+        BINDER_KEEPALIVE_DBUS_SESSION_SIGNATURE, &array);
+    g_hash_table_iter_init(&hit, self->sessions);
+    while (g_hash_table_iter_next(&hit, NULL, &value)) {
+        const BinderKeepaliveSession* session = value;
+        const dbus_uint32_t handle = session->handle;
+        const dbus_uint32_t cid = session->params.cid;
+        const dbus_uint32_t interval = session->params.interval_ms;
+        const char* status = binder_keepalive_code_str(session->code);
+        DBusMessageIter entry;
+
+        dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL,
+            &entry);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &handle);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &cid);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &interval);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &status);
+        dbus_message_iter_close_container(&array, &entry);
+    }
+    dbus_message_iter_close_container(&it, &array);
+    return reply;
+}
+
+static const GDBusMethodTable binder_keepalive_dbus_methods[] = {
+    { GDBUS_ASYNC_METHOD("Start",
+        GDBUS_ARGS({ "cid", "u" }, { "source", "s" },
+            { "sourcePort", "q" }, { "destination", "s" },
+            { "destinationPort", "q" }, { "intervalMs", "u" }),
+        GDBUS_ARGS({ "handle", "u" }),
+        binder_keepalive_dbus_start) },
+    { GDBUS_METHOD("Stop",
+        GDBUS_ARGS({ "handle", "u" }), NULL,
+        binder_keepalive_dbus_stop) },
+    { GDBUS_METHOD("GetSessions",
+        NULL, GDBUS_ARGS({ "sessions",
+            "a" BINDER_KEEPALIVE_DBUS_SESSION_SIGNATURE }),
+        binder_keepalive_dbus_get_sessions) },
+    { }
+};
+
+static const GDBusSignalTable binder_keepalive_dbus_signals[] = {
+    { GDBUS_SIGNAL(BINDER_KEEPALIVE_DBUS_SIGNAL_STATUS_CHANGED,
+        GDBUS_ARGS({ "handle", "u" }, { "status", "s" })) },
+    { }
+};
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderKeepalive*
+binder_keepalive_new(
+    RadioClient* client,
+    BinderData* data,
+    struct ofono_modem* modem,
+    const char* log_prefix)
+{
+    BinderKeepalive* self = g_new0(BinderKeepalive, 1);
+
+    self->log_prefix = binder_dup_prefix(log_prefix);
+    self->modem = modem;
+    self->path = ofono_modem_get_path(modem);
+    self->conn = dbus_connection_ref(ofono_dbus_get_connection());
+    self->g = radio_request_group_new(client); /* Keeps ref to client */
+    self->interface_aidl = radio_client_aidl_interface(client);
+    self->data = binder_data_ref(data);
+    self->sessions = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, binder_keepalive_session_free);
+    self->status_ind_id = radio_client_add_indication_handler(client,
+        (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) ?
+        RADIO_IND_KEEPALIVE_STATUS : RADIO_DATA_IND_KEEPALIVE_STATUS,
+        binder_keepalive_status_ind, self);
+
+    self->dbus_registered = binder_dbus_add_modem_interface(modem,
+        BINDER_KEEPALIVE_DBUS_INTERFACE, binder_keepalive_dbus_methods,
+        binder_keepalive_dbus_signals, self);
+    return self;
+}
+
+void
+binder_keepalive_free(
+    BinderKeepalive* self)
+{
+    if (self) {
+        GHashTableIter it;
+        gpointer key;
+
+        if (self->dbus_registered) {
+            binder_dbus_remove_modem_interface(self->modem,
+                BINDER_KEEPALIVE_DBUS_INTERFACE);
+        }
+        radio_client_remove_handler(self->g->client, self->status_ind_id);
+
+        /* This fails pending D-Bus calls */
+        radio_request_group_cancel(self->g);
+
+        /* Don't leave anything running on the modem side */
+        g_hash_table_iter_init(&it, self->sessions);
+        while (g_hash_table_iter_next(&it, &key, NULL)) {
+            binder_keepalive_stop_handle(self, GPOINTER_TO_UINT(key));
+        }
+        g_hash_table_destroy(self->sessions);
+
+        radio_request_group_unref(self->g);
+        binder_data_unref(self->data);
+        dbus_connection_unref(self->conn);
+        g_free(self->log_prefix);
+        g_free(self);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,53 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_KEEPALIVE_H
+#define BINDER_KEEPALIVE_H
+
+#include "binder_types.h"
+
+struct ofono_modem;
+
+/*
+ * NAT-T keepalive offload (startKeepalive/stopKeepalive, IRadio 1.1
+ * and later). Keepalive sessions are bound to the data call they
+ * were started for and get stopped when the call goes away or the
+ * D-Bus client which started them disappears. The D-Bus interface
+ * (org.nemomobile.ofono.Keepalive) lives at the modem path and is
+ * listed in the Interfaces property of the modem.
+ */
+
+BinderKeepalive*
+binder_keepalive_new(
+    RadioClient* client,
+    BinderData* data,
+    struct ofono_modem* modem,
+    const char* log_prefix)
+    BINDER_INTERNAL;
+
+void
+binder_keepalive_free(
+    BinderKeepalive* keepalive)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_KEEPALIVE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
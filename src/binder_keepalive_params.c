@@ -0,0 +1,86 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_keepalive_params.h"
+
+#include <string.h>
+
+gboolean
+binder_keepalive_params_init(
+    BinderKeepaliveParams* params,
+    guint cid,
+    const char* src,
+    guint src_port,
+    const char* dst,
+    guint dst_port,
+    guint interval_ms)
+{
+    memset(params, 0, sizeof(*params));
+    if (cid <= G_MAXINT32 &&
+        src_port && src_port <= G_MAXUINT16 &&
+        dst_port && dst_port <= G_MAXUINT16 &&
+        interval_ms >= BINDER_KEEPALIVE_MIN_INTERVAL_MS &&
+        interval_ms <= BINDER_KEEPALIVE_MAX_INTERVAL_MS &&
+        src && binder_data_addr_parse(src, strlen(src), &params->src) &&
+        dst && binder_data_addr_parse(dst, strlen(dst), &params->dst) &&
+        params->src.family == params->dst.family) {
+        params->cid = cid;
+        params->src_port = src_port;
+        params->dst_port = dst_port;
+        params->interval_ms = interval_ms;
+        return TRUE;
+    }
+    memset(params, 0, sizeof(*params));
+    return FALSE;
+}
+
+guint
+binder_keepalive_params_addr_size(
+    const BinderKeepaliveParams* params)
+{
+    return (params->src.family == AF_INET6) ?
+        sizeof(params->src.addr.ipv6) :
+        sizeof(params->src.addr.ipv4);
+}
+
+gboolean
+binder_keepalive_params_match_call(
+    const BinderKeepaliveParams* params,
+    const BinderDataCall* call)
+{
+    if (call && call->cid == params->cid) {
+        const BinderDataAddr* src = &params->src;
+        const guint size = binder_keepalive_params_addr_size(params);
+        guint i, n;
+        const BinderDataAddr* local = binder_data_call_addr(call,
+            BINDER_DATA_ADDR_ADDRESS, &n);
+
+        for (i = 0; i < n; i++) {
+            if (local[i].family == src->family &&
+                !memcmp(local[i].addr.bytes, src->addr.bytes, size)) {
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
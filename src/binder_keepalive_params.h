@@ -0,0 +1,67 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_KEEPALIVE_PARAMS_H
+#define BINDER_KEEPALIVE_PARAMS_H
+
+#include "binder_data_call.h"
+
+/* Same limits as Android's SocketKeepalive */
+#define BINDER_KEEPALIVE_MIN_INTERVAL_MS (10000)
+#define BINDER_KEEPALIVE_MAX_INTERVAL_MS (3600000)
+
+typedef struct binder_keepalive_params {
+    int cid;
+    BinderDataAddr src;
+    BinderDataAddr dst;
+    guint16 src_port;
+    guint16 dst_port;
+    guint interval_ms;
+} BinderKeepaliveParams;
+
+/* Validates the parameters of the Start call */
+gboolean
+binder_keepalive_params_init(
+    BinderKeepaliveParams* params,
+    guint cid,
+    const char* src,
+    guint src_port,
+    const char* dst,
+    guint dst_port,
+    guint interval_ms)
+    BINDER_INTERNAL;
+
+/* Size of the source/destination address in bytes */
+guint
+binder_keepalive_params_addr_size(
+    const BinderKeepaliveParams* params)
+    BINDER_INTERNAL;
+
+/* TRUE if the source address belongs to the call */
+gboolean
+binder_keepalive_params_match_call(
+    const BinderKeepaliveParams* params,
+    const BinderDataCall* call)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_KEEPALIVE_PARAMS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,560 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_histogram.h"
+#include "binder_latency.h"
+#include "binder_log.h"
+
+#include <ofono/dbus.h>
+#include <ofono/gdbus.h>
+
+#include <gbinder_local_request.h>
+
+#define BINDER_LATENCY_DBUS_PATH "/"
+#define BINDER_LATENCY_DBUS_INTERFACE "org.nemomobile.ofono.BinderLatency"
+#define BINDER_LATENCY_DBUS_STATS_SIGNATURE "(uiusuuuuutau)"
+
+/* How many codes are listed in the summary line */
+#define BINDER_LATENCY_SUMMARY_TOP (3)
+
+struct binder_latency {
+    GHashTable* stats;
+    GSList* sources;
+    guint timeout_ms;
+    gboolean dbus_registered;
+};
+
+struct binder_latency_source {
+    BinderLatency* latency;
+    guint slot;
+    RADIO_AIDL_INTERFACE iface;
+    GHashTable* pending;
+};
+
+/*
+ * RadioRequest retries resubmit the same parcel with the new serial
+ * written into it, so the last failed parcel is remembered to detect
+ * retries. The reference makes sure that its address can't be reused
+ * by an unrelated request.
+ */
+typedef struct binder_latency_entry {
+    BinderLatencyStats stats;
+    GBinderLocalRequest* failed_args;
+} BinderLatencyEntry;
+
+typedef struct binder_latency_pending {
+    BinderLatencySource* source;
+    BinderLatencyEntry* entry;
+    GBinderLocalRequest* args;
+    guint32 serial;
+    gint64 start;
+    guint timeout_id;
+} BinderLatencyPending;
+
+typedef struct binder_latency_summary_data {
+    guint count;
+    guint errors;
+    guint retries;
+    guint timeouts;
+    GPtrArray* slowest;
+} BinderLatencySummaryData;
+
+static
+gconstpointer
+binder_latency_key(
+    guint slot,
+    RADIO_AIDL_INTERFACE iface,
+    guint code)
+{
+    /* AIDL interfaces have overlapping codes, hence the interface */
+    return GUINT_TO_POINTER(((slot & 0xff) << 24) |
+        (((iface + 1) & 0xff) << 16) | (code & 0xffff));
+}
+
+static
+void
+binder_latency_entry_set_failed(
+    BinderLatencyEntry* entry,
+    GBinderLocalRequest* args)
+{
+    if (entry->failed_args != args) {
+        gbinder_local_request_unref(entry->failed_args);
+        entry->failed_args = gbinder_local_request_ref(args);
+    }
+}
+
+static
+void
+binder_latency_entry_free(
+    gpointer data)
+{
+    BinderLatencyEntry* entry = data;
+
+    gbinder_local_request_unref(entry->failed_args);
+    g_free(entry);
+}
+
+static
+void
+binder_latency_pending_free(
+    gpointer data)
+{
+    BinderLatencyPending* pending = data;
+
+    if (pending->timeout_id) {
+        g_source_remove(pending->timeout_id);
+    }
+    gbinder_local_request_unref(pending->args);
+    g_free(pending);
+}
+
+static
+gboolean
+binder_latency_pending_timeout(
+    gpointer user_data)
+{
+    BinderLatencyPending* pending = user_data;
+    BinderLatencyEntry* entry = pending->entry;
+
+    /* No response in time, a retry may follow */
+    pending->timeout_id = 0;
+    entry->stats.timeouts++;
+    binder_latency_entry_set_failed(entry, pending->args);
+    g_hash_table_remove(pending->source->pending,
+        GUINT_TO_POINTER(pending->serial));
+    return G_SOURCE_REMOVE;
+}
+
+static
+BinderLatencyEntry*
+binder_latency_entry(
+    BinderLatencySource* source,
+    guint code,
+    const char* name)
+{
+    BinderLatency* latency = source->latency;
+    gconstpointer key = binder_latency_key(source->slot, source->iface, code);
+    BinderLatencyEntry* entry = g_hash_table_lookup(latency->stats, key);
+
+    if (!entry) {
+        entry = g_new0(BinderLatencyEntry, 1);
+        entry->stats.slot = source->slot;
+        entry->stats.iface = source->iface;
+        entry->stats.code = code;
+        entry->stats.name = name;
+        g_hash_table_insert(latency->stats, (gpointer)key, entry);
+    }
+    return entry;
+}
+
+static
+gint
+binder_latency_stats_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderLatencyStats* s1 = *(BinderLatencyStats**)a;
+    const BinderLatencyStats* s2 = *(BinderLatencyStats**)b;
+
+    if (s1->slot != s2->slot) {
+        return (s1->slot < s2->slot) ? -1 : 1;
+    } else if (s1->iface != s2->iface) {
+        return (s1->iface < s2->iface) ? -1 : 1;
+    } else {
+        return (s1->code < s2->code) ? -1 : (s1->code > s2->code);
+    }
+}
+
+static
+gint
+binder_latency_stats_compare_slowest(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderLatencyStats* s1 = *(BinderLatencyStats**)a;
+    const BinderLatencyStats* s2 = *(BinderLatencyStats**)b;
+    const guint p1 = binder_latency_stats_percentile_ms(s1, 95);
+    const guint p2 = binder_latency_stats_percentile_ms(s2, 95);
+
+    if (p1 != p2) {
+        return (p1 > p2) ? -1 : 1;
+    } else {
+        return (s1->max_us > s2->max_us) ? -1 : (s1->max_us < s2->max_us);
+    }
+}
+
+static
+void
+binder_latency_summary_cb(
+    const BinderLatencyStats* stats,
+    void* user_data)
+{
+    BinderLatencySummaryData* data = user_data;
+
+    data->count += stats->count;
+    data->errors += stats->errors;
+    data->retries += stats->retries;
+    data->timeouts += stats->timeouts;
+    if (stats->count > stats->errors) {
+        /* Only successful round trips have timing */
+        g_ptr_array_add(data->slowest, (gpointer)stats);
+    }
+}
+
+/*==========================================================================*
+ * D-Bus
+ *==========================================================================*/
+
+static
+void
+binder_latency_dbus_append_stats(
+    const BinderLatencyStats* stats,
+    void* user_data)
+{
+    DBusMessageIter* array = user_data;
+    DBusMessageIter entry;
+    const char* name = stats->name ? stats->name : "";
+    const dbus_uint64_t total = stats->total_us;
+    const dbus_int32_t iface = stats->iface;
+
+    dbus_message_iter_open_container(array, DBUS_TYPE_STRUCT, NULL, &entry);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->slot);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_INT32, &iface);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->code);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->count);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->errors);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->retries);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->timeouts);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &stats->max_us);
+    dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &total);
+    binder_histogram_dbus_append(&entry, stats->buckets,
+        BINDER_LATENCY_BUCKETS);
+    dbus_message_iter_close_container(array, &entry);
+}
+
+static
+DBusMessage*
+binder_latency_dbus_get_statistics(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    DBusMessageIter it, array;
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+        BINDER_LATENCY_DBUS_STATS_SIGNATURE, &array);
+    binder_latency_foreach(user_data, binder_latency_dbus_append_stats,
+        &array);
+    dbus_message_iter_close_container(&it, &array);
+    return reply;
+}
+
+static
+DBusMessage*
+binder_latency_dbus_reset(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    binder_latency_reset(user_data);
+    return dbus_message_new_method_return(msg);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderLatency*
+binder_latency_new(
+    guint timeout_ms)
+{
+    BinderLatency* latency = g_new0(BinderLatency, 1);
+
+    latency->stats = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, binder_latency_entry_free);
+    latency->timeout_ms = timeout_ms;
+    return latency;
+}
+
+void
+binder_latency_free(
+    BinderLatency* latency)
+{
+    if (latency) {
+        binder_latency_dbus_unregister(latency);
+        while (latency->sources) {
+            binder_latency_source_free(latency->sources->data);
+        }
+        g_hash_table_destroy(latency->stats);
+        g_free(latency);
+    }
+}
+
+void
+binder_latency_reset(
+    BinderLatency* latency)
+{
+    if (latency) {
+        GSList* l;
+
+        /* Pending entries point to the stats */
+        for (l = latency->sources; l; l = l->next) {
+            g_hash_table_remove_all(((BinderLatencySource*)l->data)->pending);
+        }
+        g_hash_table_remove_all(latency->stats);
+    }
+}
+
+void
+binder_latency_foreach(
+    BinderLatency* latency,
+    BinderLatencyFunc fn,
+    void* user_data)
+{
+    if (latency) {
+        GPtrArray* list = g_ptr_array_sized_new(
+            g_hash_table_size(latency->stats));
+        GHashTableIter it;
+        gpointer value;
+        guint i;
+
+        g_hash_table_iter_init(&it, latency->stats);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            g_ptr_array_add(list, value);
+        }
+        g_ptr_array_sort(list, binder_latency_stats_compare);
+        for (i = 0; i < list->len; i++) {
+            fn(list->pdata[i], user_data);
+        }
+        g_ptr_array_free(list, TRUE);
+    }
+}
+
+char*
+binder_latency_summary(
+    BinderLatency* latency)
+{
+    BinderLatencySummaryData data;
+    GString* buf;
+    guint i;
+
+    memset(&data, 0, sizeof(data));
+    data.slowest = g_ptr_array_new();
+    binder_latency_foreach(latency, binder_latency_summary_cb, &data);
+    g_ptr_array_sort(data.slowest, binder_latency_stats_compare_slowest);
+
+    buf = g_string_new(NULL);
+    g_string_printf(buf, "%u requests, %u errors, %u retries, %u timeouts",
+        data.count, data.errors, data.retries, data.timeouts);
+    for (i = 0; i < MIN(data.slowest->len, BINDER_LATENCY_SUMMARY_TOP); i++) {
+        const BinderLatencyStats* stats = data.slowest->pdata[i];
+
+        g_string_append_printf(buf, "%s %s[%u] p50 %ums p95 %ums max %ums",
+            i ? "," : ";", stats->name ? stats->name : "?", stats->slot,
+            binder_latency_stats_percentile_ms(stats, 50),
+            binder_latency_stats_percentile_ms(stats, 95),
+            (stats->max_us + 999) / 1000);
+    }
+    g_ptr_array_free(data.slowest, TRUE);
+    return g_string_free(buf, FALSE);
+}
+
+/*
+ * Returns the upper bound of the bucket containing the percentile,
+ * zero if there were no successful round trips to measure.
+ */
+guint
+binder_latency_stats_percentile_ms(
+    const BinderLatencyStats* stats,
+    guint percent)
+{
+    const guint n = stats->count - stats->errors;
+    const guint target = (n * percent + 99) / 100;
+    guint i, sum = 0;
+
+    if (!n) {
+        return 0;
+    }
+    for (i = 0; i < BINDER_LATENCY_BUCKETS - 1; i++) {
+        sum += stats->buckets[i];
+        if (sum >= target) {
+            return 1 << i;
+        }
+    }
+    return MAX(1 << i, (stats->max_us + 999) / 1000);
+}
+
+gboolean
+binder_latency_dbus_register(
+    BinderLatency* latency)
+{
+    static const GDBusMethodTable binder_latency_dbus_methods[] = {
+        { GDBUS_METHOD("GetStatistics", NULL,
+            GDBUS_ARGS({ "stats", "a" BINDER_LATENCY_DBUS_STATS_SIGNATURE }),
+            binder_latency_dbus_get_statistics) },
+        { GDBUS_METHOD("Reset", NULL, NULL,
+            binder_latency_dbus_reset) },
+        { }
+    };
+
+    /*
+     * Statistics are collected for all slots, so the interface lives
+     * at the root rather than under a modem and therefore isn't added
+     * to any modem's Interfaces list.
+     */
+    if (latency && !latency->dbus_registered) {
+        latency->dbus_registered = g_dbus_register_interface(
+            ofono_dbus_get_connection(), BINDER_LATENCY_DBUS_PATH,
+            BINDER_LATENCY_DBUS_INTERFACE, binder_latency_dbus_methods,
+            NULL, NULL, latency, NULL);
+        if (!latency->dbus_registered) {
+            ofono_error("%s: failed to register %s",
+                BINDER_LATENCY_DBUS_PATH, BINDER_LATENCY_DBUS_INTERFACE);
+        }
+    }
+    return latency && latency->dbus_registered;
+}
+
+void
+binder_latency_dbus_unregister(
+    BinderLatency* latency)
+{
+    if (latency && latency->dbus_registered) {
+        latency->dbus_registered = FALSE;
+        g_dbus_unregister_interface(ofono_dbus_get_connection(),
+            BINDER_LATENCY_DBUS_PATH, BINDER_LATENCY_DBUS_INTERFACE);
+    }
+}
+
+BinderLatencySource*
+binder_latency_source_new(
+    BinderLatency* latency,
+    guint slot,
+    RADIO_AIDL_INTERFACE iface)
+{
+    if (latency) {
+        BinderLatencySource* source = g_new0(BinderLatencySource, 1);
+
+        source->latency = latency;
+        source->slot = slot;
+        source->iface = iface;
+        source->pending = g_hash_table_new_full(g_direct_hash,
+            g_direct_equal, NULL, binder_latency_pending_free);
+        latency->sources = g_slist_append(latency->sources, source);
+        return source;
+    }
+    return NULL;
+}
+
+void
+binder_latency_source_free(
+    BinderLatencySource* source)
+{
+    if (source) {
+        BinderLatency* latency = source->latency;
+
+        latency->sources = g_slist_remove(latency->sources, source);
+        g_hash_table_destroy(source->pending);
+        g_free(source);
+    }
+}
+
+void
+binder_latency_source_request(
+    BinderLatencySource* source,
+    guint code,
+    const char* name,
+    guint32 serial,
+    GBinderLocalRequest* args)
+{
+    if (source && serial) {
+        BinderLatency* latency = source->latency;
+        BinderLatencyEntry* entry = binder_latency_entry(source, code, name);
+        BinderLatencyPending* pending;
+        GHashTableIter it;
+        gpointer value;
+
+        /*
+         * If the previous attempt is still pending, RadioRequest has
+         * given up waiting for it before our own timeout has expired.
+         */
+        g_hash_table_iter_init(&it, source->pending);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            pending = value;
+            if (pending->args == args) {
+                pending->entry->stats.timeouts++;
+                binder_latency_entry_set_failed(pending->entry, args);
+                g_hash_table_iter_remove(&it);
+                break;
+            }
+        }
+        if (entry->failed_args == args) {
+            entry->stats.retries++;
+        }
+        gbinder_local_request_unref(entry->failed_args);
+        entry->failed_args = NULL;
+
+        pending = g_new0(BinderLatencyPending, 1);
+        pending->source = source;
+        pending->entry = entry;
+        pending->args = gbinder_local_request_ref(args);
+        pending->serial = serial;
+        pending->start = g_get_monotonic_time();
+        if (latency->timeout_ms) {
+            pending->timeout_id = g_timeout_add(latency->timeout_ms,
+                binder_latency_pending_timeout, pending);
+        }
+        g_hash_table_replace(source->pending, GUINT_TO_POINTER(serial),
+            pending);
+    }
+}
+
+void
+binder_latency_source_response(
+    BinderLatencySource* source,
+    guint32 serial,
+    RADIO_ERROR error)
+{
+    BinderLatencyPending* pending = source ? g_hash_table_lookup(
+        source->pending, GUINT_TO_POINTER(serial)) : NULL;
+
+    if (pending) {
+        BinderLatencyStats* stats = &pending->entry->stats;
+        const gint64 us = g_get_monotonic_time() - pending->start;
+
+        stats->count++;
+        if (error == RADIO_ERROR_NONE) {
+            binder_histogram_add(stats->buckets, BINDER_LATENCY_BUCKETS,
+                us / 1000);
+            stats->total_us += us;
+            stats->max_us = MAX(stats->max_us, (guint)us);
+        } else {
+            stats->errors++;
+            binder_latency_entry_set_failed(pending->entry, pending->args);
+        }
+        g_hash_table_remove(source->pending, GUINT_TO_POINTER(serial));
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
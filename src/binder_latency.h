@@ -0,0 +1,129 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_LATENCY_H
+#define BINDER_LATENCY_H
+
+#include "binder_types.h"
+
+/*
+ * Round-trip time statistics per slot, interface and request code.
+ * The buckets make a histogram of successful round trips in ms, see
+ * binder_histogram.h
+ */
+#define BINDER_LATENCY_BUCKETS (16)
+
+typedef struct binder_latency_stats {
+    guint slot;
+    RADIO_AIDL_INTERFACE iface;
+    guint code;
+    const char* name;
+    guint count;
+    guint errors;
+    guint retries;
+    guint timeouts;
+    guint max_us;
+    guint64 total_us;
+    guint buckets[BINDER_LATENCY_BUCKETS];
+} BinderLatencyStats;
+
+typedef struct binder_latency_source BinderLatencySource;
+
+typedef
+void
+(*BinderLatencyFunc)(
+    const BinderLatencyStats* stats,
+    void* user_data);
+
+BinderLatency*
+binder_latency_new(
+    guint timeout_ms)
+    BINDER_INTERNAL;
+
+void
+binder_latency_free(
+    BinderLatency* latency)
+    BINDER_INTERNAL;
+
+void
+binder_latency_reset(
+    BinderLatency* latency)
+    BINDER_INTERNAL;
+
+void
+binder_latency_foreach(
+    BinderLatency* latency,
+    BinderLatencyFunc fn,
+    void* user_data)
+    BINDER_INTERNAL;
+
+char*
+binder_latency_summary(
+    BinderLatency* latency)
+    BINDER_INTERNAL;
+
+guint
+binder_latency_stats_percentile_ms(
+    const BinderLatencyStats* stats,
+    guint percent)
+    BINDER_INTERNAL;
+
+gboolean
+binder_latency_dbus_register(
+    BinderLatency* latency)
+    BINDER_INTERNAL;
+
+void
+binder_latency_dbus_unregister(
+    BinderLatency* latency)
+    BINDER_INTERNAL;
+
+BinderLatencySource*
+binder_latency_source_new(
+    BinderLatency* latency,
+    guint slot,
+    RADIO_AIDL_INTERFACE iface)
+    BINDER_INTERNAL;
+
+void
+binder_latency_source_free(
+    BinderLatencySource* source)
+    BINDER_INTERNAL;
+
+void
+binder_latency_source_request(
+    BinderLatencySource* source,
+    guint code,
+    const char* name,
+    guint32 serial,
+    GBinderLocalRequest* args)
+    BINDER_INTERNAL;
+
+void
+binder_latency_source_response(
+    BinderLatencySource* source,
+    guint32 serial,
+    RADIO_ERROR error)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_LATENCY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
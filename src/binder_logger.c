@@ -13,7 +13,9 @@
  *  GNU General Public License for more details.
  */
 
+#include "binder_latency.h"
 #include "binder_logger.h"
+#include "binder_record.h"
 #include "binder_util.h"
 
 #include <radio_config.h>
@@ -47,6 +49,11 @@ struct binder_logger {
     gpointer object;
     gulong event_id[EVENT_COUNT];
     char* prefix;
+    BinderRecordRing* ring;
+    BinderRecordInstance* instance;
+    BinderLatencySource* latency;
+    RADIO_AIDL_INTERFACE iface;
+    guint slot;
 };
 
 #define CONFIG_PREFIX "config"
@@ -64,6 +71,20 @@ static GLogModule binder_logger_dump_module = {
     .flags = GLOG_FLAG_HIDE_NAME
 };
 
+static
+guint32
+binder_logger_req_serial(
+    BinderLogger* logger,
+    guint code,
+    const guint8* data,
+    gsize size)
+{
+    const gsize header_size = logger->cb->rpc_header_size(logger->object,
+        code);
+
+    return (size >= header_size + 4) ? *(guint32*)(data + header_size) : 0;
+}
+
 static
 void
 binder_logger_trace_req(
@@ -73,7 +94,6 @@ binder_logger_trace_req(
 {
     const BinderLoggerCallbacks* cb = logger->cb;
     static const GLogModule* log = &binder_logger_module;
-    const gsize header_size = cb->rpc_header_size(logger->object, code);
     const char* name = cb->req_name(logger->object, code);
     GBinderWriter writer;
     const guint8* data;
@@ -83,7 +103,7 @@ binder_logger_trace_req(
     /* Use writer API to fetch the raw data and extract the serial */
     gbinder_local_request_init_writer(args, &writer);
     data = gbinder_writer_get_data(&writer, &size);
-    serial = (size >= header_size + 4) ? *(guint32*)(data + header_size) : 0;
+    serial = binder_logger_req_serial(logger, code, data, size);
 
     if (serial) {
         gutil_log(log, GLOG_LEVEL_VERBOSE, "%s< [%08x] %u %s",
@@ -165,6 +185,140 @@ binder_logger_dump_reader(
         data, size);
 }
 
+/*==========================================================================*
+ * Binary recorder
+ *==========================================================================*/
+
+static
+void
+binder_logger_record_init(
+    BinderLogger* logger,
+    BinderRecordHeader* hdr,
+    BINDER_RECORD_TYPE type,
+    guint32 code)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->type = type;
+    hdr->slot = logger->slot;
+    hdr->iface = logger->iface;
+    hdr->time = g_get_real_time();
+    hdr->code = code;
+}
+
+static
+void
+binder_logger_radio_record_req_cb(
+    RadioInstance* radio,
+    RADIO_REQ code,
+    GBinderLocalRequest* args,
+    gpointer user_data)
+{
+    BinderLogger* logger = user_data;
+    BinderRecordHeader hdr;
+    GBinderWriter writer;
+    const guint8* data;
+    gsize size;
+
+    gbinder_local_request_init_writer(args, &writer);
+    data = gbinder_writer_get_data(&writer, &size);
+    binder_logger_record_init(logger, &hdr, BINDER_RECORD_REQ, code);
+    hdr.serial = binder_logger_req_serial(logger, code, data, size);
+    binder_record_ring_put(logger->ring, &hdr, data, size);
+}
+
+static
+void
+binder_logger_radio_record_resp_cb(
+    RadioInstance* radio,
+    RADIO_RESP code,
+    const RadioResponseInfo* info,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderLogger* logger = user_data;
+    BinderRecordHeader hdr;
+    gsize size;
+    const guint8* data = gbinder_reader_get_data(args, &size);
+
+    binder_logger_record_init(logger, &hdr, BINDER_RECORD_RESP, code);
+    hdr.serial = info->serial;
+    hdr.status = info->error;
+    binder_record_ring_put(logger->ring, &hdr, data, size);
+}
+
+static
+void
+binder_logger_radio_record_ind_cb(
+    RadioInstance* radio,
+    RADIO_IND code,
+    RADIO_IND_TYPE type,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderLogger* logger = user_data;
+    BinderRecordHeader hdr;
+    gsize size;
+    const guint8* data = gbinder_reader_get_data(args, &size);
+
+    binder_logger_record_init(logger, &hdr, BINDER_RECORD_IND, code);
+    hdr.status = type;
+    binder_record_ring_put(logger->ring, &hdr, data, size);
+}
+
+static
+void
+binder_logger_radio_record_ack_cb(
+    RadioInstance* radio,
+    guint32 serial,
+    gpointer user_data)
+{
+    BinderLogger* logger = user_data;
+    BinderRecordHeader hdr;
+
+    binder_logger_record_init(logger, &hdr, BINDER_RECORD_ACK, 0);
+    hdr.serial = serial;
+    binder_record_ring_put(logger->ring, &hdr, NULL, 0);
+}
+
+/*==========================================================================*
+ * Latency statistics
+ *==========================================================================*/
+
+static
+void
+binder_logger_radio_latency_req_cb(
+    RadioInstance* radio,
+    RADIO_REQ code,
+    GBinderLocalRequest* args,
+    gpointer user_data)
+{
+    BinderLogger* logger = user_data;
+    GBinderWriter writer;
+    const guint8* data;
+    gsize size;
+
+    gbinder_local_request_init_writer(args, &writer);
+    data = gbinder_writer_get_data(&writer, &size);
+    binder_latency_source_request(logger->latency, code,
+        radio_req_name2(radio, code), binder_logger_req_serial(logger,
+        code, data, size), args);
+}
+
+static
+void
+binder_logger_radio_latency_resp_cb(
+    RadioInstance* radio,
+    RADIO_RESP code,
+    const RadioResponseInfo* info,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderLogger* logger = user_data;
+
+    binder_latency_source_response(logger->latency, info->serial,
+        info->error);
+}
+
 /*==========================================================================*
  * RadioInstance implementation
  *==========================================================================*/
@@ -539,11 +693,59 @@ binder_logger_new_config_dump(
         binder_logger_config_dump_resp_cb, binder_logger_config_dump_ind_cb);
 }
 
+BinderLogger*
+binder_logger_new_radio_record(
+    RadioInstance* radio,
+    const char* name,
+    guint slot,
+    RADIO_INTERFACE version,
+    RADIO_AIDL_INTERFACE iface,
+    BinderRecordRing* ring)
+{
+    /* Record after trace and dump have done their thing */
+    BinderLogger* logger = ring ? binder_logger_radio_new(radio, name,
+        RADIO_INSTANCE_PRIORITY_HIGHEST - 2,
+        binder_logger_radio_record_req_cb,
+        binder_logger_radio_record_resp_cb,
+        binder_logger_radio_record_ind_cb,
+        binder_logger_radio_record_ack_cb) : NULL;
+
+    if (logger) {
+        logger->ring = ring;
+        logger->slot = slot;
+        logger->iface = iface;
+        logger->instance = binder_record_ring_add_instance(ring, slot,
+            version, iface, name);
+    }
+    return logger;
+}
+
+BinderLogger*
+binder_logger_new_radio_latency(
+    RadioInstance* radio,
+    guint slot,
+    RADIO_AIDL_INTERFACE iface,
+    BinderLatency* latency)
+{
+    BinderLogger* logger = latency ? binder_logger_radio_new(radio, NULL,
+        RADIO_INSTANCE_PRIORITY_HIGHEST, binder_logger_radio_latency_req_cb,
+        binder_logger_radio_latency_resp_cb, NULL, NULL) : NULL;
+
+    if (logger) {
+        logger->slot = slot;
+        logger->iface = iface;
+        logger->latency = binder_latency_source_new(latency, slot, iface);
+    }
+    return logger;
+}
+
 void
 binder_logger_free(
     BinderLogger* logger)
 {
     if (logger) {
+        binder_latency_source_free(logger->latency);
+        binder_record_ring_remove_instance(logger->ring, logger->instance);
         logger->cb->drop_object(logger);
         g_free(logger->prefix);
         g_free(logger);
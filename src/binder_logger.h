@@ -40,6 +40,24 @@ binder_logger_new_config_dump(
     RadioConfig* config)
     BINDER_INTERNAL;
 
+BinderLogger*
+binder_logger_new_radio_record(
+    RadioInstance* instance,
+    const char* name,
+    guint slot,
+    RADIO_INTERFACE version,
+    RADIO_AIDL_INTERFACE iface,
+    BinderRecordRing* ring)
+    BINDER_INTERNAL;
+
+BinderLogger*
+binder_logger_new_radio_latency(
+    RadioInstance* instance,
+    guint slot,
+    RADIO_AIDL_INTERFACE iface,
+    BinderLatency* latency)
+    BINDER_INTERNAL;
+
 void
 binder_logger_free(
     BinderLogger* logger)
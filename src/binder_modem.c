@@ -21,6 +21,7 @@
 #include "binder_cell_info.h"
 #include "binder_ext_slot.h"
 #include "binder_ims_reg.h"
+#include "binder_keepalive.h"
 #include "binder_data.h"
 #include "binder_util.h"
 #include "binder_log.h"
@@ -31,7 +32,9 @@
 #include <ofono/call-volume.h>
 #include <ofono/cbs.h>
 #include <ofono/cell-info.h>
+#include <ofono/dbus.h>
 #include <ofono/devinfo.h>
+#include <ofono/gdbus.h>
 #include <ofono/gprs.h>
 #include <ofono/ims.h>
 #include <ofono/message-waiting.h>
@@ -57,6 +60,10 @@
 
 #define ONLINE_TIMEOUT_SECS     (15) /* 20 sec is hardcoded in ofono core */
 
+#define LINK_CAPACITY_DBUS_INTERFACE "org.nemomobile.ofono.LinkCapacity"
+#define LINK_CAPACITY_DBUS_DOWNLINK "DownlinkKbps"
+#define LINK_CAPACITY_DBUS_UPLINK "UplinkKbps"
+
 typedef enum binder_modem_power_state {
     POWERED_OFF,
     POWERED_ON,
@@ -83,6 +90,7 @@ typedef struct binder_modem_online_request {
 struct binder_modem_priv {
     BinderModem pub;
     RadioRequestGroup* g;
+    BinderKeepalive* keepalive;
     char* log_prefix;
     char* imeisv;
     char* imei;
@@ -95,6 +103,10 @@ struct binder_modem_priv {
     BINDER_MODEM_POWER_STATE power_state;
     gulong radio_state_event_id;
 
+    gboolean link_capacity_registered;
+    BinderLinkCapacity link_capacity; /* Last value signaled over D-Bus */
+    gulong link_capacity_event_id;
+
     BinderModemOnlineRequest set_online;
     BinderModemOnlineRequest set_offline;
 };
@@ -450,6 +462,118 @@ binder_modem_disable(
     }
 }
 
+static
+void
+binder_modem_link_capacity_signal(
+    BinderModemPriv* self,
+    const char* name,
+    guint kbps)
+{
+    const dbus_uint32_t value = kbps;
+
+    ofono_dbus_signal_property_changed(ofono_dbus_get_connection(),
+        binder_modem_get_path(&self->pub), LINK_CAPACITY_DBUS_INTERFACE,
+        name, DBUS_TYPE_UINT32, &value);
+}
+
+static
+void
+binder_modem_link_capacity_changed(
+    BinderNetwork* net,
+    BINDER_NETWORK_PROPERTY property,
+    void* user_data)
+{
+    BinderModemPriv* self = user_data;
+    BinderLinkCapacity* lc = &self->link_capacity;
+    const BinderLinkCapacity* now = &net->link_capacity;
+
+    if (lc->downlink_kbps != now->downlink_kbps) {
+        lc->downlink_kbps = now->downlink_kbps;
+        binder_modem_link_capacity_signal(self,
+            LINK_CAPACITY_DBUS_DOWNLINK, lc->downlink_kbps);
+    }
+    if (lc->uplink_kbps != now->uplink_kbps) {
+        lc->uplink_kbps = now->uplink_kbps;
+        binder_modem_link_capacity_signal(self,
+            LINK_CAPACITY_DBUS_UPLINK, lc->uplink_kbps);
+    }
+}
+
+static
+DBusMessage*
+binder_modem_link_capacity_get_properties(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderModemPriv* self = user_data;
+    const BinderLinkCapacity* lc = &self->pub.network->link_capacity;
+    const dbus_uint32_t dl = lc->downlink_kbps;
+    const dbus_uint32_t ul = lc->uplink_kbps;
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    DBusMessageIter it, dict;
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+        OFONO_PROPERTIES_ARRAY_SIGNATURE, &dict);
+    ofono_dbus_dict_append(&dict, LINK_CAPACITY_DBUS_DOWNLINK,
+        DBUS_TYPE_UINT32, &dl);
+    ofono_dbus_dict_append(&dict, LINK_CAPACITY_DBUS_UPLINK,
+        DBUS_TYPE_UINT32, &ul);
+    dbus_message_iter_close_container(&it, &dict);
+    return reply;
+}
+
+static const GDBusMethodTable binder_modem_link_capacity_methods[] = {
+    { GDBUS_METHOD("GetProperties",
+        NULL, GDBUS_ARGS({ "properties", "a{sv}" }),
+        binder_modem_link_capacity_get_properties) },
+    { }
+};
+
+static const GDBusSignalTable binder_modem_link_capacity_signals[] = {
+    { GDBUS_SIGNAL("PropertyChanged",
+        GDBUS_ARGS({ "name", "s" }, { "value", "v" })) },
+    { }
+};
+
+static
+void
+binder_modem_link_capacity_register(
+    BinderModemPriv* self)
+{
+    BinderModem* modem = &self->pub;
+
+    self->link_capacity = modem->network->link_capacity;
+    self->link_capacity_registered = binder_dbus_add_modem_interface(
+        modem->ofono, LINK_CAPACITY_DBUS_INTERFACE,
+        binder_modem_link_capacity_methods,
+        binder_modem_link_capacity_signals, self);
+    if (self->link_capacity_registered) {
+        self->link_capacity_event_id =
+            binder_network_add_property_handler(modem->network,
+                BINDER_NETWORK_PROPERTY_LINK_CAPACITY,
+                binder_modem_link_capacity_changed, self);
+    }
+}
+
+static
+void
+binder_modem_link_capacity_unregister(
+    BinderModemPriv* self)
+{
+    BinderModem* modem = &self->pub;
+
+    if (self->link_capacity_registered) {
+        self->link_capacity_registered = FALSE;
+        binder_network_remove_handler(modem->network,
+            self->link_capacity_event_id);
+        self->link_capacity_event_id = 0;
+        binder_dbus_remove_modem_interface(modem->ofono,
+            LINK_CAPACITY_DBUS_INTERFACE);
+    }
+}
+
 static
 int
 binder_modem_probe(
@@ -490,6 +614,8 @@ binder_modem_remove(
         g_source_remove(self->set_offline.timeout_id);
     }
 
+    binder_keepalive_free(self->keepalive);
+    binder_modem_link_capacity_unregister(self);
     binder_ext_slot_unref(modem->ext);
     binder_ims_reg_unref(modem->ims);
     binder_network_unref(modem->network);
@@ -602,6 +728,9 @@ binder_modem_create(
         modem->ims = binder_ims_reg_new(network_client, ext, log_prefix);
         modem->ext = binder_ext_slot_ref(ext);
         self->g = radio_request_group_new(client);
+        self->keepalive = binder_keepalive_new(data_client, data, ofono,
+            log_prefix);
+        binder_modem_link_capacity_register(self);
         self->last_known_iccid = g_strdup(modem->watch->iccid);
 
         self->watch_event_id[WATCH_IMSI] =
@@ -16,12 +16,16 @@
 #include "binder_modem.h"
 #include "binder_netreg.h"
 #include "binder_network.h"
+#include "binder_oper_cache.h"
 #include "binder_oplist.h"
 #include "binder_util.h"
 #include "binder_log.h"
 
+#include <ofono/dbus.h>
+#include <ofono/gdbus.h>
 #include <ofono/watch.h>
 #include <ofono/sim.h>
+#include <ofono/storage.h>
 #include <ofono/gprs-provision.h>
 
 #include <radio_client.h>
@@ -40,6 +44,73 @@
 #define NETWORK_SCAN_TIMEOUT_SEC (60) /* 1 min */
 #define OPERATOR_LIST_TIMEOUT_SEC (300) /* 5 min */
 #define OPERATOR_LIST_TIMEOUT_MS (OPERATOR_LIST_TIMEOUT_SEC * 1000)
+#define OPER_CACHE_FILE "binder-oper-cache"
+#define OPER_CACHE_MAX_AGE (7 * 24 * 60 * 60) /* 1 week */
+
+/*
+ * Partial results of startNetworkScan are emitted as they arrive,
+ * the ofono core only gets the whole list when the scan completes.
+ * The rest (or everything, if getAvailableNetworks was used) gets
+ * emitted on completion.
+ */
+#define NETWORK_SCAN_DBUS_INTERFACE "org.nemomobile.ofono.NetworkScan"
+#define NETWORK_SCAN_DBUS_SIGNAL_OPERATORS_FOUND "OperatorsFound"
+#define NETWORK_SCAN_DBUS_OPERATOR_SIGNATURE "(sssss)"
+
+/*
+ * Signal strength reporting criteria. The [weak, strong] range of each
+ * measurement is split into the same steps as the bars shown by the UI,
+ * so that the modem only wakes us up when the number of bars would
+ * change.
+ */
+#define SIGNAL_STRENGTH_BARS (5)
+#define SIGNAL_STRENGTH_HYSTERESIS_MS (3000)
+#define SIGNAL_STRENGTH_HYSTERESIS_DB (2)
+
+/* SignalMeasurementType */
+typedef enum binder_netreg_signal_measurement {
+    SIGNAL_MEASUREMENT_RSSI = 1,
+    SIGNAL_MEASUREMENT_RSCP = 2,
+    SIGNAL_MEASUREMENT_RSRP = 3,
+    SIGNAL_MEASUREMENT_SSRSRP = 6
+} BINDER_NETREG_SIGNAL_MEASUREMENT;
+
+typedef struct binder_netreg_signal_range {
+    int weak;   /* dBm */
+    int strong; /* dBm */
+} BinderNetRegSignalRange;
+
+/* android.hardware.radio@1.5::SignalThresholdInfo */
+typedef struct binder_netreg_signal_threshold_info {
+    gint32 signalMeasurement;
+    gint32 hysteresisMs;
+    gint32 hysteresisDb;
+    GBinderHidlVec thresholds;
+    guint8 isEnabled;
+} BinderNetRegSignalThresholdInfo;
+
+static const GBinderWriterField binder_netreg_signal_threshold_info_f[] = {
+    GBINDER_WRITER_FIELD_HIDL_VEC_INT32(BinderNetRegSignalThresholdInfo,
+        thresholds),
+    GBINDER_WRITER_FIELD_END()
+};
+static const GBinderWriterType binder_netreg_signal_threshold_info_type = {
+    GBINDER_WRITER_STRUCT_NAME_AND_SIZE(BinderNetRegSignalThresholdInfo),
+    binder_netreg_signal_threshold_info_f
+};
+
+typedef struct binder_netreg_signal_criteria {
+    RADIO_ACCESS_NETWORK ran;
+    BINDER_NETREG_SIGNAL_MEASUREMENT measurement;
+} BinderNetRegSignalCriteria;
+
+/* The last one (NGRAN) requires IRadio 1.5 or AIDL */
+static const BinderNetRegSignalCriteria binder_netreg_signal_criteria[] = {
+    { RADIO_ACCESS_NETWORK_GERAN, SIGNAL_MEASUREMENT_RSSI },
+    { RADIO_ACCESS_NETWORK_UTRAN, SIGNAL_MEASUREMENT_RSCP },
+    { RADIO_ACCESS_NETWORK_EUTRAN, SIGNAL_MEASUREMENT_RSRP },
+    { RADIO_ACCESS_NETWORK_NGRAN, SIGNAL_MEASUREMENT_SSRSRP }
+};
 
 typedef struct binder_netreg_scan BinderNetRegScan;
 
@@ -72,8 +143,10 @@ typedef struct binder_netreg {
     enum ofono_radio_access_mode techs;
     gboolean use_network_scan;
     gboolean replace_strange_oper;
-    int signal_strength_dbm_weak;
-    int signal_strength_dbm_strong;
+    BinderNetRegSignalRange rssi_range;
+    BinderNetRegSignalRange rscp_range;
+    BinderNetRegSignalRange rsrp_range;
+    BinderNetRegSignalRange ssrsrp_range;
     int network_selection_timeout_ms;
     RadioRequest* register_req;
     RadioRequest* strength_req;
@@ -82,10 +155,15 @@ typedef struct binder_netreg {
     guint notify_id;
     guint current_operator_id;
     BinderNetRegScan* scan;
+    gboolean scan_registered;
     gulong ind_id[IND_COUNT];
     gulong network_event_id[NETREG_NETWORK_EVENT_COUNT];
 } BinderNetReg;
 
+/* Shared by all slots */
+static BinderOperCache* binder_netreg_oper_cache = NULL;
+static guint binder_netreg_oper_cache_users = 0;
+
 typedef struct binder_netreg_cbd {
     BinderNetReg* self;
     union {
@@ -105,6 +183,7 @@ struct binder_netreg_scan {
     gpointer data;
     gboolean stop; /* startNetworkScan succeeded */
     guint timeout_id;
+    guint reported; /* Number of oplist entries already emitted */
 };
 
 typedef struct binder_netreg_radio_type {
@@ -321,26 +400,23 @@ static
 gboolean
 binder_netreg_strange(
     const struct ofono_network_operator* op,
-    struct ofono_sim* sim)
+    const char* spn,
+    const char* mcc,
+    const char* mnc)
 {
     gsize mcclen;
 
-    if (sim && op->status != OFONO_OPERATOR_STATUS_CURRENT) {
-        const char* spn = ofono_sim_get_spn(sim);
-        const char* mcc = ofono_sim_get_mcc(sim);
-        const char* mnc = ofono_sim_get_mnc(sim);
-
-        if (spn && mcc && mnc && !strcmp(op->name, spn) &&
-            (strcmp(op->mcc, mcc) || strcmp(op->mnc, mnc))) {
-            /*
-             * Status is not "current", SPN matches the SIM, but
-             * MCC and/or MNC don't (e.g. Sony Xperia X where all
-             * operators could be reported with the same name
-             * which equals SPN).
-             */
-            DBG("%s %s%s (sim spn?)", op->name, op->mcc, op->mnc);
-            return TRUE;
-        }
+    if (spn && mcc && mnc && op->status != OFONO_OPERATOR_STATUS_CURRENT &&
+        !strcmp(op->name, spn) &&
+        (strcmp(op->mcc, mcc) || strcmp(op->mnc, mnc))) {
+        /*
+         * Status is not "current", SPN matches the SIM, but
+         * MCC and/or MNC don't (e.g. Sony Xperia X where all
+         * operators could be reported with the same name
+         * which equals SPN).
+         */
+        DBG("%s %s%s (sim spn?)", op->name, op->mcc, op->mnc);
+        return TRUE;
     }
 
     mcclen = strlen(op->mcc);
@@ -354,30 +430,60 @@ binder_netreg_strange(
     return FALSE;
 }
 
+static
+char*
+binder_netreg_provider_name(
+    const char* mcc,
+    const char* mnc)
+{
+    struct ofono_gprs_provision_data* prov = NULL;
+    int np = 0;
+    char* name = NULL;
+
+    if (ofono_gprs_provision_get_settings(mcc, mnc, NULL, &prov, &np)) {
+        /* Use the first entry */
+        if (np > 0 && prov->provider_name && prov->provider_name[0]) {
+            name = g_strdup(prov->provider_name);
+        }
+        ofono_gprs_provision_free_settings(prov, np);
+    }
+    return name;
+}
+
 static
 void
 binder_netreg_process_operators(
     BinderNetReg* self,
-    BinderOpList* oplist)
+    struct ofono_network_operator* ops,
+    guint count)
 {
-    if (self->replace_strange_oper && oplist) {
+    if (self->replace_strange_oper && count) {
+        struct ofono_sim* sim = self->watch->sim;
+        const char* spn = sim ? ofono_sim_get_spn(sim) : NULL;
+        const char* mcc = sim ? ofono_sim_get_mcc(sim) : NULL;
+        const char* mnc = sim ? ofono_sim_get_mnc(sim) : NULL;
         guint i;
 
-        for (i = 0; i < oplist->count; i++) {
-            struct ofono_network_operator* op = oplist->op + i;
-            struct ofono_gprs_provision_data* prov = NULL;
-            int np = 0;
-
-            if (binder_netreg_strange(op, self->watch->sim) &&
-                ofono_gprs_provision_get_settings(op->mcc, op->mnc,
-                NULL, &prov, &np)) {
-                /* Use the first entry */
-                if (np > 0 && prov->provider_name && prov->provider_name[0]) {
-                    DBG("%s %s%s -> %s", op->name, op->mcc, op->mnc,
-                        prov->provider_name);
-                    g_strlcpy(op->name, prov->provider_name, sizeof(op->name));
+        for (i = 0; i < count; i++) {
+            struct ofono_network_operator* op = ops + i;
+
+            if (binder_netreg_strange(op, spn, mcc, mnc)) {
+                const char* name = NULL;
+                char* buf = NULL;
+
+                /* Only hit the provisioning database on cache miss */
+                if (!binder_oper_cache_get(binder_netreg_oper_cache,
+                    op->mcc, op->mnc, &name)) {
+                    name = buf = binder_netreg_provider_name(op->mcc,
+                        op->mnc);
+                    binder_oper_cache_put(binder_netreg_oper_cache,
+                        op->mcc, op->mnc, name);
                 }
-                ofono_gprs_provision_free_settings(prov, np);
+                if (name) {
+                    DBG("%s %s%s -> %s", op->name, op->mcc, op->mnc, name);
+                    g_strlcpy(op->name, name, sizeof(op->name));
+                }
+                g_free(buf);
             }
         }
     }
@@ -426,6 +532,122 @@ binder_netreg_scan_free(
     }
 }
 
+static
+void
+binder_netreg_scan_drop(
+    BinderNetReg* self,
+    BinderNetRegScan* scan)
+{
+    if (scan) {
+        scan->cb = NULL;
+        binder_netreg_scan_free(self, scan);
+    }
+}
+
+static
+const char*
+binder_netreg_operator_status_string(
+    int status)
+{
+    switch (status) {
+    case OFONO_OPERATOR_STATUS_AVAILABLE:
+        return "available";
+    case OFONO_OPERATOR_STATUS_CURRENT:
+        return "current";
+    case OFONO_OPERATOR_STATUS_FORBIDDEN:
+        return "forbidden";
+    }
+    return "unknown";
+}
+
+static
+const char*
+binder_netreg_operator_tech_string(
+    enum ofono_access_technology tech)
+{
+    /* Same strings as the ofono core uses for Technologies property */
+    switch (tech) {
+    case OFONO_ACCESS_TECHNOLOGY_GSM:
+    case OFONO_ACCESS_TECHNOLOGY_GSM_COMPACT:
+        return "gsm";
+    case OFONO_ACCESS_TECHNOLOGY_GSM_EGPRS:
+        return "edge";
+    case OFONO_ACCESS_TECHNOLOGY_UTRAN:
+        return "umts";
+    case OFONO_ACCESS_TECHNOLOGY_UTRAN_HSDPA:
+    case OFONO_ACCESS_TECHNOLOGY_UTRAN_HSUPA:
+    case OFONO_ACCESS_TECHNOLOGY_UTRAN_HSDPA_HSUPA:
+        return "hspa";
+    case OFONO_ACCESS_TECHNOLOGY_EUTRAN:
+    case OFONO_ACCESS_TECHNOLOGY_EUTRA_5GCN:
+        return "lte";
+    case OFONO_ACCESS_TECHNOLOGY_NR_5GCN:
+    case OFONO_ACCESS_TECHNOLOGY_NG_RAN:
+    case OFONO_ACCESS_TECHNOLOGY_EUTRA_NR:
+        return "nr";
+    case OFONO_ACCESS_TECHNOLOGY_NONE:
+        break;
+    }
+    return "";
+}
+
+static
+void
+binder_netreg_scan_emit(
+    BinderNetReg* self,
+    const struct ofono_network_operator* ops,
+    guint count)
+{
+    DBusMessage* signal = dbus_message_new_signal(self->watch->path,
+        NETWORK_SCAN_DBUS_INTERFACE, NETWORK_SCAN_DBUS_SIGNAL_OPERATORS_FOUND);
+    DBusMessageIter it, array;
+    guint i;
+
+    dbus_message_iter_init_append(signal, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+        NETWORK_SCAN_DBUS_OPERATOR_SIGNATURE, &array);
+    for (i = 0; i < count; i++) {
+        const struct ofono_network_operator* op = ops + i;
+        const char* mcc = op->mcc;
+        const char* mnc = op->mnc;
+        const char* name = op->name;
+        const char* status = binder_netreg_operator_status_string(op->status);
+        const char* tech = binder_netreg_operator_tech_string(op->tech);
+        DBusMessageIter entry;
+
+        dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL,
+            &entry);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &mcc);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &mnc);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &status);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &tech);
+        dbus_message_iter_close_container(&array, &entry);
+    }
+    dbus_message_iter_close_container(&it, &array);
+    g_dbus_send_message(ofono_dbus_get_connection(), signal);
+}
+
+static
+void
+binder_netreg_scan_progress(
+    BinderNetReg* self,
+    BinderNetRegScan* scan)
+{
+    BinderOpList* oplist = scan->oplist;
+    const guint first = scan->reported;
+    const guint n = binder_oplist_merge(oplist, first);
+
+    if (n) {
+        DBG_(self, "%u new operator(s)", n);
+        binder_netreg_process_operators(self, oplist->op + first, n);
+        if (self->scan_registered) {
+            binder_netreg_scan_emit(self, oplist->op + first, n);
+        }
+        scan->reported = oplist->count;
+    }
+}
+
 static
 void
 binder_netreg_scan_complete(
@@ -440,10 +662,12 @@ binder_netreg_scan_complete(
             scan->cb = NULL;
             binder_error_init_ok(&ok);
             if (scan->oplist) {
-                BinderOpList* oplist = scan->oplist;
+                BinderOpList* oplist;
 
+                /* Whatever hasn't been reported yet goes out now */
+                binder_netreg_scan_progress(self, scan);
+                oplist = scan->oplist;
                 scan->oplist = NULL;
-                binder_netreg_process_operators(self, oplist);
                 cb(&ok, oplist->count, oplist->op, scan->data);
                 binder_oplist_free(oplist);
             } else {
@@ -454,17 +678,12 @@ binder_netreg_scan_complete(
     }
 }
 
-static
-void
-binder_netreg_scan_drop(
-    BinderNetReg* self,
-    BinderNetRegScan* scan)
-{
-    if (scan) {
-        scan->cb = NULL;
-        binder_netreg_scan_free(self, scan);
-    }
-}
+static const GDBusSignalTable binder_netreg_scan_dbus_signals[] = {
+    { GDBUS_SIGNAL(NETWORK_SCAN_DBUS_SIGNAL_OPERATORS_FOUND,
+        GDBUS_ARGS({ "operators",
+            "a" NETWORK_SCAN_DBUS_OPERATOR_SIGNATURE })) },
+    { }
+};
 
 static
 BinderOpList*
@@ -1344,6 +1563,7 @@ binder_netreg_scan_result_notify(
                         }
                     }
                 }
+                binder_netreg_scan_progress(self, scan);
                 if (result->status == RADIO_SCAN_COMPLETE) {
                     DBG_(self, "scan completed");
                     self->scan = NULL;
@@ -1366,6 +1586,7 @@ binder_netreg_scan_result_notify(
                 binder_netreg_scan_op_convert_aidl(count, &reader, scan);
                 DBG_(self, "status=%d, error=%d, %u networks", status, error, count);
 
+                binder_netreg_scan_progress(self, scan);
                 if (status == RADIO_SCAN_COMPLETE) {
                     DBG_(self, "scan completed");
                     self->scan = NULL;
@@ -1657,6 +1878,36 @@ binder_netreg_dbm_from_rscp(
         (-120 + (rscp - RSCP_MIN)) : -140;
 }
 
+/*
+ * The measurements which the reporting criteria are set on (see
+ * binder_netreg_signal_criteria) take precedence, so that the bars
+ * only change when the modem reports that a threshold is crossed.
+ * RSSI is the last resort, it's only gated for GERAN.
+ */
+static
+int
+binder_netreg_signal_strength_dbm(
+    int rssi,
+    int rscp,
+    int rsrp,
+    int ssrsrp,
+    BINDER_NETREG_SIGNAL_MEASUREMENT* measurement)
+{
+    if (ssrsrp >= RSRP_MIN) {
+        *measurement = SIGNAL_MEASUREMENT_SSRSRP;
+        return binder_netreg_dbm_from_rsrp(ssrsrp);
+    } else if (rsrp >= RSRP_MIN) {
+        *measurement = SIGNAL_MEASUREMENT_RSRP;
+        return binder_netreg_dbm_from_rsrp(rsrp);
+    } else if (rscp >= RSCP_MIN) {
+        *measurement = SIGNAL_MEASUREMENT_RSCP;
+        return binder_netreg_dbm_from_rscp(rscp);
+    } else {
+        *measurement = SIGNAL_MEASUREMENT_RSSI;
+        return (rssi >= RSSI_MIN) ? binder_netreg_dbm_from_rssi(rssi) : -140;
+    }
+}
+
 static
 int
 binder_netreg_get_signal_strength_dbm(
@@ -1664,9 +1915,10 @@ binder_netreg_get_signal_strength_dbm(
     const RadioSignalStrengthLte* lte,
     const RadioSignalStrengthWcdma_1_2* wcdma,
     const RadioSignalStrengthTdScdma_1_2* tdscdma,
-    const RadioSignalStrengthNr* nr)
+    const RadioSignalStrengthNr* nr,
+    BINDER_NETREG_SIGNAL_MEASUREMENT* measurement)
 {
-    int rssi = -1, rscp = -1, rsrp = -1;
+    int rssi = -1, rscp = -1, rsrp = -1, ssrsrp = -1;
 
     if (gsm->signalStrength <= RSSI_MAX) {
         rssi = gsm->signalStrength;
@@ -1704,27 +1956,21 @@ binder_netreg_get_signal_strength_dbm(
 
     if (nr) {
         if (nr->ssRsrp >= RSRP_MIN && nr->ssRsrp <= RSRP_MAX) {
-            rsrp = nr->ssRsrp;
+            ssrsrp = nr->ssRsrp;
         }
     }
 
-    if (rssi >= RSCP_MIN) {
-        return binder_netreg_dbm_from_rssi(rssi);
-    } else if (rscp >= RSCP_MIN) {
-        return binder_netreg_dbm_from_rscp(rssi);
-    } else if (rsrp >= RSRP_MIN) {
-        return binder_netreg_dbm_from_rsrp(rssi);
-    } else {
-        return -140;
-    }
+    return binder_netreg_signal_strength_dbm(rssi, rscp, rsrp, ssrsrp,
+        measurement);
 }
 
 static
 int
 binder_netreg_get_signal_strength_dbm_aidl(
-    GBinderReader* reader)
+    GBinderReader* reader,
+    BINDER_NETREG_SIGNAL_MEASUREMENT* measurement)
 {
-    int rssi = -1, rscp = -1, rsrp = -1;
+    int rssi = -1, rscp = -1, rsrp = -1, ssrsrp = -1;
     const RadioSignalStrengthGsm* gsm;
     const RadioSignalStrengthLte* lte;
     const RadioSignalStrengthTdScdma_1_2* tdscdma;
@@ -1777,35 +2023,194 @@ binder_netreg_get_signal_strength_dbm_aidl(
 
     if (nr) {
         if (nr->ssRsrp >= RSRP_MIN && nr->ssRsrp <= RSRP_MAX) {
-            rsrp = nr->ssRsrp;
+            ssrsrp = nr->ssRsrp;
         }
     }
 
-    if (rssi >= RSCP_MIN) {
-        return binder_netreg_dbm_from_rssi(rssi);
-    } else if (rscp >= RSCP_MIN) {
-        return binder_netreg_dbm_from_rscp(rssi);
-    } else if (rsrp >= RSRP_MIN) {
-        return binder_netreg_dbm_from_rsrp(rssi);
-    } else {
-        return -140;
+    return binder_netreg_signal_strength_dbm(rssi, rscp, rsrp, ssrsrp,
+        measurement);
+}
+
+static
+const BinderNetRegSignalRange*
+binder_netreg_signal_range(
+    BinderNetReg* self,
+    BINDER_NETREG_SIGNAL_MEASUREMENT measurement)
+{
+    switch (measurement) {
+    case SIGNAL_MEASUREMENT_RSCP:
+        return &self->rscp_range;
+    case SIGNAL_MEASUREMENT_RSRP:
+        return &self->rsrp_range;
+    case SIGNAL_MEASUREMENT_SSRSRP:
+        return &self->ssrsrp_range;
+    case SIGNAL_MEASUREMENT_RSSI:
+        break;
     }
+    return &self->rssi_range;
 }
 
 static
 int
 binder_netreg_percent_from_dbm(
     BinderNetReg* self,
+    BINDER_NETREG_SIGNAL_MEASUREMENT measurement,
     int dbm)
 {
-    const int min_dbm = self->signal_strength_dbm_weak;    /* dBm */
-    const int max_dbm = self->signal_strength_dbm_strong;  /* dBm */
+    const BinderNetRegSignalRange* range =
+        binder_netreg_signal_range(self, measurement);
+    const int min_dbm = range->weak;
+    const int max_dbm = range->strong;
 
     return (dbm <= min_dbm) ? 1 :
         (dbm >= max_dbm) ? 100 :
         (100 * (dbm - min_dbm) / (max_dbm - min_dbm));
 }
 
+static
+guint
+binder_netreg_signal_thresholds(
+    BinderNetReg* self,
+    BINDER_NETREG_SIGNAL_MEASUREMENT measurement,
+    gint32* thresholds, /* SIGNAL_STRENGTH_BARS + 1 */
+    int* hysteresis)
+{
+    const BinderNetRegSignalRange* range =
+        binder_netreg_signal_range(self, measurement);
+    const int weak = range->weak;
+    const int span = range->strong - weak;
+    int hysteresis_db = SIGNAL_STRENGTH_HYSTERESIS_DB;
+    guint i, n = 0;
+
+    /* Thresholds must be strictly increasing */
+    for (i = 0; i <= SIGNAL_STRENGTH_BARS; i++) {
+        const gint32 dbm = weak + i * span / SIGNAL_STRENGTH_BARS;
+
+        if (!n || dbm > thresholds[n - 1]) {
+            if (n) {
+                /* Hysteresis must be smaller than the smallest step */
+                hysteresis_db = MIN(hysteresis_db, dbm - thresholds[n-1] - 1);
+            }
+            thresholds[n++] = dbm;
+        }
+    }
+    *hysteresis = MAX(hysteresis_db, 0);
+    DBG_(self, "measurement %d: %u thresholds [%d..%d] dBm, hysteresis %d dB",
+        measurement, n, thresholds[0], thresholds[n - 1], *hysteresis);
+    return n;
+}
+
+static
+void
+binder_netreg_set_signal_strength_criteria(
+    BinderNetReg* self)
+{
+    const BinderNetRegSignalCriteria* criteria = binder_netreg_signal_criteria;
+    const RADIO_INTERFACE iface = radio_client_interface(self->client);
+    gint32 thresholds[SIGNAL_STRENGTH_BARS + 1];
+    int hysteresis_db;
+    guint i, n, count = G_N_ELEMENTS(binder_netreg_signal_criteria);
+    GBinderWriter writer;
+    RadioRequest* req;
+
+    if (self->interface_aidl != RADIO_AIDL_INTERFACE_NONE) {
+        req = radio_request_new(self->client,
+            RADIO_NETWORK_REQ_SET_SIGNAL_STRENGTH_REPORTING_CRITERIA,
+            &writer, NULL, NULL, NULL);
+
+        /*
+         * setSignalStrengthReportingCriteria(int serial,
+         *   in SignalThresholdInfo[] signalThresholdInfos);
+         */
+        gbinder_writer_append_int32(&writer, count);
+        for (i = 0; i < count; i++) {
+            gint32 initial_size;
+            guint k;
+
+            n = binder_netreg_signal_thresholds(self, criteria[i].measurement,
+                thresholds, &hysteresis_db);
+
+            /* Non-null parcelable */
+            gbinder_writer_append_int32(&writer, 1);
+            initial_size = gbinder_writer_bytes_written(&writer);
+            /* Dummy parcelable size, replaced at the end */
+            gbinder_writer_append_int32(&writer, -1);
+
+            gbinder_writer_append_int32(&writer, criteria[i].measurement);
+            gbinder_writer_append_int32(&writer,
+                SIGNAL_STRENGTH_HYSTERESIS_MS);
+            gbinder_writer_append_int32(&writer, hysteresis_db);
+            gbinder_writer_append_int32(&writer, n);
+            for (k = 0; k < n; k++) {
+                gbinder_writer_append_int32(&writer, thresholds[k]);
+            }
+            gbinder_writer_append_bool(&writer, TRUE);  /* isEnabled */
+            gbinder_writer_append_int32(&writer, criteria[i].ran);
+
+            /* Overwrite parcelable size */
+            gbinder_writer_overwrite_int32(&writer, initial_size,
+                gbinder_writer_bytes_written(&writer) - initial_size);
+        }
+        radio_request_submit(req);
+        radio_request_unref(req);
+    } else if (iface >= RADIO_INTERFACE_1_5) {
+        for (i = 0; i < count; i++) {
+            BinderNetRegSignalThresholdInfo* info;
+
+            n = binder_netreg_signal_thresholds(self, criteria[i].measurement,
+                thresholds, &hysteresis_db);
+            req = radio_request_new(self->client,
+                RADIO_REQ_SET_SIGNAL_STRENGTH_REPORTING_CRITERIA_1_5,
+                &writer, NULL, NULL, NULL);
+
+            /*
+             * setSignalStrengthReportingCriteria_1_5(int32 serial,
+             *   SignalThresholdInfo signalThresholdInfo,
+             *   AccessNetwork accessNetwork);
+             */
+            info = gbinder_writer_new0(&writer,
+                BinderNetRegSignalThresholdInfo);
+            info->signalMeasurement = criteria[i].measurement;
+            info->hysteresisMs = SIGNAL_STRENGTH_HYSTERESIS_MS;
+            info->hysteresisDb = hysteresis_db;
+            info->thresholds.data.ptr = gbinder_writer_memdup(&writer,
+                thresholds, n * sizeof(thresholds[0]));
+            info->thresholds.count = n;
+            info->isEnabled = TRUE;
+            gbinder_writer_append_struct(&writer, info,
+                &binder_netreg_signal_threshold_info_type, NULL);
+            gbinder_writer_append_int32(&writer, criteria[i].ran);
+            radio_request_submit(req);
+            radio_request_unref(req);
+        }
+    } else if (iface >= RADIO_INTERFACE_1_2) {
+        /* No NGRAN in IRadio 1.2 */
+        for (i = 0; i < count - 1; i++) {
+            n = binder_netreg_signal_thresholds(self, criteria[i].measurement,
+                thresholds, &hysteresis_db);
+            req = radio_request_new(self->client,
+                RADIO_REQ_SET_SIGNAL_STRENGTH_REPORTING_CRITERIA,
+                &writer, NULL, NULL, NULL);
+
+            /*
+             * setSignalStrengthReportingCriteria(int32 serial,
+             *   int32 hysteresisMs, int32 hysteresisDb,
+             *   vec<int32> thresholdsDbm, AccessNetwork accessNetwork);
+             */
+            gbinder_writer_append_int32(&writer,
+                SIGNAL_STRENGTH_HYSTERESIS_MS);
+            gbinder_writer_append_int32(&writer, hysteresis_db);
+            gbinder_writer_append_hidl_vec(&writer,
+                gbinder_writer_memdup(&writer, thresholds,
+                n * sizeof(thresholds[0])), n, sizeof(thresholds[0]));
+            gbinder_writer_append_int32(&writer, criteria[i].ran);
+            radio_request_submit(req);
+            radio_request_unref(req);
+        }
+    }
+    /* Otherwise the filtering is done by setIndicationFilter */
+}
+
 static
 void
 binder_netreg_strength_notify(
@@ -1816,6 +2221,7 @@ binder_netreg_strength_notify(
 {
     BinderNetReg* self = user_data;
     GBinderReader reader;
+    BINDER_NETREG_SIGNAL_MEASUREMENT m = SIGNAL_MEASUREMENT_RSSI;
     int dbm = 0;
 
     gbinder_reader_copy(&reader, args);
@@ -1826,7 +2232,7 @@ binder_netreg_strength_notify(
 
             if (ss) {
                 dbm = binder_netreg_get_signal_strength_dbm
-                    (&ss->gw, &ss->lte, NULL, NULL, NULL);
+                    (&ss->gw, &ss->lte, NULL, NULL, NULL, &m);
             }
         } else if (code == RADIO_IND_CURRENT_SIGNAL_STRENGTH_1_2) {
             const RadioSignalStrength_1_2* ss = gbinder_reader_read_hidl_struct
@@ -1834,7 +2240,7 @@ binder_netreg_strength_notify(
 
             if (ss) {
                 dbm = binder_netreg_get_signal_strength_dbm
-                    (&ss->gw, &ss->lte, &ss->wcdma, NULL, NULL);
+                    (&ss->gw, &ss->lte, &ss->wcdma, NULL, NULL, &m);
             }
         } else if (code == RADIO_IND_CURRENT_SIGNAL_STRENGTH_1_4) {
             const RadioSignalStrength_1_4* ss = gbinder_reader_read_hidl_struct
@@ -1842,15 +2248,16 @@ binder_netreg_strength_notify(
 
             if (ss) {
                 dbm = binder_netreg_get_signal_strength_dbm
-                    (&ss->gsm, &ss->lte, &ss->wcdma, &ss->tdscdma, &ss->nr);
+                    (&ss->gsm, &ss->lte, &ss->wcdma, &ss->tdscdma, &ss->nr,
+                        &m);
             }
         }
     } else {
-        dbm = binder_netreg_get_signal_strength_dbm_aidl(&reader);
+        dbm = binder_netreg_get_signal_strength_dbm_aidl(&reader, &m);
     }
 
     if (dbm) {
-        const int percent = binder_netreg_percent_from_dbm(self, dbm);
+        const int percent = binder_netreg_percent_from_dbm(self, m, dbm);
 
         DBG_(self, "%d dBm (%d%%)", dbm, percent);
         ofono_netreg_strength_notify(self->netreg, percent);
@@ -1877,6 +2284,7 @@ static void binder_netreg_strength_cb(
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
             GBinderReader reader;
+            BINDER_NETREG_SIGNAL_MEASUREMENT m = SIGNAL_MEASUREMENT_RSSI;
             int dbm = 0;
 
             gbinder_reader_copy(&reader, args);
@@ -1888,7 +2296,7 @@ static void binder_netreg_strength_cb(
 
                     if (ss) {
                         dbm = binder_netreg_get_signal_strength_dbm
-                            (&ss->gw, &ss->lte, NULL, NULL, NULL);
+                            (&ss->gw, &ss->lte, NULL, NULL, NULL, &m);
                     }
                 } else if (resp == RADIO_RESP_GET_SIGNAL_STRENGTH_1_2) {
                     const RadioSignalStrength_1_2* ss =
@@ -1897,7 +2305,7 @@ static void binder_netreg_strength_cb(
 
                     if (ss) {
                         dbm = binder_netreg_get_signal_strength_dbm
-                            (&ss->gw, &ss->lte, &ss->wcdma, NULL, NULL);
+                            (&ss->gw, &ss->lte, &ss->wcdma, NULL, NULL, &m);
                     }
                 } else if (resp == RADIO_RESP_GET_SIGNAL_STRENGTH_1_4) {
                     const RadioSignalStrength_1_4* ss =
@@ -1906,17 +2314,20 @@ static void binder_netreg_strength_cb(
 
                     if (ss) {
                         dbm = binder_netreg_get_signal_strength_dbm
-                            (&ss->gsm, &ss->lte, &ss->wcdma, &ss->tdscdma, &ss->nr);
+                            (&ss->gsm, &ss->lte, &ss->wcdma, &ss->tdscdma,
+                                &ss->nr, &m);
                     }
                 } else {
                     ofono_error("Unexpected getSignalStrength response %d", resp);
                 }
             } else {
-                dbm = binder_netreg_get_signal_strength_dbm_aidl(&reader);
+                dbm = binder_netreg_get_signal_strength_dbm_aidl(&reader,
+                    &m);
             }
 
             if (dbm) {
-                const int percent = binder_netreg_percent_from_dbm(self, dbm);
+                const int percent =
+                    binder_netreg_percent_from_dbm(self, m, dbm);
 
                 /* Success */
                 DBG_(self, "%d dBm (%d%%)", dbm, percent);
@@ -2046,6 +2457,9 @@ binder_netreg_modem_reset_notify(
     self->register_req = NULL;
     self->strength_req = NULL;
 
+    /* Reporting criteria don't survive modem reset */
+    binder_netreg_set_signal_strength_criteria(self);
+
     /* And complete the scan (successfully if there were any results) */
     if (self->scan) {
         BinderNetRegScan* scan = self->scan;
@@ -2145,6 +2559,8 @@ binder_netreg_register(
                 RADIO_MODEM_IND_MODEM_RESET,
                 binder_netreg_modem_reset_notify, self);
     }
+
+    binder_netreg_set_signal_strength_criteria(self);
     return G_SOURCE_REMOVE;
 }
 
@@ -2167,12 +2583,33 @@ binder_netreg_probe(
     self->interface_aidl = radio_client_aidl_interface(modem->network_client);
     self->watch = ofono_watch_new(binder_modem_get_path(modem));
     self->network = binder_network_ref(modem->network);
+    /* Nothing to call there, the interface only emits signals */
+    self->scan_registered = binder_dbus_add_modem_interface(
+        ofono_netreg_get_modem(netreg), NETWORK_SCAN_DBUS_INTERFACE,
+        NULL, binder_netreg_scan_dbus_signals, self);
     self->netreg = netreg;
     self->techs = config->techs;
     self->use_network_scan = config->use_network_scan;
     self->replace_strange_oper = config->replace_strange_oper;
-    self->signal_strength_dbm_weak = config->signal_strength_dbm_weak;
-    self->signal_strength_dbm_strong = config->signal_strength_dbm_strong;
+    if (self->replace_strange_oper) {
+        if (!binder_netreg_oper_cache_users++) {
+            char* file = config->oper_name_cache ?
+                g_build_filename(ofono_storage_dir(), OPER_CACHE_FILE,
+                    NULL) : NULL;
+
+            binder_netreg_oper_cache = binder_oper_cache_new(file,
+                OPER_CACHE_MAX_AGE);
+            g_free(file);
+        }
+    }
+    self->rssi_range.weak = config->signal_strength_dbm_weak;
+    self->rssi_range.strong = config->signal_strength_dbm_strong;
+    self->rscp_range.weak = config->rscp_dbm_weak;
+    self->rscp_range.strong = config->rscp_dbm_strong;
+    self->rsrp_range.weak = config->rsrp_dbm_weak;
+    self->rsrp_range.strong = config->rsrp_dbm_strong;
+    self->ssrsrp_range.weak = config->ssrsrp_dbm_weak;
+    self->ssrsrp_range.strong = config->ssrsrp_dbm_strong;
     self->network_selection_timeout_ms = config->network_selection_timeout_ms;
 
     ofono_netreg_set_data(netreg, self);
@@ -2204,6 +2641,10 @@ binder_netreg_remove(
     radio_request_drop(self->register_req);
     radio_request_drop(self->strength_req);
 
+    if (self->scan_registered) {
+        binder_dbus_remove_modem_interface(ofono_netreg_get_modem(netreg),
+            NETWORK_SCAN_DBUS_INTERFACE);
+    }
     ofono_watch_unref(self->watch);
     binder_network_remove_all_handlers(self->network, self->network_event_id);
     binder_network_unref(self->network);
@@ -2214,6 +2655,11 @@ binder_netreg_remove(
 
     binder_netreg_scan_drop(self, self->scan);
     g_free(self->log_prefix);
+
+    if (self->replace_strange_oper && !--binder_netreg_oper_cache_users) {
+        binder_oper_cache_free(binder_netreg_oper_cache);
+        binder_netreg_oper_cache = NULL;
+    }
     g_free(self);
 
     ofono_netreg_set_data(netreg, NULL);
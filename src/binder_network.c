@@ -46,10 +46,28 @@
 #define SET_PREF_MODE_HOLDOFF_SEC BINDER_RETRY_SECS
 #define INTINITE_TIMEOUT UINT_MAX
 #define MAX_DATA_CALLS 16
+#define POLL_DEBOUNCE_MS 200
+
+/*
+ * Link capacity reporting criteria. The modem only reports a new
+ * estimate when a threshold is crossed and the change exceeds the
+ * hysteresis. These are the defaults used by Android.
+ */
+#define LINK_CAPACITY_HYSTERESIS_MS (3000)
+#define LINK_CAPACITY_HYSTERESIS_KBPS (50)
+
+static const gint32 binder_network_lce_thresholds_dl[] = {
+    100, 500, 1000, 5000, 10000, 20000, 50000, 100000, 200000, 500000,
+    1000000
+};
+static const gint32 binder_network_lce_thresholds_ul[] = {
+    100, 500, 1000, 5000, 10000, 20000, 50000, 100000, 200000
+};
 
 typedef enum binder_network_timer {
     TIMER_SET_RAT_HOLDOFF,
     TIMER_FORCE_CHECK_PREF_MODE,
+    TIMER_POLL_DEBOUNCE,
     TIMER_COUNT
 } BINDER_NETWORK_TIMER;
 
@@ -75,6 +93,7 @@ enum binder_network_ind_events {
     IND_NETWORK_STATE,
     IND_MODEM_RESET,
     IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS_1_4,
+    IND_LINK_CAPACITY_ESTIMATE,
     IND_COUNT
 };
 
@@ -89,6 +108,12 @@ typedef struct binder_network_location {
     int ci;
 } BinderNetworkLocation;
 
+/* android.hardware.radio@1.2::LinkCapacityEstimate */
+typedef struct binder_network_lce {
+    guint32 downlinkCapacityKbps;
+    guint32 uplinkCapacityKbps;
+} BinderNetworkLce;
+
 typedef struct binder_network_data_profile {
     RADIO_DATA_PROFILE_ID id;
     RADIO_DATA_PROFILE_TYPE type;
@@ -124,6 +149,9 @@ typedef struct binder_network_object {
     RadioRequest* operator_poll_req;
     RadioRequest* voice_poll_req;
     RadioRequest* data_poll_req;
+    gboolean poll_dirty;      /* State changed while polling */
+    guint polls_requested;    /* networkStateChanged indications */
+    guint polls_issued;       /* ... of which actually caused a poll */
     RadioRequest* query_rat_req;
     RadioRequest* set_rat_req;
     RadioRequest* set_data_profiles_req;
@@ -178,6 +206,11 @@ void
 binder_network_check_initial_attach_apn(
     BinderNetworkObject* self);
 
+static
+void
+binder_network_poll_done(
+    BinderNetworkObject* self);
+
 static inline BinderNetworkObject* binder_network_cast(BinderNetwork* net)
     { return net ? THIS(G_CAST(net, BinderNetworkObject, pub)) : NULL; }
 static inline void binder_network_object_ref(BinderNetworkObject* self)
@@ -331,6 +364,7 @@ binder_network_poll_operator_cb(
     GASSERT(self->operator_poll_req == req);
     radio_request_unref(self->operator_poll_req);
     self->operator_poll_req = NULL;
+    binder_network_poll_done(self);
 
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == code) {
@@ -696,6 +730,7 @@ binder_network_poll_voice_state_cb(
     GASSERT(self->voice_poll_req == req);
     radio_request_unref(self->voice_poll_req);
     self->voice_poll_req = NULL;
+    binder_network_poll_done(self);
 
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
@@ -920,6 +955,7 @@ binder_network_poll_data_state_cb(
     GASSERT(self->data_poll_req == req);
     radio_request_unref(self->data_poll_req);
     self->data_poll_req = NULL;
+    binder_network_poll_done(self);
 
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
@@ -1100,12 +1136,78 @@ binder_network_poll_state(
     guint32 code = self->interface_aidl == RADIO_NETWORK_INTERFACE ?
         RADIO_NETWORK_REQ_GET_OPERATOR : RADIO_REQ_GET_OPERATOR;
 
+    /* This poll covers whatever has changed so far */
+    self->poll_dirty = FALSE;
+    binder_network_stop_timer(self, TIMER_POLL_DEBOUNCE);
+
     self->operator_poll_req = binder_network_poll_and_retry(self,
         self->operator_poll_req, code,
         binder_network_poll_operator_cb);
     binder_network_poll_registration_state(self);
 }
 
+static
+gboolean
+binder_network_polling(
+    BinderNetworkObject* self)
+{
+    return self->operator_poll_req || self->voice_poll_req ||
+        self->data_poll_req;
+}
+
+static
+gboolean
+binder_network_poll_debounce_cb(
+    gpointer user_data)
+{
+    BinderNetworkObject* self = THIS(user_data);
+
+    GASSERT(self->timer[TIMER_POLL_DEBOUNCE]);
+    self->timer[TIMER_POLL_DEBOUNCE] = 0;
+
+    self->polls_issued++;
+    binder_network_poll_state(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+binder_network_poll_done(
+    BinderNetworkObject* self)
+{
+    /* Issue exactly one follow-up poll if anything has changed */
+    if (self->poll_dirty && !binder_network_polling(self) &&
+        !self->timer[TIMER_POLL_DEBOUNCE]) {
+        DBG_(self, "scheduling follow-up poll");
+        self->poll_dirty = FALSE;
+        self->timer[TIMER_POLL_DEBOUNCE] =
+            g_timeout_add(POLL_DEBOUNCE_MS,
+                binder_network_poll_debounce_cb, self);
+    }
+}
+
+static
+void
+binder_network_poll_state_changed(
+    BinderNetworkObject* self)
+{
+    self->polls_requested++;
+    if (self->timer[TIMER_POLL_DEBOUNCE]) {
+        /* Follow-up poll is already scheduled */
+        DBG_(self, "poll already scheduled");
+    } else if (binder_network_polling(self)) {
+        /* Don't wait for retry timeouts to expire though */
+        radio_request_retry(self->operator_poll_req);
+        radio_request_retry(self->voice_poll_req);
+        radio_request_retry(self->data_poll_req);
+        DBG_(self, "poll in progress");
+        self->poll_dirty = TRUE;
+    } else {
+        self->polls_issued++;
+        binder_network_poll_state(self);
+    }
+}
+
 static
 RADIO_PREF_NET_TYPE
 binder_network_mode_to_pref(
@@ -2308,7 +2410,7 @@ binder_network_state_changed_cb(
         RADIO_NETWORK_IND_NETWORK_STATE_CHANGED :
         RADIO_IND_NETWORK_STATE_CHANGED;
     GASSERT(code == ind_code);
-    binder_network_poll_state(self);
+    binder_network_poll_state_changed(self);
 }
 
 static
@@ -2348,6 +2450,8 @@ binder_network_modem_reset_cb(
     self->set_rat_req = NULL;
     self->set_data_profiles_req = NULL;
     self->set_ia_apn_req  = NULL;
+    self->poll_dirty = FALSE;
+    binder_network_stop_timer(self, TIMER_POLL_DEBOUNCE);
 
     binder_network_initial_rat_query(self);
     binder_network_reset_initial_attach_apn(self);
@@ -2417,6 +2521,186 @@ binder_network_current_physical_channel_configs_cb(
     self->nr_connected = nr_connected;
 }
 
+/*==========================================================================*
+ * Link capacity estimate
+ *==========================================================================*/
+
+static
+void
+binder_network_append_int32_array(
+    GBinderWriter* writer,
+    const gint32* values,
+    guint count)
+{
+    guint i;
+
+    gbinder_writer_append_int32(writer, count);
+    for (i = 0; i < count; i++) {
+        gbinder_writer_append_int32(writer, values[i]);
+    }
+}
+
+static
+void
+binder_network_set_link_capacity_criteria_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderNetworkObject* self = THIS(user_data);
+
+    if (status != RADIO_TX_STATUS_OK || error != RADIO_ERROR_NONE) {
+        DBG_(self, "setLinkCapacityReportingCriteria failed (%d, %s)",
+            status, binder_radio_error_string(error));
+    }
+}
+
+static
+void
+binder_network_set_link_capacity_criteria(
+    BinderNetworkObject* self)
+{
+    static const RADIO_ACCESS_NETWORK an[] = {
+        RADIO_ACCESS_NETWORK_GERAN,
+        RADIO_ACCESS_NETWORK_UTRAN,
+        RADIO_ACCESS_NETWORK_EUTRAN,
+        RADIO_ACCESS_NETWORK_NGRAN  /* Requires IRadio 1.5 or AIDL */
+    };
+    const RADIO_INTERFACE iface = radio_client_interface(self->g->client);
+    const gboolean aidl = self->interface_aidl != RADIO_AIDL_INTERFACE_NONE;
+    guint32 code;
+    guint i, n = G_N_ELEMENTS(an);
+
+    if (aidl) {
+        code = RADIO_NETWORK_REQ_SET_LINK_CAPACITY_REPORTING_CRITERIA;
+    } else if (iface >= RADIO_INTERFACE_1_5) {
+        code = RADIO_REQ_SET_LINK_CAPACITY_REPORTING_CRITERIA_1_5;
+    } else if (iface >= RADIO_INTERFACE_1_2) {
+        code = RADIO_REQ_SET_LINK_CAPACITY_REPORTING_CRITERIA;
+        n--;
+    } else {
+        /* Link capacity estimates appeared in IRadio 1.2 */
+        return;
+    }
+
+    DBG_(self, "setting link capacity reporting criteria");
+    for (i = 0; i < n; i++) {
+        GBinderWriter writer;
+        RadioRequest* req = radio_request_new2(self->g, code, &writer,
+            binder_network_set_link_capacity_criteria_cb, NULL, self);
+
+        /*
+         * setLinkCapacityReportingCriteria(int32 serial,
+         *   int32 hysteresisMs, int32 hysteresisDlKbps,
+         *   int32 hysteresisUlKbps, vec<int32> thresholdsDownlinkKbps,
+         *   vec<int32> thresholdsUplinkKbps, AccessNetwork accessNetwork);
+         */
+        gbinder_writer_append_int32(&writer, LINK_CAPACITY_HYSTERESIS_MS);
+        gbinder_writer_append_int32(&writer, LINK_CAPACITY_HYSTERESIS_KBPS);
+        gbinder_writer_append_int32(&writer, LINK_CAPACITY_HYSTERESIS_KBPS);
+        if (aidl) {
+            binder_network_append_int32_array(&writer,
+                binder_network_lce_thresholds_dl,
+                G_N_ELEMENTS(binder_network_lce_thresholds_dl));
+            binder_network_append_int32_array(&writer,
+                binder_network_lce_thresholds_ul,
+                G_N_ELEMENTS(binder_network_lce_thresholds_ul));
+        } else {
+            gbinder_writer_append_hidl_vec(&writer,
+                binder_network_lce_thresholds_dl,
+                G_N_ELEMENTS(binder_network_lce_thresholds_dl),
+                sizeof(binder_network_lce_thresholds_dl[0]));
+            gbinder_writer_append_hidl_vec(&writer,
+                binder_network_lce_thresholds_ul,
+                G_N_ELEMENTS(binder_network_lce_thresholds_ul),
+                sizeof(binder_network_lce_thresholds_ul[0]));
+        }
+        gbinder_writer_append_int32(&writer, an[i]);
+        radio_request_submit(req);
+        radio_request_unref(req);
+    }
+}
+
+static
+void
+binder_network_set_link_capacity(
+    BinderNetworkObject* self,
+    guint dl,
+    guint ul)
+{
+    BinderLinkCapacity* lc = &self->pub.link_capacity;
+
+    if (lc->downlink_kbps != dl || lc->uplink_kbps != ul) {
+        lc->downlink_kbps = dl;
+        lc->uplink_kbps = ul;
+        binder_base_queue_property_change(&self->base,
+            BINDER_NETWORK_PROPERTY_LINK_CAPACITY);
+    }
+    binder_base_emit_queued_signals(&self->base);
+}
+
+static
+guint
+binder_network_lce_sum(
+    gint32 primary,
+    gint32 secondary)
+{
+    /* Secondary capacity is only valid in EN-DC mode */
+    return MAX(primary, 0) + ((secondary > 0 && secondary < G_MAXINT32) ?
+        secondary : 0);
+}
+
+static
+void
+binder_network_link_capacity_estimate_cb(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderNetworkObject* self = THIS(user_data);
+    GBinderReader reader;
+
+    gbinder_reader_copy(&reader, args);
+    if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) {
+        /*
+         * currentLinkCapacityEstimate(RadioIndicationType,
+         *   LinkCapacityEstimate lce);
+         */
+        const BinderNetworkLce* lce =
+            gbinder_reader_read_hidl_struct(&reader, BinderNetworkLce);
+
+        if (lce) {
+            DBG_(self, "%u/%u kbps", lce->downlinkCapacityKbps,
+                lce->uplinkCapacityKbps);
+            binder_network_set_link_capacity(self, lce->downlinkCapacityKbps,
+                lce->uplinkCapacityKbps);
+        }
+    } else if (binder_read_parcelable_size(&reader) >= 2 * sizeof(gint32)) {
+        gint32 dl = 0, ul = 0, dl2 = 0, ul2 = 0;
+
+        /*
+         * parcelable LinkCapacityEstimate {
+         *     int downlinkCapacityKbps;
+         *     int uplinkCapacityKbps;
+         *     int secondaryDownlinkCapacityKbps;
+         *     int secondaryUplinkCapacityKbps;
+         * }
+         */
+        gbinder_reader_read_int32(&reader, &dl);
+        gbinder_reader_read_int32(&reader, &ul);
+        gbinder_reader_read_int32(&reader, &dl2);
+        gbinder_reader_read_int32(&reader, &ul2);
+        DBG_(self, "%d/%d (+%d/%d) kbps", dl, ul, dl2, ul2);
+        binder_network_set_link_capacity(self,
+            binder_network_lce_sum(dl, dl2),
+            binder_network_lce_sum(ul, ul2));
+    }
+}
+
 static
 void
 binder_network_radio_state_cb(
@@ -2430,6 +2714,10 @@ binder_network_radio_state_cb(
     if (radio->state == RADIO_STATE_ON) {
         binder_network_poll_state(self);
         binder_network_try_set_initial_attach_apn(self);
+        binder_network_set_link_capacity_criteria(self);
+    } else {
+        /* The estimate is meaningless without radio */
+        binder_network_set_link_capacity(self, 0, 0);
     }
 }
 
@@ -2590,6 +2878,10 @@ binder_network_new(
             radio_client_add_indication_handler(client,
                 RADIO_IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS_1_4,
                 binder_network_current_physical_channel_configs_cb, self);
+        self->ind_id[IND_LINK_CAPACITY_ESTIMATE] =
+            radio_client_add_indication_handler(client,
+                RADIO_IND_CURRENT_LINK_CAPACITY_ESTIMATE,
+                binder_network_link_capacity_estimate_cb, self);
     } else {
         self->ind_id[IND_NETWORK_STATE] =
             radio_client_add_indication_handler(client,
@@ -2603,6 +2895,10 @@ binder_network_new(
             radio_client_add_indication_handler(client,
                 RADIO_NETWORK_IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS,
                 binder_network_current_physical_channel_configs_cb, self);
+        self->ind_id[IND_LINK_CAPACITY_ESTIMATE] =
+            radio_client_add_indication_handler(client,
+                RADIO_NETWORK_IND_CURRENT_LINK_CAPACITY_ESTIMATE,
+                binder_network_link_capacity_estimate_cb, self);
     }
 
     self->radio_event_id[RADIO_EVENT_STATE_CHANGED] =
@@ -2637,6 +2933,7 @@ binder_network_new(
 
     if (radio->state == RADIO_STATE_ON) {
         binder_network_poll_state(self);
+        binder_network_set_link_capacity_criteria(self);
     }
 
     self->set_initial_attach_apn = self->need_initial_attach_apn =
@@ -2788,7 +3085,9 @@ binder_network_object_finalize(
     BinderNetwork* net = &self->pub;
     BINDER_NETWORK_TIMER tid;
 
-    DBG_(self, "");
+    DBG_(self, "%u state change(s), %u poll(s), %u saved",
+        self->polls_requested, self->polls_issued,
+        self->polls_requested - self->polls_issued);
     for (tid=0; tid<TIMER_COUNT; tid++) {
         binder_network_stop_timer(self, tid);
     }
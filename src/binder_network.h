@@ -29,6 +29,7 @@ typedef enum binder_network_property {
     BINDER_NETWORK_PROPERTY_OPERATOR,
     BINDER_NETWORK_PROPERTY_PREF_MODES,
     BINDER_NETWORK_PROPERTY_ALLOWED_MODES,
+    BINDER_NETWORK_PROPERTY_LINK_CAPACITY,
     BINDER_NETWORK_PROPERTY_COUNT
 } BINDER_NETWORK_PROPERTY;
 
@@ -41,6 +42,12 @@ typedef struct binder_registration_state {
     int ci;
 } BinderRegistrationState;
 
+/* Modem's estimate of the available bandwidth, zero if unknown */
+typedef struct binder_link_capacity {
+    guint downlink_kbps;
+    guint uplink_kbps;
+} BinderLinkCapacity;
+
 struct binder_network {
     BinderSimSettings* settings;
     BinderRegistrationState voice;
@@ -49,6 +56,7 @@ struct binder_network {
     const struct ofono_network_operator* operator;
     enum ofono_radio_access_mode pref_modes;     /* Mask */
     enum ofono_radio_access_mode allowed_modes;  /* Mask */
+    BinderLinkCapacity link_capacity;
 };
 
 typedef
@@ -0,0 +1,262 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_oper_cache.h"
+
+#include <errno.h>
+#include <string.h>
+
+#define OPER_CACHE_GROUP_INFO       "Cache"
+#define OPER_CACHE_GROUP_NAMES      "Operators"
+#define OPER_CACHE_KEY_CREATED      "Created"
+#define OPER_CACHE_KEY_MAX_LEN      (6) /* 3 digit MCC + up to 3 digit MNC */
+
+struct binder_oper_cache {
+    char* file;
+    guint max_age;
+    gint64 created;     /* Seconds since the epoch */
+    GHashTable* names;  /* Empty string if there's no name */
+    guint save_id;
+    gboolean dirty;
+};
+
+static
+char*
+binder_oper_cache_key(
+    const char* mcc,
+    const char* mnc)
+{
+    /* The key ends up in a file, make sure it's harmless */
+    if (mcc && mnc && mcc[0] && mnc[0]) {
+        char* key = g_strconcat(mcc, mnc, NULL);
+        const char* ptr = key;
+
+        while (*ptr && g_ascii_isdigit(*ptr)) {
+            ptr++;
+        }
+        if (!*ptr && (ptr - key) <= OPER_CACHE_KEY_MAX_LEN) {
+            return key;
+        }
+        g_free(key);
+    }
+    return NULL;
+}
+
+static
+void
+binder_oper_cache_load(
+    BinderOperCache* cache)
+{
+    GKeyFile* kf = g_key_file_new();
+
+    if (g_key_file_load_from_file(kf, cache->file, G_KEY_FILE_NONE, NULL)) {
+        const gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+        const gint64 created = g_key_file_get_int64(kf, OPER_CACHE_GROUP_INFO,
+            OPER_CACHE_KEY_CREATED, NULL);
+
+        if (created > 0 && created <= now &&
+            (now - created) < cache->max_age) {
+            char** keys = g_key_file_get_keys(kf, OPER_CACHE_GROUP_NAMES,
+                NULL, NULL);
+
+            if (keys) {
+                char** ptr;
+
+                for (ptr = keys; *ptr; ptr++) {
+                    char* name = g_key_file_get_string(kf,
+                        OPER_CACHE_GROUP_NAMES, *ptr, NULL);
+
+                    if (name) {
+                        g_hash_table_insert(cache->names, g_strdup(*ptr),
+                            name);
+                    }
+                }
+                g_strfreev(keys);
+            }
+            cache->created = created;
+            GDEBUG("Loaded %u operator names from %s",
+                g_hash_table_size(cache->names), cache->file);
+        } else {
+            /* Start from scratch */
+            GDEBUG("Discarding stale %s", cache->file);
+            cache->dirty = TRUE;
+        }
+    }
+    g_key_file_unref(kf);
+}
+
+static
+void
+binder_oper_cache_check_age(
+    BinderOperCache* cache)
+{
+    const gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+
+    /* Same rule as for the file, the whole thing expires at once */
+    if (cache->created > now || (now - cache->created) >= cache->max_age) {
+        if (g_hash_table_size(cache->names)) {
+            GDEBUG("Discarding %u stale operator names",
+                g_hash_table_size(cache->names));
+            g_hash_table_remove_all(cache->names);
+            cache->dirty = (cache->file != NULL);
+        }
+        cache->created = now;
+    }
+}
+
+static
+gboolean
+binder_oper_cache_save_cb(
+    gpointer user_data)
+{
+    BinderOperCache* cache = user_data;
+
+    cache->save_id = 0;
+    binder_oper_cache_save(cache);
+    return G_SOURCE_REMOVE;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderOperCache*
+binder_oper_cache_new(
+    const char* file,
+    guint max_age)
+{
+    BinderOperCache* cache = g_new0(BinderOperCache, 1);
+
+    cache->max_age = max_age;
+    cache->created = g_get_real_time() / G_USEC_PER_SEC;
+    cache->names = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, g_free);
+    if (file) {
+        cache->file = g_strdup(file);
+        binder_oper_cache_load(cache);
+    }
+    return cache;
+}
+
+void
+binder_oper_cache_free(
+    BinderOperCache* cache)
+{
+    if (cache) {
+        binder_oper_cache_save(cache);
+        if (cache->save_id) {
+            g_source_remove(cache->save_id);
+        }
+        g_hash_table_destroy(cache->names);
+        g_free(cache->file);
+        g_free(cache);
+    }
+}
+
+gboolean
+binder_oper_cache_get(
+    BinderOperCache* cache,
+    const char* mcc,
+    const char* mnc,
+    const char** name)
+{
+    char* key = cache ? binder_oper_cache_key(mcc, mnc) : NULL;
+
+    if (key) {
+        const char* value;
+
+        binder_oper_cache_check_age(cache);
+        value = g_hash_table_lookup(cache->names, key);
+        g_free(key);
+        if (value) {
+            if (name) {
+                *name = value[0] ? value : NULL;
+            }
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+void
+binder_oper_cache_put(
+    BinderOperCache* cache,
+    const char* mcc,
+    const char* mnc,
+    const char* name)
+{
+    char* key = cache ? binder_oper_cache_key(mcc, mnc) : NULL;
+
+    if (key) {
+        const char* value = name ? name : "";
+
+        binder_oper_cache_check_age(cache);
+        if (g_strcmp0(g_hash_table_lookup(cache->names, key), value)) {
+            g_hash_table_insert(cache->names, key, g_strdup(value));
+            if (cache->file) {
+                /* Coalesce the writes, names come in batches */
+                cache->dirty = TRUE;
+                if (!cache->save_id) {
+                    cache->save_id = g_idle_add(binder_oper_cache_save_cb,
+                        cache);
+                }
+            }
+        } else {
+            g_free(key);
+        }
+    }
+}
+
+void
+binder_oper_cache_save(
+    BinderOperCache* cache)
+{
+    if (cache && cache->dirty && cache->file) {
+        GKeyFile* kf = g_key_file_new();
+        char* dir = g_path_get_dirname(cache->file);
+        GHashTableIter it;
+        gpointer key, value;
+        GError* error = NULL;
+
+        cache->dirty = FALSE;
+        g_key_file_set_int64(kf, OPER_CACHE_GROUP_INFO,
+            OPER_CACHE_KEY_CREATED, cache->created);
+        g_hash_table_iter_init(&it, cache->names);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            g_key_file_set_string(kf, OPER_CACHE_GROUP_NAMES, key, value);
+        }
+
+        if (g_mkdir_with_parents(dir, 0700) < 0) {
+            GWARN("Failed to create %s: %s", dir, strerror(errno));
+        } else if (!g_key_file_save_to_file(kf, cache->file, &error)) {
+            GWARN("Failed to save %s: %s", cache->file, error->message);
+            g_error_free(error);
+        } else {
+            GDEBUG("Saved %u operator names to %s",
+                g_hash_table_size(cache->names), cache->file);
+        }
+        g_key_file_unref(kf);
+        g_free(dir);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
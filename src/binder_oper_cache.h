@@ -0,0 +1,70 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_OPER_CACHE_H
+#define BINDER_OPER_CACHE_H
+
+#include "binder_types.h"
+
+/*
+ * MCC/MNC => operator name cache, remembers what the provisioning
+ * database has to say about a particular network (including the fact
+ * that it has nothing to say). Optionally backed by a file. The whole
+ * cache (both the file and what's in memory) is discarded when it gets
+ * older than max_age seconds, so that updates of the provisioning
+ * database eventually get picked up.
+ */
+
+BinderOperCache*
+binder_oper_cache_new(
+    const char* file,
+    guint max_age)
+    BINDER_INTERNAL;
+
+void
+binder_oper_cache_free(
+    BinderOperCache* cache)
+    BINDER_INTERNAL;
+
+gboolean
+binder_oper_cache_get(
+    BinderOperCache* cache,
+    const char* mcc,
+    const char* mnc,
+    const char** name)
+    BINDER_INTERNAL;
+
+void
+binder_oper_cache_put(
+    BinderOperCache* cache,
+    const char* mcc,
+    const char* mnc,
+    const char* name)
+    BINDER_INTERNAL;
+
+void
+binder_oper_cache_save(
+    BinderOperCache* cache)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_OPER_CACHE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -17,6 +17,8 @@
 
 #include <ofono/netreg.h>
 
+#include <string.h>
+
 BinderOpList*
 binder_oplist_new()
 {
@@ -48,6 +50,49 @@ binder_oplist_append(
     return oplist;
 }
 
+guint
+binder_oplist_merge(
+    BinderOpList* oplist,
+    guint first)
+{
+    guint i, n = first;
+
+    if (!oplist || oplist->count <= first) {
+        return 0;
+    }
+
+    for (i = first; i < oplist->count; i++) {
+        const struct ofono_network_operator* op = oplist->op + i;
+        struct ofono_network_operator* known = NULL;
+        guint j;
+
+        for (j = 0; j < n && !known; j++) {
+            struct ofono_network_operator* prev = oplist->op + j;
+
+            if (prev->tech == op->tech && !strcmp(prev->mcc, op->mcc) &&
+                !strcmp(prev->mnc, op->mnc)) {
+                known = prev;
+            }
+        }
+
+        if (known) {
+            if (op->status == OFONO_OPERATOR_STATUS_CURRENT) {
+                known->status = OFONO_OPERATOR_STATUS_CURRENT;
+            }
+            if (!known->name[0]) {
+                memcpy(known->name, op->name, sizeof(known->name));
+            }
+        } else {
+            if (n < i) {
+                oplist->op[n] = *op;
+            }
+            n++;
+        }
+    }
+    binder_oplist_set_count(oplist, n);
+    return n - first;
+}
+
 void
 binder_oplist_free(
     BinderOpList* oplist)
@@ -44,6 +44,17 @@ binder_oplist_append(
     const struct ofono_network_operator* op)
     BINDER_INTERNAL;
 
+/*
+ * Each cell is reported separately, so the same operator usually shows
+ * up more than once. Drops the entries starting at index first which
+ * duplicate an earlier one, and returns how many of them are left.
+ */
+guint
+binder_oplist_merge(
+    BinderOpList* oplist,
+    guint first)
+    BINDER_INTERNAL;
+
 void
 binder_oplist_free(
     BinderOpList* oplist)
@@ -25,6 +25,7 @@
 #include "binder_gprs.h"
 #include "binder_gprs_context.h"
 #include "binder_ims.h"
+#include "binder_latency.h"
 #include "binder_log.h"
 #include "binder_logger.h"
 #include "binder_modem.h"
@@ -33,6 +34,7 @@
 #include "binder_radio.h"
 #include "binder_radio_caps.h"
 #include "binder_radio_settings.h"
+#include "binder_record.h"
 #include "binder_sim.h"
 #include "binder_sim_card.h"
 #include "binder_sim_settings.h"
@@ -71,12 +73,14 @@
 #include <gutil_strv.h>
 
 #include <gio/gio.h>
+#include <glib-unix.h>
 
 #include <linux/capability.h>
 #include <sys/types.h>
 #include <sys/syscall.h>
 #include <sys/prctl.h>
 #include <sys/stat.h>
+#include <signal.h>
 #include <unistd.h>
 #include <errno.h>
 #include <pwd.h>
@@ -121,6 +125,11 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_CONF_PLUGIN_EXPECT_SLOTS       "ExpectSlots"
 #define BINDER_CONF_PLUGIN_IGNORE_SLOTS       "IgnoreSlots"
 #define BINDER_CONF_PLUGIN_INTERFACE_TYPE     "InterfaceType"
+#define BINDER_CONF_PLUGIN_RECORD_BUFFER_SIZE "RecordBufferSize"
+#define BINDER_CONF_PLUGIN_RECORD_DATA_SIZE   "RecordDataSize"
+#define BINDER_CONF_PLUGIN_RECORD_FILE        "RecordFile"
+#define BINDER_CONF_PLUGIN_LATENCY_INTERVAL   "LatencyReportInterval"
+#define BINDER_CONF_PLUGIN_OPER_NAME_CACHE    "OperatorNameCache"
 
 /* Slot specific */
 #define BINDER_CONF_SLOT_PATH                 "path"
@@ -139,16 +148,28 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_CONF_SLOT_USE_NETWORK_SCAN     "useNetworkScan"
 #define BINDER_CONF_SLOT_REPLACE_STRANGE_OPER "replaceStrangeOperatorNames"
 #define BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE "signalStrengthRange"
+#define BINDER_CONF_SLOT_RSCP_RANGE           "rscpRange"
+#define BINDER_CONF_SLOT_RSRP_RANGE           "rsrpRange"
+#define BINDER_CONF_SLOT_SSRSRP_RANGE         "ssRsrpRange"
+#define BINDER_CONF_SLOT_CELL_INFO_INTERVAL_RANGE "cellInfoIntervalRange"
+#define BINDER_CONF_SLOT_DTMF_BURST           "dtmfBurst"
 #define BINDER_CONF_SLOT_LTE_MODE             "lteNetworkMode"
 #define BINDER_CONF_SLOT_UMTS_MODE            "umtsNetworkMode"
 #define BINDER_CONF_SLOT_TECHNOLOGIES         "technologies"
+#define BINDER_CONF_SLOT_SIM_IO_WINDOW        "simIoWindow"
+#define BINDER_CONF_SLOT_SIM_FILE_CACHE       "simFileCache"
+#define BINDER_CONF_SLOT_DATA_CALL_SETUP_CONCURRENCY "dataCallSetupConcurrency"
 
 /* Defaults */
 #define BINDER_DEFAULT_RADIO_INTERFACE        RADIO_INTERFACE_1_2
 #define BINDER_DEFAULT_INTERFACE_TYPE         RADIO_INTERFACE_TYPE_HIDL
 #define BINDER_DEFAULT_PLUGIN_DEVICE          GBINDER_DEFAULT_HWBINDER
 #define BINDER_DEFAULT_PLUGIN_IDENTITY        "radio:radio"
+#define BINDER_DEFAULT_PLUGIN_RECORD_DATA_SIZE 256
+#define BINDER_DEFAULT_PLUGIN_RECORD_FILE     "ofono-binder.rec"
+#define BINDER_DEFAULT_PLUGIN_LATENCY_TIMEOUT_MS (60*1000) /* 60 sec */
 #define BINDER_DEFAULT_PLUGIN_DM_FLAGS        BINDER_DATA_MANAGER_3GLTE_HANDOVER
+#define BINDER_DEFAULT_PLUGIN_OPER_NAME_CACHE TRUE
 #define BINDER_DEFAULT_MAX_NON_DATA_MODE      OFONO_RADIO_ACCESS_MODE_UMTS
 #define BINDER_DEFAULT_SLOT_PATH_PREFIX       "ril"
 #define BINDER_DEFAULT_SLOT_TECHS             OFONO_RADIO_ACCESS_MODE_ALL
@@ -158,6 +179,12 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_DEFAULT_SLOT_NETWORK_SELECTION_TIMEOUT_MS (100*1000) /* ms */
 #define BINDER_DEFAULT_SLOT_DBM_WEAK          (-100) /* 0.0000000001 mW */
 #define BINDER_DEFAULT_SLOT_DBM_STRONG        (-60)  /* 0.000001 mW */
+#define BINDER_DEFAULT_SLOT_RSCP_DBM_WEAK     (-120)
+#define BINDER_DEFAULT_SLOT_RSCP_DBM_STRONG   (-24)
+#define BINDER_DEFAULT_SLOT_RSRP_DBM_WEAK     (-140)
+#define BINDER_DEFAULT_SLOT_RSRP_DBM_STRONG   (-44)
+#define BINDER_DEFAULT_SLOT_SSRSRP_DBM_WEAK   (-140)
+#define BINDER_DEFAULT_SLOT_SSRSRP_DBM_STRONG (-44)
 #define BINDER_DEFAULT_SLOT_FEATURES          BINDER_FEATURE_ALL
 #define BINDER_DEFAULT_SLOT_EMPTY_PIN_QUERY   TRUE
 #define BINDER_DEFAULT_SLOT_RADIO_POWER_CYCLE FALSE
@@ -177,6 +204,12 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_DEFAULT_SLOT_ALLOW_DATA        BINDER_ALLOW_DATA_ENABLED
 #define BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_LIMIT 4
 #define BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_DELAY_MS 200 /* ms */
+#define BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_MAX_DELAY_MS (30*1000) /* ms */
+#define BINDER_DEFAULT_SLOT_SIM_IO_WINDOW     1 /* Fully serialized */
+#define BINDER_MAX_SLOT_SIM_IO_WINDOW         8
+#define BINDER_DEFAULT_SLOT_SIM_FILE_CACHE    TRUE
+#define BINDER_DEFAULT_SLOT_DATA_CALL_SETUP_CONCURRENCY 1 /* Serialized */
+#define BINDER_MAX_SLOT_DATA_CALL_SETUP_CONCURRENCY 4
 
 /* The overall start timeout is the longest slot timeout plus this */
 #define BINDER_SLOT_REGISTRATION_TIMEOUT_MS         (10*1000) /* 10 sec */
@@ -238,6 +271,11 @@ typedef struct binder_plugin_settings {
     BinderPluginIdentity identity;
     enum ofono_radio_access_mode non_data_mode;
     RADIO_INTERFACE_TYPE interface_type;
+    int record_buffer_size;
+    int record_data_size;
+    char* record_file;
+    int latency_interval;
+    gboolean oper_name_cache;
 } BinderPluginSettings;
 
 typedef struct ofono_slot_driver_data {
@@ -248,6 +286,8 @@ typedef struct ofono_slot_driver_data {
     RadioConfig* radio_config;
     BinderLogger* radio_config_trace;
     BinderLogger* radio_config_dump;
+    BinderRecordRing* record;
+    BinderLatency* latency;
     BinderDataManager* data_manager;
     BinderRadioCapsManager* caps_manager;
     BinderPluginSettings settings;
@@ -255,6 +295,8 @@ typedef struct ofono_slot_driver_data {
     gulong radio_config_watch_id;
     gulong list_call_id;
     guint start_timeout_id;
+    guint record_signal_id;
+    guint latency_timer_id;
     char* dev;
     GSList* slots;
 } BinderPlugin;
@@ -272,6 +314,8 @@ typedef struct binder_slot {
     BinderPlugin* plugin;
     BinderLogger* log_trace[RADIO_AIDL_INTERFACE_COUNT];
     BinderLogger* log_dump[RADIO_AIDL_INTERFACE_COUNT];
+    BinderLogger* log_record[RADIO_AIDL_INTERFACE_COUNT];
+    BinderLogger* log_latency[RADIO_AIDL_INTERFACE_COUNT];
     BinderData* data;
     BinderDevmon* devmon;
     BinderDevmonIo* devmon_io;
@@ -503,6 +547,63 @@ binder_logger_trace_update_slot(
     }
 }
 
+static
+void
+binder_plugin_slot_start_loggers(
+    BinderSlot* slot)
+{
+    RADIO_AIDL_INTERFACE i;
+
+    for (i = 0; i < RADIO_AIDL_INTERFACE_COUNT; i++) {
+        if (slot->instance[i]) {
+            const RADIO_AIDL_INTERFACE iface = (slot->interface_type ==
+                RADIO_INTERFACE_TYPE_AIDL) ? i : RADIO_AIDL_INTERFACE_NONE;
+
+            if (!slot->log_record[i]) {
+                slot->log_record[i] = binder_logger_new_radio_record(
+                    slot->instance[i], slot->name, slot->config.slot,
+                    slot->version, iface, slot->plugin->record);
+            }
+            if (!slot->log_latency[i]) {
+                slot->log_latency[i] = binder_logger_new_radio_latency(
+                    slot->instance[i], slot->config.slot, iface,
+                    slot->plugin->latency);
+            }
+        }
+    }
+}
+
+static
+gboolean
+binder_plugin_latency_report(
+    gpointer user_data)
+{
+    BinderPlugin* plugin = user_data;
+    char* summary = binder_latency_summary(plugin->latency);
+
+    ofono_info("RIL latency: %s", summary);
+    g_free(summary);
+    return G_SOURCE_CONTINUE;
+}
+
+static
+gboolean
+binder_plugin_record_save(
+    gpointer user_data)
+{
+    BinderPlugin* plugin = user_data;
+    const char* file = plugin->settings.record_file;
+    GError* error = NULL;
+
+    if (binder_record_ring_save(plugin->record, file, &error)) {
+        ofono_info("Saved RIL capture to %s", file);
+    } else {
+        ofono_error("Failed to save RIL capture: %s", error->message);
+        g_error_free(error);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
 static
 void
 binder_plugin_check_if_started(
@@ -619,8 +720,12 @@ binder_plugin_slot_shutdown(
 
                 binder_logger_free(slot->log_trace[i]);
                 binder_logger_free(slot->log_dump[i]);
+                binder_logger_free(slot->log_record[i]);
+                binder_logger_free(slot->log_latency[i]);
                 slot->log_trace[i] = NULL;
                 slot->log_dump[i] = NULL;
+                slot->log_record[i] = NULL;
+                slot->log_latency[i] = NULL;
 
                 radio_client_remove_all_handlers(slot->client[i],
                     slot->client_event_id);
@@ -1151,8 +1256,8 @@ binder_plugin_slot_connected(
 
     GASSERT(!slot->cell_info);
     slot->cell_info = binder_cell_info_new(slot->instance[network_interface],
-        slot->client[network_interface],
-        slot->name, slot->radio, slot->sim_card);
+        slot->client[network_interface], slot->name, slot->radio,
+        slot->network, slot->sim_card, &slot->config);
 
     GASSERT(!slot->caps);
     GASSERT(!slot->caps_check_req);
@@ -1386,6 +1491,7 @@ binder_plugin_connect_to_interface(
 
         binder_logger_dump_update_slot(slot);
         binder_logger_trace_update_slot(slot);
+        binder_plugin_slot_start_loggers(slot);
 
         if (aidl_interface == modem_interface) {
             slot->client_event_id[CLIENT_EVENT_DEATH] =
@@ -1491,6 +1597,30 @@ binder_plugin_config_get_ints(
     return NULL;
 }
 
+static
+void
+binder_plugin_config_get_dbm_range(
+    GKeyFile* file,
+    const char* group,
+    const char* key,
+    int* weak,
+    int* strong)
+{
+    GUtilInts* ints = binder_plugin_config_get_ints(file, group, key);
+
+    if (gutil_ints_get_count(ints) == 2) {
+        const int* dbms = gutil_ints_get_data(ints, NULL);
+
+        /* MIN,MAX */
+        if (dbms[0] < dbms[1]) {
+            DBG("%s: %s [%d,%d]", group, key, dbms[0], dbms[1]);
+            *weak = dbms[0];
+            *strong = dbms[1];
+        }
+    }
+    gutil_ints_unref(ints);
+}
+
 static
 const char*
 binder_plugin_radio_interface_name(
@@ -1624,7 +1754,15 @@ binder_plugin_create_slot(
         BINDER_DEFAULT_SLOT_NETWORK_SELECTION_TIMEOUT_MS;
     config->signal_strength_dbm_weak = BINDER_DEFAULT_SLOT_DBM_WEAK;
     config->signal_strength_dbm_strong = BINDER_DEFAULT_SLOT_DBM_STRONG;
+    config->rscp_dbm_weak = BINDER_DEFAULT_SLOT_RSCP_DBM_WEAK;
+    config->rscp_dbm_strong = BINDER_DEFAULT_SLOT_RSCP_DBM_STRONG;
+    config->rsrp_dbm_weak = BINDER_DEFAULT_SLOT_RSRP_DBM_WEAK;
+    config->rsrp_dbm_strong = BINDER_DEFAULT_SLOT_RSRP_DBM_STRONG;
+    config->ssrsrp_dbm_weak = BINDER_DEFAULT_SLOT_SSRSRP_DBM_WEAK;
+    config->ssrsrp_dbm_strong = BINDER_DEFAULT_SLOT_SSRSRP_DBM_STRONG;
     config->empty_pin_query = BINDER_DEFAULT_SLOT_EMPTY_PIN_QUERY;
+    config->sim_io_window = BINDER_DEFAULT_SLOT_SIM_IO_WINDOW;
+    config->sim_file_cache = BINDER_DEFAULT_SLOT_SIM_FILE_CACHE;
     config->radio_power_cycle = BINDER_DEFAULT_SLOT_RADIO_POWER_CYCLE;
     config->confirm_radio_power_on = BINDER_DEFAULT_SLOT_CONFIRM_RADIO_POWER_ON;
     config->features = BINDER_DEFAULT_SLOT_FEATURES;
@@ -1654,6 +1792,10 @@ binder_plugin_create_slot(
         BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_LIMIT;
     data_opt->data_call_retry_delay_ms =
         BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_DELAY_MS;
+    data_opt->data_call_retry_max_delay_ms =
+        BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_MAX_DELAY_MS;
+    data_opt->data_call_setup_concurrency =
+        BINDER_DEFAULT_SLOT_DATA_CALL_SETUP_CONCURRENCY;
 
     /* slot */
     ival = g_key_file_get_integer(file, group,
@@ -1765,6 +1907,22 @@ binder_plugin_create_slot(
             config->empty_pin_query ? "yes" : "no");
     }
 
+    /* simIoWindow */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SIM_IO_WINDOW, &ival)) {
+        config->sim_io_window = MAX(MIN(ival,
+            BINDER_MAX_SLOT_SIM_IO_WINDOW), 1);
+        DBG("%s: " BINDER_CONF_SLOT_SIM_IO_WINDOW " %u", group,
+            config->sim_io_window);
+    }
+
+    /* simFileCache */
+    if (ofono_conf_get_boolean(file, group,
+        BINDER_CONF_SLOT_SIM_FILE_CACHE, &config->sim_file_cache)) {
+        DBG("%s: " BINDER_CONF_SLOT_SIM_FILE_CACHE " %s", group,
+            config->sim_file_cache ? "yes" : "no");
+    }
+
     /* useDataProfiles */
     if (ofono_conf_get_boolean(file, group,
         BINDER_CONF_SLOT_USE_DATA_PROFILES, &dpc->use_data_profiles)) {
@@ -1796,6 +1954,15 @@ binder_plugin_create_slot(
         slot->data_opt.allow_data = ival;
     }
 
+    /* dataCallSetupConcurrency */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_DATA_CALL_SETUP_CONCURRENCY, &ival)) {
+        slot->data_opt.data_call_setup_concurrency = MAX(MIN(ival,
+            BINDER_MAX_SLOT_DATA_CALL_SETUP_CONCURRENCY), 1);
+        DBG("%s: " BINDER_CONF_SLOT_DATA_CALL_SETUP_CONCURRENCY " %u", group,
+            slot->data_opt.data_call_setup_concurrency);
+    }
+
     /* technologies */
     strv = ofono_conf_get_strings(file, group, BINDER_CONF_SLOT_TECHNOLOGIES, ',');
     if (strv) {
@@ -1868,17 +2035,54 @@ binder_plugin_create_slot(
     }
 
     /* signalStrengthRange */
+    binder_plugin_config_get_dbm_range(file, group,
+        BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE,
+        &config->signal_strength_dbm_weak,
+        &config->signal_strength_dbm_strong);
+
+    /* rscpRange */
+    binder_plugin_config_get_dbm_range(file, group,
+        BINDER_CONF_SLOT_RSCP_RANGE,
+        &config->rscp_dbm_weak, &config->rscp_dbm_strong);
+
+    /* rsrpRange */
+    binder_plugin_config_get_dbm_range(file, group,
+        BINDER_CONF_SLOT_RSRP_RANGE,
+        &config->rsrp_dbm_weak, &config->rsrp_dbm_strong);
+
+    /* ssRsrpRange */
+    binder_plugin_config_get_dbm_range(file, group,
+        BINDER_CONF_SLOT_SSRSRP_RANGE,
+        &config->ssrsrp_dbm_weak, &config->ssrsrp_dbm_strong);
+
+    /* cellInfoIntervalRange */
     ints = binder_plugin_config_get_ints(file, group,
-        BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE);
+        BINDER_CONF_SLOT_CELL_INFO_INTERVAL_RANGE);
     if (gutil_ints_get_count(ints) == 2) {
-        const int* dbms = gutil_ints_get_data(ints, NULL);
+        const int* ms = gutil_ints_get_data(ints, NULL);
 
         /* MIN,MAX */
-        if (dbms[0] < dbms[1]) {
-            DBG("%s: " BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE " [%d,%d]",
-                group, dbms[0], dbms[1]);
-            config->signal_strength_dbm_weak = dbms[0];
-            config->signal_strength_dbm_strong = dbms[1];
+        if (ms[0] >= 0 && ms[0] < ms[1]) {
+            DBG("%s: " BINDER_CONF_SLOT_CELL_INFO_INTERVAL_RANGE " [%d,%d]",
+                group, ms[0], ms[1]);
+            config->cell_info_interval_min_ms = ms[0];
+            config->cell_info_interval_max_ms = ms[1];
+        }
+    }
+    gutil_ints_unref(ints);
+
+    /* dtmfBurst */
+    ints = binder_plugin_config_get_ints(file, group,
+        BINDER_CONF_SLOT_DTMF_BURST);
+    if (gutil_ints_get_count(ints) == 2) {
+        const int* ms = gutil_ints_get_data(ints, NULL);
+
+        /* TONE,PAUSE */
+        if (ms[0] > 0 && ms[1] >= 0) {
+            DBG("%s: " BINDER_CONF_SLOT_DTMF_BURST " [%d,%d]", group,
+                ms[0], ms[1]);
+            config->dtmf_tone_ms = ms[0];
+            config->dtmf_pause_ms = ms[1];
         }
     }
     gutil_ints_unref(ints);
@@ -2157,6 +2361,43 @@ binder_plugin_parse_config_file(
         ps->interface_type = ival;
     }
 
+    /* LatencyReportInterval */
+    if (ofono_conf_get_integer(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_LATENCY_INTERVAL, &ival) && ival >= 0) {
+        DBG(BINDER_CONF_PLUGIN_LATENCY_INTERVAL " %d", ival);
+        ps->latency_interval = ival;
+    }
+
+    /* OperatorNameCache */
+    if (ofono_conf_get_boolean(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_OPER_NAME_CACHE, &ps->oper_name_cache)) {
+        DBG(BINDER_CONF_PLUGIN_OPER_NAME_CACHE " %s",
+            ps->oper_name_cache ? "yes" : "no");
+    }
+
+    /* RecordBufferSize */
+    if (ofono_conf_get_integer(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_RECORD_BUFFER_SIZE, &ival) && ival >= 0) {
+        DBG(BINDER_CONF_PLUGIN_RECORD_BUFFER_SIZE " %d", ival);
+        ps->record_buffer_size = ival;
+    }
+
+    /* RecordDataSize */
+    if (ofono_conf_get_integer(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_RECORD_DATA_SIZE, &ival) && ival >= 0) {
+        DBG(BINDER_CONF_PLUGIN_RECORD_DATA_SIZE " %d", ival);
+        ps->record_data_size = ival;
+    }
+
+    /* RecordFile */
+    sval = g_key_file_get_string(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_RECORD_FILE, NULL);
+    if (sval) {
+        DBG(BINDER_CONF_PLUGIN_RECORD_FILE " %s", sval);
+        g_free(ps->record_file);
+        ps->record_file = sval;
+    }
+
     /*
      * The way to stop the plugin from even trying to find any slots is
      * the IgnoreSlots entry containining '*' pattern in combination with
@@ -2496,6 +2737,10 @@ binder_plugin_slot_driver_init(
     ps->dm_flags = BINDER_DEFAULT_PLUGIN_DM_FLAGS;
     ps->non_data_mode = BINDER_DEFAULT_MAX_NON_DATA_MODE;
     ps->interface_type = BINDER_DEFAULT_INTERFACE_TYPE;
+    ps->record_data_size = BINDER_DEFAULT_PLUGIN_RECORD_DATA_SIZE;
+    ps->oper_name_cache = BINDER_DEFAULT_PLUGIN_OPER_NAME_CACHE;
+    ps->record_file = g_build_filename(ofono_storage_dir(),
+        BINDER_DEFAULT_PLUGIN_RECORD_FILE, NULL);
 
     /* Connect to system bus before we switch the identity */
     plugin->system_bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
@@ -2507,6 +2752,24 @@ binder_plugin_slot_driver_init(
     /* This populates plugin->slots */
     binder_plugin_load_config(plugin, config_file);
 
+    /* Binary recorder, saved to RecordFile on SIGUSR2 */
+    plugin->record = binder_record_ring_new(ps->record_buffer_size,
+        ps->record_data_size);
+    if (plugin->record) {
+        DBG("recording up to %d bytes of RIL traffic", ps->record_buffer_size);
+        plugin->record_signal_id = g_unix_signal_add(SIGUSR2,
+            binder_plugin_record_save, plugin);
+    }
+
+    /* Latency statistics, reported periodically and over D-Bus */
+    if (ps->latency_interval > 0) {
+        plugin->latency =
+            binder_latency_new(BINDER_DEFAULT_PLUGIN_LATENCY_TIMEOUT_MS);
+        binder_latency_dbus_register(plugin->latency);
+        plugin->latency_timer_id = g_timeout_add_seconds(ps->latency_interval,
+            binder_plugin_latency_report, plugin);
+    }
+
     /*
      * Finish slot initialization. Some of them may not have path and
      * slot index set up yet.
@@ -2559,6 +2822,7 @@ binder_plugin_slot_driver_init(
 
         slot->plugin = plugin;
         slot->interface_type = plugin->settings.interface_type;
+        slot->config.oper_name_cache = plugin->settings.oper_name_cache;
         slot->watch = ofono_watch_new(slot->path);
         slot->watch_event_id[WATCH_EVENT_MODEM] =
             ofono_watch_add_modem_changed_handler(slot->watch,
@@ -2685,6 +2949,15 @@ binder_plugin_slot_driver_cleanup(
         binder_radio_caps_manager_remove_handler(plugin->caps_manager,
             plugin->caps_manager_event_id);
         binder_radio_caps_manager_unref(plugin->caps_manager);
+        if (plugin->record_signal_id) {
+            g_source_remove(plugin->record_signal_id);
+        }
+        binder_record_ring_free(plugin->record);
+        if (plugin->latency_timer_id) {
+            g_source_remove(plugin->latency_timer_id);
+        }
+        binder_latency_free(plugin->latency);
+        g_free(plugin->settings.record_file);
         g_free(plugin);
     }
 }
@@ -14,6 +14,7 @@
  */
 
 #include "binder_log.h"
+#include "binder_assign.h"
 #include "binder_data.h"
 #include "binder_radio_caps.h"
 #include "binder_radio.h"
@@ -111,7 +112,6 @@ typedef struct binder_radio_caps_manager {
     GObject object;
     GUtilIdlePool* idle_pool;
     GPtrArray* caps_list;
-    GPtrArray* order_list;
     GPtrArray* requests;
     guint check_id;
     int tx_id;
@@ -258,52 +258,6 @@ binder_radio_caps_manager_remove(
     BinderRadioCapsManager* mgr,
     BinderRadioCapsObject* caps);
 
-static
-void
-binder_radio_caps_permutate(
-    GPtrArray* list,
-    const guint* sample,
-    guint off,
-    guint n)
-{
-    if (off < n) {
-        guint i;
-
-        binder_radio_caps_permutate(list, sample, off + 1, n);
-        for (i = off + 1; i < n; i++) {
-            guint* resample = gutil_memdup(sample, sizeof(guint) * n);
-
-            resample[off] = sample[i];
-            resample[i] = sample[off];
-            g_ptr_array_add(list, resample);
-            binder_radio_caps_permutate(list, resample, off + 1, n);
-        }
-    }
-}
-
-static
-void
-binder_radio_caps_generate_permutations(
-    GPtrArray* list,
-    guint n)
-{
-    g_ptr_array_set_size(list, 0);
-
-    if (n > 0) {
-        guint i;
-        guint* order = g_new(guint, n);
-
-        /*
-         * In a general case this gives n! of permutations (1, 2,
-         * 6, 24, ...) but typically no more than 2
-         */
-        for (i = 0; i < n; i++) order[i] = i;
-        g_ptr_array_set_free_func(list, g_free);
-        g_ptr_array_add(list, order);
-        binder_radio_caps_permutate(list, order, 0, n);
-    }
-}
-
 static
 RadioCapability*
 binder_radio_caps_dup(
@@ -936,9 +890,10 @@ binder_radio_caps_manager_order_str(
         char* str;
         GString* buf = g_string_sized_new(2*n + 2 /* roughly */);
 
-        g_string_append_printf(buf, "(%u", order[0]);
+        /* NULL order is the current one i.e. (0,1,...) */
+        g_string_append_printf(buf, "(%u", order ? order[0] : 0);
         for (i = 1; i < n; i++) {
-            g_string_append_printf(buf, ",%u", order[i]);
+            g_string_append_printf(buf, ",%u", order ? order[i] : i);
         }
         g_string_append_c(buf, ')');
         str = g_string_free(buf, FALSE);
@@ -1710,9 +1665,7 @@ binder_radio_caps_manager_set_order(
     const GPtrArray* list = self->caps_list;
     guint i;
 
-    DBG("%s => %s",
-        binder_radio_caps_manager_order_str(self, self->order_list->pdata[0]),
-        binder_radio_caps_manager_order_str(self, order));
+    DBG("=> %s", binder_radio_caps_manager_order_str(self, order));
 
     for (i = 0; i < list->len; i++) {
         BinderRadioCapsObject* dest = list->pdata[i];
@@ -1731,36 +1684,49 @@ void
 binder_radio_caps_manager_check(
     BinderRadioCapsManager *self)
 {
-    if (binder_radio_caps_manager_can_check(self)) {
-        guint i;
-        const GPtrArray* list = self->caps_list;
-        const GPtrArray* permutations = self->order_list;
-        int highest_score = -INT_MAX, best_index = -1;
+    const GPtrArray* list = self->caps_list;
+    const guint n = list->len;
 
-        for (i = 0; i < permutations->len; i++) {
-            const guint* order = permutations->pdata[i];
-            int score = 0;
-            guint k;
+    if (n > 0 && binder_radio_caps_manager_can_check(self)) {
+        int* score = g_new(int, n * n);
+        guint* order = g_new(guint, n);
+        int current_score = 0, best_score;
+        gboolean same = TRUE;
+        guint i, k;
 
-            for (k = 0; k < list->len; k++) {
-                const BinderRadioCapsObject *c1 = list->pdata[k];
-                const BinderRadioCapsObject *c2 = list->pdata[order[k]];
+        /* score[i][k] is how well slot i would do with the caps of slot k */
+        for (i = 0; i < n; i++) {
+            const BinderRadioCapsObject* c1 = list->pdata[i];
 
-                score += binder_radio_caps_score(c1, c2->cap);
-            }
+            for (k = 0; k < n; k++) {
+                const BinderRadioCapsObject* c2 = list->pdata[k];
 
-            DBG("%s %d", binder_radio_caps_manager_order_str(self, order),
-                score);
-            if (score > highest_score) {
-                highest_score = score;
-                best_index = i;
+                score[i * n + k] = binder_radio_caps_score(c1, c2->cap);
             }
+            current_score += score[i * n + i];
+        }
+
+        best_score = binder_assign_best(score, n, order);
+        for (i = 0; i < n && same; i++) {
+            same = (order[i] == i);
         }
 
-        if (best_index > 0) {
-            binder_radio_caps_manager_set_order(self,
-                permutations->pdata[best_index]);
+        DBG("%s %d => %s %d", binder_radio_caps_manager_order_str(self, NULL),
+            current_score, binder_radio_caps_manager_order_str(self, order),
+            best_score);
+
+        /*
+         * The current order is only abandoned for a strictly better
+         * one. Among equally good alternatives, binder_assign_best()
+         * prefers the one moving fewer slots. That's not what the old
+         * exhaustive search did, it took whichever permutation came
+         * first in its table.
+         */
+        if (!same && best_score > current_score) {
+            binder_radio_caps_manager_set_order(self, order);
         }
+        g_free(score);
+        g_free(order);
     }
 }
 
@@ -1871,10 +1837,6 @@ binder_radio_caps_manager_list_changed(
 {
     /* Order list elements according to slot numbers */
     g_ptr_array_sort(self->caps_list, binder_radio_caps_slot_compare);
-
-    /* Generate full list of available permutations */
-    binder_radio_caps_generate_permutations(self->order_list,
-        self->caps_list->len);
 }
 
 static
@@ -1971,7 +1933,6 @@ binder_radio_caps_manager_init(
     BinderRadioCapsManager* self)
 {
     self->caps_list = g_ptr_array_new();
-    self->order_list = g_ptr_array_new();
     self->requests = g_ptr_array_new();
     self->tx_phase_index = -1;
     self->idle_pool = gutil_idle_pool_ref
@@ -1986,10 +1947,8 @@ binder_radio_caps_manager_finalize(
     BinderRadioCapsManager* self = RADIO_CAPS_MANAGER(object);
 
     GASSERT(!self->caps_list->len);
-    GASSERT(!self->order_list->len);
     GASSERT(!self->requests->len);
     g_ptr_array_free(self->caps_list, TRUE);
-    g_ptr_array_free(self->order_list, TRUE);
     g_ptr_array_free(self->requests, TRUE);
     if (self->check_id) {
         g_source_remove(self->check_id);
@@ -0,0 +1,300 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2021-2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_record.h"
+
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * The ring is only touched from the main thread, so there's no locking.
+ * Records are appended at the tail, the oldest ones get evicted to make
+ * room for the new ones. The size of the buffer is a multiple of 8 and
+ * so is the size of each record, meaning that a record header may wrap
+ * around the end of the buffer but its size field never does.
+ */
+struct binder_record_ring {
+    guint8* buf;
+    gsize size;
+    gsize max_data_size;
+    gsize head;
+    gsize used;
+    GSList* instances;
+};
+
+struct binder_record_instance {
+    BinderRecordHeader rec;
+    char* name;
+};
+
+static const guint8 binder_record_pad[8];
+
+static
+gsize
+binder_record_ring_copy_in(
+    BinderRecordRing* ring,
+    gsize offset,
+    const void* data,
+    gsize len)
+{
+    const gsize n = MIN(len, ring->size - offset);
+
+    memcpy(ring->buf + offset, data, n);
+    if (n < len) {
+        memcpy(ring->buf, (const guint8*)data + n, len - n);
+    }
+    return (offset + len) % ring->size;
+}
+
+static
+gboolean
+binder_record_write(
+    int fd,
+    const guint8* data,
+    gsize size)
+{
+    while (size > 0) {
+        const gssize written = write(fd, data, size);
+
+        if (written > 0) {
+            data += written;
+            size -= written;
+        } else if (written < 0 && errno != EINTR) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static
+void
+binder_record_append(
+    GByteArray* out,
+    const BinderRecordHeader* rec,
+    const void* data)
+{
+    g_byte_array_append(out, (const void*)rec, sizeof(*rec));
+    g_byte_array_append(out, data, rec->saved_size);
+    g_byte_array_append(out, binder_record_pad,
+        rec->size - sizeof(*rec) - rec->saved_size);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderRecordRing*
+binder_record_ring_new(
+    gsize size,
+    gsize max_data_size)
+{
+    /* Round the size down to the record alignment */
+    size &= ~((gsize)7);
+    if (size >= sizeof(BinderRecordHeader)) {
+        BinderRecordRing* ring = g_new0(BinderRecordRing, 1);
+
+        ring->buf = g_malloc(size);
+        ring->size = size;
+        ring->max_data_size = max_data_size;
+        return ring;
+    }
+    return NULL;
+}
+
+void
+binder_record_ring_free(
+    BinderRecordRing* ring)
+{
+    if (ring) {
+        while (ring->instances) {
+            binder_record_ring_remove_instance(ring, ring->instances->data);
+        }
+        g_free(ring->buf);
+        g_free(ring);
+    }
+}
+
+BinderRecordInstance*
+binder_record_ring_add_instance(
+    BinderRecordRing* ring,
+    guint slot,
+    RADIO_INTERFACE version,
+    RADIO_AIDL_INTERFACE iface,
+    const char* name)
+{
+    if (ring) {
+        BinderRecordInstance* instance = g_new0(BinderRecordInstance, 1);
+        BinderRecordHeader* rec = &instance->rec;
+        const gsize len = name ? (strlen(name) + 1) : 0;
+
+        instance->name = g_strdup(name);
+        rec->size = BINDER_RECORD_ALIGN(sizeof(*rec) + len);
+        rec->type = BINDER_RECORD_INSTANCE;
+        rec->slot = slot;
+        rec->iface = iface;
+        rec->time = g_get_real_time();
+        rec->code = version;
+        rec->data_size = rec->saved_size = len;
+        ring->instances = g_slist_append(ring->instances, instance);
+        return instance;
+    }
+    return NULL;
+}
+
+void
+binder_record_ring_remove_instance(
+    BinderRecordRing* ring,
+    BinderRecordInstance* instance)
+{
+    if (ring && instance) {
+        ring->instances = g_slist_remove(ring->instances, instance);
+        g_free(instance->name);
+        g_free(instance);
+    }
+}
+
+void
+binder_record_ring_put(
+    BinderRecordRing* ring,
+    BinderRecordHeader* rec,
+    const void* data,
+    gsize len)
+{
+    gsize saved = MIN(len, ring->max_data_size);
+    gsize total = BINDER_RECORD_ALIGN(sizeof(*rec) + saved);
+    gsize tail;
+
+    if (total > ring->size) {
+        saved = ring->size - sizeof(*rec);
+        total = ring->size;
+    }
+
+    /* Evict the oldest records */
+    while (ring->size - ring->used < total) {
+        const gsize evicted = *(guint32*)(ring->buf + ring->head);
+
+        ring->head = (ring->head + evicted) % ring->size;
+        ring->used -= evicted;
+    }
+
+    rec->size = total;
+    rec->data_size = len;
+    rec->saved_size = saved;
+    if (saved < len) {
+        rec->flags |= BINDER_RECORD_TRUNCATED;
+    }
+
+    tail = (ring->head + ring->used) % ring->size;
+    tail = binder_record_ring_copy_in(ring, tail, rec, sizeof(*rec));
+    tail = binder_record_ring_copy_in(ring, tail, data, saved);
+    binder_record_ring_copy_in(ring, tail, binder_record_pad,
+        total - sizeof(*rec) - saved);
+    ring->used += total;
+}
+
+gsize
+binder_record_ring_used(
+    BinderRecordRing* ring)
+{
+    return ring ? ring->used : 0;
+}
+
+GBytes*
+binder_record_ring_capture(
+    BinderRecordRing* ring)
+{
+    if (ring) {
+        GByteArray* out = g_byte_array_sized_new(ring->used + 256);
+        const gsize first = MIN(ring->used, ring->size - ring->head);
+        BinderRecordFileHeader fh;
+        GSList* l;
+
+        memset(&fh, 0, sizeof(fh));
+        memcpy(fh.magic, BINDER_RECORD_MAGIC, sizeof(fh.magic));
+        fh.version = BINDER_RECORD_VERSION;
+        fh.header_size = sizeof(BinderRecordHeader);
+        fh.time = g_get_real_time();
+        g_byte_array_append(out, (void*)&fh, sizeof(fh));
+
+        for (l = ring->instances; l; l = l->next) {
+            BinderRecordInstance* instance = l->data;
+
+            binder_record_append(out, &instance->rec, instance->name);
+        }
+
+        /* The oldest record is at the head, the data may wrap around */
+        g_byte_array_append(out, ring->buf + ring->head, first);
+        g_byte_array_append(out, ring->buf, ring->used - first);
+        return g_byte_array_free_to_bytes(out);
+    }
+    return NULL;
+}
+
+gboolean
+binder_record_ring_save(
+    BinderRecordRing* ring,
+    const char* path,
+    GError** error)
+{
+    GBytes* capture = binder_record_ring_capture(ring);
+    char* tmp = g_strconcat(path, ".tmp", NULL);
+    gboolean ok = FALSE;
+    int fd;
+
+    /*
+     * Raw parcels may contain PINs, IMSI, phone numbers and messages,
+     * the capture is only readable by the owner. The temporary file
+     * is created from scratch, so that its mode is exactly that.
+     */
+    g_unlink(tmp);
+    fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+        gsize size;
+        const guint8* data = g_bytes_get_data(capture, &size);
+
+        if (binder_record_write(fd, data, size) && !fsync(fd)) {
+            ok = !close(fd) && !g_rename(tmp, path);
+        } else {
+            close(fd);
+        }
+        if (!ok) {
+            const int err = errno;
+
+            g_unlink(tmp);
+            errno = err;
+        }
+    }
+
+    if (!ok) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+            "%s: %s", path, strerror(errno));
+    }
+    g_bytes_unref(capture);
+    g_free(tmp);
+    return ok;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
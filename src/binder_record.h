@@ -0,0 +1,134 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2021-2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_RECORD_H
+#define BINDER_RECORD_H
+
+#include "binder_types.h"
+
+/*
+ * Binary capture format. A capture file starts with BinderRecordFileHeader
+ * followed by a sequence of records, each one starting with a fixed size
+ * BinderRecordHeader followed by saved_size bytes of raw parcel data and
+ * padding up to the 8-byte boundary. Everything is in host byte order.
+ *
+ * A capture starts with BINDER_RECORD_INSTANCE records describing each
+ * recorded RadioInstance (slot, interface and the slot name as data),
+ * followed by the transactions in chronological order.
+ */
+#define BINDER_RECORD_MAGIC "BREC"
+#define BINDER_RECORD_VERSION 1
+#define BINDER_RECORD_ALIGN(size) (((size) + 7) & ~((gsize)7))
+
+typedef enum binder_record_type {
+    BINDER_RECORD_INSTANCE,
+    BINDER_RECORD_REQ,
+    BINDER_RECORD_RESP,
+    BINDER_RECORD_IND,
+    BINDER_RECORD_ACK
+} BINDER_RECORD_TYPE;
+
+typedef enum binder_record_flags {
+    BINDER_RECORD_NO_FLAGS = 0x00,
+    BINDER_RECORD_TRUNCATED = 0x01 /* Parcel data didn't fit */
+} BINDER_RECORD_FLAGS;
+
+typedef struct binder_record_file_header {
+    char magic[4];          /* BINDER_RECORD_MAGIC */
+    guint16 version;        /* BINDER_RECORD_VERSION */
+    guint16 header_size;    /* sizeof(BinderRecordHeader) */
+    gint64 time;            /* When the capture was saved */
+} BinderRecordFileHeader;
+
+typedef struct binder_record_header {
+    guint32 size;           /* Header + data + padding */
+    guint8 type;            /* BINDER_RECORD_TYPE */
+    guint8 slot;
+    gint8 iface;            /* RADIO_AIDL_INTERFACE, -1 for HIDL */
+    guint8 flags;           /* BINDER_RECORD_FLAGS */
+    gint64 time;            /* g_get_real_time() */
+    guint32 code;           /* RADIO_INTERFACE for BINDER_RECORD_INSTANCE */
+    guint32 serial;
+    gint32 status;          /* RADIO_ERROR or RADIO_IND_TYPE */
+    guint32 data_size;      /* Original parcel size */
+    guint32 saved_size;     /* Number of data bytes following the header */
+    guint32 reserved;
+} BinderRecordHeader;
+
+G_STATIC_ASSERT(sizeof(BinderRecordFileHeader) == 16);
+G_STATIC_ASSERT(sizeof(BinderRecordHeader) == 40);
+
+typedef struct binder_record_instance BinderRecordInstance;
+
+BinderRecordRing*
+binder_record_ring_new(
+    gsize size,
+    gsize max_data_size)
+    BINDER_INTERNAL;
+
+void
+binder_record_ring_free(
+    BinderRecordRing* ring)
+    BINDER_INTERNAL;
+
+BinderRecordInstance*
+binder_record_ring_add_instance(
+    BinderRecordRing* ring,
+    guint slot,
+    RADIO_INTERFACE version,
+    RADIO_AIDL_INTERFACE iface,
+    const char* name)
+    BINDER_INTERNAL;
+
+void
+binder_record_ring_remove_instance(
+    BinderRecordRing* ring,
+    BinderRecordInstance* instance)
+    BINDER_INTERNAL;
+
+void
+binder_record_ring_put(
+    BinderRecordRing* ring,
+    BinderRecordHeader* rec,
+    const void* data,
+    gsize size)
+    BINDER_INTERNAL;
+
+gsize
+binder_record_ring_used(
+    BinderRecordRing* ring)
+    BINDER_INTERNAL;
+
+GBytes*
+binder_record_ring_capture(
+    BinderRecordRing* ring)
+    BINDER_INTERNAL;
+
+gboolean
+binder_record_ring_save(
+    BinderRecordRing* ring,
+    const char* path,
+    GError** error)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_RECORD_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
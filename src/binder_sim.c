@@ -16,12 +16,15 @@
 #include "binder_log.h"
 #include "binder_modem.h"
 #include "binder_sim.h"
+#include "binder_sim_cache.h"
 #include "binder_sim_card.h"
+#include "binder_sim_io_queue.h"
 #include "binder_util.h"
 
 #include <ofono/log.h>
 #include <ofono/misc.h>
 #include <ofono/sim.h>
+#include <ofono/storage.h>
 #include <ofono/watch.h>
 
 #include <radio_client.h>
@@ -40,6 +43,7 @@
 #define FAC_LOCK_QUERY_TIMEOUT_SECS   (10)
 #define FAC_LOCK_QUERY_RETRIES        (1)
 #define SIM_IO_TIMEOUT_SECS           (20)
+#define SIM_CACHE_DIR                 "binder-sim-cache"
 
 #define EF_STATUS_INVALIDATED 0
 #define EF_STATUS_VALID 1
@@ -88,6 +92,10 @@ typedef struct binder_sim {
     int retries[OFONO_SIM_PASSWORD_INVALID];
     gboolean empty_pin_query_allowed;
     gboolean inserted;
+    BinderSimIoQueue* io_queue; /* NULL if SIM I/O isn't pipelined */
+    BinderSimCache* cache;
+    GQueue cache_hits; /* BinderSimCacheHit */
+    guint cache_hit_id;
     guint idle_id; /* Used by register and SIM reset callbacks */
     guint list_apps_id;
     gulong card_event_id[SIM_CARD_EVENT_COUNT];
@@ -123,8 +131,20 @@ typedef struct binder_sim_cbd_io {
     } cb;
     gpointer data;
     gpointer req_id; /* Actually RadioRequest pointer (but not a ref) */
+    gboolean queued; /* Submitted by io_queue */
+    guint cmd;
+    int fid;
+    char* cache_key;
+    char* cache_iccid; /* ICCID at the time of the request */
 } BinderSimCbdIo;
 
+typedef struct binder_sim_cache_hit {
+    guint cmd;
+    GBytes* data;
+    BinderCallback cb;
+    gpointer cb_data;
+} BinderSimCacheHit;
+
 typedef struct binder_sim_session_cbd {
     BinderSim* self;
     BinderSimCard* card;
@@ -206,6 +226,71 @@ binder_sim_cbd_io_new(
     return cbd;
 }
 
+static
+gboolean
+binder_sim_io_cmd_is_read(
+    guint cmd)
+{
+    return cmd == CMD_READ_BINARY || cmd == CMD_READ_RECORD;
+}
+
+static
+void
+binder_sim_cbd_io_failed(
+    BinderSimCbdIo* cbd)
+{
+    struct ofono_error err;
+
+    binder_error_init_failure(&err);
+    switch (cbd->cmd) {
+    case CMD_READ_BINARY:
+    case CMD_READ_RECORD:
+        cbd->cb.read(&err, NULL, 0, cbd->data);
+        break;
+    case CMD_GET_RESPONSE:
+        cbd->cb.file_info(&err, -1, -1, -1, NULL, EF_STATUS_INVALIDATED,
+            cbd->data);
+        break;
+    default:
+        cbd->cb.write(&err, cbd->data);
+        break;
+    }
+}
+
+static
+gboolean
+binder_sim_io_queue_submit_cb(
+    gpointer item,
+    gpointer user_data)
+{
+    BinderSimCbdIo* cbd = item;
+    RadioRequest* req = cbd->req_id;
+    gboolean submitted = FALSE;
+
+    /*
+     * Queued cbd holds a reference to its request, which owns the cbd.
+     * If the submission fails, radio_request_unref() deallocates both.
+     */
+    if (radio_request_submit(req)) {
+        cbd->queued = TRUE;
+        submitted = TRUE;
+    } else {
+        binder_sim_cbd_io_failed(cbd);
+    }
+    radio_request_unref(req);
+    return submitted;
+}
+
+static
+void
+binder_sim_io_queue_drop_cb(
+    gpointer item)
+{
+    BinderSimCbdIo* cbd = item;
+
+    radio_request_unref(cbd->req_id);
+}
+
 static
 void
 binder_sim_cbd_io_free(
@@ -215,6 +300,12 @@ binder_sim_cbd_io_free(
 
     binder_sim_card_sim_io_finished(cbd->card, cbd->req_id);
     binder_sim_card_unref(cbd->card);
+    g_free(cbd->cache_key);
+    g_free(cbd->cache_iccid);
+    if (cbd->queued) {
+        binder_sim_io_queue_finished(cbd->self->io_queue,
+            binder_sim_io_cmd_is_read(cbd->cmd));
+    }
     gutil_slice_free(cbd);
 }
 
@@ -231,6 +322,22 @@ binder_sim_cbd_io_start(
     return FALSE;
 }
 
+static
+void
+binder_sim_cbd_io_enqueue(
+    BinderSimCbdIo* cbd,
+    RadioRequest* req)
+{
+    /*
+     * The request waits in the queue until its turn comes, either
+     * way it counts as SIM I/O in progress from this point on.
+     */
+    binder_sim_card_sim_io_started(cbd->card, cbd->req_id = req);
+    radio_request_ref(req);
+    binder_sim_io_queue_push(cbd->self->io_queue, cbd,
+        binder_sim_io_cmd_is_read(cbd->cmd));
+}
+
 static
 BinderSimSessionCbData*
 binder_sim_session_cbd_new(
@@ -356,10 +463,9 @@ binder_sim_pin_req_done(
 }
 
 static
-const char*
-binder_sim_append_path(
+char*
+binder_sim_ef_path(
     BinderSim* self,
-    GBinderWriter* writer,
     int fileid,
     const guchar* path,
     guint path_len)
@@ -383,7 +489,6 @@ binder_sim_append_path(
 
     if (len > 0) {
         hex_path = binder_encode_hex(db_path, len);
-        gbinder_writer_add_cleanup(writer, g_free, hex_path);
         DBG_(self, "%s", hex_path);
         return hex_path;
     } else {
@@ -392,7 +497,7 @@ binder_sim_append_path(
          * from ef_db table in src/simutil.c, hard-code ROOTMF.
          */
         DBG_(self, "%s (default)", ROOTMF);
-        return ROOTMF;
+        return g_strdup(ROOTMF);
     }
 }
 
@@ -527,6 +632,41 @@ binder_sim_io_response_ok(
     return FALSE;
 }
 
+static
+gboolean
+binder_sim_file_info_parse(
+    const guint8* data,
+    guint len,
+    ofono_sim_file_info_cb_t cb,
+    void* cb_data)
+{
+    gboolean ok = FALSE;
+    guchar faccess[3] = { 0x00, 0x00, 0x00 };
+    guchar fstatus = EF_STATUS_VALID;
+    unsigned int flen = 0, rlen = 0, str = 0;
+
+    if (len) {
+        if (data[0] == 0x62) {
+            ok = ofono_parse_get_response_3g(data, len, &flen, &rlen, &str,
+                faccess, NULL);
+        } else {
+            ok = ofono_parse_get_response_2g(data, len, &flen, &rlen, &str,
+                faccess, &fstatus);
+        }
+    }
+
+    if (ok) {
+        struct ofono_error err;
+
+        /* Success */
+        cb(binder_error_ok(&err), flen, str, rlen, faccess, fstatus, cb_data);
+        return TRUE;
+    } else {
+        ofono_error("file info parse error");
+        return FALSE;
+    }
+}
+
 static
 void
 binder_sim_file_info_cb(
@@ -556,31 +696,12 @@ binder_sim_file_info_cb(
                 DBG_(self, "No SIM card");
             } else if (binder_sim_io_response_ok(res) &&
                 error == RADIO_ERROR_NONE) {
-                gboolean ok = FALSE;
-                guchar faccess[3] = { 0x00, 0x00, 0x00 };
-                guchar fstatus = EF_STATUS_VALID;
-                unsigned int flen = 0, rlen = 0, str = 0;
-
-                if (res->data_len) {
-                    if (res->data[0] == 0x62) {
-                        ok = ofono_parse_get_response_3g(res->data,
-                            res->data_len, &flen, &rlen, &str, faccess,
-                            NULL);
-                    } else {
-                        ok = ofono_parse_get_response_2g(res->data,
-                            res->data_len, &flen, &rlen, &str, faccess,
-                            &fstatus);
-                    }
-                }
-
-                if (ok) {
-                    /* Success */
-                    cb(binder_error_ok(&err), flen, str, rlen, faccess,
-                       fstatus, cbd->data);
+                if (binder_sim_file_info_parse(res->data, res->data_len,
+                    cb, cbd->data)) {
+                    binder_sim_cache_put(self->cache, cbd->cache_iccid,
+                        cbd->cache_key, res->data, res->data_len);
                     binder_sim_io_response_free(res);
                     return;
-                } else {
-                    ofono_error("file info parse error");
                 }
             } else if (res) {
                 binder_error_init_sim_error(&err, res->sw1, res->sw2);
@@ -599,6 +720,98 @@ binder_sim_file_info_cb(
     cb(&err, -1, -1, -1, NULL, EF_STATUS_INVALIDATED, cbd->data);
 }
 
+static
+void
+binder_sim_cache_hit_free(
+    BinderSimCacheHit* hit)
+{
+    g_bytes_unref(hit->data);
+    g_slice_free(BinderSimCacheHit, hit);
+}
+
+static
+gboolean
+binder_sim_cache_hit_cb(
+    gpointer user_data)
+{
+    BinderSim* self = user_data;
+    BinderSimCacheHit* hit;
+
+    self->cache_hit_id = 0;
+    while ((hit = g_queue_pop_head(&self->cache_hits)) != NULL) {
+        gsize len;
+        const guint8* data = g_bytes_get_data(hit->data, &len);
+        struct ofono_error err;
+
+        if (hit->cmd == CMD_GET_RESPONSE) {
+            ofono_sim_file_info_cb_t cb = (ofono_sim_file_info_cb_t)hit->cb;
+
+            if (!binder_sim_file_info_parse(data, len, cb, hit->cb_data)) {
+                cb(binder_error_failure(&err), -1, -1, -1, NULL,
+                    EF_STATUS_INVALIDATED, hit->cb_data);
+            }
+        } else {
+            ofono_sim_read_cb_t cb = (ofono_sim_read_cb_t)hit->cb;
+
+            cb(binder_error_ok(&err), data, len, hit->cb_data);
+        }
+        binder_sim_cache_hit_free(hit);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+binder_sim_cache_usable(
+    BinderSim* self)
+{
+    const BinderSimCard* card = self->card;
+
+    /* Nothing is read from or written to the cache until PIN is entered */
+    return self->cache && self->inserted && card->status && card->app &&
+        card->app->app_state == RADIO_APP_STATE_READY;
+}
+
+static
+gboolean
+binder_sim_cache_lookup(
+    BinderSim* self,
+    guint cmd,
+    int fid,
+    guint p1,
+    guint p2,
+    guint p3,
+    const char* path,
+    const char* aid,
+    BinderCallback cb,
+    void* data)
+{
+    if (binder_sim_cache_usable(self)) {
+        char* key = binder_sim_cache_key(cmd, fid, p1, p2, p3, path, aid);
+        GBytes* bytes = binder_sim_cache_get(self->cache, key);
+
+        g_free(key);
+        if (bytes) {
+            BinderSimCacheHit* hit = g_slice_new(BinderSimCacheHit);
+
+            DBG_(self, "cmd=0x%.2X,fid=0x%.4X,%d,%d,%d (cached)",
+                cmd, fid, p1, p2, p3);
+
+            /* Don't invoke the callback from within the driver call */
+            hit->cmd = cmd;
+            hit->data = bytes;
+            hit->cb = cb;
+            hit->cb_data = data;
+            g_queue_push_tail(&self->cache_hits, hit);
+            if (!self->cache_hit_id) {
+                self->cache_hit_id = g_idle_add(binder_sim_cache_hit_cb, self);
+            }
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 static
 gboolean
 binder_sim_request_io(
@@ -617,26 +830,44 @@ binder_sim_request_io(
 {
     static const char empty[] = "";
     const char* aid = binder_sim_card_app_aid(self->card);
-    BinderSimCbdIo* cbd = binder_sim_cbd_io_new(self, cb, data);
+    char* hex_path = binder_sim_ef_path(self, fid, path, path_len);
+    BinderSimCbdIo* cbd;
     guint parent;
     gboolean ok;
     guint32 code = self->interface_aidl == RADIO_SIM_INTERFACE ?
         RADIO_SIM_REQ_ICC_IO_FOR_APP : RADIO_REQ_ICC_IO_FOR_APP;
+    GBinderWriter writer;
+    RadioRequest* req;
+    RadioIccIo* io;
+
+    if (binder_sim_cache_lookup(self, cmd, fid, p1, p2, p3, hex_path, aid,
+        cb, data)) {
+        g_free(hex_path);
+        return TRUE;
+    }
 
     /* iccIOForApp(int32 serial, IccIo iccIo); */
-    GBinderWriter writer;
-    RadioRequest* req = radio_request_new2(self->g, code,
-        &writer, complete, binder_sim_cbd_io_free, cbd);
-    RadioIccIo* io = gbinder_writer_new0(&writer, RadioIccIo);
+    cbd = binder_sim_cbd_io_new(self, cb, data);
+    req = radio_request_new2(self->g, code, &writer, complete,
+        binder_sim_cbd_io_free, cbd);
+    gbinder_writer_add_cleanup(&writer, g_free, hex_path);
+    io = gbinder_writer_new0(&writer, RadioIccIo);
 
     DBG_(self, "cmd=0x%.2X,fid=0x%.4X,%d,%d,%d,%s,pin2=(null),aid=%s",
         cmd, fid, p1, p2, p3, hex_data, aid);
 
+    cbd->cmd = cmd;
+    cbd->fid = fid;
+    if (binder_sim_cache_usable(self)) {
+        cbd->cache_key = binder_sim_cache_key(cmd, fid, p1, p2, p3,
+            hex_path, aid);
+        cbd->cache_iccid = g_strdup(self->card->status->iccid);
+    }
+
     if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) {
         io->command = cmd;
         io->fileId = fid;
-        io->path.data.str = binder_sim_append_path(self, &writer, fid, path,
-            path_len);
+        io->path.data.str = hex_path;
         io->path.len = strlen(io->path.data.str);
         io->p1 = p1;
         io->p2 = p2;
@@ -655,8 +886,7 @@ binder_sim_request_io(
         binder_append_hidl_string_data(&writer, io, aid, parent);
     } else {
         gint32 initial_size;
-        const char* hex_path = binder_sim_append_path(self,
-            &writer, fid, path, path_len);
+
         hex_data = hex_data ? hex_data : empty;
 
         /* Non-null parcelable */
@@ -680,9 +910,18 @@ binder_sim_request_io(
             gbinder_writer_bytes_written(&writer) - initial_size);
     }
 
-    radio_request_set_blocking(req, TRUE);
     radio_request_set_timeout(req, SIM_IO_TIMEOUT_SECS * 1000);
-    ok = binder_sim_cbd_io_start(cbd, req);
+    if (!binder_sim_io_cmd_is_read(cmd)) {
+        /* Everything but reads is serialized */
+        radio_request_set_blocking(req, TRUE);
+    }
+    if (self->io_queue) {
+        /* Reads may be pipelined but nothing gets reordered */
+        binder_sim_cbd_io_enqueue(cbd, req);
+        ok = TRUE;
+    } else {
+        ok = binder_sim_cbd_io_start(cbd, req);
+    }
     radio_request_unref(req);
     return ok;
 }
@@ -738,6 +977,8 @@ binder_sim_read_cb(
             } else if (binder_sim_io_response_ok(res) &&
                 error == RADIO_ERROR_NONE) {
                 /* Success */
+                binder_sim_cache_put(self->cache, cbd->cache_iccid,
+                    cbd->cache_key, res->data, res->data_len);
                 cb(binder_error_ok(&err), res->data, res->data_len, cbd->data);
                 binder_sim_io_response_free(res);
                 return;
@@ -845,6 +1086,9 @@ void binder_sim_write_cb(
 
     DBG_(self, "");
 
+    /* Whatever the outcome, the cached contents can't be trusted anymore */
+    binder_sim_cache_invalidate_file(self->cache, cbd->fid);
+
     binder_error_init_failure(&err);
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == code) {
@@ -888,9 +1132,11 @@ binder_sim_write(
     ofono_sim_write_cb_t cb,
     void* data)
 {
+    BinderSim* self = binder_sim_get_data(sim);
     char* hex_data = binder_encode_hex(value, length);
 
-    if (!binder_sim_request_io(binder_sim_get_data(sim), cmd, fileid, p1, p2,
+    binder_sim_cache_invalidate_file(self->cache, fileid);
+    if (!binder_sim_request_io(self, cmd, fileid, p1, p2,
         length, hex_data, path, path_len, binder_sim_write_cb,
         BINDER_CB(cb), data)) {
         struct ofono_error err;
@@ -1221,6 +1467,8 @@ binder_sim_status_changed_cb(
     BinderSim* self = user_data;
 
     GASSERT(self->card == sim);
+    binder_sim_cache_set_iccid(self->cache, sim->status ?
+        sim->status->iccid : NULL);
     if (sim->status && sim->status->card_state == RADIO_CARD_STATE_PRESENT) {
         if (sim->app) {
             enum ofono_sim_password_type ps;
@@ -2601,6 +2849,8 @@ binder_sim_refresh_cb(
 {
     BinderSim* self = user_data;
 
+    binder_sim_cache_invalidate_all(self->cache);
+
     /*
      * BINDER_UNSOL_SIM_REFRESH may contain the EFID of the updated file,
      * so we could be more descrete here. However I have't actually
@@ -2664,6 +2914,17 @@ binder_sim_probe(
 
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
     self->empty_pin_query_allowed = modem->config.empty_pin_query;
+    if (modem->config.sim_io_window > 1) {
+        self->io_queue = binder_sim_io_queue_new(modem->config.sim_io_window,
+            binder_sim_io_queue_submit_cb, self);
+    }
+    g_queue_init(&self->cache_hits);
+    if (modem->config.sim_file_cache) {
+        char* dir = g_build_filename(ofono_storage_dir(), SIM_CACHE_DIR, NULL);
+
+        self->cache = binder_sim_cache_new(dir);
+        g_free(dir);
+    }
     self->card = binder_sim_card_ref(modem->sim_card);
     self->g = radio_request_group_new(modem->sim_client); /* Keeps ref to client */
     self->interface_aidl = radio_client_aidl_interface(modem->sim_client);
@@ -2689,10 +2950,26 @@ static void binder_sim_remove(struct ofono_sim *sim)
 
     radio_client_remove_all_handlers(self->g->client, self->io_event_id);
     radio_request_drop(self->query_pin_retries_req);
+
+    /* Detach the queue first, so that nothing else gets submitted */
+    if (self->io_queue) {
+        BinderSimIoQueue* queue = self->io_queue;
+
+        self->io_queue = NULL;
+        binder_sim_io_queue_free(queue, binder_sim_io_queue_drop_cb);
+    }
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
     radio_client_unref(self->network_client);
 
+    if (self->cache_hit_id) {
+        g_source_remove(self->cache_hit_id);
+    }
+    while (self->cache_hits.head) {
+        binder_sim_cache_hit_free(g_queue_pop_head(&self->cache_hits));
+    }
+    binder_sim_cache_free(self->cache);
+
     if (self->list_apps_id) {
         g_source_remove(self->list_apps_id);
     }
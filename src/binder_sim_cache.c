@@ -0,0 +1,405 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_sim_cache.h"
+
+#include <gutil_misc.h>
+
+#include <glib/gstdio.h>
+
+#include <errno.h>
+
+/* Commands defined for TS 27.007 +CRSM */
+#define CMD_READ_BINARY   176 /* 0xB0   */
+#define CMD_READ_RECORD   178 /* 0xB2   */
+#define CMD_GET_RESPONSE  192 /* 0xC0   */
+
+/* Entries saved by the versions which didn't include AID are ignored */
+#define SIM_CACHE_GROUP   "AppEF"
+#define SIM_CACHE_ICCID_MAX_LEN 24
+
+struct binder_sim_cache {
+    char* dir;
+    char* iccid;
+    char* file;
+    GHashTable* entries;
+    guint save_id;
+    gboolean dirty;
+};
+
+/*
+ * Files which only change when we write them (and then the cache gets
+ * invalidated) or behind our back with a SIM REFRESH indication (and
+ * then the cache gets invalidated too).
+ */
+static const int binder_sim_cache_files[] = {
+    0x2fe2, /* EF_ICCID */
+    0x4f30, /* EF_PBR */
+    0x6f14, /* EF_CPHS_SPN */
+    0x6f16, /* EF_CPHS_INFO */
+    0x6f18, /* EF_CPHS_SPN_SHORT */
+    0x6f38, /* EF_SST/EF_UST */
+    0x6f3e, /* EF_GID1 */
+    0x6f3f, /* EF_GID2 */
+    0x6f40, /* EF_MSISDN */
+    0x6f46, /* EF_SPN */
+    0x6f49, /* EF_SDN */
+    0x6f56, /* EF_EST */
+    0x6fad, /* EF_AD */
+    0x6fb7, /* EF_ECC */
+    0x6fc5, /* EF_PNN */
+    0x6fc6, /* EF_OPL */
+    0x6fcd  /* EF_SPDI */
+};
+
+static
+gboolean
+binder_sim_cache_file_ok(
+    int fid)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(binder_sim_cache_files); i++) {
+        if (binder_sim_cache_files[i] == fid) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_sim_cache_iccid_ok(
+    const char* iccid)
+{
+    /* ICCID becomes the file name, make sure it's harmless */
+    if (iccid && iccid[0]) {
+        const char* ptr = iccid;
+
+        while (*ptr && g_ascii_isxdigit(*ptr)) {
+            ptr++;
+        }
+        return !*ptr && (ptr - iccid) <= SIM_CACHE_ICCID_MAX_LEN;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_sim_cache_hex_ok(
+    const char* str)
+{
+    /* Path and AID end up in the cache file too */
+    if (str && str[0]) {
+        const char* ptr = str;
+
+        while (*ptr && g_ascii_isxdigit(*ptr)) {
+            ptr++;
+        }
+        return !*ptr;
+    }
+    return FALSE;
+}
+
+static
+char*
+binder_sim_cache_hex(
+    const guchar* data,
+    gsize size)
+{
+    char* hex = g_malloc(2 * size + 1);
+    gsize i;
+
+    for (i = 0; i < size; i++) {
+        static const char digits[] = "0123456789ABCDEF";
+
+        hex[2 * i] = digits[data[i] >> 4];
+        hex[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    hex[2 * size] = 0;
+    return hex;
+}
+
+static
+void
+binder_sim_cache_load(
+    BinderSimCache* cache)
+{
+    GKeyFile* kf = g_key_file_new();
+
+    if (g_key_file_load_from_file(kf, cache->file, G_KEY_FILE_NONE, NULL)) {
+        char** keys = g_key_file_get_keys(kf, SIM_CACHE_GROUP, NULL, NULL);
+
+        if (keys) {
+            char** ptr;
+
+            for (ptr = keys; *ptr; ptr++) {
+                char* hex = g_key_file_get_string(kf, SIM_CACHE_GROUP,
+                    *ptr, NULL);
+                const gsize len = hex ? strlen(hex) : 0;
+                void* data = g_malloc(len/2 + 1);
+
+                if (hex && !len) {
+                    g_hash_table_insert(cache->entries, g_strdup(*ptr),
+                        g_bytes_new(NULL, 0));
+                    g_free(data);
+                } else if (!(len & 1) && gutil_hex2bin(hex, len, data)) {
+                    g_hash_table_insert(cache->entries, g_strdup(*ptr),
+                        g_bytes_new_take(data, len/2));
+                } else {
+                    GWARN("Invalid SIM cache entry %s", *ptr);
+                    g_free(data);
+                }
+                g_free(hex);
+            }
+            g_strfreev(keys);
+        }
+        GDEBUG("Loaded %u SIM cache entries from %s",
+            g_hash_table_size(cache->entries), cache->file);
+    }
+    g_key_file_unref(kf);
+}
+
+static
+gboolean
+binder_sim_cache_save_cb(
+    gpointer user_data)
+{
+    BinderSimCache* cache = user_data;
+
+    cache->save_id = 0;
+    binder_sim_cache_save(cache);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+binder_sim_cache_changed(
+    BinderSimCache* cache)
+{
+    /* Coalesce the writes, the files are usually read in bursts */
+    cache->dirty = TRUE;
+    if (!cache->save_id) {
+        cache->save_id = g_idle_add(binder_sim_cache_save_cb, cache);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderSimCache*
+binder_sim_cache_new(
+    const char* dir)
+{
+    BinderSimCache* cache = g_new0(BinderSimCache, 1);
+
+    cache->dir = g_strdup(dir);
+    cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, (GDestroyNotify) g_bytes_unref);
+    return cache;
+}
+
+void
+binder_sim_cache_free(
+    BinderSimCache* cache)
+{
+    if (cache) {
+        binder_sim_cache_save(cache);
+        if (cache->save_id) {
+            g_source_remove(cache->save_id);
+        }
+        g_hash_table_destroy(cache->entries);
+        g_free(cache->dir);
+        g_free(cache->iccid);
+        g_free(cache->file);
+        g_free(cache);
+    }
+}
+
+void
+binder_sim_cache_set_iccid(
+    BinderSimCache* cache,
+    const char* iccid)
+{
+    if (cache && g_strcmp0(cache->iccid, iccid)) {
+        binder_sim_cache_save(cache);
+        g_hash_table_remove_all(cache->entries);
+        g_free(cache->iccid);
+        g_free(cache->file);
+        cache->iccid = NULL;
+        cache->file = NULL;
+        if (binder_sim_cache_iccid_ok(iccid)) {
+            cache->iccid = g_strdup(iccid);
+            cache->file = g_build_filename(cache->dir, iccid, NULL);
+            binder_sim_cache_load(cache);
+        }
+    }
+}
+
+char*
+binder_sim_cache_key(
+    guint cmd,
+    int fid,
+    guint p1,
+    guint p2,
+    guint p3,
+    const char* path,
+    const char* aid)
+{
+    if ((cmd == CMD_GET_RESPONSE || cmd == CMD_READ_BINARY ||
+        cmd == CMD_READ_RECORD) && binder_sim_cache_file_ok(fid) &&
+        binder_sim_cache_hex_ok(path) && (!aid || !aid[0] ||
+        binder_sim_cache_hex_ok(aid))) {
+        char* key;
+
+        /*
+         * The same file id may refer to different files under DF_GSM
+         * and ADF_USIM (e.g. EF_SST and EF_UST), hence the full path
+         * and the AID. The key must start with the file id, see
+         * binder_sim_cache_invalidate_file()
+         */
+        if (aid && aid[0]) {
+            key = g_strdup_printf("%04X-%02X-%02X%02X%02X-%s-%s", fid, cmd,
+                p1 & 0xff, p2 & 0xff, p3 & 0xff, path, aid);
+        } else {
+            key = g_strdup_printf("%04X-%02X-%02X%02X%02X-%s", fid, cmd,
+                p1 & 0xff, p2 & 0xff, p3 & 0xff, path);
+        }
+        return key;
+    }
+    return NULL;
+}
+
+GBytes*
+binder_sim_cache_get(
+    BinderSimCache* cache,
+    const char* key)
+{
+    if (cache && cache->iccid && key) {
+        GBytes* data = g_hash_table_lookup(cache->entries, key);
+
+        if (data) {
+            return g_bytes_ref(data);
+        }
+    }
+    return NULL;
+}
+
+void
+binder_sim_cache_put(
+    BinderSimCache* cache,
+    const char* iccid,
+    const char* key,
+    const void* data,
+    gsize size)
+{
+    /* Drop the data if the card has changed since it was requested */
+    if (cache && cache->iccid && key && !g_strcmp0(cache->iccid, iccid)) {
+        GBytes* old = g_hash_table_lookup(cache->entries, key);
+        GBytes* bytes = g_bytes_new(data, size);
+
+        if (!old || !g_bytes_equal(old, bytes)) {
+            g_hash_table_insert(cache->entries, g_strdup(key), bytes);
+            binder_sim_cache_changed(cache);
+        } else {
+            g_bytes_unref(bytes);
+        }
+    }
+}
+
+void
+binder_sim_cache_invalidate_file(
+    BinderSimCache* cache,
+    int fid)
+{
+    if (cache && cache->iccid && binder_sim_cache_file_ok(fid)) {
+        char* prefix = g_strdup_printf("%04X-", fid);
+        const gsize prefix_len = strlen(prefix);
+        GHashTableIter it;
+        gpointer key;
+        guint n = 0;
+
+        g_hash_table_iter_init(&it, cache->entries);
+        while (g_hash_table_iter_next(&it, &key, NULL)) {
+            if (!strncmp(key, prefix, prefix_len)) {
+                g_hash_table_iter_remove(&it);
+                n++;
+            }
+        }
+        if (n) {
+            GDEBUG("Dropped %u SIM cache entries for %04X", n, fid);
+            binder_sim_cache_changed(cache);
+        }
+        g_free(prefix);
+    }
+}
+
+void
+binder_sim_cache_invalidate_all(
+    BinderSimCache* cache)
+{
+    if (cache && cache->iccid) {
+        GDEBUG("Dropping SIM cache for %s", cache->iccid);
+        g_hash_table_remove_all(cache->entries);
+        cache->dirty = FALSE;
+        if (g_unlink(cache->file) < 0 && errno != ENOENT) {
+            GWARN("Failed to delete %s: %s", cache->file, strerror(errno));
+        }
+    }
+}
+
+void
+binder_sim_cache_save(
+    BinderSimCache* cache)
+{
+    if (cache && cache->dirty && cache->iccid) {
+        GKeyFile* kf = g_key_file_new();
+        GHashTableIter it;
+        gpointer key, value;
+        GError* error = NULL;
+
+        cache->dirty = FALSE;
+        g_hash_table_iter_init(&it, cache->entries);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            gsize size;
+            const guchar* data = g_bytes_get_data(value, &size);
+            char* hex = binder_sim_cache_hex(data, size);
+
+            g_key_file_set_string(kf, SIM_CACHE_GROUP, key, hex);
+            g_free(hex);
+        }
+
+        if (g_mkdir_with_parents(cache->dir, 0700) < 0) {
+            GWARN("Failed to create %s: %s", cache->dir, strerror(errno));
+        } else if (!g_key_file_save_to_file(kf, cache->file, &error)) {
+            GWARN("Failed to save %s: %s", cache->file, error->message);
+            g_error_free(error);
+        } else {
+            GDEBUG("Saved %u SIM cache entries to %s",
+                g_hash_table_size(cache->entries), cache->file);
+        }
+        g_key_file_unref(kf);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
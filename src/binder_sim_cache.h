@@ -0,0 +1,97 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_SIM_CACHE_H
+#define BINDER_SIM_CACHE_H
+
+#include "binder_types.h"
+
+/*
+ * Persistent cache of iccIOForApp responses for the SIM elementary
+ * files which are (practically) never modified by anyone but us.
+ * There's one cache file per card, named after its ICCID. Entries
+ * are keyed by the command, file id, P1, P2, P3, the resolved path
+ * and the AID of the application, i.e. GET RESPONSE, READ BINARY and
+ * READ RECORD responses are cached separately. Only the raw response
+ * data is stored.
+ */
+
+BinderSimCache*
+binder_sim_cache_new(
+    const char* dir)
+    BINDER_INTERNAL;
+
+void
+binder_sim_cache_free(
+    BinderSimCache* cache)
+    BINDER_INTERNAL;
+
+void
+binder_sim_cache_set_iccid(
+    BinderSimCache* cache,
+    const char* iccid)
+    BINDER_INTERNAL;
+
+char*
+binder_sim_cache_key(
+    guint cmd,
+    int fid,
+    guint p1,
+    guint p2,
+    guint p3,
+    const char* path,
+    const char* aid)
+    BINDER_INTERNAL G_GNUC_WARN_UNUSED_RESULT;
+
+GBytes*
+binder_sim_cache_get(
+    BinderSimCache* cache,
+    const char* key)
+    BINDER_INTERNAL;
+
+void
+binder_sim_cache_put(
+    BinderSimCache* cache,
+    const char* iccid,
+    const char* key,
+    const void* data,
+    gsize size)
+    BINDER_INTERNAL;
+
+void
+binder_sim_cache_invalidate_file(
+    BinderSimCache* cache,
+    int fid)
+    BINDER_INTERNAL;
+
+void
+binder_sim_cache_invalidate_all(
+    BinderSimCache* cache)
+    BINDER_INTERNAL;
+
+void
+binder_sim_cache_save(
+    BinderSimCache* cache)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_SIM_CACHE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -148,7 +148,8 @@ binder_sim_card_status_compare(
         if (s1->pin_state != s2->pin_state ||
             s1->gsm_umts_index != s2->gsm_umts_index ||
             s1->ims_index != s2->ims_index ||
-            s1->num_apps != s2->num_apps) {
+            s1->num_apps != s2->num_apps ||
+            g_strcmp0(s1->iccid, s2->iccid)) {
             diff |= BINDER_SIMCARD_STATUS_CHANGED;
         } else {
             int i;
@@ -180,6 +181,7 @@ binder_sim_card_status_free(
             }
         }
         /* status->apps is allocated from the same memory block */
+        g_free(status->iccid);
         g_free(status);
     }
 }
@@ -441,7 +443,8 @@ binder_sim_card_update_status(
 static
 BinderSimCardStatus*
 binder_sim_card_status_new(
-    const RadioCardStatus* radio_status)
+    const RadioCardStatus* radio_status,
+    const char* iccid)
 {
     const guint num_apps = radio_status->apps.count;
     BinderSimCardStatus* status = g_malloc0(sizeof(BinderSimCardStatus) +
@@ -457,6 +460,7 @@ binder_sim_card_status_new(
     status->pin_state = radio_status->universalPinState;
     status->gsm_umts_index = radio_status->gsmUmtsSubscriptionAppIndex;
     status->ims_index = radio_status->imsSubscriptionAppIndex;
+    status->iccid = (iccid && iccid[0]) ? g_strdup(iccid) : NULL;
 
     if ((status->num_apps = num_apps) > 0) {
         const RadioAppStatus* radio_apps = radio_status->apps.data.ptr;
@@ -555,7 +559,7 @@ binder_sim_card_status_new_from_aidl(
         }
     }
 
-    /* Not used by the plugin, but useful to visually verify the parsing */
+    /* ATR and EID are not used, but useful to verify the parsing */
     atr = gbinder_reader_read_string16(reader);
     iccid = gbinder_reader_read_string16(reader);
     eid = gbinder_reader_read_string16(reader);
@@ -563,8 +567,12 @@ binder_sim_card_status_new_from_aidl(
     DBG("atr=%s, iccid=%s, eid=%s", atr ? atr : "(null)",
         iccid ? iccid : "(null)", eid ? eid : "(null)");
 
+    if (iccid && iccid[0]) {
+        status->iccid = iccid;
+    } else {
+        g_free(iccid);
+    }
     g_free(atr);
-    g_free(iccid);
     g_free(eid);
 
     return status;
@@ -601,28 +609,31 @@ binder_sim_card_status_cb(
                 status_1_0 = gbinder_reader_read_hidl_struct(&reader,
                     RadioCardStatus);
                 if (status_1_0) {
-                    status = binder_sim_card_status_new(status_1_0);
+                    status = binder_sim_card_status_new(status_1_0, NULL);
                 }
                 break;
             case RADIO_RESP_GET_ICC_CARD_STATUS_1_2:
                 status_1_2 = gbinder_reader_read_hidl_struct(&reader,
                     RadioCardStatus_1_2);
                 if (status_1_2) {
-                    status = binder_sim_card_status_new(&status_1_2->base);
+                    status = binder_sim_card_status_new(&status_1_2->base,
+                        status_1_2->iccid.data.str);
                 }
                 break;
             case RADIO_RESP_GET_ICC_CARD_STATUS_RESPONSE_1_4:
                 status_1_4 = gbinder_reader_read_hidl_struct(&reader,
                     RadioCardStatus_1_4);
                 if (status_1_4) {
-                    status = binder_sim_card_status_new(&status_1_4->base);
+                    status = binder_sim_card_status_new(&status_1_4->base,
+                        status_1_4->iccid.data.str);
                 }
                 break;
             case RADIO_RESP_GET_ICC_CARD_STATUS_1_5:
                 status_1_5 = gbinder_reader_read_hidl_struct(&reader,
                     RadioCardStatus_1_5);
                 if (status_1_5) {
-                    status = binder_sim_card_status_new(&status_1_5->base.base);
+                    status = binder_sim_card_status_new(&status_1_5->base.base,
+                        status_1_5->base.iccid.data.str);
                 }
                 break;
             default:
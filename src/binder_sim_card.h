@@ -38,6 +38,7 @@ typedef struct binder_sim_card_status {
     int ims_index;
     guint num_apps;
     BinderSimCardApp* apps;
+    char* iccid; /* NULL if not provided by the modem */
 } BinderSimCardStatus;
 
 struct binder_sim_card {
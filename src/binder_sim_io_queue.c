@@ -0,0 +1,149 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_sim_io_queue.h"
+
+#include <gutil_macros.h>
+
+typedef struct binder_sim_io_queue_entry {
+    gpointer item;
+    gboolean read;
+} BinderSimIoQueueEntry;
+
+struct binder_sim_io_queue {
+    guint window;
+    guint reads;        /* Reads in flight */
+    gboolean exclusive; /* Some other command is in flight */
+    GQueue entries;     /* BinderSimIoQueueEntry waiting for their turn */
+    BinderSimIoSubmitFunc submit;
+    gpointer user_data;
+};
+
+static
+gboolean
+binder_sim_io_queue_can_submit(
+    BinderSimIoQueue* self,
+    const BinderSimIoQueueEntry* entry)
+{
+    if (self->exclusive) {
+        return FALSE;
+    } else if (entry->read) {
+        return self->reads < self->window;
+    } else {
+        /* Wait for the window to drain */
+        return !self->reads;
+    }
+}
+
+static
+void
+binder_sim_io_queue_submit(
+    BinderSimIoQueue* self)
+{
+    while (self->entries.head &&
+        binder_sim_io_queue_can_submit(self, self->entries.head->data)) {
+        BinderSimIoQueueEntry* entry = g_queue_pop_head(&self->entries);
+        const gboolean read = entry->read;
+        gpointer item = entry->item;
+
+        gutil_slice_free(entry);
+        if (read) {
+            self->reads++;
+        } else {
+            self->exclusive = TRUE;
+        }
+        if (!self->submit(item, self->user_data)) {
+            if (read) {
+                self->reads--;
+            } else {
+                self->exclusive = FALSE;
+            }
+        }
+    }
+}
+
+BinderSimIoQueue*
+binder_sim_io_queue_new(
+    guint window,
+    BinderSimIoSubmitFunc submit,
+    gpointer user_data)
+{
+    BinderSimIoQueue* self = g_new0(BinderSimIoQueue, 1);
+
+    self->window = MAX(window, 1);
+    self->submit = submit;
+    self->user_data = user_data;
+    g_queue_init(&self->entries);
+    return self;
+}
+
+void
+binder_sim_io_queue_free(
+    BinderSimIoQueue* self,
+    GDestroyNotify destroy)
+{
+    if (self) {
+        BinderSimIoQueueEntry* entry;
+
+        while ((entry = g_queue_pop_head(&self->entries)) != NULL) {
+            if (destroy) {
+                destroy(entry->item);
+            }
+            gutil_slice_free(entry);
+        }
+        g_free(self);
+    }
+}
+
+void
+binder_sim_io_queue_push(
+    BinderSimIoQueue* self,
+    gpointer item,
+    gboolean read)
+{
+    if (self) {
+        BinderSimIoQueueEntry* entry = g_slice_new(BinderSimIoQueueEntry);
+
+        entry->item = item;
+        entry->read = read;
+        g_queue_push_tail(&self->entries, entry);
+        binder_sim_io_queue_submit(self);
+    }
+}
+
+void
+binder_sim_io_queue_finished(
+    BinderSimIoQueue* self,
+    gboolean read)
+{
+    if (self) {
+        if (read) {
+            if (self->reads > 0) {
+                self->reads--;
+            }
+        } else {
+            self->exclusive = FALSE;
+        }
+        binder_sim_io_queue_submit(self);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,72 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_SIM_IO_QUEUE_H
+#define BINDER_SIM_IO_QUEUE_H
+
+#include "binder_types.h"
+
+/*
+ * Keeps SIM I/O commands in the order they were issued. Up to window
+ * reads (READ BINARY/RECORD) may be in flight at the same time. Any
+ * other command waits for the reads submitted before it to complete,
+ * and everything issued after it waits for it to complete.
+ *
+ * The submit callback returns TRUE if the item is now in flight, in
+ * which case binder_sim_io_queue_finished() must be called when it
+ * completes. If it returns FALSE, the item is considered done.
+ */
+
+typedef
+gboolean
+(*BinderSimIoSubmitFunc)(
+    gpointer item,
+    gpointer user_data);
+
+BinderSimIoQueue*
+binder_sim_io_queue_new(
+    guint window,
+    BinderSimIoSubmitFunc submit,
+    gpointer user_data)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_queue_free(
+    BinderSimIoQueue* queue,
+    GDestroyNotify destroy)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_queue_push(
+    BinderSimIoQueue* queue,
+    gpointer item,
+    gboolean read)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_queue_finished(
+    BinderSimIoQueue* queue,
+    gboolean read)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_SIM_IO_QUEUE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -20,18 +20,26 @@
 #include <radio_config_types.h>
 #include <ofono/radio-settings.h>
 
+typedef struct binder_call_stats BinderCallStats;
 typedef struct binder_data BinderData;
 typedef struct binder_data_manager BinderDataManager;
+typedef struct binder_data_retry BinderDataRetry;
 typedef struct binder_devmon BinderDevmon;
 typedef struct binder_ims_reg BinderImsReg;
+typedef struct binder_keepalive BinderKeepalive;
+typedef struct binder_latency BinderLatency;
 typedef struct binder_logger BinderLogger;
 typedef struct binder_modem BinderModem;
 typedef struct binder_network BinderNetwork;
+typedef struct binder_oper_cache BinderOperCache;
 typedef struct binder_radio_caps BinderRadioCaps;
 typedef struct binder_radio_caps_manager BinderRadioCapsManager;
 typedef struct binder_radio_caps_request BinderRadioCapsRequest;
 typedef struct binder_radio BinderRadio;
+typedef struct binder_record_ring BinderRecordRing;
+typedef struct binder_sim_cache BinderSimCache;
 typedef struct binder_sim_card BinderSimCard;
+typedef struct binder_sim_io_queue BinderSimIoQueue;
 typedef struct binder_sim_settings BinderSimSettings;
 
 typedef enum binder_feature_mask {
@@ -60,10 +68,23 @@ typedef struct binder_slot_config {
     guint slot;
     int cell_info_interval_short_ms;
     int cell_info_interval_long_ms;
+    int cell_info_interval_min_ms;
+    int cell_info_interval_max_ms;
     int network_mode_timeout_ms;
     int network_selection_timeout_ms;
-    int signal_strength_dbm_weak;
+    int signal_strength_dbm_weak; /* RSSI */
     int signal_strength_dbm_strong;
+    int rscp_dbm_weak;
+    int rscp_dbm_strong;
+    int rsrp_dbm_weak;
+    int rsrp_dbm_strong;
+    int ssrsrp_dbm_weak;
+    int ssrsrp_dbm_strong;
+    int dtmf_tone_ms; /* Zero means one sendDtmf per digit */
+    int dtmf_pause_ms;
+    guint sim_io_window;
+    gboolean sim_file_cache;
+    gboolean oper_name_cache; /* Plugin-wide OperatorNameCache */
     enum ofono_radio_access_mode techs;
     RADIO_PREF_NET_TYPE lte_network_mode;
     RADIO_PREF_NET_TYPE umts_network_mode;
@@ -15,7 +15,10 @@
 
 #include "binder_util.h"
 
+#include <ofono/dbus.h>
+#include <ofono/gdbus.h>
 #include <ofono/misc.h>
+#include <ofono/modem.h>
 #include <ofono/netreg.h>
 #include <ofono/log.h>
 
@@ -759,6 +762,40 @@ binder_submit_request2(
     return ok;
 }
 
+/*
+ * Registers D-Bus interface at the modem path and, if that worked,
+ * lists it in the Interfaces property of the modem.
+ */
+gboolean
+binder_dbus_add_modem_interface(
+    struct ofono_modem* modem,
+    const char* iface,
+    const GDBusMethodTable* methods,
+    const GDBusSignalTable* signals,
+    void* user_data)
+{
+    const char* path = ofono_modem_get_path(modem);
+
+    if (g_dbus_register_interface(ofono_dbus_get_connection(), path, iface,
+        methods, signals, NULL, user_data, NULL)) {
+        ofono_modem_add_interface(modem, iface);
+        return TRUE;
+    } else {
+        ofono_error("%s: failed to register %s", path, iface);
+        return FALSE;
+    }
+}
+
+void
+binder_dbus_remove_modem_interface(
+    struct ofono_modem* modem,
+    const char* iface)
+{
+    ofono_modem_remove_interface(modem, iface);
+    g_dbus_unregister_interface(ofono_dbus_get_connection(),
+        ofono_modem_get_path(modem), iface);
+}
+
 const char*
 binder_read_hidl_string(
     const GBinderReader* args)
@@ -23,7 +23,10 @@
 
 #include <radio_request.h>
 
+struct ofono_modem;
 struct ofono_network_operator;
+struct GDBusMethodTable;
+struct GDBusSignalTable;
 
 #define binder_dup_prefix(prefix) \
     (((prefix) && *(prefix)) ? (g_str_has_suffix(prefix, " ") ? \
@@ -197,6 +200,21 @@ binder_submit_request2(
     void* user_data)
     BINDER_INTERNAL;
 
+gboolean
+binder_dbus_add_modem_interface(
+    struct ofono_modem* modem,
+    const char* iface,
+    const struct GDBusMethodTable* methods,
+    const struct GDBusSignalTable* signals,
+    void* user_data)
+    BINDER_INTERNAL;
+
+void
+binder_dbus_remove_modem_interface(
+    struct ofono_modem* modem,
+    const char* iface)
+    BINDER_INTERNAL;
+
 const char*
 binder_read_hidl_string(
     const GBinderReader* args)
@@ -14,6 +14,8 @@
  *  GNU General Public License for more details.
  */
 
+#include "binder_call_stats.h"
+#include "binder_histogram.h"
 #include "binder_log.h"
 #include "binder_modem.h"
 #include "binder_ims_reg.h"
@@ -23,6 +25,8 @@
 #include "binder_ext_slot.h"
 #include "binder_ext_call.h"
 
+#include <ofono/dbus.h>
+#include <ofono/gdbus.h>
 #include <ofono/ims.h>
 #include <ofono/misc.h>
 #include <ofono/voicecall.h>
@@ -45,6 +49,9 @@
 
 #define VOICECALL_BLOCK_TIMEOUT_MS (5*1000)
 
+#define CALL_STATS_DBUS_INTERFACE "org.nemomobile.ofono.CallStatistics"
+#define CALL_STATS_DBUS_STATS_SIGNATURE "(suuuta" DBUS_TYPE_UINT32_AS_STRING ")"
+
 enum binder_voicecall_events {
     VOICECALL_EVENT_CALL_STATE_CHANGED,
     VOICECALL_EVENT_SUPP_SVC_NOTIFICATION,
@@ -60,9 +67,18 @@ enum binder_voicecall_ext_events {
     VOICECALL_EXT_EVENT_COUNT
 };
 
+typedef struct binder_voicecall_dial_time {
+    gint64 sent;
+    gint64 resp;
+    guint call_id; /* Zero until the call shows up */
+} BinderVoiceCallDialTime;
+
 typedef struct binder_voicecall {
     struct ofono_voicecall* vc;
     char* log_prefix;
+    BinderCallStats* stats;
+    gboolean stats_registered;
+    BinderVoiceCallDialTime dial_time;
     GSList* calls;
     BinderExtCall* ext;
     BinderImsReg* ims_reg;
@@ -79,6 +95,17 @@ typedef struct binder_voicecall {
     GUtilInts* remote_hangup_reasons;
     RadioRequest* send_dtmf_req;
     RadioRequest* clcc_poll_req;
+    int dtmf_tone_ms; /* Non-zero enables burst mode */
+    int dtmf_pause_ms;
+    guint dtmf_timer_id;
+    gboolean dtmf_tone_on; /* startDtmf sent, stopDtmf not yet */
+    gboolean clcc_poll_again; /* State changed while poll was pending */
+    gint64 state_changed_time; /* Oldest unhandled callStateChanged */
+    guint state_changes;
+    guint clcc_polls;
+    guint notify_count;
+    guint notify_max_us;
+    guint64 notify_total_us;
     guint ext_send_dtmf_id;
     guint ext_req_id;
     gulong ext_event[VOICECALL_EXT_EVENT_COUNT];
@@ -99,11 +126,13 @@ typedef struct binder_voicecall_cb_data {
 typedef struct binder_voicecall_lastcause_data {
     BinderVoiceCall* self;
     guint cid;
+    BinderCallTimeline timeline;
 } BinderVoiceCallLastCauseData;
 
 typedef struct binder_voicecall_info {
     struct ofono_call oc;
     BinderExtCall* ext; /* Not a ref */
+    BinderCallTimeline timeline;
 } BinderVoiceCallInfo;
 
 #define ANSWER_FLAGS BINDER_EXT_CALL_ANSWER_NO_FLAGS
@@ -122,6 +151,11 @@ void
 binder_voicecall_clear_dtmf_queue(
     BinderVoiceCall* self);
 
+static
+void
+binder_voicecall_clcc_poll(
+    BinderVoiceCall* self);
+
 static inline BinderVoiceCall*
 binder_voicecall_get_data(struct ofono_voicecall* vc)
     { return ofono_voicecall_get_data(vc); }
@@ -152,12 +186,70 @@ binder_voicecall_cbd_unref(
     }
 }
 
+static
+void
+binder_voicecall_dtmf_burst_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderVoiceCall* self = user_data;
+
+    /* Requests are pipelined, only failures need attention */
+    if (status != RADIO_TX_STATUS_OK || error != RADIO_ERROR_NONE) {
+        ofono_error("failed to send dtmf: %s",
+            binder_radio_error_string(error));
+        binder_voicecall_clear_dtmf_queue(self);
+    }
+}
+
+static
+gboolean
+binder_voicecall_dtmf_burst_request(
+    BinderVoiceCall* self,
+    const char* tone)
+{
+    /* startDtmf(int32 serial, string s) or stopDtmf(int32 serial) */
+    GBinderWriter writer;
+    gboolean submitted;
+    guint32 code = self->interface_aidl == RADIO_VOICE_INTERFACE ?
+        (tone ? RADIO_VOICE_REQ_START_DTMF : RADIO_VOICE_REQ_STOP_DTMF) :
+        (tone ? RADIO_REQ_START_DTMF : RADIO_REQ_STOP_DTMF);
+    RadioRequest* req = radio_request_new2(self->g, code, &writer,
+        binder_voicecall_dtmf_burst_cb, NULL, self);
+
+    if (tone) {
+        if (self->interface_aidl == RADIO_AIDL_INTERFACE_NONE) {
+            gbinder_writer_append_hidl_string_copy(&writer, tone);
+        } else {
+            gbinder_writer_append_string16(&writer, tone);
+        }
+    }
+    submitted = radio_request_submit(req);
+    radio_request_unref(req);
+
+    /* If startDtmf didn't go anywhere, there's nothing to stop */
+    self->dtmf_tone_on = submitted && tone;
+    return submitted;
+}
+
 static
 void
 binder_voicecall_clear_dtmf_queue(
     BinderVoiceCall* self)
 {
     gutil_ring_clear(self->dtmf_queue);
+    if (self->dtmf_timer_id) {
+        g_source_remove(self->dtmf_timer_id);
+        self->dtmf_timer_id = 0;
+    }
+    if (self->dtmf_tone_on) {
+        /* Don't leave the tone playing */
+        binder_voicecall_dtmf_burst_request(self, NULL);
+    }
     if (self->ext_send_dtmf_id) {
         binder_ext_call_cancel(self->ext, self->ext_send_dtmf_id);
         self->ext_send_dtmf_id = 0;
@@ -574,6 +666,53 @@ binder_voicecall_map_cause(
     return OFONO_DISCONNECT_REASON_ERROR;
 }
 
+static
+void
+binder_voicecall_timeline_done(
+    BinderVoiceCall* self,
+    guint cid,
+    const BinderCallTimeline* t)
+{
+    const gint64 t0 = t->dial ? t->dial : t->present;
+
+    /* Times are relative to dial request (or the first appearance) */
+#define TIME_MS(x) ((x) ? (int)(((x) - t0) / 1000) : -1)
+    DBG_(self, "call %u timeline: dial %d, present %d, alerting %d, "
+        "active %d, hangup %d, disconnect %d, fail cause %d ms", cid,
+        TIME_MS(t->dial_resp), TIME_MS(t->present), TIME_MS(t->alerting),
+        TIME_MS(t->active), TIME_MS(t->hangup), TIME_MS(t->disconnect),
+        TIME_MS(t->fail_cause));
+#undef TIME_MS
+    binder_call_stats_add(self->stats, t);
+}
+
+static
+void
+binder_voicecall_timeline_update(
+    BinderVoiceCall* self,
+    BinderVoiceCallInfo* call)
+{
+    BinderCallTimeline* t = &call->timeline;
+    const gint64 now = g_get_monotonic_time();
+
+    if (!t->present) {
+        t->present = now;
+        if (call->oc.direction == OFONO_CALL_DIRECTION_MOBILE_ORIGINATED &&
+            self->dial_time.sent && !self->dial_time.call_id) {
+            /* This must be the call we have dialed */
+            self->dial_time.call_id = call->oc.id;
+            t->dial = self->dial_time.sent;
+            t->dial_resp = self->dial_time.resp;
+        }
+    }
+    if (!t->alerting && call->oc.status == OFONO_CALL_STATUS_ALERTING) {
+        t->alerting = now;
+    }
+    if (!t->active && call->oc.status == OFONO_CALL_STATUS_ACTIVE) {
+        t->active = now;
+    }
+}
+
 void
 binder_voicecall_lastcause_cb(
     RadioRequest* req,
@@ -588,6 +727,9 @@ binder_voicecall_lastcause_cb(
     struct ofono_voicecall* vc = self->vc;
     const guint cid = data->cid;
 
+    data->timeline.fail_cause = g_get_monotonic_time();
+    binder_voicecall_timeline_done(self, cid, &data->timeline);
+
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
             guint32 code = self->interface_aidl == RADIO_VOICE_INTERFACE ?
@@ -647,14 +789,19 @@ binder_voicecall_set_calls(
 
     /* Note: the lists are sorted by id */
     while (n || o) {
-        const BinderVoiceCallInfo* nc = n ? n->data : NULL;
-        const BinderVoiceCallInfo* oc = o ? o->data : NULL;
+        BinderVoiceCallInfo* nc = n ? n->data : NULL;
+        BinderVoiceCallInfo* oc = o ? o->data : NULL;
 
         if (oc && (!nc || (nc->oc.id > oc->oc.id))) {
             const guint id = oc->oc.id;
 
             /* old call is gone */
+            oc->timeline.disconnect = g_get_monotonic_time();
+            if (self->dial_time.call_id == id) {
+                memset(&self->dial_time, 0, sizeof(self->dial_time));
+            }
             if (gutil_int_array_remove_all_fast(self->local_release_ids, id)) {
+                binder_voicecall_timeline_done(self, id, &oc->timeline);
                 ofono_voicecall_disconnected(vc, id,
                     OFONO_DISCONNECT_REASON_LOCAL_HANGUP, NULL);
             } else {
@@ -671,6 +818,7 @@ binder_voicecall_set_calls(
 
                 reqdata->self = self;
                 reqdata->cid = id;
+                reqdata->timeline = oc->timeline;
                 radio_request_submit(req2);
                 radio_request_unref(req2);
             }
@@ -680,6 +828,7 @@ binder_voicecall_set_calls(
 
         } else if (nc && (!oc || (nc->oc.id < oc->oc.id))) {
             /* new call, signal it */
+            binder_voicecall_timeline_update(self, nc);
             if (nc->oc.type == OFONO_CALL_MODE_VOICE) {
                 ofono_voicecall_notify(vc, &nc->oc);
                 if (self->cb) {
@@ -697,6 +846,8 @@ binder_voicecall_set_calls(
 
         } else {
             /* Both old and new call exist */
+            nc->timeline = oc->timeline;
+            binder_voicecall_timeline_update(self, nc);
             if (!binder_voicecall_ofono_call_equal(&nc->oc, &oc->oc)) {
                 ofono_voicecall_notify(vc, &nc->oc);
             }
@@ -791,6 +942,22 @@ binder_voicecall_clcc_poll_cb(
     /* Merge the ongoing ext calls since IRadio may not report them */
     binder_voicecall_set_calls(self,
         binder_voicecall_merge_ext_calls(self, list, TRUE));
+
+    if (self->clcc_poll_again) {
+        /* This response may predate the last change, ask again */
+        self->clcc_poll_again = FALSE;
+        binder_voicecall_clcc_poll(self);
+    } else if (self->state_changed_time) {
+        /* The call list is up to date with all indications so far */
+        const guint us = (guint)(g_get_monotonic_time() -
+            self->state_changed_time);
+
+        self->state_changed_time = 0;
+        self->notify_count++;
+        self->notify_total_us += us;
+        self->notify_max_us = MAX(self->notify_max_us, us);
+        DBG_(self, "call state updated in %u us", us);
+    }
 }
 
 static
@@ -820,7 +987,14 @@ void
 binder_voicecall_clcc_poll(
     BinderVoiceCall* self)
 {
-    if (!self->clcc_poll_req) {
+    if (self->clcc_poll_req) {
+        /*
+         * The pending response may or may not reflect the change.
+         * Poll once more when it arrives, no matter how many times
+         * we get here in the meantime.
+         */
+        self->clcc_poll_again = TRUE;
+    } else {
         /* getCurrentCalls(int32 serial); */
         guint32 code = self->interface_aidl == RADIO_VOICE_INTERFACE ?
             RADIO_VOICE_REQ_GET_CURRENT_CALLS :
@@ -833,6 +1007,7 @@ binder_voicecall_clcc_poll(
         radio_request_set_retry_func(req, binder_voicecall_clcc_retry);
         if (radio_request_submit(req)) {
             self->clcc_poll_req = req;
+            self->clcc_polls++;
         } else {
             radio_request_unref(req);
         }
@@ -948,6 +1123,20 @@ binder_voicecall_dial_cb(
     gpointer user_data)
 {
     BinderVoiceCall* self = user_data;
+    BinderVoiceCallDialTime* dt = &self->dial_time;
+    gboolean ok = FALSE;
+
+    dt->resp = g_get_monotonic_time();
+    if (dt->call_id) {
+        /* The call has already shown up */
+        GSList* l = binder_voicecall_find_call_link_with_id(self, dt->call_id);
+
+        if (l) {
+            BinderVoiceCallInfo* call = l->data;
+
+            call->timeline.dial_resp = dt->resp;
+        }
+    }
 
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
@@ -955,6 +1144,7 @@ binder_voicecall_dial_cb(
                 RADIO_VOICE_RESP_DIAL :
                 RADIO_RESP_DIAL;
             if (resp == code) {
+                ok = TRUE;
                 if (self->cb) {
                     /*
                      * CLCC will update the oFono call list with
@@ -976,6 +1166,10 @@ binder_voicecall_dial_cb(
      * successfully by binder_voicecall_clcc_poll_cb, RADIO_REQ_DIAL
      * may still fail.
      */
+    if (!ok) {
+        /* Don't let the next MO call pick up the failed dial time */
+        memset(dt, 0, sizeof(*dt));
+    }
     if (self->cb) {
         struct ofono_error err;
         ofono_voicecall_cb_t cb = self->cb;
@@ -1115,6 +1309,8 @@ binder_voicecall_dial(
     if (radio_request_submit(req)) {
         self->cb = cb;
         self->data = data;
+        memset(&self->dial_time, 0, sizeof(self->dial_time));
+        self->dial_time.sent = g_get_monotonic_time();
     } else {
         struct ofono_error err;
 
@@ -1132,8 +1328,8 @@ binder_voicecall_submit_hangup_req(
 {
     BinderVoiceCall* self = binder_voicecall_get_data(vc);
     RadioRequest* req;
-    const BinderVoiceCallInfo* call =
-        binder_voicecall_find_call_with_id(self, cid);
+    GSList* l = binder_voicecall_find_call_link_with_id(self, cid);
+    BinderVoiceCallInfo* call = l ? l->data : NULL;
 
     /*
      * hangup() for incoming calls doesn't always work the way we would like
@@ -1164,6 +1360,9 @@ binder_voicecall_submit_hangup_req(
     /* Append the call id to the list of calls being released locally */
     GASSERT(!gutil_int_array_contains(self->local_release_ids, cid));
     gutil_int_array_append(self->local_release_ids, cid);
+    if (call && !call->timeline.hangup) {
+        call->timeline.hangup = g_get_monotonic_time();
+    }
 
     /* Request data will be unref'ed when the request is done */
     if (radio_request_submit(req)) {
@@ -1369,10 +1568,17 @@ binder_voicecall_call_state_changed_event(
     RadioClient* client,
     RADIO_IND code,
     const GBinderReader* args,
-    gpointer self)
+    gpointer user_data)
 {
+    BinderVoiceCall* self = user_data;
+
+    self->state_changes++;
+    if (!self->state_changed_time) {
+        self->state_changed_time = g_get_monotonic_time();
+    }
+
     /* Just need to request the call list again */
-    binder_voicecall_clcc_poll((BinderVoiceCall*) self);
+    binder_voicecall_clcc_poll(self);
 }
 
 static
@@ -1582,6 +1788,82 @@ binder_voicecall_send_dtmf_ext_cb(
     }
 }
 
+static
+gboolean
+binder_voicecall_dtmf_pause_done(
+    gpointer user_data)
+{
+    BinderVoiceCall* self = user_data;
+
+    self->dtmf_timer_id = 0;
+    binder_voicecall_send_one_dtmf(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+binder_voicecall_dtmf_tone_done(
+    gpointer user_data)
+{
+    BinderVoiceCall* self = user_data;
+
+    self->dtmf_timer_id = 0;
+    binder_voicecall_dtmf_burst_request(self, NULL);
+    if (gutil_ring_size(self->dtmf_queue) > 0) {
+        self->dtmf_timer_id = g_timeout_add(self->dtmf_pause_ms,
+            binder_voicecall_dtmf_pause_done, self);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+binder_voicecall_send_dtmf_burst(
+    BinderVoiceCall* self)
+{
+    const int n = gutil_ring_size(self->dtmf_queue);
+    char tone[2];
+
+    /* Hand the whole queue over to the extension if there is one */
+    if (self->ext) {
+        char* tones = g_malloc(n + 1);
+        int i;
+
+        for (i = 0; i < n; i++) {
+            gpointer c = gutil_ring_data_at(self->dtmf_queue, i);
+
+            tones[i] = (char)GPOINTER_TO_UINT(c);
+        }
+        tones[n] = 0;
+        self->ext_send_dtmf_id = binder_ext_call_send_dtmf(self->ext, tones,
+            binder_voicecall_send_dtmf_ext_cb, NULL, self);
+        if (self->ext_send_dtmf_id) {
+            DBG_(self, "'%s'", tones);
+            gutil_ring_drop(self->dtmf_queue, n);
+            g_free(tones);
+            return;
+        }
+        g_free(tones);
+    }
+
+    /*
+     * Otherwise play the tones with startDtmf/stopDtmf without waiting
+     * for the responses, the timers define the pace. That's a lot faster
+     * than one sendDtmf round trip (plus the default tone duration) per
+     * digit.
+     */
+    tone[0] = (char)GPOINTER_TO_UINT(gutil_ring_get(self->dtmf_queue));
+    tone[1] = 0;
+    DBG_(self, "'%s' (%d ms)", tone, self->dtmf_tone_ms);
+    if (binder_voicecall_dtmf_burst_request(self, tone)) {
+        self->dtmf_timer_id = g_timeout_add(self->dtmf_tone_ms,
+            binder_voicecall_dtmf_tone_done, self);
+    } else {
+        ofono_error("failed to send dtmf");
+        binder_voicecall_clear_dtmf_queue(self);
+    }
+}
+
 static
 void
 binder_voicecall_send_one_dtmf(
@@ -1589,9 +1871,15 @@ binder_voicecall_send_one_dtmf(
 {
     if (!self->send_dtmf_req &&
         !self->ext_send_dtmf_id &&
+        !self->dtmf_timer_id &&
         gutil_ring_size(self->dtmf_queue) > 0) {
         char tone[2];
 
+        if (self->dtmf_tone_ms) {
+            binder_voicecall_send_dtmf_burst(self);
+            return;
+        }
+
         tone[0] = (char)GPOINTER_TO_UINT(gutil_ring_get(self->dtmf_queue));
         tone[1] = 0;
         DBG_(self, "'%s'", tone);
@@ -2196,6 +2484,72 @@ binder_voicecall_register(
     }
 }
 
+/*==========================================================================*
+ * D-Bus
+ *==========================================================================*/
+
+static
+DBusMessage*
+binder_voicecall_dbus_get_statistics(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderVoiceCall* self = user_data;
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    DBusMessageIter it, array;
+    BINDER_CALL_STAGE stage;
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+        CALL_STATS_DBUS_STATS_SIGNATURE, &array);
+    for (stage = 0; stage < BINDER_CALL_STAGE_COUNT; stage++) {
+        const BinderCallStageStats* stats =
+            binder_call_stats_get(self->stats, stage);
+        const char* name = binder_call_stage_name(stage);
+        const dbus_uint64_t total = stats->total_ms;
+        DBusMessageIter entry;
+
+        dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL,
+            &entry);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &stats->count);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &stats->max_ms);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &stats->last_ms);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &total);
+        binder_histogram_dbus_append(&entry, stats->buckets,
+            BINDER_CALL_STATS_BUCKETS);
+        dbus_message_iter_close_container(&array, &entry);
+    }
+    dbus_message_iter_close_container(&it, &array);
+    return reply;
+}
+
+static
+DBusMessage*
+binder_voicecall_dbus_reset(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderVoiceCall* self = user_data;
+
+    binder_call_stats_reset(self->stats);
+    return dbus_message_new_method_return(msg);
+}
+
+static const GDBusMethodTable binder_voicecall_dbus_methods[] = {
+    { GDBUS_METHOD("GetStatistics", NULL,
+        GDBUS_ARGS({ "stats", "a" CALL_STATS_DBUS_STATS_SIGNATURE }),
+        binder_voicecall_dbus_get_statistics) },
+    { GDBUS_METHOD("Reset", NULL, NULL,
+        binder_voicecall_dbus_reset) },
+    { }
+};
+
 static
 int
 binder_voicecall_probe(
@@ -2211,7 +2565,13 @@ binder_voicecall_probe(
     DBG_(self, "");
 
     self->vc = vc;
+    self->stats = binder_call_stats_new();
+    self->stats_registered = binder_dbus_add_modem_interface(
+        ofono_voicecall_get_modem(vc), CALL_STATS_DBUS_INTERFACE,
+        binder_voicecall_dbus_methods, NULL, self);
     self->dtmf_queue = gutil_ring_new();
+    self->dtmf_tone_ms = cfg->dtmf_tone_ms;
+    self->dtmf_pause_ms = cfg->dtmf_pause_ms;
     self->instance = radio_instance_ref(modem->instance);
     self->g = radio_request_group_new(modem->voice_client); /* Keeps ref to client */
     self->network_client = radio_client_ref(modem->network_client);
@@ -2242,11 +2602,20 @@ binder_voicecall_remove(
 {
     BinderVoiceCall* self = binder_voicecall_get_data(vc);
 
-    DBG_(self, "");
+    DBG_(self, "%u state change(s), %u poll(s)", self->state_changes,
+        self->clcc_polls);
+    if (self->notify_count) {
+        DBG_(self, "call state update latency avg %u us, max %u us",
+            (guint)(self->notify_total_us / self->notify_count),
+            self->notify_max_us);
+    }
     g_slist_free_full(self->calls, binder_voicecall_info_free);
 
     radio_request_drop(self->send_dtmf_req);
     radio_request_drop(self->clcc_poll_req);
+    if (self->dtmf_timer_id) {
+        g_source_remove(self->dtmf_timer_id);
+    }
     radio_client_remove_all_handlers(self->g->client, self->radio_event);
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
@@ -2267,6 +2636,11 @@ binder_voicecall_remove(
     }
 
     binder_ims_reg_unref(self->ims_reg);
+    if (self->stats_registered) {
+        binder_dbus_remove_modem_interface(ofono_voicecall_get_modem(vc),
+            CALL_STATS_DBUS_INTERFACE);
+    }
+    binder_call_stats_free(self->stats);
     g_free(self->log_prefix);
     g_free(self);
 
@@ -0,0 +1,239 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_assign.h"
+#include "binder_log.h"
+
+#include <gutil_log.h>
+
+GLOG_MODULE_DEFINE("unit_assign");
+
+#define MAX_SLOTS (8)
+
+/* Exhaustive search, the way it used to be done */
+
+typedef struct test_brute_force {
+    const int* score;
+    guint n;
+    int best;
+    guint fixed;
+    guint order[MAX_SLOTS];
+} TestBruteForce;
+
+static
+void
+test_brute_force_permutate(
+    TestBruteForce* bf,
+    guint* order,
+    guint k)
+{
+    const guint n = bf->n;
+
+    if (k == n) {
+        int total = 0;
+        guint i, fixed = 0;
+
+        for (i = 0; i < n; i++) {
+            total += bf->score[i * n + order[i]];
+            fixed += (order[i] == i);
+        }
+        if (total > bf->best || (total == bf->best && fixed > bf->fixed)) {
+            bf->best = total;
+            bf->fixed = fixed;
+            memcpy(bf->order, order, sizeof(order[0]) * n);
+        }
+    } else {
+        guint i;
+
+        for (i = k; i < n; i++) {
+            guint tmp = order[k];
+
+            order[k] = order[i];
+            order[i] = tmp;
+            test_brute_force_permutate(bf, order, k + 1);
+            order[i] = order[k];
+            order[k] = tmp;
+        }
+    }
+}
+
+static
+int
+test_brute_force(
+    const int* score,
+    guint n,
+    guint* fixed)
+{
+    TestBruteForce bf;
+    guint order[MAX_SLOTS];
+    guint i;
+
+    memset(&bf, 0, sizeof(bf));
+    bf.score = score;
+    bf.n = n;
+    bf.best = -G_MAXINT;
+    for (i = 0; i < n; i++) order[i] = i;
+    test_brute_force_permutate(&bf, order, 0);
+    *fixed = bf.fixed;
+    return bf.best;
+}
+
+static
+void
+test_random_scores(
+    GRand* rand,
+    int* score,
+    guint n)
+{
+    guint i;
+
+    /* Narrow range to get plenty of ties */
+    for (i = 0; i < n * n; i++) {
+        score[i] = g_rand_int_range(rand, -4, 5);
+    }
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    /* Slot 0 wants what slot 1 has and vice versa */
+    static const int score[] = {
+        -2, 4,
+        3, -1
+    };
+    /* Nobody cares */
+    static const int zero[] = {
+        0, 0, 0,
+        0, 0, 0,
+        0, 0, 0
+    };
+    guint order[3];
+
+    g_assert_cmpint(binder_assign_best(NULL, 0, NULL), == ,0);
+    g_assert_cmpint(binder_assign_best(score, 2, order), == ,7);
+    g_assert_cmpuint(order[0], == ,1);
+    g_assert_cmpuint(order[1], == ,0);
+
+    /* Ties are resolved in favor of the current order */
+    g_assert_cmpint(binder_assign_best(zero, 3, order), == ,0);
+    g_assert_cmpuint(order[0], == ,0);
+    g_assert_cmpuint(order[1], == ,1);
+    g_assert_cmpuint(order[2], == ,2);
+}
+
+/*==========================================================================*
+ * random
+ *==========================================================================*/
+
+static
+void
+test_random(
+    void)
+{
+    GRand* rand = g_rand_new_with_seed(1234);
+    int score[MAX_SLOTS * MAX_SLOTS];
+    guint order[MAX_SLOTS];
+    guint n, k;
+
+    for (n = 1; n <= 6; n++) {
+        for (k = 0; k < 1000; k++) {
+            guint i, fixed = 0, expected_fixed;
+            int expected, best;
+
+            test_random_scores(rand, score, n);
+            expected = test_brute_force(score, n, &expected_fixed);
+            best = binder_assign_best(score, n, order);
+            for (i = 0; i < n; i++) {
+                fixed += (order[i] == i);
+            }
+            g_assert_cmpint(best, == ,expected);
+            g_assert_cmpuint(fixed, == ,expected_fixed);
+        }
+    }
+    g_rand_free(rand);
+}
+
+/*==========================================================================*
+ * benchmark
+ *==========================================================================*/
+
+static
+void
+test_benchmark(
+    void)
+{
+    GRand* rand = g_rand_new_with_seed(4321);
+    int score[MAX_SLOTS * MAX_SLOTS];
+    guint order[MAX_SLOTS];
+    guint n;
+
+    for (n = 2; n <= MAX_SLOTS; n++) {
+        const guint iterations = 1000;
+        gdouble solver, brute;
+        guint fixed, k;
+
+        test_random_scores(rand, score, n);
+        g_test_timer_start();
+        for (k = 0; k < iterations; k++) {
+            binder_assign_best(score, n, order);
+        }
+        solver = g_test_timer_elapsed() / iterations;
+
+        g_test_timer_start();
+        test_brute_force(score, n, &fixed);
+        brute = g_test_timer_elapsed();
+
+        g_test_message("%u slots: solver %.2f us, n! search %.2f us", n,
+            solver * 1e6, brute * 1e6);
+        GDEBUG("%u slots: solver %.2f us, n! search %.2f us", n,
+            solver * 1e6, brute * 1e6);
+    }
+    g_rand_free(rand);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/assign/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("random"), test_random);
+    g_test_add_func(TEST_("benchmark"), test_benchmark);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,162 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_call_stats.h"
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+GLOG_MODULE_DEFINE("unit_call_stats");
+
+#define MS(x) ((x) * 1000)
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    BinderCallTimeline t;
+    BinderCallStats* stats = binder_call_stats_new();
+
+    memset(&t, 0, sizeof(t));
+    binder_call_stats_free(NULL);
+    binder_call_stats_reset(NULL);
+    binder_call_stats_add(NULL, &t);
+    binder_call_stats_add(stats, NULL);
+    g_assert(!binder_call_stats_get(NULL, BINDER_CALL_STAGE_DIAL));
+    g_assert(!binder_call_stats_get(stats, BINDER_CALL_STAGE_COUNT));
+    g_assert(!binder_call_stage_name(BINDER_CALL_STAGE_COUNT));
+    binder_call_stats_free(stats);
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    BinderCallStats* stats = binder_call_stats_new();
+    const BinderCallStageStats* s;
+    BinderCallTimeline t;
+    BINDER_CALL_STAGE stage;
+
+    for (stage = 0; stage < BINDER_CALL_STAGE_COUNT; stage++) {
+        g_assert(binder_call_stage_name(stage));
+        s = binder_call_stats_get(stats, stage);
+        g_assert(s);
+        g_assert_cmpuint(s->count, == ,0);
+    }
+
+    /* Outgoing call, hung up by the other side */
+    memset(&t, 0, sizeof(t));
+    t.dial = MS(1000);
+    t.dial_resp = MS(1100);
+    t.present = MS(1050);
+    t.alerting = MS(3000);
+    t.active = MS(10000);
+    t.disconnect = MS(20000);
+    t.fail_cause = MS(20030);
+    binder_call_stats_add(stats, &t);
+
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_DIAL);
+    g_assert_cmpuint(s->count, == ,1);
+    g_assert_cmpuint(s->last_ms, == ,100);
+    g_assert_cmpuint(s->buckets[7], == ,1); /* [64, 128) */
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_PRESENT);
+    g_assert_cmpuint(s->last_ms, == ,50);
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_ALERTING);
+    g_assert_cmpuint(s->last_ms, == ,2000);
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_ACTIVE);
+    g_assert_cmpuint(s->last_ms, == ,9000);
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_HANGUP);
+    g_assert_cmpuint(s->count, == ,0);
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_FAIL_CAUSE);
+    g_assert_cmpuint(s->count, == ,1);
+    g_assert_cmpuint(s->last_ms, == ,30);
+
+    /* Incoming call, hung up locally */
+    memset(&t, 0, sizeof(t));
+    t.present = MS(1000);
+    t.active = MS(5000);
+    t.hangup = MS(8000);
+    t.disconnect = MS(8000);
+    binder_call_stats_add(stats, &t);
+
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_ACTIVE);
+    g_assert_cmpuint(s->count, == ,1);
+    g_assert_cmpuint(s->last_ms, == ,9000); /* Not touched */
+    g_assert_cmpuint(s->max_ms, == ,9000);
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_HANGUP);
+    g_assert_cmpuint(s->count, == ,1);
+    g_assert_cmpuint(s->buckets[0], == ,1);
+
+    /* Slow one ends up in the last bucket */
+    memset(&t, 0, sizeof(t));
+    t.dial = MS(1000);
+    t.dial_resp = MS(1000000);
+    binder_call_stats_add(stats, &t);
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_DIAL);
+    g_assert_cmpuint(s->count, == ,2);
+    g_assert_cmpuint(s->max_ms, == ,999000);
+    g_assert_cmpuint(s->total_ms, == ,999100);
+    g_assert_cmpuint(s->buckets[BINDER_CALL_STATS_BUCKETS - 1], == ,1);
+
+    /* Time going backwards is ignored */
+    t.dial_resp = MS(500);
+    binder_call_stats_add(stats, &t);
+    g_assert_cmpuint(s->count, == ,2);
+
+    binder_call_stats_reset(stats);
+    s = binder_call_stats_get(stats, BINDER_CALL_STAGE_DIAL);
+    g_assert_cmpuint(s->count, == ,0);
+    g_assert_cmpuint(s->max_ms, == ,0);
+    binder_call_stats_free(stats);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/call_stats/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("basic"), test_basic);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
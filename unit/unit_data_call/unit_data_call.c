@@ -0,0 +1,252 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_data_call.h"
+
+#include <gutil_log.h>
+
+#include <arpa/inet.h>
+
+GLOG_MODULE_DEFINE("unit_data_call");
+
+static
+BinderDataCall*
+test_call_new(
+    const char* ifname,
+    const char* addresses,
+    const char* gateways,
+    const char* dnses,
+    const char* pcscf)
+{
+    BinderDataCallBuilder b;
+
+    binder_data_call_builder_init(&b);
+    b.call.cid = 1;
+    b.call.active = RADIO_DATA_CALL_ACTIVE;
+    b.call.prot = OFONO_GPRS_PROTO_IPV4V6;
+    b.call.mtu = 1500;
+    binder_data_call_builder_set_ifname(&b, ifname);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_ADDRESS, addresses);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_GATEWAY, gateways);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_DNS, dnses);
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_PCSCF, pcscf);
+    return binder_data_call_builder_finish(&b);
+}
+
+static
+void
+test_assert_list(
+    const BinderDataCall* call,
+    BINDER_DATA_ADDR_TYPE type,
+    const char* expected)
+{
+    char* list = binder_data_call_addr_list(call, type);
+
+    g_assert_cmpstr(list, == ,expected);
+    g_free(list);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    guint n = 1;
+
+    binder_data_call_free(NULL);
+    g_assert(!binder_data_call_dup(NULL));
+    g_assert(!binder_data_call_ifname(NULL));
+    g_assert(binder_data_call_equal(NULL, NULL));
+    g_assert(!binder_data_call_addr(NULL, BINDER_DATA_ADDR_DNS, &n));
+    g_assert_cmpuint(n, == ,0);
+    g_assert(binder_data_call_addr_equal(NULL, NULL, BINDER_DATA_ADDR_DNS));
+}
+
+/*==========================================================================*
+ * parse
+ *==========================================================================*/
+
+static
+void
+test_parse(
+    void)
+{
+    static const char v4[] = "10.0.0.1/24";
+    static const char v6[] = "2001:db8::1/64";
+    static const char v6_scope[] = "fe80::1%rmnet_data0/64";
+    static const char v4_scope[] = "10.0.0.1%rmnet_data0";
+    static const char bad_prefix[] = "10.0.0.1/33";
+    char buf[BINDER_DATA_ADDR_STRLEN];
+    BinderDataAddr addr;
+
+    g_assert(binder_data_addr_parse(v4, strlen(v4), &addr));
+    g_assert_cmpuint(addr.family, == ,AF_INET);
+    g_assert_cmpuint(addr.prefix, == ,24);
+    g_assert_cmpstr(binder_data_addr_ntop(&addr, buf), == ,"10.0.0.1");
+    g_assert_cmpstr(binder_data_addr_netmask(&addr, buf), == ,
+        "255.255.255.0");
+
+    /* Only the specified number of characters is parsed */
+    g_assert(binder_data_addr_parse(v4, 8, &addr));
+    g_assert_cmpuint(addr.prefix, == ,0);
+    g_assert(!binder_data_addr_netmask(&addr, buf));
+
+    g_assert(binder_data_addr_parse(v6, strlen(v6), &addr));
+    g_assert_cmpuint(addr.family, == ,AF_INET6);
+    g_assert_cmpuint(addr.prefix, == ,64);
+    g_assert_cmpstr(binder_data_addr_ntop(&addr, buf), == ,"2001:db8::1");
+    g_assert(!binder_data_addr_netmask(&addr, buf));
+
+    /* Scope id is dropped, it's only allowed for IPv6 */
+    g_assert(binder_data_addr_parse(v6_scope, strlen(v6_scope), &addr));
+    g_assert_cmpuint(addr.family, == ,AF_INET6);
+    g_assert_cmpuint(addr.prefix, == ,64);
+    g_assert_cmpstr(binder_data_addr_ntop(&addr, buf), == ,"fe80::1");
+    g_assert(!binder_data_addr_parse(v4_scope, strlen(v4_scope), &addr));
+
+    /* Invalid prefix is ignored */
+    g_assert(binder_data_addr_parse(bad_prefix, strlen(bad_prefix), &addr));
+    g_assert_cmpuint(addr.prefix, == ,0);
+
+    g_assert(!binder_data_addr_parse("", 0, &addr));
+    g_assert(!binder_data_addr_parse("foo", 3, &addr));
+    g_assert(!binder_data_addr_parse("10.0.0", 6, &addr));
+}
+
+/*==========================================================================*
+ * build
+ *==========================================================================*/
+
+static
+void
+test_build(
+    void)
+{
+    BinderDataCall* call = test_call_new("rmnet_data0",
+        " 10.0.0.1/32  2001:db8::1/64 garbage", "10.0.0.254",
+        "8.8.8.8 8.8.4.4 2001:4860:4860::8888", NULL);
+    const BinderDataAddr* addr;
+    guint n;
+
+    g_assert_cmpstr(binder_data_call_ifname(call), == ,"rmnet_data0");
+    g_assert_cmpuint(call->count[BINDER_DATA_ADDR_ADDRESS], == ,2);
+    g_assert_cmpuint(call->count[BINDER_DATA_ADDR_GATEWAY], == ,1);
+    g_assert_cmpuint(call->count[BINDER_DATA_ADDR_DNS], == ,3);
+    g_assert_cmpuint(call->count[BINDER_DATA_ADDR_PCSCF], == ,0);
+    g_assert_cmpuint(call->size, == ,sizeof(*call) + 6 * sizeof(*addr) +
+        sizeof("rmnet_data0"));
+
+    addr = binder_data_call_addr(call, BINDER_DATA_ADDR_DNS, &n);
+    g_assert(addr);
+    g_assert_cmpuint(n, == ,3);
+    g_assert_cmpuint(addr[2].family, == ,AF_INET6);
+    g_assert(!binder_data_call_addr(call, BINDER_DATA_ADDR_PCSCF, &n));
+    g_assert_cmpuint(n, == ,0);
+
+    test_assert_list(call, BINDER_DATA_ADDR_ADDRESS,
+        "10.0.0.1/32 2001:db8::1/64");
+    test_assert_list(call, BINDER_DATA_ADDR_GATEWAY, "10.0.0.254");
+    test_assert_list(call, BINDER_DATA_ADDR_DNS,
+        "8.8.8.8 8.8.4.4 2001:4860:4860::8888");
+    test_assert_list(call, BINDER_DATA_ADDR_PCSCF, "");
+    binder_data_call_free(call);
+
+    /* Interface name isn't limited to IFNAMSIZ */
+    call = test_call_new("this_name_is_way_too_long", NULL, NULL, NULL, NULL);
+    g_assert_cmpstr(binder_data_call_ifname(call), == ,
+        "this_name_is_way_too_long");
+    g_assert_cmpuint(call->size, == ,sizeof(*call) +
+        sizeof("this_name_is_way_too_long"));
+    binder_data_call_free(call);
+
+    /* Missing interface name becomes an empty string */
+    call = test_call_new(NULL, NULL, NULL, NULL, NULL);
+    g_assert_cmpstr(binder_data_call_ifname(call), == ,"");
+    g_assert_cmpuint(call->size, == ,sizeof(*call) + 1);
+    binder_data_call_free(call);
+}
+
+/*==========================================================================*
+ * equal
+ *==========================================================================*/
+
+static
+void
+test_equal(
+    void)
+{
+    BinderDataCall* c1 = test_call_new("rmnet0", "10.0.0.1/32",
+        "10.0.0.254", "8.8.8.8", NULL);
+    BinderDataCall* c2 = binder_data_call_dup(c1);
+    BinderDataCall* c3 = test_call_new("rmnet0", "10.0.0.1/32",
+        "10.0.0.254", "8.8.8.8 8.8.4.4", NULL);
+    BinderDataCall* c4 = test_call_new("rmnet0", "10.0.0.1/32",
+        "10.0.0.254", "8.8.4.4", NULL);
+
+    g_assert(c2 != c1);
+    g_assert(binder_data_call_equal(c1, c1));
+    g_assert(binder_data_call_equal(c1, c2));
+    g_assert(!binder_data_call_equal(c1, NULL));
+    g_assert(!binder_data_call_equal(c1, c3));
+    g_assert(!binder_data_call_equal(c1, c4));
+
+    g_assert(binder_data_call_addr_equal(c1, c3, BINDER_DATA_ADDR_ADDRESS));
+    g_assert(binder_data_call_addr_equal(c1, c3, BINDER_DATA_ADDR_GATEWAY));
+    g_assert(!binder_data_call_addr_equal(c1, c3, BINDER_DATA_ADDR_DNS));
+    g_assert(!binder_data_call_addr_equal(c1, c4, BINDER_DATA_ADDR_DNS));
+    g_assert(binder_data_call_addr_equal(c1, c4, BINDER_DATA_ADDR_PCSCF));
+
+    c2->mtu = 1400;
+    g_assert(!binder_data_call_equal(c1, c2));
+
+    binder_data_call_free(c1);
+    binder_data_call_free(c2);
+    binder_data_call_free(c3);
+    binder_data_call_free(c4);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/data_call/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("parse"), test_parse);
+    g_test_add_func(TEST_("build"), test_build);
+    g_test_add_func(TEST_("equal"), test_equal);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
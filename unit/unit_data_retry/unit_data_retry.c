@@ -0,0 +1,251 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_data_retry.h"
+
+#include <gutil_log.h>
+
+GLOG_MODULE_DEFINE("unit_data_retry");
+
+#define TEST_APN "internet"
+#define TEST_APN2 "mms"
+
+typedef struct test_find_stats {
+    const char* apn;
+    const BinderDataRetryStats* stats;
+} TestFindStats;
+
+static
+void
+test_find_stats_cb(
+    const char* apn,
+    const BinderDataRetryStats* stats,
+    void* user_data)
+{
+    TestFindStats* find = user_data;
+
+    if (!g_ascii_strcasecmp(apn, find->apn)) {
+        g_assert(!find->stats);
+        find->stats = stats;
+    }
+}
+
+static
+const BinderDataRetryStats*
+test_find_stats(
+    BinderDataRetry* retry,
+    const char* apn)
+{
+    TestFindStats find;
+
+    find.apn = apn;
+    find.stats = NULL;
+    binder_data_retry_foreach_stats(retry, test_find_stats_cb, &find);
+    return find.stats;
+}
+
+static
+void
+test_count_stats(
+    const char* apn,
+    const BinderDataRetryStats* stats,
+    void* user_data)
+{
+    (*(int*)user_data)++;
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    binder_data_retry_free(NULL);
+    binder_data_retry_attempt(NULL, TEST_APN);
+    binder_data_retry_done(NULL, TEST_APN, TRUE);
+    binder_data_retry_reset(NULL, TEST_APN);
+    binder_data_retry_foreach_stats(NULL, NULL, NULL);
+    g_assert(!test_find_stats(NULL, TEST_APN));
+    g_assert_cmpint(binder_data_retry_delay(NULL, TEST_APN, -1), == ,
+        BINDER_DATA_RETRY_NONE);
+}
+
+/*==========================================================================*
+ * backoff
+ *==========================================================================*/
+
+static
+void
+test_backoff(
+    void)
+{
+    BinderDataRetry* retry = binder_data_retry_new(5, 100, 300);
+    const BinderDataRetryStats* stats;
+    int ms;
+
+    /* Unknown APN */
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, -1), == ,
+        BINDER_DATA_RETRY_NONE);
+
+    /* First retry is immediate */
+    binder_data_retry_attempt(retry, TEST_APN);
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, -1), == ,0);
+
+    /* Then [50..100], [100..200] and then capped at [150..300] */
+    binder_data_retry_attempt(retry, TEST_APN);
+    ms = binder_data_retry_delay(retry, TEST_APN, -1);
+    g_assert_cmpint(ms, >= ,50);
+    g_assert_cmpint(ms, <= ,100);
+
+    binder_data_retry_attempt(retry, TEST_APN);
+    ms = binder_data_retry_delay(retry, TEST_APN, -1);
+    g_assert_cmpint(ms, >= ,100);
+    g_assert_cmpint(ms, <= ,200);
+
+    binder_data_retry_attempt(retry, TEST_APN);
+    ms = binder_data_retry_delay(retry, TEST_APN, -1);
+    g_assert_cmpint(ms, >= ,150);
+    g_assert_cmpint(ms, <= ,300);
+
+    /* Modem's suggestion wins, but is kept within [100..300] */
+    binder_data_retry_attempt(retry, TEST_APN);
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, 200), == ,
+        200);
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, 5000), == ,
+        300);
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, 0), == ,
+        100);
+
+    /* That was the last one */
+    binder_data_retry_attempt(retry, TEST_APN);
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, -1), == ,
+        BINDER_DATA_RETRY_NONE);
+    binder_data_retry_done(retry, TEST_APN, FALSE);
+
+    stats = test_find_stats(retry, TEST_APN);
+    g_assert(stats);
+    g_assert_cmpuint(stats->attempts, == ,6);
+    g_assert_cmpuint(stats->retries, == ,5);
+    g_assert_cmpuint(stats->failed, == ,1);
+    g_assert_cmpuint(stats->connected, == ,0);
+
+    /* Done with it */
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, -1), == ,
+        BINDER_DATA_RETRY_NONE);
+    binder_data_retry_free(retry);
+}
+
+/*==========================================================================*
+ * never
+ *==========================================================================*/
+
+static
+void
+test_never(
+    void)
+{
+    BinderDataRetry* retry = binder_data_retry_new(5, 100, 300);
+
+    /* INT_MAX means no retry */
+    binder_data_retry_attempt(retry, TEST_APN);
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN, G_MAXINT32),
+        == ,BINDER_DATA_RETRY_NONE);
+    binder_data_retry_free(retry);
+}
+
+/*==========================================================================*
+ * connect
+ *==========================================================================*/
+
+static
+void
+test_connect(
+    void)
+{
+    BinderDataRetry* retry = binder_data_retry_new(2, 100, 1000);
+    const BinderDataRetryStats* stats;
+    int n = 0;
+
+    /* APN names are case insensitive */
+    binder_data_retry_attempt(retry, TEST_APN);
+    binder_data_retry_attempt(retry, "Internet");
+    binder_data_retry_done(retry, "INTERNET", TRUE);
+
+    stats = test_find_stats(retry, TEST_APN);
+    g_assert(stats);
+    g_assert_cmpuint(stats->attempts, == ,2);
+    g_assert_cmpuint(stats->retries, == ,1);
+    g_assert_cmpuint(stats->connected, == ,1);
+    g_assert_cmpuint(stats->max_attempts, == ,2);
+    g_assert_cmpuint(stats->failed, == ,0);
+
+    /* Second done is ignored */
+    binder_data_retry_done(retry, TEST_APN, FALSE);
+    g_assert_cmpuint(stats->failed, == ,0);
+
+    /* Reset starts a new sequence without touching the stats */
+    binder_data_retry_attempt(retry, TEST_APN2);
+    binder_data_retry_attempt(retry, TEST_APN2);
+    binder_data_retry_reset(retry, TEST_APN2);
+    binder_data_retry_reset(retry, "foo");
+    binder_data_retry_attempt(retry, TEST_APN2);
+    g_assert_cmpint(binder_data_retry_delay(retry, TEST_APN2, -1), == ,0);
+    stats = test_find_stats(retry, TEST_APN2);
+    g_assert_cmpuint(stats->attempts, == ,3);
+    g_assert_cmpuint(stats->retries, == ,1);
+
+    /* NULL APN is fine too */
+    binder_data_retry_attempt(retry, NULL);
+    binder_data_retry_done(retry, NULL, TRUE);
+    g_assert(test_find_stats(retry, ""));
+
+    binder_data_retry_foreach_stats(retry, NULL, NULL);
+    binder_data_retry_foreach_stats(retry, test_count_stats, &n);
+    g_assert_cmpint(n, == ,3);
+    binder_data_retry_free(retry);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/data_retry/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("backoff"), test_backoff);
+    g_test_add_func(TEST_("never"), test_never);
+    g_test_add_func(TEST_("connect"), test_connect);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,204 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_keepalive_params.h"
+
+#include <gutil_log.h>
+
+#include <arpa/inet.h>
+
+GLOG_MODULE_DEFINE("unit_keepalive");
+
+#define TEST_CID 1
+#define TEST_SRC4 "10.0.0.1"
+#define TEST_DST4 "192.0.2.1"
+#define TEST_SRC6 "2001:db8::1"
+#define TEST_DST6 "2001:db8::2"
+#define TEST_PORT 4500
+#define TEST_INTERVAL BINDER_KEEPALIVE_MIN_INTERVAL_MS
+
+static
+BinderDataCall*
+test_call_new(
+    int cid,
+    const char* addresses)
+{
+    BinderDataCallBuilder b;
+
+    binder_data_call_builder_init(&b);
+    b.call.cid = cid;
+    b.call.active = RADIO_DATA_CALL_ACTIVE;
+    b.call.prot = OFONO_GPRS_PROTO_IPV4V6;
+    binder_data_call_builder_set_ifname(&b, "rmnet_data0");
+    binder_data_call_builder_add(&b, BINDER_DATA_ADDR_ADDRESS, addresses);
+    return binder_data_call_builder_finish(&b);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    BinderKeepaliveParams params;
+
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, NULL,
+        TEST_PORT, NULL, TEST_PORT, TEST_INTERVAL));
+    g_assert_cmpint(params.cid, == ,0);
+    g_assert_cmpuint(params.src.family, == ,0);
+    g_assert(!binder_keepalive_params_match_call(&params, NULL));
+}
+
+/*==========================================================================*
+ * init
+ *==========================================================================*/
+
+static
+void
+test_init(
+    void)
+{
+    BinderKeepaliveParams params;
+
+    g_assert(binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, TEST_DST4, TEST_PORT + 1, TEST_INTERVAL));
+    g_assert_cmpint(params.cid, == ,TEST_CID);
+    g_assert_cmpuint(params.src.family, == ,AF_INET);
+    g_assert_cmpuint(params.dst.family, == ,AF_INET);
+    g_assert_cmpuint(params.src_port, == ,TEST_PORT);
+    g_assert_cmpuint(params.dst_port, == ,TEST_PORT + 1);
+    g_assert_cmpuint(params.interval_ms, == ,TEST_INTERVAL);
+    g_assert_cmpuint(binder_keepalive_params_addr_size(&params), == ,4);
+
+    g_assert(binder_keepalive_params_init(&params, TEST_CID, TEST_SRC6,
+        TEST_PORT, TEST_DST6, TEST_PORT, BINDER_KEEPALIVE_MAX_INTERVAL_MS));
+    g_assert_cmpuint(params.src.family, == ,AF_INET6);
+    g_assert_cmpuint(binder_keepalive_params_addr_size(&params), == ,16);
+
+    /* Link-local source with the scope id */
+    g_assert(binder_keepalive_params_init(&params, TEST_CID,
+        "fe80::1%rmnet_data0", TEST_PORT, TEST_DST6, TEST_PORT,
+        TEST_INTERVAL));
+}
+
+/*==========================================================================*
+ * invalid
+ *==========================================================================*/
+
+static
+void
+test_invalid(
+    void)
+{
+    BinderKeepaliveParams params;
+
+    /* Out of range cid and ports */
+    g_assert(!binder_keepalive_params_init(&params, (guint)G_MAXINT32 + 1,
+        TEST_SRC4, TEST_PORT, TEST_DST4, TEST_PORT, TEST_INTERVAL));
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        0, TEST_DST4, TEST_PORT, TEST_INTERVAL));
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, TEST_DST4, 0, TEST_INTERVAL));
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, TEST_DST4, G_MAXUINT16 + 1, TEST_INTERVAL));
+
+    /* Interval is limited from both sides */
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, TEST_DST4, TEST_PORT,
+        BINDER_KEEPALIVE_MIN_INTERVAL_MS - 1));
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, TEST_DST4, TEST_PORT,
+        BINDER_KEEPALIVE_MAX_INTERVAL_MS + 1));
+
+    /* Garbage and mixed address families */
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, "foo",
+        TEST_PORT, TEST_DST4, TEST_PORT, TEST_INTERVAL));
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, "", TEST_PORT, TEST_INTERVAL));
+    g_assert(!binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, TEST_DST6, TEST_PORT, TEST_INTERVAL));
+
+    /* Failure leaves nothing behind */
+    g_assert_cmpint(params.cid, == ,0);
+    g_assert_cmpuint(params.src.family, == ,0);
+}
+
+/*==========================================================================*
+ * match
+ *==========================================================================*/
+
+static
+void
+test_match(
+    void)
+{
+    BinderDataCall* call = test_call_new(TEST_CID,
+        TEST_SRC4 "/24 " TEST_SRC6 "/64");
+    BinderDataCall* other = test_call_new(TEST_CID + 1, TEST_SRC4 "/24");
+    BinderDataCall* empty = test_call_new(TEST_CID, NULL);
+    BinderKeepaliveParams params;
+
+    g_assert(binder_keepalive_params_init(&params, TEST_CID, TEST_SRC4,
+        TEST_PORT, TEST_DST4, TEST_PORT, TEST_INTERVAL));
+    g_assert(binder_keepalive_params_match_call(&params, call));
+    g_assert(!binder_keepalive_params_match_call(&params, other));
+    g_assert(!binder_keepalive_params_match_call(&params, empty));
+
+    g_assert(binder_keepalive_params_init(&params, TEST_CID, TEST_SRC6,
+        TEST_PORT, TEST_DST6, TEST_PORT, TEST_INTERVAL));
+    g_assert(binder_keepalive_params_match_call(&params, call));
+
+    /* Address which doesn't belong to the call */
+    g_assert(binder_keepalive_params_init(&params, TEST_CID, "10.0.0.2",
+        TEST_PORT, TEST_DST4, TEST_PORT, TEST_INTERVAL));
+    g_assert(!binder_keepalive_params_match_call(&params, call));
+
+    binder_data_call_free(call);
+    binder_data_call_free(other);
+    binder_data_call_free(empty);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/keepalive/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("init"), test_init);
+    g_test_add_func(TEST_("invalid"), test_invalid);
+    g_test_add_func(TEST_("match"), test_match);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,251 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_oper_cache.h"
+
+#include <gutil_log.h>
+#include <glib/gstdio.h>
+
+GLOG_MODULE_DEFINE("unit_oper_cache");
+
+#define TEST_FILE "oper"
+#define TEST_MAX_AGE (60*60)
+
+static
+void
+test_assert_name(
+    BinderOperCache* cache,
+    const char* mcc,
+    const char* mnc,
+    const char* expected)
+{
+    const char* name = "?";
+
+    g_assert(binder_oper_cache_get(cache, mcc, mnc, &name));
+    g_assert_cmpstr(name, == ,expected);
+    g_assert(binder_oper_cache_get(cache, mcc, mnc, NULL));
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    binder_oper_cache_free(NULL);
+    binder_oper_cache_put(NULL, "244", "91", "Telia");
+    binder_oper_cache_save(NULL);
+    g_assert(!binder_oper_cache_get(NULL, "244", "91", NULL));
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    BinderOperCache* cache = binder_oper_cache_new(NULL, TEST_MAX_AGE);
+
+    g_assert(!binder_oper_cache_get(cache, "244", "91", NULL));
+    binder_oper_cache_put(cache, "244", "91", "Telia");
+    binder_oper_cache_put(cache, "244", "91", "Telia");
+    test_assert_name(cache, "244", "91", "Telia");
+
+    /* Negative result is cached too */
+    binder_oper_cache_put(cache, "250", "99", NULL);
+    test_assert_name(cache, "250", "99", NULL);
+
+    /* And can be replaced */
+    binder_oper_cache_put(cache, "250", "99", "Beeline");
+    test_assert_name(cache, "250", "99", "Beeline");
+
+    /* Invalid keys are ignored */
+    binder_oper_cache_put(cache, NULL, "91", "Foo");
+    binder_oper_cache_put(cache, "244", "", "Foo");
+    binder_oper_cache_put(cache, "24x", "91", "Foo");
+    binder_oper_cache_put(cache, "../", "91", "Foo");
+    binder_oper_cache_put(cache, "2440", "910", "Foo");
+    g_assert(!binder_oper_cache_get(cache, NULL, "91", NULL));
+    g_assert(!binder_oper_cache_get(cache, "24x", "91", NULL));
+    g_assert(!binder_oper_cache_get(cache, "2440", "910", NULL));
+
+    /* Nothing to save */
+    binder_oper_cache_save(cache);
+    binder_oper_cache_free(cache);
+}
+
+/*==========================================================================*
+ * persist
+ *==========================================================================*/
+
+static
+void
+test_persist(
+    void)
+{
+    char* dir = g_dir_make_tmp("unit_oper_cache_XXXXXX", NULL);
+    char* file = g_build_filename(dir, TEST_FILE, NULL);
+    BinderOperCache* cache = binder_oper_cache_new(file, TEST_MAX_AGE);
+
+    /* Nothing gets written until there's something to write */
+    binder_oper_cache_save(cache);
+    g_assert(!g_file_test(file, G_FILE_TEST_EXISTS));
+
+    binder_oper_cache_put(cache, "244", "91", "Telia");
+    binder_oper_cache_put(cache, "250", "99", NULL);
+    binder_oper_cache_save(cache);
+    g_assert(g_file_test(file, G_FILE_TEST_EXISTS));
+    binder_oper_cache_free(cache);
+
+    /* Load it back */
+    cache = binder_oper_cache_new(file, TEST_MAX_AGE);
+    test_assert_name(cache, "244", "91", "Telia");
+    test_assert_name(cache, "250", "99", NULL);
+    g_assert(!binder_oper_cache_get(cache, "244", "05", NULL));
+
+    /* Free saves the changes */
+    binder_oper_cache_put(cache, "244", "05", "Elisa");
+    binder_oper_cache_free(cache);
+
+    cache = binder_oper_cache_new(file, TEST_MAX_AGE);
+    test_assert_name(cache, "244", "05", "Elisa");
+    test_assert_name(cache, "244", "91", "Telia");
+    binder_oper_cache_free(cache);
+
+    g_unlink(file);
+    g_rmdir(dir);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * stale
+ *==========================================================================*/
+
+static
+void
+test_stale(
+    void)
+{
+    char* dir = g_dir_make_tmp("unit_oper_cache_XXXXXX", NULL);
+    char* file = g_build_filename(dir, TEST_FILE, NULL);
+    const gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    char* contents = g_strdup_printf("[Cache]\nCreated=%" G_GINT64_FORMAT
+        "\n[Operators]\n24491=Telia\n", now - 2 * TEST_MAX_AGE);
+    BinderOperCache* cache;
+
+    g_assert(g_file_set_contents(file, contents, -1, NULL));
+    cache = binder_oper_cache_new(file, TEST_MAX_AGE);
+    g_assert(!binder_oper_cache_get(cache, "244", "91", NULL));
+
+    /* Stale file gets overwritten */
+    binder_oper_cache_free(cache);
+    cache = binder_oper_cache_new(file, 2 * TEST_MAX_AGE + 60);
+    g_assert(!binder_oper_cache_get(cache, "244", "91", NULL));
+    binder_oper_cache_free(cache);
+
+    /* Timestamp from the future is no good either */
+    g_free(contents);
+    contents = g_strdup_printf("[Cache]\nCreated=%" G_GINT64_FORMAT
+        "\n[Operators]\n24491=Telia\n", now + TEST_MAX_AGE);
+    g_assert(g_file_set_contents(file, contents, -1, NULL));
+    cache = binder_oper_cache_new(file, TEST_MAX_AGE);
+    g_assert(!binder_oper_cache_get(cache, "244", "91", NULL));
+    binder_oper_cache_free(cache);
+
+    g_unlink(file);
+    g_rmdir(dir);
+    g_free(contents);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * expire
+ *==========================================================================*/
+
+static
+void
+test_expire(
+    void)
+{
+    char* dir = g_dir_make_tmp("unit_oper_cache_XXXXXX", NULL);
+    char* file = g_build_filename(dir, TEST_FILE, NULL);
+    const gint64 now = g_get_real_time() / G_USEC_PER_SEC;
+    char* contents = g_strdup_printf("[Cache]\nCreated=%" G_GINT64_FORMAT
+        "\n[Operators]\n24491=Telia\n", now - TEST_MAX_AGE + 1);
+    BinderOperCache* cache;
+
+    /* The file is still fresh when it's loaded */
+    g_assert(g_file_set_contents(file, contents, -1, NULL));
+    cache = binder_oper_cache_new(file, TEST_MAX_AGE);
+    test_assert_name(cache, "244", "91", "Telia");
+
+    /* But then it expires in memory */
+    g_usleep(G_USEC_PER_SEC);
+    g_assert(!binder_oper_cache_get(cache, "244", "91", NULL));
+    binder_oper_cache_put(cache, "244", "05", "Elisa");
+    test_assert_name(cache, "244", "05", "Elisa");
+    binder_oper_cache_free(cache);
+
+    /* And the new generation is what gets saved */
+    cache = binder_oper_cache_new(file, TEST_MAX_AGE);
+    g_assert(!binder_oper_cache_get(cache, "244", "91", NULL));
+    test_assert_name(cache, "244", "05", "Elisa");
+    binder_oper_cache_free(cache);
+
+    g_unlink(file);
+    g_rmdir(dir);
+    g_free(contents);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/oper_cache/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("persist"), test_persist);
+    g_test_add_func(TEST_("stale"), test_stale);
+    g_test_add_func(TEST_("expire"), test_expire);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
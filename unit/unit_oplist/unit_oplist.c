@@ -0,0 +1,167 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_oplist.h"
+
+#include <ofono/netreg.h>
+
+#include <gutil_log.h>
+
+GLOG_MODULE_DEFINE("unit_oplist");
+
+static
+BinderOpList*
+test_append(
+    BinderOpList* oplist,
+    const char* mcc,
+    const char* mnc,
+    const char* name,
+    int status,
+    enum ofono_access_technology tech)
+{
+    struct ofono_network_operator op;
+
+    memset(&op, 0, sizeof(op));
+    g_strlcpy(op.mcc, mcc, sizeof(op.mcc));
+    g_strlcpy(op.mnc, mnc, sizeof(op.mnc));
+    g_strlcpy(op.name, name, sizeof(op.name));
+    op.status = status;
+    op.tech = tech;
+    return binder_oplist_append(oplist, &op);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    BinderOpList* oplist = binder_oplist_new();
+
+    g_assert_cmpuint(binder_oplist_merge(NULL, 0), == ,0);
+    g_assert_cmpuint(binder_oplist_merge(oplist, 0), == ,0);
+    g_assert_cmpuint(binder_oplist_merge(oplist, 1), == ,0);
+    binder_oplist_free(oplist);
+    binder_oplist_free(NULL);
+}
+
+/*==========================================================================*
+ * merge
+ *==========================================================================*/
+
+static
+void
+test_merge(
+    void)
+{
+    BinderOpList* oplist = NULL;
+
+    oplist = test_append(oplist, "244", "05", "",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    oplist = test_append(oplist, "244", "05", "Elisa",
+        OFONO_OPERATOR_STATUS_CURRENT, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    oplist = test_append(oplist, "244", "05", "Elisa",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_UTRAN);
+    oplist = test_append(oplist, "244", "91", "Telia",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    oplist = test_append(oplist, "244", "91", "Telia",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+
+    /* Same MCC/MNC on a different technology is a different entry */
+    g_assert_cmpuint(binder_oplist_merge(oplist, 0), == ,3);
+    g_assert_cmpuint(oplist->count, == ,3);
+    g_assert_cmpstr(oplist->op[0].name, == ,"Elisa");
+    g_assert_cmpint(oplist->op[0].status, == ,OFONO_OPERATOR_STATUS_CURRENT);
+    g_assert_cmpint(oplist->op[1].tech, == ,OFONO_ACCESS_TECHNOLOGY_UTRAN);
+    g_assert_cmpstr(oplist->op[2].mnc, == ,"91");
+
+    /* Nothing left to merge */
+    g_assert_cmpuint(binder_oplist_merge(oplist, oplist->count), == ,0);
+    g_assert_cmpuint(binder_oplist_merge(oplist, 0), == ,3);
+    g_assert_cmpuint(oplist->count, == ,3);
+    binder_oplist_free(oplist);
+}
+
+/*==========================================================================*
+ * tail
+ *==========================================================================*/
+
+static
+void
+test_tail(
+    void)
+{
+    BinderOpList* oplist = NULL;
+
+    oplist = test_append(oplist, "244", "05", "Elisa",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    oplist = test_append(oplist, "244", "91", "Telia",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    g_assert_cmpuint(binder_oplist_merge(oplist, 0), == ,2);
+
+    /*
+     * The tail which arrived after the first two entries had been
+     * reported. Duplicates only update what's already there.
+     */
+    oplist = test_append(oplist, "244", "91", "Telia",
+        OFONO_OPERATOR_STATUS_CURRENT, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    oplist = test_append(oplist, "244", "12", "DNA",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    oplist = test_append(oplist, "244", "12", "DNA",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    g_assert_cmpuint(binder_oplist_merge(oplist, 2), == ,1);
+    g_assert_cmpuint(oplist->count, == ,3);
+    g_assert_cmpint(oplist->op[1].status, == ,OFONO_OPERATOR_STATUS_CURRENT);
+    g_assert_cmpstr(oplist->op[2].name, == ,"DNA");
+
+    /* The tail may consist of nothing but duplicates */
+    oplist = test_append(oplist, "244", "05", "Elisa",
+        OFONO_OPERATOR_STATUS_AVAILABLE, OFONO_ACCESS_TECHNOLOGY_EUTRAN);
+    g_assert_cmpuint(binder_oplist_merge(oplist, 3), == ,0);
+    g_assert_cmpuint(oplist->count, == ,3);
+    binder_oplist_free(oplist);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/oplist/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("merge"), test_merge);
+    g_test_add_func(TEST_("tail"), test_tail);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,380 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_record.h"
+
+#include <gutil_log.h>
+
+#include <glib/gstdio.h>
+
+GLOG_MODULE_DEFINE("unit_record");
+
+#define TEST_REC_SIZE(data) BINDER_RECORD_ALIGN(sizeof(BinderRecordHeader) + \
+    (data))
+
+static
+void
+test_put(
+    BinderRecordRing* ring,
+    BINDER_RECORD_TYPE type,
+    guint32 code,
+    guint32 serial,
+    gint64 time,
+    const void* data,
+    gsize size)
+{
+    BinderRecordHeader rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.type = type;
+    rec.code = code;
+    rec.serial = serial;
+    rec.time = time;
+    binder_record_ring_put(ring, &rec, data, size);
+}
+
+typedef struct test_capture {
+    GBytes* bytes;
+    GPtrArray* records;
+} TestCapture;
+
+static
+TestCapture*
+test_capture_new(
+    GBytes* bytes)
+{
+    TestCapture* capture = g_new0(TestCapture, 1);
+    gsize size;
+    const guint8* ptr = g_bytes_get_data(bytes, &size);
+    const guint8* end = ptr + size;
+    const BinderRecordFileHeader* fh = (const BinderRecordFileHeader*)ptr;
+
+    capture->bytes = g_bytes_ref(bytes);
+    capture->records = g_ptr_array_new();
+
+    g_assert_cmpuint(size, >= ,sizeof(*fh));
+    g_assert(!memcmp(fh->magic, BINDER_RECORD_MAGIC, sizeof(fh->magic)));
+    g_assert_cmpuint(fh->version, == ,BINDER_RECORD_VERSION);
+    g_assert_cmpuint(fh->header_size, == ,sizeof(BinderRecordHeader));
+    for (ptr += sizeof(*fh); ptr < end; ) {
+        const BinderRecordHeader* rec = (const BinderRecordHeader*)ptr;
+
+        g_assert_cmpuint(end - ptr, >= ,sizeof(*rec));
+        g_assert_cmpuint(rec->size, == ,BINDER_RECORD_ALIGN(sizeof(*rec) +
+            rec->saved_size));
+        g_assert_cmpuint(rec->size, <= ,end - ptr);
+        g_ptr_array_add(capture->records, (gpointer)rec);
+        ptr += rec->size;
+    }
+    return capture;
+}
+
+static
+TestCapture*
+test_capture_ring(
+    BinderRecordRing* ring)
+{
+    GBytes* bytes = binder_record_ring_capture(ring);
+    TestCapture* capture = test_capture_new(bytes);
+
+    g_bytes_unref(bytes);
+    return capture;
+}
+
+static
+TestCapture*
+test_capture_file(
+    const char* path)
+{
+    TestCapture* capture;
+    gchar* contents;
+    gsize len;
+    GBytes* bytes;
+
+    g_assert(g_file_get_contents(path, &contents, &len, NULL));
+    bytes = g_bytes_new_take(contents, len);
+    capture = test_capture_new(bytes);
+    g_bytes_unref(bytes);
+    return capture;
+}
+
+static
+void
+test_capture_free(
+    TestCapture* capture)
+{
+    g_ptr_array_free(capture->records, TRUE);
+    g_bytes_unref(capture->bytes);
+    g_free(capture);
+}
+
+static
+guint
+test_capture_count(
+    TestCapture* capture)
+{
+    return capture->records->len;
+}
+
+static
+const BinderRecordHeader*
+test_capture_record(
+    TestCapture* capture,
+    guint i,
+    const void** data)
+{
+    if (i < capture->records->len) {
+        const BinderRecordHeader* rec = capture->records->pdata[i];
+
+        if (data) {
+            *data = rec->saved_size ? (rec + 1) : NULL;
+        }
+        return rec;
+    }
+    return NULL;
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    g_assert(!binder_record_ring_new(0, 0));
+    g_assert(!binder_record_ring_new(sizeof(BinderRecordHeader) - 1, 0));
+    g_assert(!binder_record_ring_add_instance(NULL, 0, RADIO_INTERFACE_NONE,
+        RADIO_AIDL_INTERFACE_NONE, NULL));
+    g_assert(!binder_record_ring_capture(NULL));
+    g_assert_cmpuint(binder_record_ring_used(NULL), == ,0);
+    binder_record_ring_remove_instance(NULL, NULL);
+    binder_record_ring_free(NULL);
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    static const guint8 req[] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    static const guint8 ind[] = { 0x06, 0x07 };
+    BinderRecordRing* ring = binder_record_ring_new(1024, 256);
+    BinderRecordInstance* slot1;
+    const BinderRecordHeader* rec;
+    const void* data;
+    TestCapture* capture;
+
+    slot1 = binder_record_ring_add_instance(ring, 0, RADIO_INTERFACE_1_4,
+        RADIO_AIDL_INTERFACE_NONE, "slot1");
+    binder_record_ring_add_instance(ring, 1, RADIO_INTERFACE_1_4,
+        RADIO_AIDL_INTERFACE_NONE, "slot2");
+    test_put(ring, BINDER_RECORD_REQ, 1, 100, 1000, req, sizeof(req));
+    test_put(ring, BINDER_RECORD_ACK, 0, 100, 2000, NULL, 0);
+    test_put(ring, BINDER_RECORD_IND, 2, 0, 3000, ind, sizeof(ind));
+    g_assert_cmpuint(binder_record_ring_used(ring), == ,
+        TEST_REC_SIZE(sizeof(req)) + TEST_REC_SIZE(0) +
+        TEST_REC_SIZE(sizeof(ind)));
+
+    /* The removed instance doesn't get saved */
+    binder_record_ring_remove_instance(ring, slot1);
+    capture = test_capture_ring(ring);
+    g_assert_cmpuint(test_capture_count(capture), == ,4);
+
+    rec = test_capture_record(capture, 0, &data);
+    g_assert_cmpuint(rec->type, == ,BINDER_RECORD_INSTANCE);
+    g_assert_cmpuint(rec->slot, == ,1);
+    g_assert_cmpint(rec->iface, == ,RADIO_AIDL_INTERFACE_NONE);
+    g_assert_cmpuint(rec->code, == ,RADIO_INTERFACE_1_4);
+    g_assert_cmpstr(data, == ,"slot2");
+
+    rec = test_capture_record(capture, 1, &data);
+    g_assert_cmpuint(rec->type, == ,BINDER_RECORD_REQ);
+    g_assert_cmpuint(rec->code, == ,1);
+    g_assert_cmpuint(rec->serial, == ,100);
+    g_assert_cmpuint(rec->data_size, == ,sizeof(req));
+    g_assert_cmpuint(rec->saved_size, == ,sizeof(req));
+    g_assert(!(rec->flags & BINDER_RECORD_TRUNCATED));
+    g_assert(!memcmp(data, req, sizeof(req)));
+
+    rec = test_capture_record(capture, 2, &data);
+    g_assert_cmpuint(rec->type, == ,BINDER_RECORD_ACK);
+    g_assert_cmpuint(rec->serial, == ,100);
+    g_assert(!data);
+
+    rec = test_capture_record(capture, 3, &data);
+    g_assert_cmpuint(rec->type, == ,BINDER_RECORD_IND);
+    g_assert(!memcmp(data, ind, sizeof(ind)));
+    g_assert(!test_capture_record(capture, 4, NULL));
+
+    test_capture_free(capture);
+    binder_record_ring_free(ring);
+}
+
+/*==========================================================================*
+ * wrap
+ *==========================================================================*/
+
+static
+void
+test_wrap(
+    void)
+{
+    /* Room for 3.5 records, so that headers end up wrapping */
+    const gsize rec_size = TEST_REC_SIZE(sizeof(guint32));
+    BinderRecordRing* ring = binder_record_ring_new(rec_size * 7 / 2, 256);
+    TestCapture* capture;
+    guint32 i;
+
+    for (i = 0; i < 10; i++) {
+        test_put(ring, BINDER_RECORD_REQ, 1, i, i, &i, sizeof(i));
+        g_assert_cmpuint(binder_record_ring_used(ring), == ,
+            MIN(i + 1, 3) * rec_size);
+    }
+
+    /* Only the last 3 records survive */
+    capture = test_capture_ring(ring);
+    g_assert_cmpuint(test_capture_count(capture), == ,3);
+    for (i = 0; i < 3; i++) {
+        const void* data;
+        const BinderRecordHeader* rec = test_capture_record(capture, i, &data);
+
+        g_assert_cmpuint(rec->serial, == ,7 + i);
+        g_assert_cmpuint(*(guint32*)data, == ,7 + i);
+    }
+
+    test_capture_free(capture);
+    binder_record_ring_free(ring);
+}
+
+/*==========================================================================*
+ * truncate
+ *==========================================================================*/
+
+static
+void
+test_truncate(
+    void)
+{
+    static const guint8 data[100] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    BinderRecordRing* ring = binder_record_ring_new(1024, 4);
+    BinderRecordRing* tiny = binder_record_ring_new(TEST_REC_SIZE(8), 256);
+    const BinderRecordHeader* rec;
+    TestCapture* capture;
+    const void* saved;
+
+    /* Truncated to RecordDataSize */
+    test_put(ring, BINDER_RECORD_RESP, 1, 1, 0, data, sizeof(data));
+    capture = test_capture_ring(ring);
+    rec = test_capture_record(capture, 0, &saved);
+    g_assert(rec->flags & BINDER_RECORD_TRUNCATED);
+    g_assert_cmpuint(rec->data_size, == ,sizeof(data));
+    g_assert_cmpuint(rec->saved_size, == ,4);
+    g_assert(!memcmp(saved, data, 4));
+    test_capture_free(capture);
+
+    /* Truncated to whatever fits the ring */
+    test_put(tiny, BINDER_RECORD_RESP, 1, 1, 0, data, sizeof(data));
+    test_put(tiny, BINDER_RECORD_RESP, 1, 2, 0, data, sizeof(data));
+    capture = test_capture_ring(tiny);
+    g_assert_cmpuint(test_capture_count(capture), == ,1);
+    rec = test_capture_record(capture, 0, &saved);
+    g_assert(rec->flags & BINDER_RECORD_TRUNCATED);
+    g_assert_cmpuint(rec->serial, == ,2);
+    g_assert_cmpuint(rec->saved_size, == ,8);
+    test_capture_free(capture);
+
+    binder_record_ring_free(ring);
+    binder_record_ring_free(tiny);
+}
+
+/*==========================================================================*
+ * save
+ *==========================================================================*/
+
+static
+void
+test_save(
+    void)
+{
+    BinderRecordRing* ring = binder_record_ring_new(1024, 256);
+    char* dir = g_dir_make_tmp("unit_record_XXXXXX", NULL);
+    char* file = g_build_filename(dir, "capture", NULL);
+    const BinderRecordHeader* rec;
+    TestCapture* capture;
+    const void* data;
+    GStatBuf st;
+
+    binder_record_ring_add_instance(ring, 0, RADIO_INTERFACE_NONE,
+        RADIO_MODEM_INTERFACE, "slot1");
+    test_put(ring, BINDER_RECORD_IND, 3, 0, 0, NULL, 0);
+    g_assert(binder_record_ring_save(ring, file, NULL));
+
+    /* Only the owner can read it */
+    g_assert(!g_stat(file, &st));
+    g_assert_cmpuint(st.st_mode & 0777, == ,0600);
+
+    capture = test_capture_file(file);
+    g_assert_cmpuint(test_capture_count(capture), == ,2);
+    rec = test_capture_record(capture, 0, &data);
+    g_assert_cmpint(rec->iface, == ,RADIO_MODEM_INTERFACE);
+    g_assert_cmpstr(data, == ,"slot1");
+    rec = test_capture_record(capture, 1, &data);
+    g_assert_cmpuint(rec->code, == ,3);
+    test_capture_free(capture);
+
+    binder_record_ring_free(ring);
+    g_unlink(file);
+    g_rmdir(dir);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/record/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("wrap"), test_wrap);
+    g_test_add_func(TEST_("truncate"), test_truncate);
+    g_test_add_func(TEST_("save"), test_save);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
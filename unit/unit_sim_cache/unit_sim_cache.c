@@ -0,0 +1,290 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_sim_cache.h"
+
+#include <gutil_log.h>
+
+#include <glib/gstdio.h>
+
+GLOG_MODULE_DEFINE("unit_sim_cache");
+
+#define CMD_READ_BINARY   0xB0
+#define CMD_READ_RECORD   0xB2
+#define CMD_GET_RESPONSE  0xC0
+#define CMD_UPDATE_BINARY 0xD6
+
+#define EF_SPN    0x6f46
+#define EF_MSISDN 0x6f40
+#define EF_ADN    0x6f3a
+#define EF_SST    0x6f38
+
+#define TEST_ICCID "8935810000000000001F"
+#define TEST_ICCID2 "8935810000000000002F"
+#define TEST_PATH_2G "3F007F20"
+#define TEST_PATH_3G "3F007FFF"
+#define TEST_AID_SIM "A0000000090001"
+#define TEST_AID_USIM "A0000000871002FF33FF01890000"
+
+static
+void
+test_assert_cached(
+    BinderSimCache* cache,
+    const char* key,
+    const void* data,
+    gsize size)
+{
+    GBytes* bytes = binder_sim_cache_get(cache, key);
+    gsize len;
+    const void* ptr;
+
+    g_assert(bytes);
+    ptr = g_bytes_get_data(bytes, &len);
+    g_assert_cmpuint(len, == ,size);
+    g_assert(!memcmp(ptr, data, size));
+    g_bytes_unref(bytes);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    binder_sim_cache_free(NULL);
+    binder_sim_cache_set_iccid(NULL, NULL);
+    binder_sim_cache_put(NULL, NULL, NULL, NULL, 0);
+    binder_sim_cache_invalidate_file(NULL, EF_SPN);
+    binder_sim_cache_invalidate_all(NULL);
+    binder_sim_cache_save(NULL);
+    g_assert(!binder_sim_cache_get(NULL, NULL));
+}
+
+/*==========================================================================*
+ * key
+ *==========================================================================*/
+
+static
+void
+test_key(
+    void)
+{
+    char* key;
+    char* key2;
+
+    /* Only reads of the known files are cacheable */
+    g_assert(!binder_sim_cache_key(CMD_UPDATE_BINARY, EF_SPN, 0, 0, 17,
+        TEST_PATH_2G, NULL));
+    g_assert(!binder_sim_cache_key(CMD_READ_RECORD, EF_ADN, 1, 4, 28,
+        TEST_PATH_2G, NULL));
+
+    /* Path is required, both path and AID must be hex */
+    g_assert(!binder_sim_cache_key(CMD_READ_BINARY, EF_SPN, 0, 0, 17,
+        NULL, NULL));
+    g_assert(!binder_sim_cache_key(CMD_READ_BINARY, EF_SPN, 0, 0, 17,
+        "", NULL));
+    g_assert(!binder_sim_cache_key(CMD_READ_BINARY, EF_SPN, 0, 0, 17,
+        "3F00/7F20", NULL));
+    g_assert(!binder_sim_cache_key(CMD_READ_BINARY, EF_SPN, 0, 0, 17,
+        TEST_PATH_3G, "A0000000=7"));
+
+    key = binder_sim_cache_key(CMD_READ_BINARY, EF_SPN, 0, 0, 17,
+        TEST_PATH_2G, NULL);
+    g_assert_cmpstr(key, == ,"6F46-B0-000011-3F007F20");
+    g_free(key);
+
+    key = binder_sim_cache_key(CMD_GET_RESPONSE, EF_SPN, 0, 0, 15,
+        TEST_PATH_3G, "");
+    g_assert_cmpstr(key, == ,"6F46-C0-00000F-3F007FFF");
+    g_free(key);
+
+    key = binder_sim_cache_key(CMD_GET_RESPONSE, EF_SPN, 0, 0, 15,
+        TEST_PATH_3G, TEST_AID_USIM);
+    g_assert_cmpstr(key, == ,"6F46-C0-00000F-3F007FFF-" TEST_AID_USIM);
+    g_free(key);
+
+    /* EF_SST under DF_GSM and EF_UST under ADF_USIM are different */
+    key = binder_sim_cache_key(CMD_READ_BINARY, EF_SST, 0, 0, 10,
+        TEST_PATH_2G, TEST_AID_SIM);
+    key2 = binder_sim_cache_key(CMD_READ_BINARY, EF_SST, 0, 0, 10,
+        TEST_PATH_3G, TEST_AID_USIM);
+    g_assert(key);
+    g_assert(key2);
+    g_assert_cmpstr(key, != ,key2);
+    g_free(key);
+    g_free(key2);
+}
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    static const guint8 spn[] = { 0x01, 'J', 'o', 'l', 'l', 'a' };
+    static const guint8 msisdn[] = { 0xff, 0xff, 0x07, 0x81 };
+    static const guint8 empty[] = { 0 };
+    char* dir = g_dir_make_tmp("unit_sim_cache_XXXXXX", NULL);
+    char* file = g_build_filename(dir, TEST_ICCID, NULL);
+    char* spn_key = binder_sim_cache_key(CMD_READ_BINARY, EF_SPN, 0, 0,
+        sizeof(spn), TEST_PATH_3G, TEST_AID_USIM);
+    char* msisdn_key = binder_sim_cache_key(CMD_READ_RECORD, EF_MSISDN, 1,
+        4, sizeof(msisdn), TEST_PATH_3G, TEST_AID_USIM);
+    BinderSimCache* cache = binder_sim_cache_new(dir);
+
+    /* Nothing gets cached until we know ICCID */
+    binder_sim_cache_put(cache, TEST_ICCID, spn_key, spn, sizeof(spn));
+    g_assert(!binder_sim_cache_get(cache, spn_key));
+
+    /* Invalid ICCID is ignored */
+    binder_sim_cache_set_iccid(cache, "../" TEST_ICCID);
+    binder_sim_cache_put(cache, "../" TEST_ICCID, spn_key, spn, sizeof(spn));
+    g_assert(!binder_sim_cache_get(cache, spn_key));
+
+    binder_sim_cache_set_iccid(cache, TEST_ICCID);
+    g_assert(!binder_sim_cache_get(cache, NULL));
+    g_assert(!binder_sim_cache_get(cache, spn_key));
+    binder_sim_cache_put(cache, TEST_ICCID, NULL, spn, sizeof(spn));
+    binder_sim_cache_put(cache, TEST_ICCID, spn_key, empty, 0);
+    test_assert_cached(cache, spn_key, empty, 0);
+    binder_sim_cache_put(cache, TEST_ICCID, spn_key, spn, sizeof(spn));
+    binder_sim_cache_put(cache, TEST_ICCID, spn_key, spn, sizeof(spn));
+    binder_sim_cache_put(cache, TEST_ICCID, msisdn_key, msisdn,
+        sizeof(msisdn));
+    test_assert_cached(cache, spn_key, spn, sizeof(spn));
+    test_assert_cached(cache, msisdn_key, msisdn, sizeof(msisdn));
+    binder_sim_cache_free(cache);
+    g_assert(g_file_test(file, G_FILE_TEST_EXISTS));
+
+    /* Load it back */
+    cache = binder_sim_cache_new(dir);
+    binder_sim_cache_set_iccid(cache, TEST_ICCID);
+    test_assert_cached(cache, spn_key, spn, sizeof(spn));
+    test_assert_cached(cache, msisdn_key, msisdn, sizeof(msisdn));
+
+    /* Another card */
+    binder_sim_cache_set_iccid(cache, NULL);
+    g_assert(!binder_sim_cache_get(cache, spn_key));
+
+    /* Response to the request submitted before the card was changed */
+    binder_sim_cache_set_iccid(cache, TEST_ICCID2);
+    binder_sim_cache_put(cache, TEST_ICCID, spn_key, spn, sizeof(spn));
+    g_assert(!binder_sim_cache_get(cache, spn_key));
+    binder_sim_cache_set_iccid(cache, TEST_ICCID);
+    test_assert_cached(cache, spn_key, spn, sizeof(spn));
+
+    /* Write invalidates the file */
+    binder_sim_cache_invalidate_file(cache, EF_ADN);
+    binder_sim_cache_invalidate_file(cache, EF_MSISDN);
+    binder_sim_cache_invalidate_file(cache, EF_MSISDN);
+    g_assert(!binder_sim_cache_get(cache, msisdn_key));
+    test_assert_cached(cache, spn_key, spn, sizeof(spn));
+    binder_sim_cache_save(cache);
+
+    binder_sim_cache_free(cache);
+    cache = binder_sim_cache_new(dir);
+    binder_sim_cache_set_iccid(cache, TEST_ICCID);
+    g_assert(!binder_sim_cache_get(cache, msisdn_key));
+    test_assert_cached(cache, spn_key, spn, sizeof(spn));
+
+    /* And SIM refresh invalidates everything */
+    binder_sim_cache_invalidate_all(cache);
+    g_assert(!binder_sim_cache_get(cache, spn_key));
+    g_assert(!g_file_test(file, G_FILE_TEST_EXISTS));
+    binder_sim_cache_invalidate_all(cache);
+    binder_sim_cache_free(cache);
+    g_assert(!g_file_test(file, G_FILE_TEST_EXISTS));
+
+    g_rmdir(dir);
+    g_free(spn_key);
+    g_free(msisdn_key);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * garbage
+ *==========================================================================*/
+
+static
+void
+test_garbage(
+    void)
+{
+    static const char contents[] =
+        "[EF]\n6F38-B0-00000A-" TEST_PATH_2G "=0304\n"
+        "[AppEF]\n6F46-B0-000011-" TEST_PATH_3G "=ABC\n"
+        "6F46-B0-000002-" TEST_PATH_3G "=XY\n"
+        "6F46-C0-00000F-" TEST_PATH_3G "-" TEST_AID_USIM "=0102\n";
+    static const guint8 data[] = { 0x01, 0x02 };
+    char* dir = g_dir_make_tmp("unit_sim_cache_XXXXXX", NULL);
+    char* file = g_build_filename(dir, TEST_ICCID, NULL);
+    char* key = binder_sim_cache_key(CMD_GET_RESPONSE, EF_SPN, 0, 0, 15,
+        TEST_PATH_3G, TEST_AID_USIM);
+    char* old_key = binder_sim_cache_key(CMD_READ_BINARY, EF_SST, 0, 0, 10,
+        TEST_PATH_2G, NULL);
+    BinderSimCache* cache = binder_sim_cache_new(dir);
+
+    /* Broken entries and the old format entries are ignored */
+    g_assert(g_file_set_contents(file, contents, -1, NULL));
+    binder_sim_cache_set_iccid(cache, TEST_ICCID);
+    test_assert_cached(cache, key, data, sizeof(data));
+    g_assert(!binder_sim_cache_get(cache, old_key));
+    binder_sim_cache_free(cache);
+
+    g_unlink(file);
+    g_rmdir(dir);
+    g_free(old_key);
+    g_free(key);
+    g_free(file);
+    g_free(dir);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/sim_cache/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("key"), test_key);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("garbage"), test_garbage);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
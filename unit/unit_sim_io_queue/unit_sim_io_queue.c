@@ -0,0 +1,224 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2022 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_sim_io_queue.h"
+
+#include <gutil_log.h>
+
+GLOG_MODULE_DEFINE("unit_sim_io_queue");
+
+/*
+ * Items are single characters: 'r' for reads, 'w' for everything
+ * else. Submitted items are appended to the string.
+ */
+
+typedef struct test_io {
+    GString* submitted;
+    gboolean fail;
+} TestIo;
+
+static
+gboolean
+test_submit(
+    gpointer item,
+    gpointer user_data)
+{
+    TestIo* test = user_data;
+
+    g_string_append_c(test->submitted, GPOINTER_TO_INT(item));
+    return !test->fail;
+}
+
+static
+void
+test_push(
+    BinderSimIoQueue* queue,
+    char c)
+{
+    binder_sim_io_queue_push(queue, GINT_TO_POINTER(c), c == 'r');
+}
+
+static
+void
+test_destroy(
+    gpointer item)
+{
+    g_assert_cmpint(GPOINTER_TO_INT(item), == ,'w');
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    binder_sim_io_queue_free(NULL, NULL);
+    binder_sim_io_queue_push(NULL, NULL, TRUE);
+    binder_sim_io_queue_finished(NULL, TRUE);
+}
+
+/*==========================================================================*
+ * window
+ *==========================================================================*/
+
+static
+void
+test_window(
+    void)
+{
+    TestIo test;
+    BinderSimIoQueue* queue;
+
+    memset(&test, 0, sizeof(test));
+    test.submitted = g_string_new(NULL);
+    queue = binder_sim_io_queue_new(2, test_submit, &test);
+
+    /* Only two reads fit into the window */
+    test_push(queue, 'r');
+    test_push(queue, 'r');
+    test_push(queue, 'r');
+    g_assert_cmpstr(test.submitted->str, == ,"rr");
+
+    /* Completion of either one lets the next one in */
+    binder_sim_io_queue_finished(queue, TRUE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrr");
+    binder_sim_io_queue_finished(queue, TRUE);
+    binder_sim_io_queue_finished(queue, TRUE);
+
+    binder_sim_io_queue_free(queue, NULL);
+    g_string_free(test.submitted, TRUE);
+}
+
+/*==========================================================================*
+ * order
+ *==========================================================================*/
+
+static
+void
+test_order(
+    void)
+{
+    TestIo test;
+    BinderSimIoQueue* queue;
+
+    memset(&test, 0, sizeof(test));
+    test.submitted = g_string_new(NULL);
+    queue = binder_sim_io_queue_new(2, test_submit, &test);
+
+    /* Update doesn't overtake the read waiting for the window */
+    test_push(queue, 'r');
+    test_push(queue, 'r');
+    test_push(queue, 'r');
+    test_push(queue, 'w');
+    test_push(queue, 'r');
+    g_assert_cmpstr(test.submitted->str, == ,"rr");
+
+    /* The third read goes in but the update waits for all of them */
+    binder_sim_io_queue_finished(queue, TRUE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrr");
+    binder_sim_io_queue_finished(queue, TRUE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrr");
+    binder_sim_io_queue_finished(queue, TRUE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrrw");
+
+    /* And the next read waits for the update */
+    test_push(queue, 'r');
+    g_assert_cmpstr(test.submitted->str, == ,"rrrw");
+    binder_sim_io_queue_finished(queue, FALSE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrrwrr");
+
+    /* Commands other than reads go one by one */
+    test_push(queue, 'w');
+    test_push(queue, 'w');
+    binder_sim_io_queue_finished(queue, TRUE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrrwrr");
+    binder_sim_io_queue_finished(queue, TRUE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrrwrrw");
+    binder_sim_io_queue_finished(queue, FALSE);
+    g_assert_cmpstr(test.submitted->str, == ,"rrrwrrww");
+
+    /* The one still waiting is destroyed */
+    test_push(queue, 'w');
+    g_assert_cmpstr(test.submitted->str, == ,"rrrwrrww");
+    binder_sim_io_queue_free(queue, test_destroy);
+    g_string_free(test.submitted, TRUE);
+}
+
+/*==========================================================================*
+ * fail
+ *==========================================================================*/
+
+static
+void
+test_fail(
+    void)
+{
+    TestIo test;
+    BinderSimIoQueue* queue;
+
+    memset(&test, 0, sizeof(test));
+    test.submitted = g_string_new(NULL);
+    queue = binder_sim_io_queue_new(2, test_submit, &test);
+
+    /* Failed submissions don't occupy the window */
+    test.fail = TRUE;
+    test_push(queue, 'r');
+    test_push(queue, 'w');
+    test_push(queue, 'r');
+    test_push(queue, 'r');
+    g_assert_cmpstr(test.submitted->str, == ,"rwrr");
+
+    test.fail = FALSE;
+    test_push(queue, 'r');
+    test_push(queue, 'r');
+    g_assert_cmpstr(test.submitted->str, == ,"rwrrrr");
+
+    binder_sim_io_queue_free(queue, NULL);
+    g_string_free(test.submitted, TRUE);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/sim_io_queue/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("window"), test_window);
+    g_test_add_func(TEST_("order"), test_order);
+    g_test_add_func(TEST_("fail"), test_fail);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */